@@ -2497,8 +2497,26 @@
 
 /* ECP options */
 //#define MBEDTLS_ECP_MAX_BITS             521 /**< 521 Maximum bit size of groups */
+/*
+ * ECP speed / RAM trade-off, selected at build time with NET_TLS_ECP_TUNING:
+ *   0 (default)  window 2, no fixed-point speed-up: smallest heap.
+ *   1            window 4, fixed-point speed-up.
+ *   2            window 6, fixed-point speed-up: fastest, largest heap.
+ * Combine with the "fast" tls_profile socket option (netsock/inc/net.h);
+ * netsock/bench/tls_bench measures both.
+ */
+#if !defined(NET_TLS_ECP_TUNING) || (NET_TLS_ECP_TUNING == 0)
 #define MBEDTLS_ECP_WINDOW_SIZE            2 /**< Maximum window size used */
 #define MBEDTLS_ECP_FIXED_POINT_OPTIM      0 /**< Disable fixed-point speed-up */
+#elif (NET_TLS_ECP_TUNING == 1)
+#define MBEDTLS_ECP_WINDOW_SIZE            4 /**< Maximum window size used */
+#define MBEDTLS_ECP_FIXED_POINT_OPTIM      1 /**< Enable fixed-point speed-up */
+#elif (NET_TLS_ECP_TUNING == 2)
+#define MBEDTLS_ECP_WINDOW_SIZE            6 /**< Maximum window size used */
+#define MBEDTLS_ECP_FIXED_POINT_OPTIM      1 /**< Enable fixed-point speed-up */
+#else
+#error "NET_TLS_ECP_TUNING must be 0, 1 or 2"
+#endif
 
 /* Entropy options */
 //#define MBEDTLS_ENTROPY_MAX_SOURCES                20 /**< Maximum number of sources supported */
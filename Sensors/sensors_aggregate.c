@@ -0,0 +1,197 @@
+/*
+ * sensors_aggregate.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Daruin Solano
+ */
+
+#include <string.h>
+#include "sensors_aggregate.h"
+
+/* Private functions ---------------------------------------------------------*/
+
+static void sensors_agg_reset(sensors_agg_pane_t* p)
+{
+	memset(p, 0, sizeof(*p));
+}
+
+/* Welford: running mean and sum of the squared deviations, stable in single precision. */
+static void sensors_agg_add(sensors_agg_t* a, float x)
+{
+	sensors_agg_pane_t* p = &a->panes[a->current];
+	float d, pos;
+	int bin;
+
+	if ((p->count == 0) || (x < p->min)) {
+		p->min = x;
+	}
+	if ((p->count == 0) || (x > p->max)) {
+		p->max = x;
+	}
+	p->count++;
+	d = x - p->mean;
+	p->mean += d / (float)p->count;
+	p->m2 += d * (x - p->mean);
+
+	pos = (x - a->config.lo) * a->scale;
+	bin = (pos < 0.0f) ? 0 : (pos >= (float)SENSORS_AGG_BINS) ? (SENSORS_AGG_BINS - 1) : (int)pos;
+	if (p->bins[bin] < UINT16_MAX) {
+		p->bins[bin]++;
+	}
+}
+
+/* Value of rank p (0..1) in the histogram, interpolated within its bin. The rank is taken from the
+ * bins, not from the sample count: a pane bin saturates, the histogram may hold fewer samples. */
+static float sensors_agg_percentile(const sensors_agg_t* a, const uint32_t* bins, const sensors_agg_summary_t* s,
+		float p)
+{
+	uint32_t total = 0;
+	float rank, below = 0.0f, v;
+	int i;
+
+	for (i = 0; i < SENSORS_AGG_BINS; ++i) {
+		total += bins[i];
+	}
+	if (total == 0) {
+		return s->mean;
+	}
+	rank = p * (float)(total - 1);
+	for (i = 0; i < SENSORS_AGG_BINS - 1; ++i) {
+		if (below + (float)bins[i] > rank) {
+			break;
+		}
+		below += (float)bins[i];
+	}
+	if (bins[i] == 0) {
+		return s->max;
+	}
+	v = a->config.lo + ((float)i + (rank - below + 0.5f) / (float)bins[i]) / a->scale;
+	return (v < s->min) ? s->min : (v > s->max) ? s->max : v;
+}
+
+/* Merge the panes of the window (Chan et al.), and its percentiles. @return false if it has no sample */
+static bool sensors_agg_summarize(const sensors_agg_t* a, sensors_agg_summary_t* s)
+{
+	uint32_t bins[SENSORS_AGG_BINS] = { 0 };
+	const sensors_agg_pane_t* p;
+	float mean = 0.0f, m2 = 0.0f, d;
+	uint32_t n;
+	uint16_t i;
+	int b;
+
+	memset(s, 0, sizeof(*s));
+	for (i = 0; i < a->pane_count; ++i) {
+		p = &a->panes[i];
+		if (p->count == 0) {
+			continue;
+		}
+		if ((s->count == 0) || (p->min < s->min)) {
+			s->min = p->min;
+		}
+		if ((s->count == 0) || (p->max > s->max)) {
+			s->max = p->max;
+		}
+		n = s->count + p->count;
+		d = p->mean - mean;
+		mean += d * (float)p->count / (float)n;
+		m2 += p->m2 + d * d * (float)s->count * (float)p->count / (float)n;
+		s->count = n;
+		for (b = 0; b < SENSORS_AGG_BINS; ++b) {
+			bins[b] += p->bins[b];
+		}
+	}
+	if (s->count == 0) {
+		return false;
+	}
+
+	s->channel = a->config.channel;
+	s->end_tick = a->pane_end;
+	s->start_tick = a->pane_end - a->config.window_ms;
+	s->mean = mean;
+	s->variance = (s->count > 1) ? (m2 / (float)(s->count - 1)) : 0.0f;
+	s->p50 = sensors_agg_percentile(a, bins, s, 0.50f);
+	s->p90 = sensors_agg_percentile(a, bins, s, 0.90f);
+	s->p99 = sensors_agg_percentile(a, bins, s, 0.99f);
+	return true;
+}
+
+/* Close the current pane: the summary of the window it ends, if full and not empty; the next pane starts. */
+static bool sensors_agg_close(sensors_agg_t* a, sensors_agg_summary_t* summary)
+{
+	bool out = false;
+
+	if (a->filled < a->pane_count) {
+		a->filled++;
+	}
+	if (a->filled == a->pane_count) {
+		out = sensors_agg_summarize(a, summary);
+	}
+	a->current = (uint16_t)((a->current + 1) % a->pane_count);
+	sensors_agg_reset(&a->panes[a->current]);
+	a->pane_end += a->config.hop_ms;
+	if (out) {
+		a->windows++;
+	}
+	return out;
+}
+
+/* Exported functions --------------------------------------------------------*/
+
+int sensors_agg_init(sensors_agg_t* a, const sensors_agg_config_t* config, sensors_agg_pane_t* panes, uint16_t pane_count)
+{
+	uint16_t i, n;
+
+	if ((config->hop_ms == 0) || ((config->window_ms % config->hop_ms) != 0) || !(config->hi > config->lo)
+			|| (config->channel >= SENSOR_CH_COUNT)) {
+		return -1;
+	}
+	n = (uint16_t)(config->window_ms / config->hop_ms);
+	if ((n == 0) || (n > pane_count)) {
+		return -1;
+	}
+
+	memset(a, 0, sizeof(*a));
+	a->config = *config;
+	a->panes = panes;
+	a->pane_count = n;
+	a->scale = (float)SENSORS_AGG_BINS / (config->hi - config->lo);
+	a->cursor = sensors_cursor(config->channel);
+	for (i = 0; i < n; ++i) {
+		sensors_agg_reset(&panes[i]);
+	}
+	return 0;
+}
+
+bool sensors_agg_poll(sensors_agg_t* a, sensors_agg_summary_t* summary)
+{
+	uint32_t from;
+	size_t n;
+
+	if (a->pane_count == 0) {
+		return false;	/* not initialized */
+	}
+	for (;;) {
+		if (!a->pending) {
+			from = a->cursor;
+			n = sensors_read(a->config.channel, &a->cursor, &a->sample, 1);
+			a->lost += a->cursor - from - n;	/* skipped over: overwritten before read */
+			if (n == 0) {
+				return false;
+			}
+			a->pending = true;
+			if (!a->started) {
+				/* the panes are aligned on multiples of the hop */
+				a->pane_end = a->sample.tick - (a->sample.tick % a->config.hop_ms) + a->config.hop_ms;
+				a->started = true;
+			}
+		}
+		if ((int32_t)(a->sample.tick - a->pane_end) >= 0) {
+			if (sensors_agg_close(a, summary)) {
+				return true;
+			}
+			continue;
+		}
+		sensors_agg_add(a, a->sample.value);
+		a->pending = false;
+	}
+}
@@ -0,0 +1,109 @@
+/*
+ * sensors_aggregate.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Daruin Solano
+ *
+ *  Windowed statistics of a sensor channel, computed on the device: one
+ *  summary per window instead of the raw samples, e.g. a minute of the
+ *  accelerometer at 50 Hz, 3000 samples, in one record.
+ *
+ *  An aggregator reads the samples of its channel from the ring of the
+ *  acquisition (sensors_sampling.h) and summarizes them per window:
+ *  count, min, max, mean, variance (Welford), and the 50th, 90th and 99th
+ *  percentiles. The windows are aligned on multiples of config.hop_ms:
+ *  - tumbling: hop_ms == window_ms, one summary per window, no overlap;
+ *  - sliding: hop_ms a divisor of window_ms, a summary of the last
+ *    window_ms every hop_ms, e.g. the last 5 minutes, every minute.
+ *  A window is made of window_ms / hop_ms panes, each of them holding the
+ *  moments and a histogram of its samples; the summary merges them, so the
+ *  memory is constant whatever the rate: SENSORS_AGG_BINS counters a pane.
+ *  The percentiles are interpolated in the histogram, over [config.lo,
+ *  config.hi]: their error is within a bin, (hi - lo) / SENSORS_AGG_BINS,
+ *  and they are bounded by the exact min and max.
+ *
+ *    static sensors_agg_pane_t acc_x_panes[1];
+ *    sensors_agg_config_t cfg = { SENSOR_CH_ACC_X, 60000, 60000, -2000.0f, 2000.0f };
+ *    sensors_agg_init(&acc_x, &cfg, acc_x_panes, 1);
+ *    ...
+ *    while (sensors_agg_poll(&acc_x, &summary)) {
+ *      ... publish the summary ...
+ *    }
+ *
+ *  The summary of a window is out with the first sample after it; a window
+ *  without samples has none. Poll more often than the ring fills up
+ *  (SENSORS_RING_SIZE - 1 samples): the samples overwritten meanwhile are lost
+ *  to the statistics, and counted.
+ *
+ *  Not thread-safe: poll an aggregator from a single task.
+ */
+
+#ifndef SENSORS_SENSORS_AGGREGATE_H_
+#define SENSORS_SENSORS_AGGREGATE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "sensors_sampling.h"
+
+#if !defined(SENSORS_AGG_BINS)
+#define SENSORS_AGG_BINS            64      /* redefinable - histogram bins of a pane */
+#endif
+
+typedef struct {
+  sensor_channel_t channel;
+  uint32_t window_ms;
+  uint32_t hop_ms;              /**< window_ms: tumbling windows; a divisor of it: sliding ones. */
+  float lo;                     /**< Range of the percentiles: the values out of it count */
+  float hi;                     /**< in the end bins. */
+} sensors_agg_config_t;
+
+typedef struct {
+  uint32_t count;
+  float min;
+  float max;
+  float mean;
+  float m2;                     /**< Sum of the squared deviations from the mean. */
+  uint16_t bins[SENSORS_AGG_BINS];   /**< Saturate: past 65535 samples in a bin, the percentiles are approximate. */
+} sensors_agg_pane_t;
+
+typedef struct {
+  sensor_channel_t channel;
+  uint32_t start_tick;          /**< The window, ms: [start_tick, end_tick). */
+  uint32_t end_tick;
+  uint32_t count;
+  float min;
+  float max;
+  float mean;
+  float variance;               /**< Sample variance, 0 for less than 2 samples. */
+  float p50;
+  float p90;
+  float p99;
+} sensors_agg_summary_t;
+
+typedef struct {
+  sensors_agg_config_t config;
+  sensors_agg_pane_t* panes;    /**< window_ms / hop_ms panes, of the application. */
+  uint16_t pane_count;
+  uint16_t current;             /**< Pane of the samples to come. */
+  uint16_t filled;              /**< Panes closed, up to pane_count: a full window. */
+  float scale;                  /**< Bins per unit. */
+  bool started;
+  bool pending;                 /**< A sample after the current pane waits for its close. */
+  sensor_sample_t sample;
+  uint32_t pane_end;            /**< Tick closing the current pane. */
+  uint32_t cursor;              /**< In the ring of the channel. */
+  /* Metrics */
+  uint32_t windows;             /**< Summaries out. */
+  uint32_t lost;                /**< Samples overwritten in the ring before read. */
+} sensors_agg_t;
+
+/** Aggregate the channel of config from its next sample on; panes: room for window_ms / hop_ms panes.
+ *  @return 0, or -1 if hop_ms does not divide window_ms, the panes do not fit, or the range is empty */
+int  sensors_agg_init(sensors_agg_t* a, const sensors_agg_config_t* config, sensors_agg_pane_t* panes, uint16_t pane_count);
+
+/** Aggregate the samples acquired since the last call, up to the end of a window.
+ *  @return true with the summary of the window, false once the samples are all aggregated */
+bool sensors_agg_poll(sensors_agg_t* a, sensors_agg_summary_t* summary);
+
+#endif /* SENSORS_SENSORS_AGGREGATE_H_ */
@@ -47,6 +47,7 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include "sensors_data.h"
+#include "sensors_sampling.h"
 
 #include "stm32l4xx_hal.h"
 #include "stm32l475e_iot01.h"
@@ -65,8 +66,75 @@
 /* Private variables ---------------------------------------------------------*/
 /* Global variables ----------------------------------------------------------*/
 /* Private function prototypes -----------------------------------------------*/
+static int read_temperature(float * values);
+static int read_humidity(float * values);
+static int read_pressure(float * values);
+static int read_accelero(float * values);
+static int read_gyro(float * values);
+static int read_magneto(float * values);
+
+/* Acquisition of the board sensors: the accelerometer sampled at 50 Hz, for
+ * its windowed statistics (sensors_aggregate.h), the gyro read at 50 Hz and
+ * averaged by 5 into 10 Hz samples, the environmental ones once a second.
+ */
+static const sensor_source_t board_sources[] =
+{
+  { "temperature", read_temperature, SENSOR_CH_TEMPERATURE, 1, 1, 1000 },
+  { "humidity",    read_humidity,    SENSOR_CH_HUMIDITY,    1, 1, 1000 },
+  { "pressure",    read_pressure,    SENSOR_CH_PRESSURE,    1, 1, 1000 },
+  { "accelero",    read_accelero,    SENSOR_CH_ACC_X,       3, 1, 20 },
+  { "gyro",        read_gyro,        SENSOR_CH_GYR_X,       3, 5, 20 },
+  { "magneto",     read_magneto,     SENSOR_CH_MAG_X,       3, 1, 100 },
+};
+
 /* Functions Definition ------------------------------------------------------*/
 
+static int read_temperature(float * values)
+{
+  values[0] = BSP_TSENSOR_ReadTemp();
+  return 0;
+}
+
+static int read_humidity(float * values)
+{
+  values[0] = BSP_HSENSOR_ReadHumidity();
+  return 0;
+}
+
+static int read_pressure(float * values)
+{
+  values[0] = BSP_PSENSOR_ReadPressure();
+  return 0;
+}
+
+static int read_accelero(float * values)
+{
+  int16_t xyz[3];
+
+  BSP_ACCELERO_AccGetXYZ(xyz);
+  values[0] = xyz[0];
+  values[1] = xyz[1];
+  values[2] = xyz[2];
+  return 0;
+}
+
+static int read_gyro(float * values)
+{
+  BSP_GYRO_GetXYZ(values);
+  return 0;
+}
+
+static int read_magneto(float * values)
+{
+  int16_t xyz[3];
+
+  BSP_MAGNETO_GetXYZ(xyz);
+  values[0] = xyz[0];
+  values[1] = xyz[1];
+  values[2] = xyz[2];
+  return 0;
+}
+
 /**
   * @brief  init_sensors
   * @param  none
@@ -119,7 +187,37 @@ int init_sensors(void)
 }
 
 /**
-  * @brief  fill the buffer with the sensor values
+  * @brief  init_sensors_sampling: init the sensors and their background acquisition,
+  *         from a task of its own in SENSORS_TASK builds, else from sensors_sampling_poll()
+  *         calls of the application
+  * @param  none
+  * @retval 0 in case of success
+  *         -1 in case of failure
+  */
+int init_sensors_sampling(void)
+{
+  if (init_sensors() != 0)
+  {
+    return -1;
+  }
+  if (sensors_sampling_init(board_sources, sizeof(board_sources) / sizeof(board_sources[0]), HAL_GetTick) != 0)
+  {
+    msg_error("sensors_sampling_init() failed\n");
+    return -1;
+  }
+#if defined(SENSORS_TASK)
+  if (sensors_sampling_start_task() != 0)
+  {
+    msg_error("sensors_sampling_start_task() failed\n");
+    return -1;
+  }
+#endif
+  return 0;
+}
+
+/**
+  * @brief  fill the buffer with the sensor values, the last ones sampled by the
+  *         background acquisition: no bus access
   * @param  none
   * @param Buffer is the char pointer for the buffer to be filled
   * @param Size size of the above buffer
@@ -135,19 +233,25 @@ int PrepareSensorsData(char * Buffer, int Size, char * deviceID)
   int16_t  ACC_Value[3];
   float    GYR_Value[3];
   int16_t  MAG_Value[3];
-  uint16_t PROXIMITY_Value;
+  uint16_t PROXIMITY_Value = 0;
+  sensors_snapshot_t snap;
+  int i;
 
   char * Buff = Buffer;
   int BuffSize = Size;
   int snprintfreturn = 0;
 
-  TEMPERATURE_Value = BSP_TSENSOR_ReadTemp();
-  HUMIDITY_Value = BSP_HSENSOR_ReadHumidity();
-  PRESSURE_Value = BSP_PSENSOR_ReadPressure();
+  sensors_snapshot(&snap);
+  TEMPERATURE_Value = snap.value[SENSOR_CH_TEMPERATURE];
+  HUMIDITY_Value = snap.value[SENSOR_CH_HUMIDITY];
+  PRESSURE_Value = snap.value[SENSOR_CH_PRESSURE];
   //PROXIMITY_Value = VL53L0X_PROXIMITY_GetDistance();
-  BSP_ACCELERO_AccGetXYZ(ACC_Value);
-  BSP_GYRO_GetXYZ(GYR_Value);
-  BSP_MAGNETO_GetXYZ(MAG_Value);
+  for (i = 0; i < 3; i++)
+  {
+    ACC_Value[i] = (int16_t)snap.value[SENSOR_CH_ACC_X + i];
+    GYR_Value[i] = snap.value[SENSOR_CH_GYR_X + i];
+    MAG_Value[i] = (int16_t)snap.value[SENSOR_CH_MAG_X + i];
+  }
 
 #ifdef BLUEMIX
   snprintfreturn = snprintf( Buff, BuffSize, "{\"d\":{"
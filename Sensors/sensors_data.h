@@ -52,6 +52,7 @@
 
 #define AWS
 int init_sensors(void);
+int init_sensors_sampling(void);
 int PrepareSensorsData(char * Buffer, int Size, char * deviceID);
 
 #ifdef __cplusplus
@@ -0,0 +1,215 @@
+/*
+ * sensors_deadband.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Daruin Solano
+ */
+
+#include <string.h>
+#include <math.h>
+#include "sensors_deadband.h"
+
+/* Private functions ---------------------------------------------------------*/
+
+/* Members of a channel configuration: known, numbers, not negative. */
+static bool sensors_deadband_valid(const cJSON* cfg)
+{
+	const cJSON* m;
+
+	if (!cJSON_IsObject(cfg)) {
+		return false;
+	}
+	cJSON_ArrayForEach(m, cfg) {
+		if (!cJSON_IsNumber(m) || (m->valuedouble < 0.0)) {
+			return false;
+		}
+		if ((strcmp(m->string, "abs") != 0) && (strcmp(m->string, "rel") != 0)
+				&& (strcmp(m->string, "heartbeat_ms") != 0) && (strcmp(m->string, "min_interval_ms") != 0)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+/* Object of channel configurations, by name. */
+static bool sensors_deadband_valid_object(const cJSON* obj)
+{
+	const cJSON* cfg;
+
+	if (!cJSON_IsObject(obj)) {
+		return false;
+	}
+	cJSON_ArrayForEach(cfg, obj) {
+		if ((sensors_channel_find(cfg->string) < 0) || !sensors_deadband_valid(cfg)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+static void sensors_deadband_apply(sensors_deadband_config_t* config, const cJSON* cfg)
+{
+	const cJSON* m;
+
+	if ((m = cJSON_GetObjectItemCaseSensitive(cfg, "abs")) != NULL) {
+		config->abs = (float)m->valuedouble;
+	}
+	if ((m = cJSON_GetObjectItemCaseSensitive(cfg, "rel")) != NULL) {
+		config->rel = (float)m->valuedouble;
+	}
+	if ((m = cJSON_GetObjectItemCaseSensitive(cfg, "heartbeat_ms")) != NULL) {
+		config->heartbeat_ms = (uint32_t)m->valuedouble;
+	}
+	if ((m = cJSON_GetObjectItemCaseSensitive(cfg, "min_interval_ms")) != NULL) {
+		config->min_interval_ms = (uint32_t)m->valuedouble;
+	}
+}
+
+/* Exported functions --------------------------------------------------------*/
+
+void sensors_deadband_init(sensors_deadband_t* d)
+{
+	memset(d, 0, sizeof(*d));
+	atomic_init(&d->staged, NULL);
+}
+
+void sensors_deadband_set(sensors_deadband_t* d, sensor_channel_t ch, const sensors_deadband_config_t* config)
+{
+	if (ch < SENSOR_CH_COUNT) {
+		d->ch[ch].config = *config;
+	}
+}
+
+sensors_deadband_reason_t sensors_deadband_check(sensors_deadband_t* d, sensor_channel_t ch, float value, uint32_t now)
+{
+	sensors_deadband_channel_t* c;
+	uint32_t elapsed;
+	float delta;
+	bool changed;
+
+	if (ch >= SENSOR_CH_COUNT) {
+		return SENSORS_DEADBAND_NONE;
+	}
+	c = &d->ch[ch];
+	if (!c->reported) {
+		return SENSORS_DEADBAND_FIRST;
+	}
+	elapsed = now - c->last_tick;
+	if ((c->config.heartbeat_ms != 0) && (elapsed >= c->config.heartbeat_ms)) {
+		c->heartbeats++;
+		return SENSORS_DEADBAND_HEARTBEAT;
+	}
+
+	delta = fabsf(value - c->last);
+	changed = ((c->config.abs <= 0.0f) && (c->config.rel <= 0.0f))
+			|| ((c->config.abs > 0.0f) && (delta >= c->config.abs))
+			|| ((c->config.rel > 0.0f) && (delta > 0.0f) && (delta >= c->config.rel * fabsf(c->last)));
+	if (!changed) {
+		c->suppressed++;
+		return SENSORS_DEADBAND_NONE;
+	}
+	if ((c->config.min_interval_ms != 0) && (elapsed < c->config.min_interval_ms)) {
+		c->limited++;
+		return SENSORS_DEADBAND_NONE;
+	}
+	return SENSORS_DEADBAND_CHANGE;
+}
+
+void sensors_deadband_reported(sensors_deadband_t* d, sensor_channel_t ch, float value, uint32_t now)
+{
+	sensors_deadband_channel_t* c;
+
+	if (ch >= SENSOR_CH_COUNT) {
+		return;
+	}
+	c = &d->ch[ch];
+	c->last = value;
+	c->last_tick = now;
+	c->reported = true;
+	c->reports++;
+}
+
+bool sensors_deadband_filter(sensors_deadband_t* d, sensor_channel_t ch, float value, uint32_t now)
+{
+	if (sensors_deadband_check(d, ch, value, now) == SENSORS_DEADBAND_NONE) {
+		return false;
+	}
+	sensors_deadband_reported(d, ch, value, now);
+	return true;
+}
+
+int sensors_deadband_from_json(sensors_deadband_t* d, const cJSON* obj)
+{
+	const cJSON* cfg;
+	int n = 0;
+
+	if (!sensors_deadband_valid_object(obj)) {
+		return -1;
+	}
+	cJSON_ArrayForEach(cfg, obj) {
+		sensors_deadband_apply(&d->ch[sensors_channel_find(cfg->string)].config, cfg);
+		n++;
+	}
+	return n;
+}
+
+int sensors_deadband_stage(sensors_deadband_t* d, const cJSON* obj)
+{
+	cJSON* copy;
+	cJSON* none = NULL;
+
+	if (!sensors_deadband_valid_object(obj)) {
+		return -1;
+	}
+	copy = cJSON_Duplicate(obj, true);
+	if (copy == NULL) {
+		return -2;
+	}
+	/* the copy is complete before the task of the checks sees it (release), and is its own after */
+	if (!atomic_compare_exchange_strong_explicit(&d->staged, &none, copy, memory_order_release,
+			memory_order_relaxed)) {
+		cJSON_Delete(copy);
+		return -2;
+	}
+	return cJSON_GetArraySize(obj);
+}
+
+int sensors_deadband_update(sensors_deadband_t* d)
+{
+	cJSON* staged;
+	int n;
+
+	if (atomic_load_explicit(&d->staged, memory_order_relaxed) == NULL) {
+		return 0;
+	}
+	staged = atomic_exchange_explicit(&d->staged, NULL, memory_order_acquire);
+	n = sensors_deadband_from_json(d, staged);
+	cJSON_Delete(staged);
+	return n;
+}
+
+cJSON* sensors_deadband_to_json(const sensors_deadband_t* d)
+{
+	const sensors_deadband_channel_t* c;
+	cJSON *root = cJSON_CreateObject();
+	cJSON *item;
+	int ch;
+
+	for (ch = 0; (root != NULL) && (ch < SENSOR_CH_COUNT); ++ch) {
+		c = &d->ch[ch];
+		item = cJSON_AddObjectToObject(root, sensors_channel_name((sensor_channel_t)ch));
+		if ((item == NULL)
+				|| (cJSON_AddNumberToObject(item, "abs", c->config.abs) == NULL)
+				|| (cJSON_AddNumberToObject(item, "rel", c->config.rel) == NULL)
+				|| (cJSON_AddNumberToObject(item, "heartbeat_ms", c->config.heartbeat_ms) == NULL)
+				|| (cJSON_AddNumberToObject(item, "min_interval_ms", c->config.min_interval_ms) == NULL)
+				|| (cJSON_AddNumberToObject(item, "reports", c->reports) == NULL)
+				|| (cJSON_AddNumberToObject(item, "heartbeats", c->heartbeats) == NULL)
+				|| (cJSON_AddNumberToObject(item, "suppressed", c->suppressed) == NULL)
+				|| (cJSON_AddNumberToObject(item, "limited", c->limited) == NULL)) {
+			cJSON_Delete(root);
+			root = NULL;
+		}
+	}
+	return root;
+}
@@ -0,0 +1,112 @@
+/*
+ * sensors_deadband.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Daruin Solano
+ *
+ *  Report by exception of the sensor channels, between the sampling and the
+ *  publication: a value goes out when it changed, not on every sample. The
+ *  environmental channels barely move between two samples, most of their
+ *  reports are dropped.
+ *
+ *  Per channel, a value is reported when:
+ *  - it is the first one;
+ *  - it moved out of the deadband of the last value reported: by config.abs
+ *    or more, or by config.rel of it or more (0.02: 2%); neither set, every
+ *    value is reported;
+ *  - the channel has been silent for config.heartbeat_ms: the receiver tells
+ *    a steady value from a dead device;
+ *  and not sooner than config.min_interval_ms after the last report (rate
+ *  limit): a noisy or fast changing channel is reported at most that often.
+ *
+ *  A report carrying several channels asks each of them, then records the
+ *  values sent:
+ *
+ *    if (sensors_deadband_check(&db, SENSOR_CH_TEMPERATURE, t, now)
+ *        | sensors_deadband_check(&db, SENSOR_CH_HUMIDITY, h, now)) {
+ *      sensors_deadband_reported(&db, SENSOR_CH_TEMPERATURE, t, now);
+ *      sensors_deadband_reported(&db, SENSOR_CH_HUMIDITY, h, now);
+ *      ... publish t and h ...
+ *    }
+ *
+ *  The configuration changes at runtime, from the REST API or an MQTT
+ *  message, as the JSON object of sensors_deadband_from_json():
+ *
+ *    { "temperature": { "abs": 0.3, "heartbeat_ms": 600000, "min_interval_ms": 5000 },
+ *      "humidity": { "rel": 0.02 } }
+ *
+ *  Not thread-safe, but for the staging: another task, e.g. the REST API,
+ *  hands its configuration with sensors_deadband_stage(), and the task of
+ *  the checks applies it between two checks with sensors_deadband_update().
+ */
+
+#ifndef SENSORS_SENSORS_DEADBAND_H_
+#define SENSORS_SENSORS_DEADBAND_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include "sensors_sampling.h"
+#include "cJSON.h"
+
+typedef enum {
+  SENSORS_DEADBAND_NONE = 0,    /**< Not to be reported. */
+  SENSORS_DEADBAND_FIRST,
+  SENSORS_DEADBAND_CHANGE,
+  SENSORS_DEADBAND_HEARTBEAT,
+} sensors_deadband_reason_t;
+
+typedef struct {
+  float abs;                    /**< Deadband in units of the channel; 0: none. */
+  float rel;                    /**< Deadband as a fraction of the last value reported; 0: none. */
+  uint32_t heartbeat_ms;        /**< Longest silence; 0: none. */
+  uint32_t min_interval_ms;     /**< Shortest time between two reports; 0: none. */
+} sensors_deadband_config_t;
+
+typedef struct {
+  sensors_deadband_config_t config;
+  float last;                   /**< Last value reported... */
+  uint32_t last_tick;           /**< ... and when, ms. */
+  bool reported;                /**< A value was reported. */
+  /* Metrics */
+  uint32_t reports;
+  uint32_t heartbeats;          /**< Silences over: reports due to the heartbeat. */
+  uint32_t suppressed;          /**< Values within the deadband. */
+  uint32_t limited;             /**< Changes held back by the rate limit. */
+} sensors_deadband_channel_t;
+
+typedef struct {
+  sensors_deadband_channel_t ch[SENSOR_CH_COUNT];
+  _Atomic(cJSON*) staged;       /**< Configuration of another task, not applied yet. */
+} sensors_deadband_t;
+
+/** Every channel without deadband, heartbeat nor rate limit: every value reported. */
+void sensors_deadband_init(sensors_deadband_t* d);
+
+void sensors_deadband_set(sensors_deadband_t* d, sensor_channel_t ch, const sensors_deadband_config_t* config);
+
+/** Is the value of the channel to be reported now? Counts the values held back. */
+sensors_deadband_reason_t sensors_deadband_check(sensors_deadband_t* d, sensor_channel_t ch, float value, uint32_t now);
+
+/** The value of the channel was reported: the deadband and the timers restart from it. */
+void sensors_deadband_reported(sensors_deadband_t* d, sensor_channel_t ch, float value, uint32_t now);
+
+/** Check and, if to be reported, record the value. @return true if to be reported */
+bool sensors_deadband_filter(sensors_deadband_t* d, sensor_channel_t ch, float value, uint32_t now);
+
+/** Configure the channels of obj, by name; the members not given are kept. Nothing is changed
+ *  unless the whole object is valid. @return the channels configured, or -1 */
+int  sensors_deadband_from_json(sensors_deadband_t* d, const cJSON* obj);
+
+/** Any task: a copy of obj, as sensors_deadband_from_json() takes it, applied by the next
+ *  sensors_deadband_update(). @return the channels given, -1 if obj is not valid, or -2 if a
+ *  configuration is staged already or out of memory: nothing staged */
+int  sensors_deadband_stage(sensors_deadband_t* d, const cJSON* obj);
+
+/** Task of the checks: apply the configuration staged, if any. @return the channels configured */
+int  sensors_deadband_update(sensors_deadband_t* d);
+
+/** Configuration and metrics of the channels, as an object by name; NULL if out of memory. */
+cJSON* sensors_deadband_to_json(const sensors_deadband_t* d);
+
+#endif /* SENSORS_SENSORS_DEADBAND_H_ */
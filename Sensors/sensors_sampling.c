@@ -0,0 +1,301 @@
+/*
+ * sensors_sampling.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Daruin Solano
+ */
+
+#include <string.h>
+#include "sensors_sampling.h"
+#if defined(SENSORS_TASK)
+#include "cmsis_os.h"
+#endif
+
+#define SENSORS_RING_MASK       (SENSORS_RING_SIZE - 1)
+
+/* Order of the accesses shared with the readers: a dmb on the Cortex-M. */
+#define SENSORS_BARRIER()       __sync_synchronize()
+
+#if (SENSORS_RING_SIZE & SENSORS_RING_MASK) != 0
+#error "SENSORS_RING_SIZE must be a power of 2"
+#endif
+
+typedef struct {
+  sensor_sample_t ring[SENSORS_RING_SIZE];
+  volatile uint32_t head;       /* Samples written: the last one at (head - 1) & SENSORS_RING_MASK. */
+} sensor_ring_t;
+
+typedef struct {
+  uint32_t period_ms;
+  uint16_t decimation;
+  uint32_t next_tick;           /* Time of the next read. */
+  float sum[SENSORS_MAX_SOURCE_CHANNELS];
+  uint16_t reads;               /* Reads in the sum. */
+  sensors_source_stats_t stats;
+} sensor_source_state_t;
+
+/* Private variables ---------------------------------------------------------*/
+
+static const sensor_source_t* sources;
+static size_t source_count;
+static uint32_t (*tick_ms)(void);
+static sensor_source_state_t state[SENSORS_MAX_SOURCES];
+static sensor_ring_t rings[SENSOR_CH_COUNT];
+
+/* Last sample of every channel, under a sequence lock: odd while written. */
+static sensors_snapshot_t last;
+static volatile uint32_t last_seq;
+
+static const char* const channel_names[SENSOR_CH_COUNT] = {
+	"temperature", "humidity", "pressure",
+	"acc_x", "acc_y", "acc_z",
+	"gyr_x", "gyr_y", "gyr_z",
+	"mag_x", "mag_y", "mag_z",
+};
+
+#if defined(SENSORS_TASK)
+const osThreadAttr_t sensorsTask_attributes = {
+  .name = "sensorsTask",
+  .stack_size = 256 * 4,
+  .priority = (osPriority_t) osPriorityAboveNormal
+};
+osThreadId_t sensorsTaskHandle;
+#endif
+
+/* Private functions ---------------------------------------------------------*/
+
+/* Push the samples of a source into its rings and the snapshot. */
+static void sensors_push(const sensor_source_t* src, const float* values, uint32_t now)
+{
+	sensor_ring_t* ring;
+	uint8_t i, ch;
+
+	last_seq++;
+	SENSORS_BARRIER();
+	for (i = 0; i < src->channels; ++i) {
+		ch = src->first_channel + i;
+		ring = &rings[ch];
+		ring->ring[ring->head & SENSORS_RING_MASK].value = values[i];
+		ring->ring[ring->head & SENSORS_RING_MASK].tick = now;
+		last.value[ch] = values[i];
+		last.tick[ch] = now;
+		last.valid |= (1u << ch);
+	}
+	SENSORS_BARRIER();
+	for (i = 0; i < src->channels; ++i) {
+		rings[src->first_channel + i].head++;
+	}
+	last_seq++;
+}
+
+/* Read a due source; every decimation reads, their mean is a sample. */
+static void sensors_acquire(size_t n, uint32_t now)
+{
+	const sensor_source_t* src = &sources[n];
+	sensor_source_state_t* st = &state[n];
+	float values[SENSORS_MAX_SOURCE_CHANNELS];
+	uint32_t elapsed;
+	uint8_t i;
+
+	st->stats.reads++;
+	if (src->read(values) != 0) {
+		st->stats.errors++;
+		return;
+	}
+	elapsed = tick_ms() - now;
+	if (elapsed > st->stats.max_read_ms) {
+		st->stats.max_read_ms = elapsed;
+	}
+
+	for (i = 0; i < src->channels; ++i) {
+		st->sum[i] += values[i];
+	}
+	if (++st->reads < st->decimation) {
+		return;
+	}
+	for (i = 0; i < src->channels; ++i) {
+		values[i] = st->sum[i] / (float)st->reads;
+		st->sum[i] = 0.0f;
+	}
+	st->reads = 0;
+	sensors_push(src, values, now);
+}
+
+#if defined(SENSORS_TASK)
+static void sensors_task(void* argument)
+{
+	(void)argument;
+
+	for (;;) {
+		osDelay(sensors_sampling_poll());
+	}
+}
+#endif
+
+/* Exported functions --------------------------------------------------------*/
+
+int sensors_sampling_init(const sensor_source_t* table, size_t count, uint32_t (*tick)(void))
+{
+	size_t n;
+	uint32_t now;
+
+	if (count > SENSORS_MAX_SOURCES) {
+		return -1;
+	}
+	for (n = 0; n < count; ++n) {
+		if ((table[n].channels == 0) || (table[n].channels > SENSORS_MAX_SOURCE_CHANNELS)
+				|| (table[n].first_channel + table[n].channels > SENSOR_CH_COUNT)) {
+			return -1;
+		}
+	}
+
+	memset(state, 0, sizeof(state));
+	memset(rings, 0, sizeof(rings));
+	memset(&last, 0, sizeof(last));
+	sources = table;
+	source_count = count;
+	tick_ms = tick;
+	now = tick();
+	for (n = 0; n < count; ++n) {
+		state[n].period_ms = table[n].period_ms;
+		state[n].decimation = (table[n].decimation != 0) ? table[n].decimation : 1;
+		state[n].next_tick = now;
+	}
+	return 0;
+}
+
+void sensors_sampling_set_rate(size_t source, uint32_t period_ms, uint16_t decimation)
+{
+	sensor_source_state_t* st;
+
+	if (source >= source_count) {
+		return;
+	}
+	st = &state[source];
+	st->period_ms = period_ms;
+	st->decimation = (decimation != 0) ? decimation : 1;
+	memset(st->sum, 0, sizeof(st->sum));
+	st->reads = 0;
+	st->next_tick = tick_ms();
+}
+
+uint32_t sensors_sampling_poll(void)
+{
+	uint32_t now, wait = UINT32_MAX, left;
+	sensor_source_state_t* st;
+	size_t n;
+
+	for (n = 0; n < source_count; ++n) {
+		st = &state[n];
+		now = tick_ms();
+		if ((int32_t)(now - st->next_tick) >= 0) {
+			sensors_acquire(n, now);
+			st->next_tick += st->period_ms;
+			if ((int32_t)(now - st->next_tick) >= 0) {
+				/* a period or more behind: skip ahead rather than read in a burst */
+				st->stats.late++;
+				st->next_tick = now + st->period_ms;
+			}
+		}
+		left = st->next_tick - now;
+		if (left > st->period_ms) {
+			left = 0;
+		}
+		if (left < wait) {
+			wait = left;
+		}
+	}
+	return wait;
+}
+
+#if defined(SENSORS_TASK)
+int sensors_sampling_start_task(void)
+{
+	sensorsTaskHandle = osThreadNew(sensors_task, NULL, &sensorsTask_attributes);
+	return (sensorsTaskHandle != NULL) ? 0 : -1;
+}
+#endif
+
+void sensors_snapshot(sensors_snapshot_t* snap)
+{
+	uint32_t seq;
+
+	do {
+		seq = last_seq;
+		SENSORS_BARRIER();
+		memcpy(snap, &last, sizeof(*snap));
+		SENSORS_BARRIER();
+	} while ((seq & 1) || (seq != last_seq));
+}
+
+size_t sensors_read(sensor_channel_t ch, uint32_t* cursor, sensor_sample_t* out, size_t max)
+{
+	sensor_ring_t* ring;
+	uint32_t start, head, lost;
+	size_t n, i;
+
+	if (ch >= SENSOR_CH_COUNT) {
+		return 0;
+	}
+	ring = &rings[ch];
+	start = *cursor;
+	head = ring->head;
+	SENSORS_BARRIER();
+	/* readable: [head + 1 - SENSORS_RING_SIZE, head), the slot of head may be under write */
+	if (head - start > SENSORS_RING_SIZE - 1) {
+		start = head - SENSORS_RING_SIZE + 1;
+	}
+	n = head - start;
+	if (n > max) {
+		n = max;
+	}
+	for (i = 0; i < n; ++i) {
+		out[i] = ring->ring[(start + i) & SENSORS_RING_MASK];
+	}
+	SENSORS_BARRIER();
+
+	/* the samples overwritten while copied are dropped, and the one under write */
+	head = ring->head;
+	if (head - start >= SENSORS_RING_SIZE) {
+		lost = head - SENSORS_RING_SIZE + 1 - start;
+		if (lost >= n) {
+			lost = n;
+		}
+		memmove(out, out + lost, (n - lost) * sizeof(*out));
+		n -= lost;
+		start += lost;
+	}
+	*cursor = start + n;
+	return n;
+}
+
+uint32_t sensors_cursor(sensor_channel_t ch)
+{
+	return (ch < SENSOR_CH_COUNT) ? rings[ch].head : 0;
+}
+
+void sensors_sampling_stats(size_t source, sensors_source_stats_t* stats)
+{
+	if (source < source_count) {
+		*stats = state[source].stats;
+	} else {
+		memset(stats, 0, sizeof(*stats));
+	}
+}
+
+const char* sensors_channel_name(sensor_channel_t ch)
+{
+	return (ch < SENSOR_CH_COUNT) ? channel_names[ch] : "";
+}
+
+int sensors_channel_find(const char* name)
+{
+	int ch;
+
+	for (ch = 0; (name != NULL) && (ch < SENSOR_CH_COUNT); ++ch) {
+		if (strcmp(name, channel_names[ch]) == 0) {
+			return ch;
+		}
+	}
+	return -1;
+}
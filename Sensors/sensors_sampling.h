@@ -0,0 +1,125 @@
+/*
+ * sensors_sampling.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Daruin Solano
+ *
+ *  Background acquisition of the board sensors, out of the publish path.
+ *
+ *  Each source (a sensor on the I2C bus: one value, or x/y/z) is read at its
+ *  own period by sensors_sampling_poll(), from the task of the application
+ *  between two events, or from a task of its own (SENSORS_TASK builds,
+ *  sensors_sampling_start_task()). A source can average decimation reads
+ *  into one sample: a boxcar low-pass filter, then a decimation by the same
+ *  factor, e.g. the accelerometer read at 50 Hz and sampled at 10 Hz.
+ *
+ *  The samples go into a ring per channel, SENSORS_RING_SIZE deep, for the
+ *  consumers of the history (statistics, aggregation): sensors_read() copies
+ *  the samples after a cursor of the reader. The last sample of every
+ *  channel is also published as one snapshot: sensors_snapshot() returns
+ *  them without locking nor waiting on the bus, the x/y/z of a source from
+ *  the same sample and no value half written; the publishers no longer
+ *  depend on the latency of the bus.
+ *
+ *  One writer (the acquisition), any number of readers in other tasks: the
+ *  snapshot is a sequence lock, the readers retry if a round was written
+ *  meanwhile; the rings are read from their write count.
+ */
+
+#ifndef SENSORS_SENSORS_SAMPLING_H_
+#define SENSORS_SENSORS_SAMPLING_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#if !defined(SENSORS_RING_SIZE)
+#define SENSORS_RING_SIZE           64      /* redefinable - samples per channel, a power of 2 */
+#endif
+#if !defined(SENSORS_MAX_SOURCES)
+#define SENSORS_MAX_SOURCES         8       /* redefinable */
+#endif
+#define SENSORS_MAX_SOURCE_CHANNELS 3
+
+typedef enum {
+  SENSOR_CH_TEMPERATURE,
+  SENSOR_CH_HUMIDITY,
+  SENSOR_CH_PRESSURE,
+  SENSOR_CH_ACC_X,
+  SENSOR_CH_ACC_Y,
+  SENSOR_CH_ACC_Z,
+  SENSOR_CH_GYR_X,
+  SENSOR_CH_GYR_Y,
+  SENSOR_CH_GYR_Z,
+  SENSOR_CH_MAG_X,
+  SENSOR_CH_MAG_Y,
+  SENSOR_CH_MAG_Z,
+  SENSOR_CH_COUNT
+} sensor_channel_t;
+
+/** Bus read of a source: its values, channels of them. @return 0, or -1 on a bus error */
+typedef int (*sensor_read_fn_t)(float* values);
+
+typedef struct {
+  const char* name;
+  sensor_read_fn_t read;
+  uint8_t first_channel;        /**< sensor_channel_t of values[0], the others follow. */
+  uint8_t channels;             /**< Up to SENSORS_MAX_SOURCE_CHANNELS. */
+  uint16_t decimation;          /**< Reads averaged into a sample: 1, no filter. */
+  uint32_t period_ms;           /**< Between two reads. */
+} sensor_source_t;
+
+typedef struct {
+  float value;
+  uint32_t tick;                /**< Time of the last read of the sample, ms. */
+} sensor_sample_t;
+
+typedef struct {
+  float value[SENSOR_CH_COUNT];
+  uint32_t tick[SENSOR_CH_COUNT];
+  uint32_t valid;               /**< Bit per channel sampled at least once. */
+} sensors_snapshot_t;
+
+typedef struct {
+  uint32_t reads;
+  uint32_t errors;              /**< Reads failed: no sample from them. */
+  uint32_t late;                /**< Reads more than a period late: the acquisition skipped ahead. */
+  uint32_t max_read_ms;         /**< Longest bus read. */
+} sensors_source_stats_t;
+
+/** Sources of the acquisition, kept by reference; tick: time in ms, e.g. HAL_GetTick.
+ *  @return 0, or -1 if the table does not fit SENSORS_MAX_SOURCES and SENSOR_CH_COUNT */
+int  sensors_sampling_init(const sensor_source_t* sources, size_t count, uint32_t (*tick)(void));
+
+/** Change the period and the decimation of a source; the filter restarts. */
+void sensors_sampling_set_rate(size_t source, uint32_t period_ms, uint16_t decimation);
+
+/** Read the sources that are due. @return the time until the next one, ms */
+uint32_t sensors_sampling_poll(void);
+
+#if defined(SENSORS_TASK)
+/** Acquire from a task of its own, instead of sensors_sampling_poll() calls. @return 0, -1 on failure */
+int  sensors_sampling_start_task(void);
+#endif
+
+/** Last sample of every channel. Never blocks. */
+void sensors_snapshot(sensors_snapshot_t* snap);
+
+/** Copy up to max samples of the channel written after *cursor, oldest first, and advance it.
+ *  A reader that falls more than SENSORS_RING_SIZE - 1 behind loses the oldest ones: the slot of
+ *  the sample being written is not read.
+ *  Start with *cursor = sensors_cursor(ch) for the samples to come. @return the samples copied */
+size_t sensors_read(sensor_channel_t ch, uint32_t* cursor, sensor_sample_t* out, size_t max);
+
+/** Write count of the channel: the cursor of the next sample. */
+uint32_t sensors_cursor(sensor_channel_t ch);
+
+void sensors_sampling_stats(size_t source, sensors_source_stats_t* stats);
+
+/** Name of a channel in the payloads and the configurations: "temperature", "acc_x", ... */
+const char* sensors_channel_name(sensor_channel_t ch);
+
+/** @return the channel of a name, or -1 if none */
+int  sensors_channel_find(const char* name);
+
+#endif /* SENSORS_SENSORS_SAMPLING_H_ */
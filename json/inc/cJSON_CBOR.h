@@ -0,0 +1,30 @@
+/*
+ * cJSON_CBOR.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Daruin Solano
+ *
+ *  cJSON trees to and from CBOR (cbor.h), e.g. the REST bodies of the
+ *  clients that negotiate application/cbor.
+ *
+ *  Numbers: the integral ones are written as CBOR integers, the others as
+ *  floats in the shortest exact precision. Decoding: integer map keys become
+ *  their decimal string, tags are ignored, undefined is null; byte strings,
+ *  and keys of other types, are refused.
+ */
+
+#ifndef JSON_INC_CJSON_CBOR_H_
+#define JSON_INC_CJSON_CBOR_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include "cJSON.h"
+
+/** Encode item into buf, of size bytes; buf NULL: only measure the encoding.
+ *  @return the length of the encoding, or -1 if it did not fit or item holds a raw value */
+int cJSON_ToCBOR(const cJSON* item, uint8_t* buf, size_t size);
+
+/** Decode one data item, the whole of buf. @return the tree, to cJSON_Delete(), or NULL if malformed */
+cJSON* cJSON_FromCBOR(const void* buf, size_t len);
+
+#endif /* JSON_INC_CJSON_CBOR_H_ */
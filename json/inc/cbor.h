@@ -0,0 +1,119 @@
+/*
+ * cbor.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Daruin Solano
+ *
+ *  CBOR (RFC 8949) encoder and decoder for the telemetry and REST payloads:
+ *  the same data model as JSON, in binary. The numbers take 1 to 9 bytes,
+ *  the strings carry their length instead of quotes and escapes, so that a
+ *  message is typically 30 to 50% smaller than its compact JSON.
+ *
+ *  - cbor_writer_t: streaming encoder into a caller buffer, no heap. With a
+ *    NULL buffer it only measures the encoding.
+ *  - cbor_reader_t: pull decoder, one data item header at a time; the
+ *    strings are returned as pointers into the input.
+ *  - cJSON_ToCBOR() / cJSON_FromCBOR() (cJSON_CBOR.h): cJSON trees.
+ *  - json_writer_init_cbor() (json_writer.h): the schema-driven telemetry
+ *    writer, CBOR instead of JSON with the same calls.
+ *
+ *  The floats are written in the shortest of half, single and double
+ *  precision that holds the value exactly. Indefinite-length strings are
+ *  not decoded.
+ */
+
+#ifndef JSON_INC_CBOR_H_
+#define JSON_INC_CBOR_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#define CBOR_HEAD_MAX           9       /**< Longest encoded head or float. */
+#define CBOR_INDEFINITE         SIZE_MAX /**< cbor_item_t.count of an indefinite-length array or map. */
+
+/* Major types */
+#define CBOR_MAJOR_UINT         0
+#define CBOR_MAJOR_NEGINT       1
+#define CBOR_MAJOR_BYTES        2
+#define CBOR_MAJOR_TEXT         3
+#define CBOR_MAJOR_ARRAY        4
+#define CBOR_MAJOR_MAP          5
+#define CBOR_MAJOR_TAG          6
+#define CBOR_MAJOR_SIMPLE       7
+
+#define CBOR_FALSE              0xF4
+#define CBOR_TRUE               0xF5
+#define CBOR_NULL               0xF6
+#define CBOR_BREAK              0xFF
+#define CBOR_ARRAY_INDEFINITE   0x9F
+#define CBOR_MAP_INDEFINITE     0xBF
+
+typedef enum {
+	CBOR_ITEM_UINT,
+	CBOR_ITEM_NEGINT,       /**< value: -1 - u */
+	CBOR_ITEM_BYTES,
+	CBOR_ITEM_TEXT,
+	CBOR_ITEM_ARRAY,
+	CBOR_ITEM_MAP,
+	CBOR_ITEM_TAG,          /**< u: tag number, the tagged item follows */
+	CBOR_ITEM_FALSE,
+	CBOR_ITEM_TRUE,
+	CBOR_ITEM_NULL,
+	CBOR_ITEM_UNDEFINED,
+	CBOR_ITEM_FLOAT,
+	CBOR_ITEM_BREAK,        /**< end of an indefinite-length array or map */
+} cbor_item_type_t;
+
+typedef struct {
+	cbor_item_type_t type;
+	uint64_t u;               /**< UINT, NEGINT, TAG */
+	double f;                 /**< FLOAT */
+	const uint8_t* str;       /**< BYTES, TEXT: into the input, not \0 terminated */
+	size_t count;             /**< BYTES, TEXT: bytes; ARRAY: items; MAP: pairs; or CBOR_INDEFINITE */
+} cbor_item_t;
+
+typedef struct {
+	uint8_t* buf;             /**< NULL: measure only */
+	size_t size;
+	size_t len;               /**< Written (or measured) so far. */
+	bool overflow;            /**< The encoding did not fit: cbor_writer_end() fails. */
+} cbor_writer_t;
+
+typedef struct {
+	const uint8_t* p;
+	const uint8_t* end;
+	bool error;               /**< Malformed or truncated input: all reads fail from then on. */
+} cbor_reader_t;
+
+/** Head of a data item: major type and argument. @return its length, up to CBOR_HEAD_MAX */
+size_t cbor_encode_head(uint8_t* out, uint8_t major, uint64_t value);
+
+/** Float in the shortest exact precision. @return its length, up to CBOR_HEAD_MAX */
+size_t cbor_encode_float(uint8_t* out, double value);
+
+/** Encode into buf, of size bytes; buf NULL: measure only. */
+void cbor_writer_init(cbor_writer_t* w, uint8_t* buf, size_t size);
+
+/** @return the length of the encoding, or -1 if it did not fit in the buffer */
+int  cbor_writer_end(const cbor_writer_t* w);
+
+void cbor_write_uint(cbor_writer_t* w, uint64_t value);
+void cbor_write_int(cbor_writer_t* w, int64_t value);
+void cbor_write_float(cbor_writer_t* w, double value);
+void cbor_write_bool(cbor_writer_t* w, bool value);
+void cbor_write_null(cbor_writer_t* w);
+void cbor_write_text(cbor_writer_t* w, const char* s, size_t len);
+void cbor_write_bytes(cbor_writer_t* w, const void* data, size_t len);
+/** Array of count items, or map of count key/value pairs, that follow; CBOR_INDEFINITE: closed by cbor_write_break(). */
+void cbor_write_array(cbor_writer_t* w, size_t count);
+void cbor_write_map(cbor_writer_t* w, size_t count);
+void cbor_write_break(cbor_writer_t* w);
+
+void cbor_reader_init(cbor_reader_t* r, const void* buf, size_t len);
+
+/** Read the next data item header; the content of arrays and maps follows as items of their own.
+ *  @return false at the end of the input or on an error (r->error) */
+bool cbor_read(cbor_reader_t* r, cbor_item_t* item);
+
+#endif /* JSON_INC_CBOR_H_ */
@@ -0,0 +1,116 @@
+/*
+ * json_writer.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Daruin Solano
+ *
+ *  Compact JSON serializer for the telemetry records: one flat object of
+ *  scalars (and arrays of scalars), written straight into a caller buffer,
+ *  with no heap and no tree. It replaces the cJSON_CreateObject() /
+ *  cJSON_Add*ToObject() / cJSON_Print() sequence of the publish paths.
+ *
+ *  The members of a C record can be described once by a schema, a table of
+ *  json_field_t (key, type, offset in the record):
+ *
+ *    static const json_field_t status_fields[] = {
+ *      JSON_FIELD(status_data_t, LedOn, "LedOn", JSON_FIELD_BOOL),
+ *      JSON_FIELD(status_data_t, TelemetryInterval, "TelemetryInterval", JSON_FIELD_UINT32),
+ *    };
+ *
+ *    json_writer_t w;
+ *    json_writer_init(&w, buf, sizeof(buf));
+ *    json_write_fields(&w, status_fields, JSON_FIELDS(status_fields), &status_data);
+ *    json_write_int(&w, "Temperature", t);
+ *    len = json_writer_end(&w);   -> {"LedOn":true,"TelemetryInterval":60000,"Temperature":72}
+ *
+ *  A batch of records goes out as an array of objects, the members shared by
+ *  the batch written once around it:
+ *
+ *    json_write_string(&w, "ID", id);
+ *    json_write_records(&w, "samples", sample_fields, JSON_FIELDS(sample_fields),
+ *                       samples, sizeof(samples[0]), n);
+ *                                 -> {"ID":"IOT_STM32","samples":[{"dt":0,...},{"dt":1000,...}]}
+ *
+ *  The floats are written with a fixed number of decimals, trailing zeros
+ *  removed, without printf (no float support needed in the C library);
+ *  NaN, infinities and values beyond +/-2^63 / 10^decimals are written as
+ *  null. The strings are escaped.
+ *
+ *  json_writer_init_cbor() writes the same object in CBOR (cbor.h) with the
+ *  same calls: a map of indefinite length, the floats rounded to their
+ *  decimals then written as integers when integral, else in half or single
+ *  precision. The payload format is a choice of the writer init only.
+ */
+
+#ifndef JSON_INC_JSON_WRITER_H_
+#define JSON_INC_JSON_WRITER_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#define JSON_FLOAT_DECIMALS_MAX   6
+
+typedef enum {
+	JSON_FIELD_STRING,      /**< char array member, \0 terminated */
+	JSON_FIELD_STRPTR,      /**< const char* member, NULL: null */
+	JSON_FIELD_BOOL,        /**< bool member */
+	JSON_FIELD_INT16,
+	JSON_FIELD_INT32,
+	JSON_FIELD_UINT32,
+	JSON_FIELD_FLOAT,       /**< float member, with json_field_t.decimals */
+} json_field_type_t;
+
+typedef struct {
+	const char* key;
+	uint16_t offset;          /**< of the member in the record */
+	uint8_t type;             /**< json_field_type_t */
+	uint8_t count;            /**< 0: scalar, else array of count elements */
+	uint8_t decimals;         /**< JSON_FIELD_FLOAT: digits after the point, up to JSON_FLOAT_DECIMALS_MAX */
+} json_field_t;
+
+/** Scalar member of a record. */
+#define JSON_FIELD(record, member, key, type) \
+	{ (key), (uint16_t)offsetof(record, member), (uint8_t)(type), 0, 0 }
+/** Float member, written with decimals digits after the point. */
+#define JSON_FIELD_DEC(record, member, key, decimals) \
+	{ (key), (uint16_t)offsetof(record, member), (uint8_t)JSON_FIELD_FLOAT, 0, (uint8_t)(decimals) }
+/** Array member of numbers or bools, written as a JSON array; decimals is ignored but for JSON_FIELD_FLOAT. */
+#define JSON_FIELD_ARRAY(record, member, key, type, decimals) \
+	{ (key), (uint16_t)offsetof(record, member), (uint8_t)(type), \
+	  (uint8_t)(sizeof(((record*)0)->member) / sizeof(((record*)0)->member[0])), (uint8_t)(decimals) }
+/** Number of fields of a schema table. */
+#define JSON_FIELDS(table)        (sizeof(table) / sizeof((table)[0]))
+
+typedef struct {
+	char* buf;
+	size_t size;
+	size_t len;               /**< Written so far, \0 excluded. */
+	bool overflow;            /**< The object did not fit: json_writer_end() fails. */
+	bool first;               /**< No member written yet. */
+	bool cbor;                /**< CBOR instead of JSON, see json_writer_init_cbor() */
+} json_writer_t;
+
+/** Start an object in buf, of at most size bytes with its \0. */
+void json_writer_init(json_writer_t* w, char* buf, size_t size);
+
+/** Start a CBOR map in buf, of at most size bytes: the json_write_*() calls write its members. */
+void json_writer_init_cbor(json_writer_t* w, char* buf, size_t size);
+
+/** Close the object. @return its length (JSON: \0 excluded), or -1 if it did not fit in the buffer */
+int  json_writer_end(json_writer_t* w);
+
+void json_write_string(json_writer_t* w, const char* key, const char* value);
+void json_write_bool(json_writer_t* w, const char* key, bool value);
+void json_write_int(json_writer_t* w, const char* key, int32_t value);
+void json_write_uint(json_writer_t* w, const char* key, uint32_t value);
+void json_write_float(json_writer_t* w, const char* key, float value, int decimals);
+
+/** Write the members of a record described by a schema, in the order of the table. */
+void json_write_fields(json_writer_t* w, const json_field_t* fields, size_t count, const void* record);
+
+/** Write n records, stride bytes apart, as an array of objects of the members described by the schema. */
+void json_write_records(json_writer_t* w, const char* key, const json_field_t* fields, size_t count,
+		const void* records, size_t stride, size_t n);
+
+#endif /* JSON_INC_JSON_WRITER_H_ */
@@ -0,0 +1,211 @@
+/*
+ * cJSON_CBOR.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Daruin Solano
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "cJSON_CBOR.h"
+#include "cbor.h"
+
+/* Private functions ---------------------------------------------------------*/
+
+static bool cbor_from_json(cbor_writer_t* w, const cJSON* item)
+{
+	const cJSON* child;
+	double d;
+
+	if (cJSON_IsFalse(item) || cJSON_IsTrue(item)) {
+		cbor_write_bool(w, cJSON_IsTrue(item));
+	} else if (cJSON_IsNull(item)) {
+		cbor_write_null(w);
+	} else if (cJSON_IsNumber(item)) {
+		d = item->valuedouble;
+		/* integral within the int64 range: an integer, else a float */
+		if ((d >= -9.2e18) && (d <= 9.2e18) && (d == (double)(int64_t)d)) {
+			cbor_write_int(w, (int64_t)d);
+		} else {
+			cbor_write_float(w, d);
+		}
+	} else if (cJSON_IsString(item)) {
+		cbor_write_text(w, item->valuestring, strlen(item->valuestring));
+	} else if (cJSON_IsArray(item) || cJSON_IsObject(item)) {
+		if (cJSON_IsArray(item)) {
+			cbor_write_array(w, (size_t)cJSON_GetArraySize(item));
+		} else {
+			cbor_write_map(w, (size_t)cJSON_GetArraySize(item));
+		}
+		cJSON_ArrayForEach(child, item) {
+			if (cJSON_IsObject(item)) {
+				cbor_write_text(w, child->string, strlen(child->string));
+			}
+			if (!cbor_from_json(w, child)) {
+				return false;
+			}
+		}
+	} else {
+		return false;	/* raw or invalid */
+	}
+	return true;
+}
+
+/* \0 terminated copy of a string of the input, or decimal string of an integer key. */
+static char* json_string_of(const cbor_item_t* it)
+{
+	char num[24];
+	const char* s = (const char*)it->str;
+	size_t len = it->count;
+	char* out;
+
+	if (it->type == CBOR_ITEM_UINT) {
+		len = (size_t)snprintf(num, sizeof(num), "%llu", (unsigned long long)it->u);
+		s = num;
+	} else if (it->type == CBOR_ITEM_NEGINT) {
+		len = (size_t)snprintf(num, sizeof(num), "-%llu", (unsigned long long)it->u + 1);
+		s = num;
+	} else if (it->type != CBOR_ITEM_TEXT) {
+		return NULL;
+	}
+	out = (char*)cJSON_malloc(len + 1);
+	if (out != NULL) {
+		memcpy(out, s, len);
+		out[len] = '\0';
+	}
+	return out;
+}
+
+static cJSON* json_from_cbor(cbor_reader_t* r, cbor_item_t* it, int depth);
+
+/* Items of an array, or pairs of a map, up to the count or the break. */
+static cJSON* json_container(cbor_reader_t* r, const cbor_item_t* head, int depth)
+{
+	bool map = (head->type == CBOR_ITEM_MAP);
+	cJSON* c = map ? cJSON_CreateObject() : cJSON_CreateArray();
+	cbor_item_t it;
+	size_t i;
+
+	for (i = 0; (c != NULL) && ((head->count == CBOR_INDEFINITE) || (i < head->count)); ++i) {
+		char* key = NULL;
+		cJSON* value;
+
+		if (!cbor_read(r, &it)) {
+			break;
+		}
+		if (it.type == CBOR_ITEM_BREAK) {
+			if (head->count == CBOR_INDEFINITE) {
+				return c;
+			}
+			break;
+		}
+		if (map) {
+			key = json_string_of(&it);
+			if ((key == NULL) || !cbor_read(r, &it)) {
+				cJSON_free(key);
+				break;
+			}
+		}
+		value = json_from_cbor(r, &it, depth + 1);
+		if (value == NULL) {
+			cJSON_free(key);
+			break;
+		}
+		if (map) {
+			cJSON_AddItemToObject(c, key, value);
+			cJSON_free(key);
+		} else {
+			cJSON_AddItemToArray(c, value);
+		}
+	}
+	if ((c != NULL) && (head->count != CBOR_INDEFINITE) && (i == head->count)) {
+		return c;
+	}
+	cJSON_Delete(c);
+	return NULL;
+}
+
+static cJSON* json_from_cbor(cbor_reader_t* r, cbor_item_t* it, int depth)
+{
+	cJSON* item = NULL;
+	char* s;
+
+	if (depth > CJSON_NESTING_LIMIT) {
+		return NULL;
+	}
+	while (it->type == CBOR_ITEM_TAG) {
+		if (!cbor_read(r, it)) {
+			return NULL;
+		}
+	}
+
+	switch (it->type) {
+	case CBOR_ITEM_UINT:
+		item = cJSON_CreateNumber((double)it->u);
+		break;
+	case CBOR_ITEM_NEGINT:
+		item = cJSON_CreateNumber(-1.0 - (double)it->u);
+		break;
+	case CBOR_ITEM_FLOAT:
+		item = cJSON_CreateNumber(it->f);
+		break;
+	case CBOR_ITEM_FALSE:
+		item = cJSON_CreateFalse();
+		break;
+	case CBOR_ITEM_TRUE:
+		item = cJSON_CreateTrue();
+		break;
+	case CBOR_ITEM_NULL:
+	case CBOR_ITEM_UNDEFINED:
+		item = cJSON_CreateNull();
+		break;
+	case CBOR_ITEM_TEXT:
+		s = json_string_of(it);
+		if (s != NULL) {
+			item = cJSON_CreateString(s);
+			cJSON_free(s);
+		}
+		break;
+	case CBOR_ITEM_ARRAY:
+	case CBOR_ITEM_MAP:
+		item = json_container(r, it, depth);
+		break;
+	default:
+		break;	/* byte strings, stray break */
+	}
+	return item;
+}
+
+/* Exported functions --------------------------------------------------------*/
+
+int cJSON_ToCBOR(const cJSON* item, uint8_t* buf, size_t size)
+{
+	cbor_writer_t w;
+
+	if (item == NULL) {
+		return -1;
+	}
+	cbor_writer_init(&w, buf, size);
+	if (!cbor_from_json(&w, item)) {
+		return -1;
+	}
+	return cbor_writer_end(&w);
+}
+
+cJSON* cJSON_FromCBOR(const void* buf, size_t len)
+{
+	cbor_reader_t r;
+	cbor_item_t it;
+	cJSON* item;
+
+	cbor_reader_init(&r, buf, len);
+	if (!cbor_read(&r, &it)) {
+		return NULL;
+	}
+	item = json_from_cbor(&r, &it, 0);
+	if ((item != NULL) && (r.error || (r.p != r.end))) {
+		cJSON_Delete(item);	/* trailing bytes */
+		item = NULL;
+	}
+	return item;
+}
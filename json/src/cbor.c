@@ -0,0 +1,387 @@
+/*
+ * cbor.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Daruin Solano
+ */
+
+#include <string.h>
+#include "cbor.h"
+
+/* Private functions ---------------------------------------------------------*/
+
+static void cbor_be(uint8_t* out, uint64_t v, size_t n)
+{
+	while (n > 0) {
+		out[--n] = (uint8_t)v;
+		v >>= 8;
+	}
+}
+
+static uint64_t cbor_from_be(const uint8_t* in, size_t n)
+{
+	uint64_t v = 0;
+
+	while (n-- > 0) {
+		v = (v << 8) | *in++;
+	}
+	return v;
+}
+
+/* Half precision of f, if it holds f exactly (NaN: the canonical one). */
+static bool cbor_half(float f, uint16_t* h)
+{
+	uint32_t b, mant, full;
+	uint16_t sign;
+	int e;
+
+	memcpy(&b, &f, sizeof(b));
+	sign = (uint16_t)((b >> 16) & 0x8000);
+	mant = b & 0x7FFFFF;
+	e = (int)((b >> 23) & 0xFF);
+
+	if (e == 0xFF) {
+		*h = sign | 0x7C00 | ((mant != 0) ? 0x200 : 0);
+		return true;
+	}
+	if ((e == 0) && (mant == 0)) {
+		*h = sign;
+		return true;
+	}
+	if (e == 0) {
+		return false;	/* single subnormal: below the half range */
+	}
+	e -= 127;
+	if (e > 15) {
+		return false;
+	}
+	if (e >= -14) {
+		if ((mant & 0x1FFF) != 0) {
+			return false;
+		}
+		*h = sign | (uint16_t)((e + 15) << 10) | (uint16_t)(mant >> 13);
+		return true;
+	}
+	if (e >= -24) {
+		/* half subnormal: m * 2^-24 */
+		full = mant | 0x800000;
+		if ((full & ((1u << (-e - 1)) - 1)) != 0) {
+			return false;
+		}
+		*h = sign | (uint16_t)(full >> (-e - 1));
+		return true;
+	}
+	return false;
+}
+
+static float cbor_half_to_float(uint16_t h)
+{
+	uint32_t sign = (uint32_t)(h & 0x8000) << 16;
+	uint32_t e = (h >> 10) & 0x1F;
+	uint32_t mant = h & 0x3FF;
+	uint32_t b;
+	float f;
+
+	if (e == 0) {
+		f = (float)mant * (1.0f / 16777216.0f);
+		return (sign != 0) ? -f : f;
+	}
+	if (e == 0x1F) {
+		b = sign | 0x7F800000 | (mant << 13);
+	} else {
+		b = sign | ((e - 15 + 127) << 23) | (mant << 13);
+	}
+	memcpy(&f, &b, sizeof(f));
+	return f;
+}
+
+static void cbor_put(cbor_writer_t* w, const void* data, size_t n)
+{
+	if (w->overflow) {
+		return;
+	}
+	if (w->buf != NULL) {
+		if (w->len + n > w->size) {
+			w->overflow = true;
+			return;
+		}
+		memcpy(w->buf + w->len, data, n);
+	}
+	w->len += n;
+}
+
+static void cbor_put_head(cbor_writer_t* w, uint8_t major, uint64_t value)
+{
+	uint8_t head[CBOR_HEAD_MAX];
+
+	cbor_put(w, head, cbor_encode_head(head, major, value));
+}
+
+static void cbor_put_byte(cbor_writer_t* w, uint8_t b)
+{
+	cbor_put(w, &b, 1);
+}
+
+/* Argument of the head: ai 0..23 inline, 24..27 on 1 to 8 bytes, 31 indefinite. */
+static bool cbor_read_arg(cbor_reader_t* r, uint8_t ai, uint64_t* arg)
+{
+	size_t n;
+
+	if (ai < 24) {
+		*arg = ai;
+		return true;
+	}
+	if ((ai > 27) || ((size_t)(r->end - r->p) < ((size_t)1 << (ai - 24)))) {
+		r->error = true;
+		return false;
+	}
+	n = (size_t)1 << (ai - 24);
+	*arg = cbor_from_be(r->p, n);
+	r->p += n;
+	return true;
+}
+
+static bool cbor_read_simple(cbor_reader_t* r, uint8_t ai, cbor_item_t* item)
+{
+	uint64_t v;
+	uint32_t b;
+	float f;
+
+	switch (ai) {
+	case 20: item->type = CBOR_ITEM_FALSE; return true;
+	case 21: item->type = CBOR_ITEM_TRUE; return true;
+	case 22: item->type = CBOR_ITEM_NULL; return true;
+	case 31: item->type = CBOR_ITEM_BREAK; return true;
+	case 25:
+	case 26:
+	case 27:
+		if (!cbor_read_arg(r, ai, &v)) {
+			return false;
+		}
+		item->type = CBOR_ITEM_FLOAT;
+		if (ai == 25) {
+			item->f = cbor_half_to_float((uint16_t)v);
+		} else if (ai == 26) {
+			b = (uint32_t)v;
+			memcpy(&f, &b, sizeof(f));
+			item->f = f;
+		} else {
+			memcpy(&item->f, &v, sizeof(item->f));
+		}
+		return true;
+	default:
+		/* undefined, and the other simple values */
+		if ((ai > 24) || ((ai == 24) && !cbor_read_arg(r, ai, &v))) {
+			r->error = true;
+			return false;
+		}
+		item->type = CBOR_ITEM_UNDEFINED;
+		return true;
+	}
+}
+
+/* Exported functions --------------------------------------------------------*/
+
+size_t cbor_encode_head(uint8_t* out, uint8_t major, uint64_t value)
+{
+	size_t n;
+
+	major = (uint8_t)(major << 5);
+	if (value < 24) {
+		out[0] = major | (uint8_t)value;
+		return 1;
+	}
+	if (value <= 0xFF) {
+		out[0] = major | 24;
+		n = 1;
+	} else if (value <= 0xFFFF) {
+		out[0] = major | 25;
+		n = 2;
+	} else if (value <= 0xFFFFFFFFu) {
+		out[0] = major | 26;
+		n = 4;
+	} else {
+		out[0] = major | 27;
+		n = 8;
+	}
+	cbor_be(out + 1, value, n);
+	return n + 1;
+}
+
+size_t cbor_encode_float(uint8_t* out, double value)
+{
+	float f = (float)value;
+	uint16_t h;
+	uint32_t b;
+	uint64_t d;
+
+	if (((double)f == value) || (value != value)) {
+		if (cbor_half(f, &h)) {
+			out[0] = 0xF9;
+			cbor_be(out + 1, h, 2);
+			return 3;
+		}
+		memcpy(&b, &f, sizeof(b));
+		out[0] = 0xFA;
+		cbor_be(out + 1, b, 4);
+		return 5;
+	}
+	memcpy(&d, &value, sizeof(d));
+	out[0] = 0xFB;
+	cbor_be(out + 1, d, 8);
+	return 9;
+}
+
+void cbor_writer_init(cbor_writer_t* w, uint8_t* buf, size_t size)
+{
+	w->buf = buf;
+	w->size = (buf != NULL) ? size : 0;
+	w->len = 0;
+	w->overflow = false;
+}
+
+int cbor_writer_end(const cbor_writer_t* w)
+{
+	return w->overflow ? -1 : (int)w->len;
+}
+
+void cbor_write_uint(cbor_writer_t* w, uint64_t value)
+{
+	cbor_put_head(w, CBOR_MAJOR_UINT, value);
+}
+
+void cbor_write_int(cbor_writer_t* w, int64_t value)
+{
+	if (value < 0) {
+		cbor_put_head(w, CBOR_MAJOR_NEGINT, ~(uint64_t)value);	/* -1 - value */
+	} else {
+		cbor_put_head(w, CBOR_MAJOR_UINT, (uint64_t)value);
+	}
+}
+
+void cbor_write_float(cbor_writer_t* w, double value)
+{
+	uint8_t out[CBOR_HEAD_MAX];
+
+	cbor_put(w, out, cbor_encode_float(out, value));
+}
+
+void cbor_write_bool(cbor_writer_t* w, bool value)
+{
+	cbor_put_byte(w, value ? CBOR_TRUE : CBOR_FALSE);
+}
+
+void cbor_write_null(cbor_writer_t* w)
+{
+	cbor_put_byte(w, CBOR_NULL);
+}
+
+void cbor_write_text(cbor_writer_t* w, const char* s, size_t len)
+{
+	cbor_put_head(w, CBOR_MAJOR_TEXT, len);
+	cbor_put(w, s, len);
+}
+
+void cbor_write_bytes(cbor_writer_t* w, const void* data, size_t len)
+{
+	cbor_put_head(w, CBOR_MAJOR_BYTES, len);
+	cbor_put(w, data, len);
+}
+
+void cbor_write_array(cbor_writer_t* w, size_t count)
+{
+	if (count == CBOR_INDEFINITE) {
+		cbor_put_byte(w, CBOR_ARRAY_INDEFINITE);
+	} else {
+		cbor_put_head(w, CBOR_MAJOR_ARRAY, count);
+	}
+}
+
+void cbor_write_map(cbor_writer_t* w, size_t count)
+{
+	if (count == CBOR_INDEFINITE) {
+		cbor_put_byte(w, CBOR_MAP_INDEFINITE);
+	} else {
+		cbor_put_head(w, CBOR_MAJOR_MAP, count);
+	}
+}
+
+void cbor_write_break(cbor_writer_t* w)
+{
+	cbor_put_byte(w, CBOR_BREAK);
+}
+
+void cbor_reader_init(cbor_reader_t* r, const void* buf, size_t len)
+{
+	r->p = (const uint8_t*)buf;
+	r->end = r->p + ((buf != NULL) ? len : 0);
+	r->error = false;
+}
+
+bool cbor_read(cbor_reader_t* r, cbor_item_t* item)
+{
+	uint8_t major, ai;
+	uint64_t arg = 0;
+
+	if (r->error || (r->p >= r->end)) {
+		return false;
+	}
+	major = *r->p >> 5;
+	ai = *r->p & 0x1F;
+	r->p++;
+	memset(item, 0, sizeof(*item));
+
+	if (major == CBOR_MAJOR_SIMPLE) {
+		return cbor_read_simple(r, ai, item);
+	}
+	if (ai == 31) {
+		/* indefinite length: arrays and maps only */
+		if ((major != CBOR_MAJOR_ARRAY) && (major != CBOR_MAJOR_MAP)) {
+			r->error = true;
+			return false;
+		}
+		item->type = (major == CBOR_MAJOR_ARRAY) ? CBOR_ITEM_ARRAY : CBOR_ITEM_MAP;
+		item->count = CBOR_INDEFINITE;
+		return true;
+	}
+	if (!cbor_read_arg(r, ai, &arg)) {
+		return false;
+	}
+
+	switch (major) {
+	case CBOR_MAJOR_UINT:
+		item->type = CBOR_ITEM_UINT;
+		item->u = arg;
+		break;
+	case CBOR_MAJOR_NEGINT:
+		item->type = CBOR_ITEM_NEGINT;
+		item->u = arg;
+		break;
+	case CBOR_MAJOR_BYTES:
+	case CBOR_MAJOR_TEXT:
+		if (arg > (uint64_t)(r->end - r->p)) {
+			r->error = true;
+			return false;
+		}
+		item->type = (major == CBOR_MAJOR_BYTES) ? CBOR_ITEM_BYTES : CBOR_ITEM_TEXT;
+		item->str = r->p;
+		item->count = (size_t)arg;
+		r->p += arg;
+		break;
+	case CBOR_MAJOR_ARRAY:
+	case CBOR_MAJOR_MAP:
+		/* at least one byte per item: a longer count is malformed */
+		if (arg > (uint64_t)(r->end - r->p)) {
+			r->error = true;
+			return false;
+		}
+		item->type = (major == CBOR_MAJOR_ARRAY) ? CBOR_ITEM_ARRAY : CBOR_ITEM_MAP;
+		item->count = (size_t)arg;
+		break;
+	default:
+		item->type = CBOR_ITEM_TAG;
+		item->u = arg;
+		break;
+	}
+	return true;
+}
@@ -0,0 +1,374 @@
+/*
+ * json_writer.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Daruin Solano
+ */
+
+#include <string.h>
+#include "json_writer.h"
+#include "cbor.h"
+
+/* Private functions ---------------------------------------------------------*/
+
+static void json_put(json_writer_t* w, const char* s, size_t n)
+{
+	/* JSON: room kept for the \0 */
+	if (w->overflow || (w->len + n + (w->cbor ? 0 : 1) > w->size)) {
+		w->overflow = true;
+		return;
+	}
+	memcpy(w->buf + w->len, s, n);
+	w->len += n;
+}
+
+static void json_putc(json_writer_t* w, char c)
+{
+	json_put(w, &c, 1);
+}
+
+static void json_put_cbor_head(json_writer_t* w, uint8_t major, uint64_t value)
+{
+	uint8_t head[CBOR_HEAD_MAX];
+
+	json_put(w, (const char*)head, cbor_encode_head(head, major, value));
+}
+
+/* Container: '{' or '[' in JSON, indefinite-length map or array in CBOR. */
+static void json_open(json_writer_t* w, char c)
+{
+	if (w->cbor) {
+		json_putc(w, (char)((c == '{') ? CBOR_MAP_INDEFINITE : CBOR_ARRAY_INDEFINITE));
+	} else {
+		json_putc(w, c);
+	}
+}
+
+static void json_close(json_writer_t* w, char c)
+{
+	json_putc(w, w->cbor ? (char)CBOR_BREAK : c);
+}
+
+static void json_put_sep(json_writer_t* w)
+{
+	if (!w->cbor) {
+		json_putc(w, ',');
+	}
+}
+
+static void json_put_null(json_writer_t* w)
+{
+	if (w->cbor) {
+		json_putc(w, (char)CBOR_NULL);
+	} else {
+		json_put(w, "null", 4);
+	}
+}
+
+static void json_put_bool(json_writer_t* w, bool value)
+{
+	if (w->cbor) {
+		json_putc(w, (char)(value ? CBOR_TRUE : CBOR_FALSE));
+	} else if (value) {
+		json_put(w, "true", 4);
+	} else {
+		json_put(w, "false", 5);
+	}
+}
+
+static void json_put_quoted(json_writer_t* w, const char* s)
+{
+	static const char hex[] = "0123456789abcdef";
+	const char* run = s;
+
+	if (w->cbor) {
+		size_t len = strlen(s);
+
+		json_put_cbor_head(w, CBOR_MAJOR_TEXT, len);
+		json_put(w, s, len);
+		return;
+	}
+	json_putc(w, '"');
+	for (; *s != '\0'; ++s) {
+		unsigned char c = (unsigned char)*s;
+		char esc[6] = { '\\', 0, '0', '0', 0, 0 };
+		size_t n = 2;
+
+		if ((c >= 0x20) && (c != '"') && (c != '\\')) {
+			continue;
+		}
+		json_put(w, run, s - run);
+		run = s + 1;
+		switch (c) {
+		case '"':  esc[1] = '"'; break;
+		case '\\': esc[1] = '\\'; break;
+		case '\b': esc[1] = 'b'; break;
+		case '\f': esc[1] = 'f'; break;
+		case '\n': esc[1] = 'n'; break;
+		case '\r': esc[1] = 'r'; break;
+		case '\t': esc[1] = 't'; break;
+		default:
+			esc[1] = 'u';
+			esc[4] = hex[c >> 4];
+			esc[5] = hex[c & 0xF];
+			n = 6;
+			break;
+		}
+		json_put(w, esc, n);
+	}
+	json_put(w, run, s - run);
+	json_putc(w, '"');
+}
+
+static void json_put_key(json_writer_t* w, const char* key)
+{
+	if (!w->first) {
+		json_put_sep(w);
+	}
+	w->first = false;
+	json_put_quoted(w, key);
+	if (!w->cbor) {
+		json_putc(w, ':');
+	}
+}
+
+/* Decimal digits of v, with the given minimum count (zeros on the left). */
+static void json_put_digits(json_writer_t* w, uint64_t v, int min_digits)
+{
+	char tmp[20];
+	int n = 0;
+
+	do {
+		tmp[sizeof(tmp) - 1 - n++] = (char)('0' + (v % 10));
+		v /= 10;
+	} while ((v != 0) || (n < min_digits));
+	json_put(w, tmp + sizeof(tmp) - n, n);
+}
+
+static void json_put_int(json_writer_t* w, int64_t v)
+{
+	if (w->cbor) {
+		if (v < 0) {
+			json_put_cbor_head(w, CBOR_MAJOR_NEGINT, ~(uint64_t)v);	/* -1 - v */
+		} else {
+			json_put_cbor_head(w, CBOR_MAJOR_UINT, (uint64_t)v);
+		}
+	} else if (v < 0) {
+		json_putc(w, '-');
+		json_put_digits(w, (uint64_t)0 - (uint64_t)v, 1);
+	} else {
+		json_put_digits(w, (uint64_t)v, 1);
+	}
+}
+
+static void json_put_float(json_writer_t* w, float value, int decimals)
+{
+	static const uint32_t scale[JSON_FLOAT_DECIMALS_MAX + 1] = { 1, 10, 100, 1000, 10000, 100000, 1000000 };
+	double v = value;
+	uint64_t fixed, ip, fp;
+	bool neg = (v < 0);
+
+	if (decimals < 0) {
+		decimals = 0;
+	} else if (decimals > JSON_FLOAT_DECIMALS_MAX) {
+		decimals = JSON_FLOAT_DECIMALS_MAX;
+	}
+	if (neg) {
+		v = -v;
+	}
+	v = v * scale[decimals] + 0.5;
+	if (!(v < 9.2e18)) {	/* also NaN */
+		json_put_null(w);
+		return;
+	}
+	fixed = (uint64_t)v;
+	ip = fixed / scale[decimals];
+	fp = fixed % scale[decimals];
+	while ((decimals > 0) && (fp % 10 == 0)) {
+		fp /= 10;
+		decimals--;
+	}
+	if (w->cbor) {
+		/* the rounded value: an integer if integral, else the shortest exact float */
+		if (decimals == 0) {
+			json_put_int(w, neg ? -(int64_t)ip : (int64_t)ip);
+		} else {
+			uint8_t out[CBOR_HEAD_MAX];
+			float r = (float)((double)ip + (double)fp / scale[decimals]);
+
+			json_put(w, (const char*)out, cbor_encode_float(out, neg ? -r : r));
+		}
+		return;
+	}
+	if (neg && (fixed != 0)) {
+		json_putc(w, '-');
+	}
+	json_put_digits(w, ip, 1);
+	if (decimals > 0) {
+		json_putc(w, '.');
+		json_put_digits(w, fp, decimals);
+	}
+}
+
+static void json_put_member(json_writer_t* w, const json_field_t* f, const void* p)
+{
+	switch (f->type) {
+	case JSON_FIELD_STRING:
+		json_put_quoted(w, (const char*)p);
+		break;
+	case JSON_FIELD_STRPTR:
+		if (*(const char* const*)p == NULL) {
+			json_put_null(w);
+		} else {
+			json_put_quoted(w, *(const char* const*)p);
+		}
+		break;
+	case JSON_FIELD_BOOL:
+		json_put_bool(w, *(const bool*)p);
+		break;
+	case JSON_FIELD_INT16:
+		json_put_int(w, *(const int16_t*)p);
+		break;
+	case JSON_FIELD_INT32:
+		json_put_int(w, *(const int32_t*)p);
+		break;
+	case JSON_FIELD_UINT32:
+		json_put_int(w, *(const uint32_t*)p);
+		break;
+	case JSON_FIELD_FLOAT:
+		json_put_float(w, *(const float*)p, f->decimals);
+		break;
+	default:
+		json_put_null(w);
+		break;
+	}
+}
+
+static size_t json_member_size(uint8_t type)
+{
+	switch (type) {
+	case JSON_FIELD_BOOL:   return sizeof(bool);
+	case JSON_FIELD_INT16:  return sizeof(int16_t);
+	case JSON_FIELD_INT32:  return sizeof(int32_t);
+	case JSON_FIELD_UINT32: return sizeof(uint32_t);
+	case JSON_FIELD_FLOAT:  return sizeof(float);
+	default:                return sizeof(const char*);
+	}
+}
+
+/* Exported functions --------------------------------------------------------*/
+
+static void json_writer_start(json_writer_t* w, char* buf, size_t size, bool cbor)
+{
+	w->buf = buf;
+	w->size = size;
+	w->len = 0;
+	w->overflow = (buf == NULL) || (size == 0);
+	w->first = true;
+	w->cbor = cbor;
+	json_open(w, '{');
+}
+
+void json_writer_init(json_writer_t* w, char* buf, size_t size)
+{
+	json_writer_start(w, buf, size, false);
+}
+
+void json_writer_init_cbor(json_writer_t* w, char* buf, size_t size)
+{
+	json_writer_start(w, buf, size, true);
+}
+
+int json_writer_end(json_writer_t* w)
+{
+	json_close(w, '}');
+	if (w->overflow) {
+		if (w->size > 0) {
+			w->buf[0] = '\0';
+		}
+		return -1;
+	}
+	if (!w->cbor) {
+		w->buf[w->len] = '\0';
+	}
+	return (int)w->len;
+}
+
+void json_write_string(json_writer_t* w, const char* key, const char* value)
+{
+	json_put_key(w, key);
+	if (value == NULL) {
+		json_put_null(w);
+	} else {
+		json_put_quoted(w, value);
+	}
+}
+
+void json_write_bool(json_writer_t* w, const char* key, bool value)
+{
+	json_put_key(w, key);
+	json_put_bool(w, value);
+}
+
+void json_write_int(json_writer_t* w, const char* key, int32_t value)
+{
+	json_put_key(w, key);
+	json_put_int(w, value);
+}
+
+void json_write_uint(json_writer_t* w, const char* key, uint32_t value)
+{
+	json_put_key(w, key);
+	json_put_int(w, value);
+}
+
+void json_write_float(json_writer_t* w, const char* key, float value, int decimals)
+{
+	json_put_key(w, key);
+	json_put_float(w, value, decimals);
+}
+
+void json_write_fields(json_writer_t* w, const json_field_t* fields, size_t count, const void* record)
+{
+	size_t i;
+	uint8_t k;
+
+	for (i = 0; i < count; ++i) {
+		const json_field_t* f = &fields[i];
+		const char* p = (const char*)record + f->offset;
+
+		json_put_key(w, f->key);
+		if (f->count == 0) {
+			json_put_member(w, f, p);
+			continue;
+		}
+		json_open(w, '[');
+		for (k = 0; k < f->count; ++k) {
+			if (k > 0) {
+				json_put_sep(w);
+			}
+			json_put_member(w, f, p + k * json_member_size(f->type));
+		}
+		json_close(w, ']');
+	}
+}
+
+void json_write_records(json_writer_t* w, const char* key, const json_field_t* fields, size_t count,
+		const void* records, size_t stride, size_t n)
+{
+	size_t i;
+
+	json_put_key(w, key);
+	json_open(w, '[');
+	for (i = 0; i < n; ++i) {
+		if (i > 0) {
+			json_put_sep(w);
+		}
+		json_open(w, '{');
+		w->first = true;
+		json_write_fields(w, fields, count, (const char*)records + i * stride);
+		json_close(w, '}');
+	}
+	json_close(w, ']');
+	w->first = false;
+}
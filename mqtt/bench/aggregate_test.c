@@ -0,0 +1,206 @@
+/*
+ * aggregate_test.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Daruin Solano
+ *
+ *  Host test of the windowed aggregation of the sensors (sensors_aggregate.c),
+ *  on a simulated clock: the acquisition (sensors_sampling.c) reads a
+ *  temperature source that returns known values, every 100 ms.
+ *
+ *  Checks: count, mean and variance of tumbling and sliding windows against
+ *  a reference in double, so the Welford update and the merge of the panes;
+ *  the 50th, 90th and 99th percentiles within a bin of the interpolated
+ *  exact ones; the number of summaries of each kind of window, and their
+ *  time bounds; the percentiles of a pane with a saturated bin.
+ *
+ *  Build and run: make -C mqtt/bench aggregate
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <math.h>
+
+#include "sensors_sampling.h"
+#include "sensors_aggregate.h"
+#include "test_check.h"
+
+/* Private defines -----------------------------------------------------------*/
+#define TEST_PERIOD_MS          100
+#define TEST_DURATION_MS        60000
+#define TEST_WINDOW_SAMPLES     100     /* samples of a 10 s pane: the values 0.0 to 9.9 */
+#define TEST_TUMBLING_MS        10000
+#define TEST_SLIDING_MS         20000
+#define TEST_LO                 0.0f
+#define TEST_HI                 10.0f
+#define TEST_STEADY_MS          100000
+
+/* Private variables ---------------------------------------------------------*/
+static uint32_t test_now;
+static uint32_t test_reads;
+
+/* Private functions ---------------------------------------------------------*/
+static bool test_near(double value, double expected, double tolerance)
+{
+  return fabs(value - expected) <= tolerance;
+}
+
+static uint32_t test_tick(void)
+{
+  return test_now;
+}
+
+/* The read at t ms returns (t / 100 % 100) / 10: 0.0 to 9.9 in every 10 s. */
+static float test_value(uint32_t tick)
+{
+  return (float) ((tick / TEST_PERIOD_MS) % TEST_WINDOW_SAMPLES) / 10.0f;
+}
+
+static int test_read(float * values)
+{
+  values[0] = test_value(test_now);
+  test_reads++;
+  return 0;
+}
+
+/* 5.0 every ms, but 9.9 for the last 100 ms of a 100 s window: 99900 samples in the bin of 5.0. */
+static int test_read_steady(float * values)
+{
+  values[0] = (test_now % TEST_STEADY_MS >= TEST_STEADY_MS - 100) ? 9.9f : 5.0f;
+  return 0;
+}
+
+static int test_compare(const void * a, const void * b)
+{
+  double x = *(const double *) a;
+  double y = *(const double *) b;
+  return (x > y) - (x < y);
+}
+
+/* Percentile of rank p (0..1), interpolated between the sorted values. */
+static double test_percentile(const double * sorted, int n, double p)
+{
+  double rank = p * (n - 1);
+  int i = (int) rank;
+
+  return (i + 1 < n) ? sorted[i] + (rank - i) * (sorted[i + 1] - sorted[i]) : sorted[n - 1];
+}
+
+/* The summary against the samples of its window, in double. */
+static void test_summary(const sensors_agg_summary_t * s)
+{
+  static double values[TEST_SLIDING_MS / TEST_PERIOD_MS];
+  double mean = 0.0;
+  double m2 = 0.0;
+  double bin = (TEST_HI - TEST_LO) / SENSORS_AGG_BINS;
+  uint32_t t;
+  int n = 0;
+  int i;
+
+  for (t = s->start_tick; t != s->end_tick; t += TEST_PERIOD_MS)
+  {
+    values[n++] = test_value(t);
+    mean += values[n - 1];
+  }
+  mean /= n;
+  for (i = 0; i < n; ++i)
+  {
+    m2 += (values[i] - mean) * (values[i] - mean);
+  }
+  qsort(values, n, sizeof(values[0]), test_compare);
+
+  TEST_CHECK(s->channel == SENSOR_CH_TEMPERATURE);
+  TEST_CHECK(s->count == (uint32_t) n);
+  TEST_CHECK((s->min == (float) values[0]) && (s->max == (float) values[n - 1]));
+  TEST_CHECK(test_near(s->mean, mean, 1e-4));
+  TEST_CHECK(test_near(s->variance, m2 / (n - 1), 1e-3));
+  TEST_CHECK(test_near(s->p50, test_percentile(values, n, 0.50), bin));
+  TEST_CHECK(test_near(s->p90, test_percentile(values, n, 0.90), bin));
+  TEST_CHECK(test_near(s->p99, test_percentile(values, n, 0.99), bin));
+}
+
+static void test_aggregate(void)
+{
+  static const sensor_source_t sources[] = {
+    { "test", test_read, SENSOR_CH_TEMPERATURE, 1, 1, TEST_PERIOD_MS },
+  };
+  sensors_agg_config_t tumbling_cfg = { SENSOR_CH_TEMPERATURE, TEST_TUMBLING_MS, TEST_TUMBLING_MS, TEST_LO, TEST_HI };
+  sensors_agg_config_t sliding_cfg = { SENSOR_CH_TEMPERATURE, TEST_SLIDING_MS, TEST_TUMBLING_MS, TEST_LO, TEST_HI };
+  static sensors_agg_pane_t tumbling_panes[1];
+  static sensors_agg_pane_t sliding_panes[TEST_SLIDING_MS / TEST_TUMBLING_MS];
+  sensors_agg_t tumbling, sliding;
+  sensors_agg_summary_t s;
+  uint32_t tumbling_out = 0;
+  uint32_t sliding_out = 0;
+
+  printf("aggregation\n");
+  test_now = 0;
+  TEST_CHECK(sensors_sampling_init(sources, 1, test_tick) == 0);
+  TEST_CHECK(sensors_agg_init(&tumbling, &tumbling_cfg, tumbling_panes, 1) == 0);
+  TEST_CHECK(sensors_agg_init(&sliding, &sliding_cfg, sliding_panes, 1) == -1);   /* 2 panes needed */
+  TEST_CHECK(sensors_agg_init(&sliding, &sliding_cfg, sliding_panes, 2) == 0);
+
+  /* A sample every 100 ms, up to the first one after the last window; polled every second. */
+  for (test_now = 0; test_now <= TEST_DURATION_MS; test_now += TEST_PERIOD_MS)
+  {
+    sensors_sampling_poll();
+    if ((test_now % 1000 == 0) || (test_now == TEST_DURATION_MS))
+    {
+      while (sensors_agg_poll(&tumbling, &s))
+      {
+        TEST_CHECK((s.start_tick == tumbling_out * TEST_TUMBLING_MS) && (s.end_tick - s.start_tick == TEST_TUMBLING_MS));
+        test_summary(&s);
+        tumbling_out++;
+      }
+      while (sensors_agg_poll(&sliding, &s))
+      {
+        /* the first full window ends at 20 s, then one every 10 s */
+        TEST_CHECK((s.end_tick == TEST_SLIDING_MS + sliding_out * TEST_TUMBLING_MS) && (s.end_tick - s.start_tick == TEST_SLIDING_MS));
+        test_summary(&s);
+        sliding_out++;
+      }
+    }
+  }
+  TEST_CHECK(test_reads == TEST_DURATION_MS / TEST_PERIOD_MS + 1);
+  TEST_CHECK((tumbling_out == TEST_DURATION_MS / TEST_TUMBLING_MS) && (tumbling.windows == tumbling_out));
+  TEST_CHECK((sliding_out == (TEST_DURATION_MS - TEST_SLIDING_MS) / TEST_TUMBLING_MS + 1) && (sliding.windows == sliding_out));
+  TEST_CHECK((tumbling.lost == 0) && (sliding.lost == 0));
+}
+
+/* A pane bin saturates: the percentiles are ranked among the samples the bins hold. */
+static void test_saturation(void)
+{
+  static const sensor_source_t sources[] = {
+    { "steady", test_read_steady, SENSOR_CH_TEMPERATURE, 1, 1, 1 },
+  };
+  sensors_agg_config_t cfg = { SENSOR_CH_TEMPERATURE, TEST_STEADY_MS, TEST_STEADY_MS, TEST_LO, TEST_HI };
+  static sensors_agg_pane_t pane[1];
+  sensors_agg_t a;
+  sensors_agg_summary_t s;
+  double bin = (TEST_HI - TEST_LO) / SENSORS_AGG_BINS;
+  uint32_t out = 0;
+
+  printf("aggregation, saturated bins\n");
+  test_now = 0;
+  TEST_CHECK(sensors_sampling_init(sources, 1, test_tick) == 0);
+  TEST_CHECK(sensors_agg_init(&a, &cfg, pane, 1) == 0);
+  for (test_now = 0; test_now <= TEST_STEADY_MS; test_now++)
+  {
+    sensors_sampling_poll();
+    while (sensors_agg_poll(&a, &s))
+    {
+      TEST_CHECK((s.count == TEST_STEADY_MS) && (s.min == 5.0f) && (s.max == 9.9f));
+      TEST_CHECK(test_near(s.p50, 5.0, bin) && test_near(s.p99, 5.0, bin));
+      out++;
+    }
+  }
+  TEST_CHECK((out == 1) && (a.lost == 0));
+}
+
+int main(void)
+{
+  test_aggregate();
+  test_saturation();
+  return test_result();
+}
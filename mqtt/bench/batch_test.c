@@ -0,0 +1,122 @@
+/*
+ * batch_test.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Daruin Solano
+ *
+ *  Host test of the telemetry batching (mqtt_batch.c), on a simulated
+ *  clock: the flush by size, age, urgent value and request, the samples
+ *  refused when full, the metrics, and the payload written.
+ *
+ *  Build and run: make -C mqtt/bench batch
+ */
+
+#include <string.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#include "mqtt_batch.h"
+#include "test_check.h"
+
+/* Private typedef -----------------------------------------------------------*/
+typedef struct {
+  float value;
+  int32_t n;
+} test_sample_t;
+
+/* Private variables ---------------------------------------------------------*/
+static uint32_t test_now;
+
+static const json_field_t test_sample_fields[] = {
+  JSON_FIELD_DEC(test_sample_t, value, "v", 1),
+  JSON_FIELD(test_sample_t, n, "n", JSON_FIELD_INT32),
+};
+
+/* Private functions ---------------------------------------------------------*/
+static uint32_t test_tick(void)
+{
+  return test_now;
+}
+
+static void test_batch(void)
+{
+  test_sample_t samples[4];
+  test_sample_t s = { 1.5f, 0 };
+  mqtt_batch_t b;
+  json_writer_t w;
+  char msg[256];
+  int i;
+
+  printf("batching\n");
+  test_now = 0;
+  mqtt_batch_init(&b, samples, 4, sizeof(samples[0]), test_sample_fields, JSON_FIELDS(test_sample_fields), test_tick);
+
+  /* Size: due with the 3rd sample; the payload holds the three of them. */
+  b.policy.max_samples = 3;
+  b.policy.max_age_ms = 0;
+  for (i = 0; i < 3; ++i)
+  {
+    s.n = i;
+    TEST_CHECK(mqtt_batch_add(&b, &s) == (i == 2));
+  }
+  TEST_CHECK(b.due == MQTT_BATCH_SIZE);
+  json_writer_init(&w, msg, sizeof(msg));
+  json_write_string(&w, "ID", "dev");
+  mqtt_batch_write(&b, &w, "samples");
+  TEST_CHECK(json_writer_end(&w) > 0);
+  TEST_CHECK(strcmp(msg, "{\"ID\":\"dev\",\"samples\":[{\"v\":1.5,\"n\":0},{\"v\":1.5,\"n\":1},{\"v\":1.5,\"n\":2}]}") == 0);
+  mqtt_batch_clear(&b);
+  TEST_CHECK((b.count == 0) && (b.batches == 1) && (b.flushes[MQTT_BATCH_SIZE] == 1));
+
+  /* Age: from the first sample. */
+  b.policy.max_age_ms = 1000;
+  TEST_CHECK(mqtt_batch_wait_ms(&b) == UINT32_MAX);
+  test_now = 5000;
+  TEST_CHECK(!mqtt_batch_add(&b, &s));
+  test_now = 5600;
+  TEST_CHECK(!mqtt_batch_add(&b, &s));
+  TEST_CHECK((mqtt_batch_elapsed_ms(&b) == 600) && (mqtt_batch_wait_ms(&b) == 400));
+  test_now = 5999;
+  TEST_CHECK(!mqtt_batch_due(&b));
+  test_now = 6000;
+  TEST_CHECK(mqtt_batch_due(&b) && (b.due == MQTT_BATCH_AGE) && (mqtt_batch_wait_ms(&b) == 0));
+  mqtt_batch_clear(&b);
+
+  /* Urgent: a value out of [0, 50] goes at once, the first reason is kept. */
+  b.policy.urgent_offset = offsetof(test_sample_t, value);
+  b.policy.urgent_low = 0.0f;
+  b.policy.urgent_high = 50.0f;
+  TEST_CHECK(!mqtt_batch_add(&b, &s));
+  s.value = 50.5f;
+  TEST_CHECK(mqtt_batch_add(&b, &s) && (b.due == MQTT_BATCH_URGENT));
+  s.value = 1.5f;
+  TEST_CHECK(mqtt_batch_add(&b, &s) && (b.due == MQTT_BATCH_URGENT));
+  mqtt_batch_clear(&b);
+
+  /* Request: on an empty batch, due with its first sample. */
+  mqtt_batch_request(&b);
+  TEST_CHECK(!mqtt_batch_due(&b));
+  TEST_CHECK(mqtt_batch_add(&b, &s) && (b.due == MQTT_BATCH_REQUEST));
+  mqtt_batch_clear(&b);
+
+  /* Full: the samples past the capacity are refused. */
+  b.policy.max_samples = 0;
+  b.policy.urgent_offset = MQTT_BATCH_NO_URGENT;
+  for (i = 0; i < 5; ++i)
+  {
+    TEST_CHECK(mqtt_batch_add(&b, &s) == (i >= 3));
+  }
+  TEST_CHECK((b.count == 4) && (b.dropped == 1) && (b.due == MQTT_BATCH_SIZE));
+  mqtt_batch_clear(&b);
+
+  TEST_CHECK((b.batches == 5) && (b.flushes[MQTT_BATCH_SIZE] == 2) && (b.flushes[MQTT_BATCH_AGE] == 1)
+             && (b.flushes[MQTT_BATCH_URGENT] == 1) && (b.flushes[MQTT_BATCH_REQUEST] == 1));
+  TEST_CHECK(b.added == 3 + 2 + 3 + 1 + 4);
+}
+
+int main(void)
+{
+  test_batch();
+  return test_result();
+}
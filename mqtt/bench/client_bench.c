@@ -0,0 +1,375 @@
+/*
+ * client_bench.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Daruin Solano
+ *
+ *  Throughput and latency of the MQTT client (MQTTClient.c), in process,
+ *  against the LAN broker (mqtt_broker.c) as the server: both ends talk
+ *  through two memory pipes instead of a socket, the client reads call
+ *  mqtt_broker_poll() when the broker to client pipe is empty. No thread,
+ *  no syscall: what is measured is the client cycle(), readPacket() and
+ *  the packet serialization, plus the broker side of the exchange.
+ *
+ *  The client subscribes to the topics it publishes to, as the devices
+ *  subscribing to their own command topics do, so every publication comes
+ *  back (QoS0, the broker delivers QoS0). The publications go through
+ *  MQTTPublishAsync() and MQTTYield(), the way mqtt_queue sends them.
+ *
+ *  Per point (QoS, payload size, subscribed topics, client buffer size):
+ *  - msg/s: publications per second, until all are acknowledged and back;
+ *  - p50/p99: publish to PUBACK/PUBCOMP latency, publish to delivery for
+ *    QoS0, in microseconds;
+ *  - tx/rx: bytes on the wire per message, client to broker and back;
+ *  - allocs: malloc/calloc/realloc calls during the run, expected 0.
+ *
+ *  Build and run: make -C mqtt/bench client
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <time.h>
+
+#include "MQTTClient.h"
+#include "mqtt_broker.h"
+
+/* Private defines -----------------------------------------------------------*/
+#define BENCH_DEFAULT_MSGS      20000
+#define BENCH_PIPE_SIZE         (1024 * 1024)
+#define BENCH_MAX_TOPICS        128
+#define BENCH_DRAIN_MS          5000
+#define BENCH_TIMEOUT_MS        1000
+
+/* Private typedef -----------------------------------------------------------*/
+typedef struct {
+  uint8_t data[BENCH_PIPE_SIZE];
+  size_t head;
+  size_t tail;
+  unsigned long bytes;          /* written since the last reset */
+} bench_pipe_t;
+
+typedef struct {
+  int qos;
+  int payload;
+  int topics;
+  int buf;                      /* client send and read buffers, each */
+} bench_point_t;
+
+/* Private variables ---------------------------------------------------------*/
+static const bench_point_t bench_points[] = {
+  /* QoS and payload size */
+  { 0, 16, 1, 2048 }, { 1, 16, 1, 2048 }, { 2, 16, 1, 2048 },
+  { 0, 256, 1, 2048 }, { 1, 256, 1, 2048 }, { 2, 256, 1, 2048 },
+  { 0, 1024, 1, 2048 }, { 1, 1024, 1, 2048 }, { 2, 1024, 1, 2048 },
+  /* subscribed topics */
+  { 1, 64, 16, 2048 }, { 1, 64, BENCH_MAX_TOPICS, 2048 },
+  /* client buffers */
+  { 1, 128, 1, 256 }, { 1, 128, 1, 512 }, { 1, 128, 1, 8192 },
+};
+
+static bench_pipe_t bench_c2b;  /* client to broker */
+static bench_pipe_t bench_b2c;  /* broker to client */
+static mqtt_broker_t bench_broker;
+static char bench_topics[BENCH_MAX_TOPICS][32];
+static uint64_t* bench_sent;    /* publish time per message, ns */
+static uint64_t* bench_latency; /* ns, per completed message */
+static long bench_completed;
+static long bench_delivered;
+static int bench_qos;
+static unsigned long bench_allocs;
+
+/* Private functions ---------------------------------------------------------*/
+
+/* Allocation count, on top of the glibc allocator. */
+extern void* __libc_malloc(size_t size);
+extern void* __libc_calloc(size_t n, size_t size);
+extern void* __libc_realloc(void* ptr, size_t size);
+extern void __libc_free(void* ptr);
+
+void* malloc(size_t size)
+{
+  bench_allocs++;
+  return __libc_malloc(size);
+}
+
+void* calloc(size_t n, size_t size)
+{
+  bench_allocs++;
+  return __libc_calloc(n, size);
+}
+
+void* realloc(void* ptr, size_t size)
+{
+  bench_allocs++;
+  return __libc_realloc(ptr, size);
+}
+
+void free(void* ptr)
+{
+  __libc_free(ptr);
+}
+
+static uint64_t bench_now_ns(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t) ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+static int bench_pipe_write(bench_pipe_t* p, const uint8_t* buf, size_t len)
+{
+  if (p->tail + len > sizeof(p->data))
+  {
+    memmove(p->data, p->data + p->head, p->tail - p->head);
+    p->tail -= p->head;
+    p->head = 0;
+    if (p->tail + len > sizeof(p->data))
+    {
+      return -1;
+    }
+  }
+  memcpy(p->data + p->tail, buf, len);
+  p->tail += len;
+  p->bytes += len;
+  return (int) len;
+}
+
+static int bench_pipe_read(bench_pipe_t* p, uint8_t* buf, size_t len)
+{
+  size_t avail = p->tail - p->head;
+
+  if (len > avail)
+  {
+    len = avail;
+  }
+  memcpy(buf, p->data + p->head, len);
+  p->head += len;
+  if (p->head == p->tail)
+  {
+    p->head = p->tail = 0;
+  }
+  return (int) len;
+}
+
+/* Client side: the broker runs when the client has nothing to read. */
+static int bench_net_read(Network* n, unsigned char* buf, int len, int timeout_ms)
+{
+  (void) n;
+  (void) timeout_ms;
+  if (bench_b2c.head == bench_b2c.tail)
+  {
+    mqtt_broker_poll(&bench_broker, HAL_GetTick());
+  }
+  return bench_pipe_read(&bench_b2c, buf, (size_t) len);
+}
+
+static int bench_net_write(Network* n, unsigned char* buf, int len, int timeout_ms)
+{
+  (void) n;
+  (void) timeout_ms;
+  return bench_pipe_write(&bench_c2b, buf, (size_t) len);
+}
+
+static int bench_net_disconnect(Network* n)
+{
+  (void) n;
+  return 0;
+}
+
+/* Broker side. */
+static int bench_brk_recv(void* conn, uint8_t* buf, size_t len)
+{
+  (void) conn;
+  return bench_pipe_read(&bench_c2b, buf, len);
+}
+
+static int bench_brk_send(void* conn, const uint8_t* buf, size_t len)
+{
+  (void) conn;
+  return (bench_pipe_write(&bench_b2c, buf, len) < 0) ? -1 : 0;
+}
+
+static void bench_brk_close(void* conn)
+{
+  (void) conn;
+}
+
+static const mqtt_broker_transport_t bench_transport = { bench_brk_recv, bench_brk_send, bench_brk_close };
+
+static void bench_record(long k)
+{
+  bench_latency[bench_completed++] = bench_now_ns() - bench_sent[k];
+}
+
+static void bench_complete(void* context, unsigned short id, int rc)
+{
+  (void) id;
+  if ((bench_qos != 0) && (rc == MQSUCCESS))
+  {
+    bench_record((long) (intptr_t) context);
+  }
+}
+
+/* The publications come back: the message number is in the first bytes of the payload. */
+static void bench_handler(MessageData* md)
+{
+  uint32_t k;
+
+  bench_delivered++;
+  if ((bench_qos == 0) && (md->message->payloadlen >= sizeof(k)))
+  {
+    memcpy(&k, md->message->payload, sizeof(k));
+    bench_record(k);
+  }
+}
+
+static int bench_cmp(const void* a, const void* b)
+{
+  uint64_t x = *(const uint64_t*) a;
+  uint64_t y = *(const uint64_t*) b;
+  return (x < y) ? -1 : (x > y);
+}
+
+static int bench_run(const bench_point_t* pt, long msgs)
+{
+  static MQTTClient c;
+  static uint8_t payload[8192];
+  Network n = { bench_net_read, bench_net_write, bench_net_disconnect, NULL, NULL };
+  MQTTPacket_connectData options = MQTTPacket_connectData_initializer;
+  MQTTMessage m;
+  unsigned char* sendbuf = malloc(pt->buf);
+  unsigned char* readbuf = malloc(pt->buf);
+  unsigned long allocs;
+  uint64_t t0;
+  uint64_t elapsed;
+  long k;
+  int i;
+  int rc = 0;
+
+  memset(&bench_c2b, 0, sizeof(bench_c2b));
+  memset(&bench_b2c, 0, sizeof(bench_b2c));
+  mqtt_broker_init(&bench_broker);
+  mqtt_broker_attach(&bench_broker, &bench_c2b, &bench_transport, HAL_GetTick());
+  MQTTClientInit(&c, &n, BENCH_TIMEOUT_MS, sendbuf, pt->buf, readbuf, pt->buf);
+  options.clientID.cstring = "client_bench";
+  if (MQTTConnect(&c, &options) != MQSUCCESS)
+  {
+    printf("connect failed\n");
+    rc = -1;
+    goto exit;
+  }
+  for (i = 0; i < pt->topics; ++i)
+  {
+    if (MQTTSubscribe(&c, bench_topics[i], QOS0, bench_handler) != MQSUCCESS)
+    {
+      printf("subscribe %d failed\n", i);
+      rc = -1;
+      goto exit;
+    }
+  }
+  MQTTSetInflightWindow(&c, MAX_INFLIGHT_MESSAGES, bench_complete);
+
+  bench_qos = pt->qos;
+  bench_completed = 0;
+  bench_delivered = 0;
+  bench_c2b.bytes = bench_b2c.bytes = 0;
+  memset(&m, 0, sizeof(m));
+  m.qos = (enum QoS) pt->qos;
+  m.payload = payload;
+  m.payloadlen = pt->payload;
+
+  allocs = bench_allocs;
+  t0 = bench_now_ns();
+  for (k = 0; k < msgs;)
+  {
+    uint32_t id = (uint32_t) k;
+
+    memcpy(payload, &id, sizeof(id));
+    bench_sent[k] = bench_now_ns();
+    if ((i = MQTTPublishAsync(&c, bench_topics[k % pt->topics], &m, (void*) (intptr_t) k)) == MQSUCCESS)
+    {
+      k++;
+    }
+    else if (i != WINDOW_FULL)
+    {
+      printf("publish failed rc=%d\n", i);
+      rc = -1;
+      goto exit;
+    }
+    MQTTYield(&c, 0);
+  }
+  while (((bench_completed < msgs) || (bench_delivered < msgs)) && (bench_now_ns() - t0 < BENCH_DRAIN_MS * 1000000ull))
+  {
+    MQTTYield(&c, 0);
+  }
+  elapsed = bench_now_ns() - t0;
+  allocs = bench_allocs - allocs;
+
+  if ((bench_completed < msgs) || (bench_delivered < msgs))
+  {
+    printf("%3d %7d %6d %6d   incomplete: %ld acknowledged, %ld delivered\n", pt->qos, pt->payload, pt->topics,
+           pt->buf, bench_completed, bench_delivered);
+    rc = -1;
+    goto exit;
+  }
+  qsort(bench_latency, bench_completed, sizeof(bench_latency[0]), bench_cmp);
+  printf("%3d %7d %6d %6d %10.0f %9.1f %9.1f %7.1f %7.1f %7lu\n", pt->qos, pt->payload, pt->topics, pt->buf,
+         msgs / (elapsed / 1e9), bench_latency[msgs / 2] / 1e3, bench_latency[msgs * 99 / 100] / 1e3,
+         (double) bench_c2b.bytes / msgs, (double) bench_b2c.bytes / msgs, allocs);
+
+exit:
+  free(sendbuf);
+  free(readbuf);
+  return rc;
+}
+
+static void bench_usage(const char * prog)
+{
+  printf("usage: %s [-m messages_per_point]\n", prog);
+}
+
+int main(int argc, char ** argv)
+{
+  long msgs = BENCH_DEFAULT_MSGS;
+  unsigned int i;
+  int rc = 0;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "m:h")) != -1)
+  {
+    switch (opt)
+    {
+      case 'm': msgs = atol(optarg); break;
+      default:
+        bench_usage(argv[0]);
+        return (opt == 'h') ? 0 : 1;
+    }
+  }
+  if (msgs <= 0)
+  {
+    bench_usage(argv[0]);
+    return 1;
+  }
+
+  for (i = 0; i < BENCH_MAX_TOPICS; ++i)
+  {
+    snprintf(bench_topics[i], sizeof(bench_topics[i]), "bench/%u/data", i);
+  }
+  bench_sent = malloc(msgs * sizeof(bench_sent[0]));
+  bench_latency = malloc(msgs * sizeof(bench_latency[0]));
+
+  printf("MQTT client over loopback to mqtt_broker, %ld messages per point, window %d\n", msgs, MAX_INFLIGHT_MESSAGES);
+  printf("%3s %7s %6s %6s %10s %9s %9s %7s %7s %7s\n", "qos", "payload", "topics", "buf", "msg/s", "p50 us",
+         "p99 us", "tx B", "rx B", "allocs");
+  for (i = 0; i < sizeof(bench_points) / sizeof(bench_points[0]); ++i)
+  {
+    rc |= bench_run(&bench_points[i], msgs);
+  }
+
+  free(bench_sent);
+  free(bench_latency);
+  return (rc == 0) ? 0 : 1;
+}
@@ -0,0 +1,115 @@
+/*
+ * deadband_test.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Daruin Solano
+ *
+ *  Host test of the report by exception (sensors_deadband.c): the absolute
+ *  and relative deadbands, the heartbeat, the rate limit, their metrics,
+ *  and the JSON configuration, all or nothing, direct or staged.
+ *
+ *  Build and run: make -C mqtt/bench deadband
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include "sensors_deadband.h"
+#include "cJSON.h"
+#include "test_check.h"
+
+/* Private functions ---------------------------------------------------------*/
+static void test_deadband(void)
+{
+  sensors_deadband_config_t abs_cfg = { 0.5f, 0.0f, 0, 0 };
+  sensors_deadband_config_t rel_cfg = { 0.0f, 0.1f, 0, 0 };
+  sensors_deadband_config_t hb_cfg = { 1.0f, 0.0f, 1000, 0 };
+  sensors_deadband_config_t limit_cfg = { 0.1f, 0.0f, 0, 500 };
+  sensors_deadband_t d;
+  const sensors_deadband_channel_t * c;
+  cJSON * json;
+
+  printf("report by exception\n");
+  sensors_deadband_init(&d);
+
+  /* Absolute deadband: from the last value reported, not from the last one seen. */
+  sensors_deadband_set(&d, SENSOR_CH_TEMPERATURE, &abs_cfg);
+  c = &d.ch[SENSOR_CH_TEMPERATURE];
+  TEST_CHECK(sensors_deadband_check(&d, SENSOR_CH_TEMPERATURE, 20.0f, 0) == SENSORS_DEADBAND_FIRST);
+  TEST_CHECK(sensors_deadband_filter(&d, SENSOR_CH_TEMPERATURE, 20.0f, 0));
+  TEST_CHECK(!sensors_deadband_filter(&d, SENSOR_CH_TEMPERATURE, 20.3f, 100));
+  TEST_CHECK(!sensors_deadband_filter(&d, SENSOR_CH_TEMPERATURE, 19.6f, 200));
+  TEST_CHECK(sensors_deadband_check(&d, SENSOR_CH_TEMPERATURE, 20.5f, 300) == SENSORS_DEADBAND_CHANGE);
+  TEST_CHECK(sensors_deadband_filter(&d, SENSOR_CH_TEMPERATURE, 19.4f, 400));
+  TEST_CHECK((c->last == 19.4f) && (c->last_tick == 400));
+  TEST_CHECK((c->reports == 2) && (c->suppressed == 2));
+
+  /* Relative deadband: 10% of the last value reported. */
+  sensors_deadband_set(&d, SENSOR_CH_PRESSURE, &rel_cfg);
+  c = &d.ch[SENSOR_CH_PRESSURE];
+  TEST_CHECK(sensors_deadband_filter(&d, SENSOR_CH_PRESSURE, 1000.0f, 0));
+  TEST_CHECK(!sensors_deadband_filter(&d, SENSOR_CH_PRESSURE, 1090.0f, 100));
+  TEST_CHECK(sensors_deadband_filter(&d, SENSOR_CH_PRESSURE, 899.0f, 200));
+  TEST_CHECK(!sensors_deadband_filter(&d, SENSOR_CH_PRESSURE, 899.0f, 300));
+
+  /* Heartbeat: a steady value is reported again after 1 s of silence. */
+  sensors_deadband_set(&d, SENSOR_CH_HUMIDITY, &hb_cfg);
+  c = &d.ch[SENSOR_CH_HUMIDITY];
+  TEST_CHECK(sensors_deadband_filter(&d, SENSOR_CH_HUMIDITY, 40.0f, 0));
+  TEST_CHECK(sensors_deadband_check(&d, SENSOR_CH_HUMIDITY, 40.0f, 999) == SENSORS_DEADBAND_NONE);
+  TEST_CHECK(sensors_deadband_check(&d, SENSOR_CH_HUMIDITY, 40.0f, 1000) == SENSORS_DEADBAND_HEARTBEAT);
+  sensors_deadband_reported(&d, SENSOR_CH_HUMIDITY, 40.0f, 1000);
+  TEST_CHECK(!sensors_deadband_filter(&d, SENSOR_CH_HUMIDITY, 40.2f, 1500));
+  TEST_CHECK(sensors_deadband_filter(&d, SENSOR_CH_HUMIDITY, 40.2f, 2000));
+  TEST_CHECK((c->reports == 3) && (c->heartbeats == 2) && (c->suppressed == 2));
+
+  /* Rate limit: a change within 500 ms of the last report waits, and is reported once it is over. */
+  sensors_deadband_set(&d, SENSOR_CH_ACC_X, &limit_cfg);
+  c = &d.ch[SENSOR_CH_ACC_X];
+  TEST_CHECK(sensors_deadband_filter(&d, SENSOR_CH_ACC_X, 0.0f, 0));
+  TEST_CHECK(!sensors_deadband_filter(&d, SENSOR_CH_ACC_X, 1.0f, 100));
+  TEST_CHECK(!sensors_deadband_filter(&d, SENSOR_CH_ACC_X, 2.0f, 499));
+  TEST_CHECK(sensors_deadband_filter(&d, SENSOR_CH_ACC_X, 2.0f, 500));
+  TEST_CHECK((c->reports == 2) && (c->limited == 2));
+
+  /* No deadband: every value. */
+  TEST_CHECK(sensors_deadband_filter(&d, SENSOR_CH_MAG_X, 1.0f, 0));
+  TEST_CHECK(sensors_deadband_filter(&d, SENSOR_CH_MAG_X, 1.0f, 1));
+
+  /* JSON configuration: all or nothing, the members not given are kept. */
+  json = cJSON_Parse("{\"temperature\":{\"abs\":0.3,\"heartbeat_ms\":600000},\"humidity\":{\"rel\":0.02}}");
+  TEST_CHECK(sensors_deadband_from_json(&d, json) == 2);
+  cJSON_Delete(json);
+  TEST_CHECK((d.ch[SENSOR_CH_TEMPERATURE].config.abs == 0.3f) && (d.ch[SENSOR_CH_TEMPERATURE].config.heartbeat_ms == 600000));
+  TEST_CHECK((d.ch[SENSOR_CH_HUMIDITY].config.rel == 0.02f) && (d.ch[SENSOR_CH_HUMIDITY].config.abs == 1.0f));
+  json = cJSON_Parse("{\"pressure\":{\"abs\":1},\"humidity\":{\"abs\":-1}}");
+  TEST_CHECK(sensors_deadband_from_json(&d, json) == -1);
+  cJSON_Delete(json);
+  json = cJSON_Parse("{\"pressure\":{\"abs\":1},\"altitude\":{\"abs\":1}}");
+  TEST_CHECK(sensors_deadband_from_json(&d, json) == -1);
+  cJSON_Delete(json);
+  json = cJSON_Parse("{\"pressure\":{\"delta\":1}}");
+  TEST_CHECK(sensors_deadband_from_json(&d, json) == -1);
+  cJSON_Delete(json);
+  TEST_CHECK((d.ch[SENSOR_CH_PRESSURE].config.abs == 0.0f) && (d.ch[SENSOR_CH_HUMIDITY].config.abs == 1.0f));
+
+  /* Staged configuration: checked and copied at once, applied by the next update only, one at a time. */
+  json = cJSON_Parse("{\"pressure\":{\"abs\":2}}");
+  TEST_CHECK(sensors_deadband_stage(&d, json) == 1);
+  TEST_CHECK(sensors_deadband_stage(&d, json) == -2);
+  cJSON_Delete(json);
+  TEST_CHECK(d.ch[SENSOR_CH_PRESSURE].config.abs == 0.0f);
+  TEST_CHECK(sensors_deadband_update(&d) == 1);
+  TEST_CHECK((d.ch[SENSOR_CH_PRESSURE].config.abs == 2.0f) && (d.ch[SENSOR_CH_PRESSURE].config.rel == 0.1f));
+  TEST_CHECK(sensors_deadband_update(&d) == 0);
+  json = cJSON_Parse("{\"pressure\":{\"abs\":-2}}");
+  TEST_CHECK(sensors_deadband_stage(&d, json) == -1);
+  cJSON_Delete(json);
+  TEST_CHECK((sensors_deadband_update(&d) == 0) && (d.ch[SENSOR_CH_PRESSURE].config.abs == 2.0f));
+}
+
+int main(void)
+{
+  test_deadband();
+  return test_result();
+}
@@ -0,0 +1,29 @@
+/*
+ * msg.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Daruin Solano
+ *
+ *  Host (Linux) stand-in for common/msg.h: errors and information only.
+ */
+
+#ifndef __MSG_H__
+#define __MSG_H__
+
+#include <stdlib.h>
+#include <stdio.h>
+
+#define msg_debug(...)
+#define msg_warning(...)
+#define msg_info(...)   \
+	{ \
+	printf(__VA_ARGS__ ); \
+	fflush(stdout); \
+	}
+#define msg_error(...)  \
+	{ \
+	fprintf(stderr, "[ERROR]: %s L#%d " , __func__, __LINE__); \
+	fprintf(stderr, __VA_ARGS__ ); \
+	}
+
+#endif /* __MSG_H__ */
@@ -0,0 +1,31 @@
+/*
+ * net.conf.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Daruin Solano
+ *
+ *  Host (Linux) stand-in for netsock/inc/net.conf.h: the Timer of the MQTT
+ *  client only, implemented on CLOCK_MONOTONIC by timer.c.
+ */
+
+#ifndef __NET_CONF_H__
+#define __NET_CONF_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <string.h>
+
+typedef struct Timer {
+  uint64_t end_ms;
+} Timer;
+
+extern void TimerInit(Timer*);
+extern char TimerIsExpired(Timer*);
+extern void TimerCountdownMS(Timer*, unsigned int);
+extern void TimerCountdown(Timer*, unsigned int);
+extern int TimerLeftMS(Timer*);
+
+uint32_t HAL_GetTick(void);
+
+#endif /* __NET_CONF_H__ */
@@ -0,0 +1,37 @@
+/*
+ * net_mqtt.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Daruin Solano
+ *
+ *  Host (Linux) stand-in for netsock/inc/net_mqtt.h: the Network of the MQTT
+ *  client, without the netsock handles. The benchmarks provide the
+ *  mqttread/mqttwrite functions.
+ */
+
+#ifndef __NET_MQTT_H__
+#define __NET_MQTT_H__
+
+#include <stdint.h>
+
+typedef struct Network_s Network;
+
+typedef int net_read_t(Network* n, unsigned char* buffer, int len, int timeout_ms);
+typedef int net_write_t(Network* n, unsigned char* buffer, int len, int timeout_ms);
+typedef int net_disconnect_t(Network* n);
+typedef int net_flush_t(Network* n);
+
+typedef uint32_t Mutex;
+typedef uint32_t Thread;
+typedef void (*mqttrun_t)(void * client);
+
+struct Network_s
+{
+  net_read_t       * mqttread;
+  net_write_t      * mqttwrite;
+  net_disconnect_t * mqttdisconnect;
+  net_flush_t      * mqttflush;
+  void             * ctx;         /* transport of the benchmark */
+};
+
+#endif /* __NET_MQTT_H__ */
@@ -0,0 +1,50 @@
+/*
+ * timer.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Daruin Solano
+ *
+ *  Host (Linux) stand-in for Time/src/timer.c: the MQTT client Timer on
+ *  CLOCK_MONOTONIC, and HAL_GetTick().
+ */
+
+#include <time.h>
+#include "net.conf.h"
+
+static uint64_t timer_now_ms(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t) ts.tv_sec * 1000u + ts.tv_nsec / 1000000u;
+}
+
+uint32_t HAL_GetTick(void)
+{
+  return (uint32_t) timer_now_ms();
+}
+
+void TimerInit(Timer* timer)
+{
+  timer->end_ms = 0;
+}
+
+void TimerCountdownMS(Timer* timer, unsigned int timeout_ms)
+{
+  timer->end_ms = timer_now_ms() + timeout_ms;
+}
+
+void TimerCountdown(Timer* timer, unsigned int timeout)
+{
+  TimerCountdownMS(timer, timeout * 1000);
+}
+
+int TimerLeftMS(Timer* timer)
+{
+  uint64_t now = timer_now_ms();
+  return (timer->end_ms > now) ? (int) (timer->end_ms - now) : 0;
+}
+
+char TimerIsExpired(Timer* timer)
+{
+  return (TimerLeftMS(timer) > 0) ? 0 : 1;
+}
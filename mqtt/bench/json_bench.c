@@ -0,0 +1,286 @@
+/*
+ * json_bench.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Daruin Solano
+ *
+ *  Cost of formatting the telemetry payload of mqtt_app.c, the same keys and
+ *  values, by the three paths the publish code has used, and by the two
+ *  CBOR ones:
+ *  - cJSON_Print: tree of cJSON items, pretty-printed into a heap string,
+ *    copied to the message buffer (mqtt_client_publish_task, formerly);
+ *  - cJSON_PrintPreallocated: same tree, printed into the message buffer
+ *    (mqtt_client_publish, formerly);
+ *  - json_writer: compact JSON, written straight into the message buffer
+ *    from the schema of the records (json/inc/json_writer.h);
+ *  - json_writer/cbor: same calls, CBOR (json_writer_init_cbor());
+ *  - cJSON_ToCBOR: the cJSON tree, encoded in CBOR (json/inc/cJSON_CBOR.h).
+ *
+ *  Per path: ns per payload, payload bytes, malloc/calloc/realloc calls per
+ *  payload. The outputs are parsed back with cJSON (cJSON_FromCBOR for CBOR)
+ *  and compared, so that the paths are known to carry the same content.
+ *
+ *  Build and run: make -C mqtt/bench json
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include <time.h>
+
+#include "cJSON.h"
+#include "json_writer.h"
+#include "cJSON_CBOR.h"
+
+/* Private defines -----------------------------------------------------------*/
+#define BENCH_DEFAULT_RUNS      200000
+#define BENCH_MSG_SIZE          1024    /* MQTT_MSG_BUFFER_SIZE of the board */
+
+/* Private typedef -----------------------------------------------------------*/
+/* The records of netsock/inc/net_mqtt.h, the members the telemetry publishes. */
+typedef struct {
+  char mac[20];
+  char* tstamp;
+  float temperature;
+  float humidity;
+} bench_pub_data_t;
+
+typedef struct {
+  char mac[20];
+  bool LedOn;
+  uint32_t TelemetryInterval;
+} bench_status_data_t;
+
+typedef int (*bench_format_t)(char* buf, size_t size);
+
+typedef struct {
+  const char* name;
+  bench_format_t format;
+  bool cbor;
+} bench_path_t;
+
+/* Private variables ---------------------------------------------------------*/
+static bench_pub_data_t pub_data = { "C4:7F:51:0A:12:9E", "2026-10-18T05:08:11Z", 23.7f, 41.2f };
+static bench_status_data_t status_data = { "C4:7F:51:0A:12:9E", true, 60000 };
+static const char* client_id = "IOT_STM32";
+static uint32_t reconnects = 3, reconnect_ms = 1840, rtt_ms = 87, retries = 12;
+
+static const json_field_t status_fields[] = {
+  JSON_FIELD(bench_status_data_t, LedOn, "LedOn", JSON_FIELD_BOOL),
+};
+static const json_field_t pub_fields[] = {
+  JSON_FIELD(bench_pub_data_t, tstamp, "timestamp", JSON_FIELD_STRPTR),
+  JSON_FIELD(bench_pub_data_t, mac, "MacAddress", JSON_FIELD_STRING),
+};
+
+static unsigned long bench_allocs;
+
+/* Private functions ---------------------------------------------------------*/
+
+/* Allocation count, on top of the glibc allocator. */
+extern void* __libc_malloc(size_t size);
+extern void* __libc_calloc(size_t n, size_t size);
+extern void* __libc_realloc(void* ptr, size_t size);
+extern void __libc_free(void* ptr);
+
+void* malloc(size_t size)
+{
+  bench_allocs++;
+  return __libc_malloc(size);
+}
+
+void* calloc(size_t n, size_t size)
+{
+  bench_allocs++;
+  return __libc_calloc(n, size);
+}
+
+void* realloc(void* ptr, size_t size)
+{
+  bench_allocs++;
+  return __libc_realloc(ptr, size);
+}
+
+void free(void* ptr)
+{
+  __libc_free(ptr);
+}
+
+static uint64_t bench_now_ns(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t) ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+static cJSON* bench_tree(void)
+{
+  cJSON* publish_data = cJSON_CreateObject();
+  cJSON_AddStringToObject(publish_data, "ID", client_id);
+  cJSON_AddBoolToObject(publish_data, "LedOn", status_data.LedOn);
+  cJSON_AddNumberToObject(publish_data, "Temperature", (int)(pub_data.temperature * 9.0 / 5.0) + 32.0);
+  cJSON_AddNumberToObject(publish_data, "Humidity", (int)pub_data.humidity);
+  cJSON_AddStringToObject(publish_data, "timestamp", pub_data.tstamp);
+  cJSON_AddStringToObject(publish_data, "MacAddress", pub_data.mac);
+  cJSON_AddNumberToObject(publish_data, "Reconnects", reconnects);
+  cJSON_AddNumberToObject(publish_data, "ReconnectMs", reconnect_ms);
+  cJSON_AddNumberToObject(publish_data, "AckRttMs", rtt_ms);
+  cJSON_AddNumberToObject(publish_data, "Retries", retries);
+  return publish_data;
+}
+
+static int bench_cjson_print(char* buf, size_t size)
+{
+  cJSON* publish_data = bench_tree();
+  char* msg = cJSON_Print(publish_data);
+  int len = -1;
+
+  if ((msg != NULL) && (strlen(msg) < size))
+  {
+    strcpy(buf, msg);
+    len = strlen(buf);
+  }
+  free(msg);
+  cJSON_Delete(publish_data);
+  return len;
+}
+
+static int bench_cjson_prealloc(char* buf, size_t size)
+{
+  cJSON* publish_data = bench_tree();
+  int len = cJSON_PrintPreallocated(publish_data, buf, size, 1) ? (int)strlen(buf) : -1;
+
+  cJSON_Delete(publish_data);
+  return len;
+}
+
+static int bench_writer(json_writer_t* w)
+{
+  json_write_string(w, "ID", client_id);
+  json_write_fields(w, status_fields, JSON_FIELDS(status_fields), &status_data);
+  json_write_int(w, "Temperature", (int)(pub_data.temperature * 9.0 / 5.0) + 32);
+  json_write_int(w, "Humidity", (int)pub_data.humidity);
+  json_write_fields(w, pub_fields, JSON_FIELDS(pub_fields), &pub_data);
+  json_write_uint(w, "Reconnects", reconnects);
+  json_write_uint(w, "ReconnectMs", reconnect_ms);
+  json_write_uint(w, "AckRttMs", rtt_ms);
+  json_write_uint(w, "Retries", retries);
+  return json_writer_end(w);
+}
+
+static int bench_json_writer(char* buf, size_t size)
+{
+  json_writer_t w;
+
+  json_writer_init(&w, buf, size);
+  return bench_writer(&w);
+}
+
+static int bench_cbor_writer(char* buf, size_t size)
+{
+  json_writer_t w;
+
+  json_writer_init_cbor(&w, buf, size);
+  return bench_writer(&w);
+}
+
+static int bench_cjson_cbor(char* buf, size_t size)
+{
+  cJSON* publish_data = bench_tree();
+  int len = cJSON_ToCBOR(publish_data, (uint8_t*)buf, size);
+
+  cJSON_Delete(publish_data);
+  return len;
+}
+
+static const bench_path_t bench_paths[] = {
+  { "cJSON_Print", bench_cjson_print, false },
+  { "cJSON_PrintPreallocated", bench_cjson_prealloc, false },
+  { "json_writer", bench_json_writer, false },
+  { "json_writer/cbor", bench_cbor_writer, true },
+  { "cJSON_ToCBOR", bench_cjson_cbor, true },
+};
+
+/* Same content as the cJSON tree, whatever the formatting. */
+static int bench_check(const bench_path_t* path, const char* payload, int len)
+{
+  cJSON* expected = bench_tree();
+  cJSON* parsed = path->cbor ? cJSON_FromCBOR(payload, len) : cJSON_Parse(payload);
+  int rc = 0;
+
+  if ((parsed == NULL) || !cJSON_Compare(expected, parsed, 1))
+  {
+    printf("%s: content differs%s%s\n", path->name, path->cbor ? "" : ": ", path->cbor ? "" : payload);
+    rc = 1;
+  }
+  cJSON_Delete(parsed);
+  cJSON_Delete(expected);
+  return rc;
+}
+
+static int bench_run(const bench_path_t* path, long runs)
+{
+  static char buf[BENCH_MSG_SIZE];
+  unsigned long allocs;
+  uint64_t t0, t1;
+  long i;
+  int len = 0;
+
+  len = path->format(buf, sizeof(buf));
+  if ((len < 0) || bench_check(path, buf, len))
+  {
+    return 1;
+  }
+
+  allocs = bench_allocs;
+  t0 = bench_now_ns();
+  for (i = 0; i < runs; ++i)
+  {
+    len = path->format(buf, sizeof(buf));
+  }
+  t1 = bench_now_ns();
+  allocs = bench_allocs - allocs;
+
+  printf("%-24s %9.1f %7d %9.1f\n", path->name, (double)(t1 - t0) / runs, len, (double)allocs / runs);
+  return 0;
+}
+
+static void bench_usage(const char * prog)
+{
+  printf("usage: %s [-n payloads_per_path]\n", prog);
+}
+
+int main(int argc, char ** argv)
+{
+  long runs = BENCH_DEFAULT_RUNS;
+  unsigned int i;
+  int rc = 0;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "n:h")) != -1)
+  {
+    switch (opt)
+    {
+      case 'n': runs = atol(optarg); break;
+      default:
+        bench_usage(argv[0]);
+        return (opt == 'h') ? 0 : 1;
+    }
+  }
+  if (runs <= 0)
+  {
+    bench_usage(argv[0]);
+    return 1;
+  }
+
+  printf("Telemetry payload of mqtt_app.c, %ld payloads per path\n", runs);
+  printf("%-24s %9s %7s %9s\n", "path", "ns", "bytes", "allocs");
+  for (i = 0; i < sizeof(bench_paths) / sizeof(bench_paths[0]); ++i)
+  {
+    rc |= bench_run(&bench_paths[i], runs);
+  }
+  return (rc == 0) ? 0 : 1;
+}
@@ -0,0 +1,158 @@
+/*
+ * publish_queue_test.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Daruin Solano
+ *
+ *  Host test of the lock-free publication queue of the MQTT_TASK builds
+ *  (MQTTPublishQueue.c), built with ThreadSanitizer: TEST_PRODUCERS
+ *  threads push TEST_PUBLICATIONS publications each, as the application
+ *  tasks do with MQTTPublishQueued(), while the main thread consumes them
+ *  as the network task does.
+ *
+ *  Checks:
+ *  - single thread: empty, full at MAX_QUEUED_PUBLICATIONS, the front left
+ *    in place until popped, the cells reused lap after lap;
+ *  - producers: every publication consumed once, in the order of its
+ *    producer, its members as pushed; a push refused while the queue is
+ *    full is tried again;
+ *  - no data race reported by ThreadSanitizer (the build fails the run).
+ *
+ *  Build and run: make -C mqtt/bench publish_queue
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include "MQTTPublishQueue.h"
+#include "test_check.h"
+
+/* Private defines -----------------------------------------------------------*/
+#define TEST_PRODUCERS          4
+#define TEST_PUBLICATIONS       2000    /* per producer */
+
+/* Private variables ---------------------------------------------------------*/
+static MQTTPublishQueue test_queue;
+static const char * const test_topics[TEST_PRODUCERS] = { "/t/0", "/t/1", "/t/2", "/t/3" };
+static unsigned long test_full[TEST_PRODUCERS];
+
+/* Private functions ---------------------------------------------------------*/
+/* Producer p: publication n carries p and n in its context, its payload length and its QoS. */
+static void * test_producer(void * arg)
+{
+  uintptr_t p = (uintptr_t) arg;
+  MQTTQueuedPublish pub = { test_topics[p], NULL, 0, 1, 0, NULL };
+  uintptr_t n;
+
+  for (n = 0; n < TEST_PUBLICATIONS; ++n)
+  {
+    pub.context = (void *) ((p << 16) | n);
+    pub.payloadlen = n;
+    pub.qos = (unsigned char) (n % 3);
+    while (MQTTPublishQueue_push(&test_queue, &pub) != 0)
+    {
+      test_full[p]++;
+      sched_yield();
+    }
+  }
+  return NULL;
+}
+
+static void test_single(void)
+{
+  MQTTQueuedPublish pub = { "/t", NULL, 0, 1, 0, NULL };
+  MQTTQueuedPublish * front;
+  uintptr_t i;
+  int lap;
+
+  printf("single thread\n");
+  MQTTPublishQueue_init(&test_queue);
+  TEST_CHECK(MQTTPublishQueue_front(&test_queue) == NULL);
+  for (lap = 0; lap < 3; ++lap)
+  {
+    for (i = 0; i < MAX_QUEUED_PUBLICATIONS; ++i)
+    {
+      pub.context = (void *) i;
+      TEST_CHECK(MQTTPublishQueue_push(&test_queue, &pub) == 0);
+    }
+    TEST_CHECK(MQTTPublishQueue_push(&test_queue, &pub) == -1);
+    for (i = 0; i < MAX_QUEUED_PUBLICATIONS; ++i)
+    {
+      front = MQTTPublishQueue_front(&test_queue);
+      TEST_CHECK((front != NULL) && (front->context == (void *) i));
+      TEST_CHECK(MQTTPublishQueue_front(&test_queue) == front);
+      MQTTPublishQueue_pop(&test_queue);
+      if (i == 0)
+      {
+        /* a cell popped is free for the next push */
+        TEST_CHECK(MQTTPublishQueue_push(&test_queue, &pub) == 0);
+        TEST_CHECK(MQTTPublishQueue_push(&test_queue, &pub) == -1);
+      }
+    }
+    front = MQTTPublishQueue_front(&test_queue);
+    TEST_CHECK((front != NULL) && (front->context == (void *) (MAX_QUEUED_PUBLICATIONS - 1)));
+    MQTTPublishQueue_pop(&test_queue);
+    TEST_CHECK(MQTTPublishQueue_front(&test_queue) == NULL);
+  }
+}
+
+static void test_producers(void)
+{
+  pthread_t threads[TEST_PRODUCERS];
+  uintptr_t next[TEST_PRODUCERS] = { 0 };
+  unsigned long consumed = 0;
+  unsigned long out_of_order = 0;
+  unsigned long corrupted = 0;
+  unsigned long full = 0;
+  MQTTQueuedPublish * front;
+  uintptr_t p, n;
+
+  printf("%d producers, %d publications each\n", TEST_PRODUCERS, TEST_PUBLICATIONS);
+  MQTTPublishQueue_init(&test_queue);
+  for (p = 0; p < TEST_PRODUCERS; ++p)
+  {
+    TEST_CHECK(pthread_create(&threads[p], NULL, test_producer, (void *) p) == 0);
+  }
+
+  while (consumed < TEST_PRODUCERS * TEST_PUBLICATIONS)
+  {
+    front = MQTTPublishQueue_front(&test_queue);
+    if (front == NULL)
+    {
+      sched_yield();
+      continue;
+    }
+    p = (uintptr_t) front->context >> 16;
+    n = (uintptr_t) front->context & 0xFFFF;
+    if ((p >= TEST_PRODUCERS) || (front->topicName != test_topics[p]) || (front->payloadlen != n)
+        || (front->qos != n % 3))
+    {
+      corrupted++;
+    }
+    else if (n != next[p]++)
+    {
+      out_of_order++;
+    }
+    MQTTPublishQueue_pop(&test_queue);
+    consumed++;
+  }
+
+  for (p = 0; p < TEST_PRODUCERS; ++p)
+  {
+    pthread_join(threads[p], NULL);
+    full += test_full[p];
+    TEST_CHECK(next[p] == TEST_PUBLICATIONS);
+  }
+  TEST_CHECK((corrupted == 0) && (out_of_order == 0));
+  TEST_CHECK(MQTTPublishQueue_front(&test_queue) == NULL);
+  printf("  %lu consumed, %lu pushes refused while full\n", consumed, full);
+}
+
+int main(void)
+{
+  test_single();
+  test_producers();
+  return test_result();
+}
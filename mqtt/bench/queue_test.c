@@ -0,0 +1,282 @@
+/*
+ * queue_test.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Daruin Solano
+ *
+ *  Host test of the MQTT outbound queue (mqtt_queue.c), without a client:
+ *  MQTTPublishAsync(), MQTTIsConnected() and MQTTSetInflightWindow() are
+ *  stubs that log the publications, and the test completes them itself
+ *  through the handler the queue attached.
+ *
+ *  Checks:
+ *  - drop-oldest: the newest messages are kept, the drops are counted;
+ *  - coalesce-by-topic: the last value of a queued topic replaces the
+ *    previous one, in place; a topic not queued drops the oldest;
+ *  - recovery: the messages left in the file backend are found again, in
+ *    order, after a re-init (mqtt_queue_file_open);
+ *  - drain: at most MQTT_QUEUE_MAX_BATCH in flight, released in order
+ *    whatever the order of the completions, sent again from the oldest on
+ *    a failure, nothing sent while disconnected.
+ *
+ *  Build and run: make -C mqtt/bench queue
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <unistd.h>
+
+#include "mqtt_queue.h"
+#include "test_check.h"
+
+/* Private defines -----------------------------------------------------------*/
+#define TEST_SLOT_SIZE          64
+#define TEST_MAX_LOG            32
+
+/* Private typedef -----------------------------------------------------------*/
+typedef struct {
+  char topic[32];
+  char payload[16];
+  unsigned short id;
+} test_publication_t;
+
+/* Private variables ---------------------------------------------------------*/
+static MQTTClient test_client;
+static bool test_connected;
+static publishCompleteHandler test_complete;
+static unsigned short test_next_id;
+static test_publication_t test_log[TEST_MAX_LOG];
+static int test_published;
+
+static unsigned char test_ram[MQTT_QUEUE_RAM_SIZE(8, TEST_SLOT_SIZE)];
+static unsigned char test_stage[MQTT_QUEUE_STAGE_SIZE(TEST_SLOT_SIZE)];
+
+/* Client stubs --------------------------------------------------------------*/
+int MQTTIsConnected(MQTTClient* client)
+{
+  (void) client;
+  return test_connected;
+}
+
+int MQTTSetInflightWindow(MQTTClient* client, int window, publishCompleteHandler handler)
+{
+  client->inflight_window = window;
+  test_complete = handler;
+  return MQSUCCESS;
+}
+
+/* Logs the publication; QoS0 completes at once, as in the client. */
+int MQTTPublishAsync(MQTTClient* client, const char* topicName, MQTTMessage* message, void* context)
+{
+  test_publication_t* p;
+
+  (void) client;
+  if (test_published == TEST_MAX_LOG)
+  {
+    return FAILURE;
+  }
+  p = &test_log[test_published++];
+  snprintf(p->topic, sizeof(p->topic), "%s", topicName);
+  snprintf(p->payload, sizeof(p->payload), "%.*s", (int) message->payloadlen, (char*) message->payload);
+  p->id = (message->qos == QOS0) ? 0 : ++test_next_id;
+  message->id = p->id;
+  if (message->qos == QOS0)
+  {
+    test_complete(context, 0, MQSUCCESS);
+  }
+  return MQSUCCESS;
+}
+
+/* Private functions ---------------------------------------------------------*/
+static int test_push(mqtt_queue_t* q, const char * topic, const char * payload, enum QoS qos)
+{
+  MQTTMessage m;
+
+  memset(&m, 0, sizeof(m));
+  m.qos = qos;
+  m.payload = (void*) payload;
+  m.payloadlen = strlen(payload);
+  return mqtt_queue_push(q, topic, &m);
+}
+
+/* Was publication i of the log this topic and payload? */
+static bool test_sent(int i, const char * topic, const char * payload)
+{
+  return (i < test_published) && (strcmp(test_log[i].topic, topic) == 0)
+      && (strcmp(test_log[i].payload, payload) == 0);
+}
+
+static void test_reset(bool connected)
+{
+  memset(&test_client, 0, sizeof(test_client));
+  test_client.inflight_window = MQTT_QUEUE_MAX_BATCH;
+  test_connected = connected;
+  test_complete = NULL;
+  test_next_id = 0;
+  test_published = 0;
+}
+
+static void test_drop_oldest(void)
+{
+  mqtt_queue_backend_t be;
+  mqtt_queue_t q;
+  char payload[8];
+  int i;
+
+  printf("drop-oldest\n");
+  test_reset(true);
+  mqtt_queue_ram_init(&be, test_ram, 4, TEST_SLOT_SIZE);
+  TEST_CHECK(mqtt_queue_init(&q, &be, MQTT_QUEUE_DROP_OLDEST, test_stage) == MQSUCCESS);
+  TEST_CHECK(mqtt_queue_attach(&q, &test_client) == MQSUCCESS);
+  for (i = 0; i < 6; ++i)
+  {
+    snprintf(payload, sizeof(payload), "%d", i);
+    TEST_CHECK(test_push(&q, "t", payload, QOS0) == MQSUCCESS);
+  }
+  TEST_CHECK(mqtt_queue_count(&q) == 4);
+  TEST_CHECK(q.dropped == 2);
+
+  TEST_CHECK(mqtt_queue_drain(&q, &test_client) == MQSUCCESS);
+  TEST_CHECK(test_published == 4);
+  TEST_CHECK(test_sent(0, "t", "2") && test_sent(3, "t", "5"));
+  TEST_CHECK(mqtt_queue_drain(&q, &test_client) == MQSUCCESS);
+  TEST_CHECK(mqtt_queue_count(&q) == 0);
+}
+
+static void test_coalesce_topic(void)
+{
+  mqtt_queue_backend_t be;
+  mqtt_queue_t q;
+
+  printf("coalesce-by-topic\n");
+  test_reset(true);
+  mqtt_queue_ram_init(&be, test_ram, 3, TEST_SLOT_SIZE);
+  TEST_CHECK(mqtt_queue_init(&q, &be, MQTT_QUEUE_COALESCE_TOPIC, test_stage) == MQSUCCESS);
+  TEST_CHECK(mqtt_queue_attach(&q, &test_client) == MQSUCCESS);
+  TEST_CHECK(test_push(&q, "a", "a1", QOS1) == MQSUCCESS);
+  TEST_CHECK(test_push(&q, "b", "b1", QOS1) == MQSUCCESS);
+  TEST_CHECK(test_push(&q, "c", "c1", QOS1) == MQSUCCESS);
+  TEST_CHECK(test_push(&q, "b", "b2", QOS1) == MQSUCCESS);   /* full: replaces b1 */
+  TEST_CHECK((mqtt_queue_count(&q) == 3) && (q.coalesced == 1) && (q.dropped == 0));
+  TEST_CHECK(test_push(&q, "d", "d1", QOS1) == MQSUCCESS);   /* not queued: drops a1 */
+  TEST_CHECK((mqtt_queue_count(&q) == 3) && (q.coalesced == 1) && (q.dropped == 1));
+
+  TEST_CHECK(mqtt_queue_drain(&q, &test_client) == MQSUCCESS);
+  TEST_CHECK(test_published == 3);
+  TEST_CHECK(test_sent(0, "b", "b2") && test_sent(1, "c", "c1") && test_sent(2, "d", "d1"));
+}
+
+static void test_recovery(void)
+{
+  char path[] = "/tmp/mqtt_queue_testXXXXXX";
+  mqtt_queue_backend_t be;
+  mqtt_queue_t q;
+  int fd;
+
+  printf("recovery after re-init\n");
+  test_reset(false);
+  if ((fd = mkstemp(path)) < 0)
+  {
+    TEST_CHECK(fd >= 0);
+    return;
+  }
+  close(fd);
+
+  TEST_CHECK(mqtt_queue_file_open(&be, path, 4, TEST_SLOT_SIZE) == MQSUCCESS);
+  TEST_CHECK(mqtt_queue_init(&q, &be, MQTT_QUEUE_DROP_OLDEST, test_stage) == MQSUCCESS);
+  TEST_CHECK(mqtt_queue_count(&q) == 0);
+  TEST_CHECK(test_push(&q, "r", "r1", QOS1) == MQSUCCESS);
+  TEST_CHECK(test_push(&q, "r", "r2", QOS1) == MQSUCCESS);
+  TEST_CHECK(test_push(&q, "r", "r3", QOS1) == MQSUCCESS);
+  mqtt_queue_file_close(&be);
+
+  /* The device restarts: the three messages are back, r1 is sent and released. */
+  test_reset(true);
+  TEST_CHECK(mqtt_queue_file_open(&be, path, 4, TEST_SLOT_SIZE) == MQSUCCESS);
+  TEST_CHECK(mqtt_queue_init(&q, &be, MQTT_QUEUE_DROP_OLDEST, test_stage) == MQSUCCESS);
+  TEST_CHECK(mqtt_queue_attach(&q, &test_client) == MQSUCCESS);
+  TEST_CHECK(mqtt_queue_count(&q) == 3);
+  TEST_CHECK(mqtt_queue_drain(&q, &test_client) == MQSUCCESS);
+  TEST_CHECK(test_sent(0, "r", "r1") && test_sent(1, "r", "r2") && test_sent(2, "r", "r3"));
+  test_complete(&q, test_log[0].id, MQSUCCESS);
+  TEST_CHECK(mqtt_queue_drain(&q, &test_client) == MQSUCCESS);
+  TEST_CHECK(mqtt_queue_count(&q) == 2);
+  mqtt_queue_file_close(&be);
+
+  /* And again: r2 and r3, the ones not acknowledged, are left, and a new message goes after them. */
+  test_reset(true);
+  TEST_CHECK(mqtt_queue_file_open(&be, path, 4, TEST_SLOT_SIZE) == MQSUCCESS);
+  TEST_CHECK(mqtt_queue_init(&q, &be, MQTT_QUEUE_DROP_OLDEST, test_stage) == MQSUCCESS);
+  TEST_CHECK(mqtt_queue_attach(&q, &test_client) == MQSUCCESS);
+  TEST_CHECK(mqtt_queue_count(&q) == 2);
+  TEST_CHECK(test_push(&q, "r", "r4", QOS1) == MQSUCCESS);
+  TEST_CHECK(mqtt_queue_drain(&q, &test_client) == MQSUCCESS);
+  TEST_CHECK(test_sent(0, "r", "r2") && test_sent(1, "r", "r3") && test_sent(2, "r", "r4"));
+  mqtt_queue_file_close(&be);
+  unlink(path);
+}
+
+static void test_drain(void)
+{
+  mqtt_queue_backend_t be;
+  mqtt_queue_t q;
+  char payload[8];
+  int i;
+
+  printf("drain with completions\n");
+  test_reset(false);
+  mqtt_queue_ram_init(&be, test_ram, 8, TEST_SLOT_SIZE);
+  TEST_CHECK(mqtt_queue_init(&q, &be, MQTT_QUEUE_DROP_OLDEST, test_stage) == MQSUCCESS);
+  TEST_CHECK(mqtt_queue_attach(&q, &test_client) == MQSUCCESS);
+  for (i = 0; i < MQTT_QUEUE_MAX_BATCH + 2; ++i)
+  {
+    snprintf(payload, sizeof(payload), "m%d", i);
+    TEST_CHECK(test_push(&q, "q", payload, QOS1) == MQSUCCESS);
+  }
+
+  /* Disconnected: kept. */
+  TEST_CHECK(mqtt_queue_drain(&q, &test_client) == MQSUCCESS);
+  TEST_CHECK(test_published == 0);
+
+  /* A batch in flight. */
+  test_connected = true;
+  TEST_CHECK(mqtt_queue_drain(&q, &test_client) == MQSUCCESS);
+  TEST_CHECK(test_published == MQTT_QUEUE_MAX_BATCH);
+  TEST_CHECK(mqtt_queue_drain(&q, &test_client) == MQSUCCESS);
+  TEST_CHECK(test_published == MQTT_QUEUE_MAX_BATCH);
+
+  /* The second one acknowledged first: nothing is released until the first one is. */
+  test_complete(&q, test_log[1].id, MQSUCCESS);
+  TEST_CHECK(mqtt_queue_drain(&q, &test_client) == MQSUCCESS);
+  TEST_CHECK(mqtt_queue_count(&q) == MQTT_QUEUE_MAX_BATCH + 2);
+  test_complete(&q, test_log[0].id, MQSUCCESS);
+  TEST_CHECK(mqtt_queue_drain(&q, &test_client) == MQSUCCESS);
+  TEST_CHECK(mqtt_queue_count(&q) == MQTT_QUEUE_MAX_BATCH);
+  TEST_CHECK(test_published == MQTT_QUEUE_MAX_BATCH + 2);
+  TEST_CHECK(test_sent(MQTT_QUEUE_MAX_BATCH + 1, "q", "m5"));
+
+  /* The session is lost: all is sent again, from the oldest left. */
+  test_complete(&q, test_log[2].id, FAILURE);
+  TEST_CHECK(mqtt_queue_drain(&q, &test_client) == MQSUCCESS);
+  TEST_CHECK(mqtt_queue_count(&q) == MQTT_QUEUE_MAX_BATCH);
+  TEST_CHECK(test_published == 2 * MQTT_QUEUE_MAX_BATCH + 2);
+  TEST_CHECK(test_sent(MQTT_QUEUE_MAX_BATCH + 2, "q", "m2"));
+
+  for (i = MQTT_QUEUE_MAX_BATCH + 2; i < test_published; ++i)
+  {
+    test_complete(&q, test_log[i].id, MQSUCCESS);
+  }
+  TEST_CHECK(mqtt_queue_drain(&q, &test_client) == MQSUCCESS);
+  TEST_CHECK(mqtt_queue_count(&q) == 0);
+}
+
+int main(void)
+{
+  test_drop_oldest();
+  test_coalesce_topic();
+  test_recovery();
+  test_drain();
+  return test_result();
+}
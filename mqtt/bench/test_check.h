@@ -0,0 +1,37 @@
+/*
+ * test_check.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Daruin Solano
+ *
+ *  Checks of the host tests: a condition that does not hold is printed with
+ *  its line and counted, the test goes on; test_result() prints the verdict
+ *  and gives the exit status of the test.
+ */
+
+#ifndef __TEST_CHECK_H__
+#define __TEST_CHECK_H__
+
+#include <stdio.h>
+#include <stdbool.h>
+
+#define TEST_CHECK(cond)        test_check((cond), #cond, __LINE__)
+
+static int test_failures;
+
+static inline void test_check(bool ok, const char * what, int line)
+{
+  if (!ok)
+  {
+    printf("  FAILED line %d: %s\n", line, what);
+    test_failures++;
+  }
+}
+
+static inline int test_result(void)
+{
+  printf("%s\n", (test_failures == 0) ? "PASSED" : "FAILED");
+  return (test_failures == 0) ? 0 : 1;
+}
+
+#endif /* __TEST_CHECK_H__ */
@@ -0,0 +1,260 @@
+/*
+ * topic_bench.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Daruin Solano
+ *
+ *  Dispatch cost of the MQTT client subscription index (MQTTTopicIndex.c)
+ *  against the linear scan of the handler array it replaced
+ *  (MQTTPacket_equals() then isTopicMatched() on every slot), as the number
+ *  of subscriptions grows.
+ *
+ *  The subscriptions look like the ones of a device:
+ *  - literal command topics "devices/<id>/cmd/<name>";
+ *  - one in 8 is a '+' filter "devices/+/cfg/<name>";
+ *  - one "devices/<id>/ota/#" filter.
+ *  The published topic names cycle over all of them, and over a few topics
+ *  nobody subscribed to (the default handler case).
+ *
+ *  Per subscription count it reports ns per delivered message for both
+ *  methods, and checks that they find the same number of handlers.
+ *
+ *  Build and run: make -C mqtt/bench run
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <time.h>
+
+#include "MQTTTopicIndex.h"
+
+/* Private defines -----------------------------------------------------------*/
+#define BENCH_DEVICE            "IOT_STM32"
+#define BENCH_MAX_SUBS          (MAX_TOPIC_NODES / 4)
+#define BENCH_DEFAULT_MSGS      200000
+#define BENCH_UNMATCHED         4
+
+/* Private typedef -----------------------------------------------------------*/
+typedef struct {
+  const char * topicFilter;
+  void (*fp) (struct MessageData*);
+} bench_handler_t;
+
+/* Private variables ---------------------------------------------------------*/
+static char bench_filters[BENCH_MAX_SUBS][64];
+static char bench_names[BENCH_MAX_SUBS + BENCH_UNMATCHED][64];
+static bench_handler_t bench_handlers[BENCH_MAX_SUBS];
+static MQTTTopicIndex bench_index;
+static volatile unsigned long bench_delivered;
+
+/* Private functions ---------------------------------------------------------*/
+static void bench_handler(struct MessageData* md)
+{
+  (void) md;
+  bench_delivered++;
+}
+
+static void bench_visit(void* arg, MQTTTopicNode* node)
+{
+  (void) arg;
+  node->fp(NULL);
+}
+
+/* The matching of the former MQTTClient.c deliverMessage(), unchanged. */
+static char isTopicMatched(char* topicFilter, MQTTString* topicName)
+{
+    char* curf = topicFilter;
+    char* curn = topicName->lenstring.data;
+    char* curn_end = curn + topicName->lenstring.len;
+
+    while (*curf && curn < curn_end)
+    {
+        if (*curn == '/' && *curf != '/')
+            break;
+        if (*curf != '+' && *curf != '#' && *curf != *curn)
+            break;
+        if (*curf == '+')
+        {   // skip until we meet the next separator, or end of string
+            char* nextpos = curn + 1;
+            while (nextpos < curn_end && *nextpos != '/')
+                nextpos = ++curn + 1;
+        }
+        else if (*curf == '#')
+            curn = curn_end - 1;    // skip until end of string
+        curf++;
+        curn++;
+    };
+
+    return (curn == curn_end) && (*curf == '\0');
+}
+
+static int bench_linear(int subs, MQTTString* topicName)
+{
+  int i;
+  int count = 0;
+
+  for (i = 0; i < subs; ++i)
+  {
+    if (bench_handlers[i].topicFilter != 0 && (MQTTPacket_equals(topicName, (char*) bench_handlers[i].topicFilter) ||
+        isTopicMatched((char*) bench_handlers[i].topicFilter, topicName)))
+    {
+      if (bench_handlers[i].fp != NULL)
+      {
+        bench_handlers[i].fp(NULL);
+        count++;
+      }
+    }
+  }
+  return count;
+}
+
+static uint64_t bench_now_ns(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t) ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+/* Subscriptions and published topic names, the first subs ones are used. */
+static void bench_build(void)
+{
+  int i;
+
+  for (i = 0; i < BENCH_MAX_SUBS; ++i)
+  {
+    if (i == 0)
+    {
+      snprintf(bench_filters[i], sizeof(bench_filters[i]), "devices/%s/ota/#", BENCH_DEVICE);
+      snprintf(bench_names[i], sizeof(bench_names[i]), "devices/%s/ota/chunk", BENCH_DEVICE);
+    }
+    else if (i % 8 == 7)
+    {
+      snprintf(bench_filters[i], sizeof(bench_filters[i]), "devices/+/cfg/param%d", i);
+      snprintf(bench_names[i], sizeof(bench_names[i]), "devices/%s/cfg/param%d", BENCH_DEVICE, i);
+    }
+    else
+    {
+      snprintf(bench_filters[i], sizeof(bench_filters[i]), "devices/%s/cmd/command%d", BENCH_DEVICE, i);
+      snprintf(bench_names[i], sizeof(bench_names[i]), "devices/%s/cmd/command%d", BENCH_DEVICE, i);
+    }
+  }
+  for (i = 0; i < BENCH_UNMATCHED; ++i)
+  {
+    snprintf(bench_names[BENCH_MAX_SUBS + i], sizeof(bench_names[0]), "devices/%s/status/unsubscribed%d", BENCH_DEVICE, i);
+  }
+}
+
+/* Topic names of the run: the subs subscribed ones, then the unmatched ones. */
+static int bench_topics(int subs, MQTTString* topics)
+{
+  int i;
+  int n = 0;
+
+  for (i = 0; i < subs; ++i)
+  {
+    topics[n].cstring = NULL;
+    topics[n].lenstring.data = bench_names[i];
+    topics[n++].lenstring.len = strlen(bench_names[i]);
+  }
+  for (i = 0; i < BENCH_UNMATCHED; ++i)
+  {
+    topics[n].cstring = NULL;
+    topics[n].lenstring.data = bench_names[BENCH_MAX_SUBS + i];
+    topics[n++].lenstring.len = strlen(bench_names[BENCH_MAX_SUBS + i]);
+  }
+  return n;
+}
+
+static int bench_run(int subs, long msgs)
+{
+  static MQTTString topics[BENCH_MAX_SUBS + BENCH_UNMATCHED];
+  int ntopics;
+  int i;
+  long m;
+  uint64_t t0;
+  double linear_ns;
+  double trie_ns;
+  unsigned long linear_hits = 0;
+  unsigned long trie_hits = 0;
+
+  memset(bench_handlers, 0, sizeof(bench_handlers));
+  MQTTTopicIndex_init(&bench_index);
+  for (i = 0; i < subs; ++i)
+  {
+    bench_handlers[i].topicFilter = bench_filters[i];
+    bench_handlers[i].fp = bench_handler;
+    if (MQTTTopicIndex_add(&bench_index, bench_filters[i], bench_handler, NULL) != 0)
+    {
+      printf("out of topic nodes at %d subscriptions\n", i);
+      return -1;
+    }
+  }
+  ntopics = bench_topics(subs, topics);
+
+  t0 = bench_now_ns();
+  for (m = 0; m < msgs; ++m)
+  {
+    linear_hits += bench_linear(subs, &topics[m % ntopics]);
+  }
+  linear_ns = (double) (bench_now_ns() - t0) / msgs;
+
+  t0 = bench_now_ns();
+  for (m = 0; m < msgs; ++m)
+  {
+    trie_hits += MQTTTopicIndex_match(&bench_index, &topics[m % ntopics], bench_visit, NULL);
+  }
+  trie_ns = (double) (bench_now_ns() - t0) / msgs;
+
+  printf("%6d %8d %12.1f %12.1f %8.1fx %s\n", subs, bench_index.subscriptions, linear_ns, trie_ns,
+         linear_ns / trie_ns, (linear_hits == trie_hits) ? "" : "MISMATCH");
+  return (linear_hits == trie_hits) ? 0 : -1;
+}
+
+static void bench_usage(const char * prog)
+{
+  printf("usage: %s [-m messages_per_point] [-s max_subscriptions]\n"
+         "  subscriptions: 1, 2, 4... up to %d (MAX_TOPIC_NODES / 4)\n", prog, BENCH_MAX_SUBS);
+}
+
+int main(int argc, char ** argv)
+{
+  long msgs = BENCH_DEFAULT_MSGS;
+  int max_subs = BENCH_MAX_SUBS;
+  int subs;
+  int rc = 0;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "m:s:h")) != -1)
+  {
+    switch (opt)
+    {
+      case 'm': msgs = atol(optarg); break;
+      case 's': max_subs = atoi(optarg); break;
+      default:
+        bench_usage(argv[0]);
+        return (opt == 'h') ? 0 : 1;
+    }
+  }
+  if ((msgs <= 0) || (max_subs <= 0) || (max_subs > BENCH_MAX_SUBS))
+  {
+    bench_usage(argv[0]);
+    return 1;
+  }
+
+  bench_build();
+  printf("MQTT dispatch, %ld messages per point, ns per message (%d topic nodes, %u bytes index)\n",
+         msgs, MAX_TOPIC_NODES, (unsigned) sizeof(MQTTTopicIndex));
+  printf("%6s %8s %12s %12s %9s\n", "subs", "indexed", "linear", "trie", "speedup");
+  for (subs = 1; subs <= max_subs; subs *= 2)
+  {
+    rc |= bench_run(subs, msgs);
+  }
+  if ((subs / 2) != max_subs)
+  {
+    rc |= bench_run(max_subs, msgs);
+  }
+  return (rc == 0) ? 0 : 1;
+}
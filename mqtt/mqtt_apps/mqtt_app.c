@@ -7,16 +7,35 @@
 
 #include "mqtt_app.h"
 #include "MQTTClient.h"
+#include "mqtt_queue.h"
+#include "mqtt_reconnect.h"
+#include "mqtt_batch.h"
 #include "cJSON.h"
+#include "json_writer.h"
+#include "cJSON_CBOR.h"
+#include "cbor.h"
 #include "aws_cert.h"
+#ifdef USE_DER_CREDENTIALS
+#include "aws_cert_der.h"	/* generated by netsock/tools/pem2der.py */
+#endif
 #include "timedate.h"
+#ifdef SENSORS
+#include "sensors_data.h"
+#include "sensors_sampling.h"
+#include "sensors_aggregate.h"
+#endif
 
 extern timestamp_t ts;
 
 
-static uint32_t backoff_ms = RECONN_MIN_MS;
 static void allpurposeMessageHandler(MessageData *data);
-static int mqtt_client_publish(MQTTClient *client, device_config_t *dev) ;
+static int mqtt_client_publish(device_config_t *dev) ;
+static void mqtt_client_sample(bool requested);
+static int mqtt_client_queue(int len);
+#ifdef SENSORS
+static void mqtt_client_aggregate(void);
+static int mqtt_client_publish_stats(device_config_t *dev);
+#endif
 
 /* Detailed variables for the mqtt apps*/
 /*For use in MQTT client task*/
@@ -34,6 +53,95 @@ static char mqtt_subtopic[MQTT_TOPIC_BUFFER_SIZE];
 static char mqtt_pubtopic[MQTT_TOPIC_BUFFER_SIZE];
 static char mqtt_msg[MQTT_MSG_BUFFER_SIZE];
 
+/* Telemetry payload: the members of the sample records published as they are, see json_writer.h */
+static const json_field_t status_fields[] = {
+	JSON_FIELD(status_data_t, LedOn, "LedOn", JSON_FIELD_BOOL),
+};
+static const json_field_t pub_fields[] = {
+	JSON_FIELD(pub_data_t, tstamp, "timestamp", JSON_FIELD_STRPTR),
+	JSON_FIELD(pub_data_t, mac, "MacAddress", JSON_FIELD_STRING),
+};
+
+/* Sample of the telemetry batch: the members shared by the samples (ID, MacAddress, ...) are written once per batch. */
+typedef struct {
+	uint32_t dt;		/* ms since the first sample of the batch, the one of the timestamp */
+	float temperature;	/* Fahrenheit */
+	float humidity;
+} telemetry_sample_t;
+
+static const json_field_t sample_fields[] = {
+	JSON_FIELD(telemetry_sample_t, dt, "dt", JSON_FIELD_UINT32),
+	JSON_FIELD_DEC(telemetry_sample_t, temperature, "Temperature", 0),
+	JSON_FIELD_DEC(telemetry_sample_t, humidity, "Humidity", 0),
+};
+
+static telemetry_sample_t telemetry_samples[TELEMETRY_BATCH_SAMPLES];
+static mqtt_batch_t telemetry_batch;
+
+#ifdef SENSORS
+/* Windowed statistics: the summaries of the channels below, batched as records of the stats topic. */
+typedef struct {
+	const char *name;
+	sensors_agg_config_t config;
+} stats_channel_t;
+
+static const stats_channel_t stats_channels[] = {
+	/* tumbling, in mg: the +-2 g full scale */
+	{ "acc_x", { SENSOR_CH_ACC_X, STATS_WINDOW_MS, STATS_WINDOW_MS, -2000.0f, 2000.0f } },
+	{ "acc_y", { SENSOR_CH_ACC_Y, STATS_WINDOW_MS, STATS_WINDOW_MS, -2000.0f, 2000.0f } },
+	{ "acc_z", { SENSOR_CH_ACC_Z, STATS_WINDOW_MS, STATS_WINDOW_MS, -2000.0f, 2000.0f } },
+	/* sliding, in Celsius */
+	{ "temperature", { SENSOR_CH_TEMPERATURE, STATS_SLIDING_WINDOWS * STATS_WINDOW_MS, STATS_WINDOW_MS, -10.0f, 50.0f } },
+};
+#define STATS_CHANNELS	(sizeof(stats_channels) / sizeof(stats_channels[0]))
+#define STATS_PANES		(3 + STATS_SLIDING_WINDOWS)	/* a pane per window, STATS_SLIDING_WINDOWS for the sliding one */
+
+typedef struct {
+	const char *channel;
+	uint32_t window_s;
+	uint32_t count;
+	float min;
+	float max;
+	float mean;
+	float variance;
+	float p50;
+	float p90;
+	float p99;
+} stats_record_t;
+
+static const json_field_t stats_fields[] = {
+	JSON_FIELD(stats_record_t, channel, "ch", JSON_FIELD_STRPTR),
+	JSON_FIELD(stats_record_t, window_s, "win", JSON_FIELD_UINT32),
+	JSON_FIELD(stats_record_t, count, "n", JSON_FIELD_UINT32),
+	JSON_FIELD_DEC(stats_record_t, min, "min", 1),
+	JSON_FIELD_DEC(stats_record_t, max, "max", 1),
+	JSON_FIELD_DEC(stats_record_t, mean, "mean", 1),
+	JSON_FIELD_DEC(stats_record_t, variance, "var", 1),
+	JSON_FIELD_DEC(stats_record_t, p50, "p50", 1),
+	JSON_FIELD_DEC(stats_record_t, p90, "p90", 1),
+	JSON_FIELD_DEC(stats_record_t, p99, "p99", 1),
+};
+
+static sensors_agg_t stats_agg[STATS_CHANNELS];
+static sensors_agg_pane_t stats_panes[STATS_PANES];
+static stats_record_t stats_records[STATS_BATCH_RECORDS];
+static mqtt_batch_t stats_batch;
+
+sensors_deadband_t telemetry_deadband;
+#endif
+
+/* Telemetry is queued, then forwarded when the link is up. */
+static unsigned char telemetry_queue_ram[MQTT_QUEUE_RAM_SIZE(TELEMETRY_QUEUE_SLOTS, TELEMETRY_QUEUE_SLOT_SIZE)];
+static unsigned char telemetry_queue_stage[MQTT_QUEUE_STAGE_SIZE(TELEMETRY_QUEUE_SLOT_SIZE)];
+static mqtt_queue_backend_t telemetry_queue_be;
+static mqtt_queue_t telemetry_queue;
+
+/* Paces the reconnections, and measures them. */
+static mqtt_reconnect_t reconnect;
+
+/* Sample requested out of period, see mqtt_sample_ready(). */
+static volatile bool sample_ready;
+
 /* Detailed variables for the mqtt apps*/
 extern net_hnd_t hnet;
 extern RTC_t rtc;
@@ -61,122 +169,259 @@ static void mqtt_hard_reset(Network *net, MQTTClient *mc)
     }
 }
 
-static int mqtt_do_connect_and_subscribe(MQTTClient *mc,
-                                        MQTTPacket_connectData *opt,
-                                        const char *subtopic)
+/* Reconnection attempt of the supervisor. The fast path opens a new socket to the cached broker
+ * address, without NTP nor DNS; the full one resolves the broker again. The session is resumed
+ * (cleansession 0): the client sends the unacknowledged telemetry again, and the subscription
+ * is only renewed if the broker lost it. */
+static int mqtt_reconnect_cb(void *ctx, bool full)
 {
-    int rc = MQTTConnect(mc, opt);
-    if (rc != SUCCESS) return rc;
+	MQTTConnackData connack;
+	int rc;
+
+	(void) ctx;
+	mqtt_hard_reset(&net, &mc);
 
-    rc = MQTTSubscribe(mc, subtopic, QOS0, allpurposeMessageHandler);
-    return rc;
+	rc = full ? mqtt_network_init(&net, &dev) : mqtt_network_reconnect(&net, &dev);
+	if (rc != NET_OK) {
+		return FAILURE;
+	}
+
+	rc = MQTTConnectWithResults(&mc, &options, &connack);
+	if ((rc == SUCCESS) && !connack.sessionPresent) {
+		rc = MQTTSubscribe(&mc, mqtt_subtopic, QOS0, allpurposeMessageHandler);
+	}
+	return rc;
+}
+
+static uint32_t mqtt_tick(void)
+{
+	return HAL_GetTick();
+}
+
+void mqtt_sample_ready(void)
+{
+	sample_ready = true;
 }
 
+/* Event loop: the client processes the incoming packets as they arrive (downlink commands within
+ * the network round trip), its keepalive and retransmissions at their deadlines, and the queued
+ * telemetry goes out as soon as the acks open the window. */
 void mqtt_main(void) {
-	uint32_t last_pub = 0;
+	uint32_t last_sample = 0;
 
 	while (1) {
+		uint32_t now = HAL_GetTick();
+		uint32_t wait = EVENT_WAIT_MS;
 
-		/* 1) Ensure connected */
-		if (!MQTTIsConnected(&mc)) {
-
-			msg_debug("MQTT: connecting...\n");
-			int rc = mqtt_do_connect_and_subscribe(&mc, &options,
-					mqtt_subtopic);
+#if defined(SENSORS) && !defined(SENSORS_TASK)
+		/* 0) Acquire the sensors that are due, at their own rates: the samples only read the last values */
+		wait = sensors_sampling_poll();
+#endif
 
-			if (rc != SUCCESS) {
-				msg_error("MQTT: connect/sub failed rc=%d\n", rc);
+#ifdef SENSORS
+		/* The deadband configuration staged by another task, e.g. the REST API, applies from here */
+		if (sensors_deadband_update(&telemetry_deadband) > 0) {
+			msg_info("Telemetry deadband updated\n");
+		}
+#endif
 
-				mqtt_hard_reset(&net, &mc);
+		/* 1) Sample periodically or on request, connected or not: the queue keeps the telemetry during outages.
+		 *    The samples are batched; a batch is queued when full, old, urgent or requested. */
+		if (sample_ready || ((now - last_sample) >= SAMPLE_INTERVAL_MS)) {
+			bool requested = sample_ready;
 
-				HAL_Delay(backoff_ms);
-				backoff_ms =
-						(backoff_ms < RECONN_MAX_MS) ?
-								(backoff_ms * 2) : RECONN_MAX_MS;
-				continue;
+			if (requested) {
+				sample_ready = false;
+				mqtt_batch_request(&telemetry_batch);
+			}
+			mqtt_client_sample(requested);
+			last_sample = now;
+		}
+		if (mqtt_batch_due(&telemetry_batch)) {
+			if (mqtt_client_publish(&dev) != MQSUCCESS) {
+				msg_error("MQTT: telemetry batch lost\n");
 			}
+		}
+#ifdef SENSORS
+		mqtt_client_aggregate();
+		if (mqtt_batch_due(&stats_batch)) {
+			if (mqtt_client_publish_stats(&dev) != MQSUCCESS) {
+				msg_error("MQTT: stats batch lost\n");
+			}
+		}
+#endif
 
-			/* Success => reset backoff */
-			backoff_ms = RECONN_MIN_MS;
+		/* 2) Ensure connected: the supervisor paces the attempts, keep sampling meanwhile */
+		if (mqtt_reconnect_poll(&reconnect, MQTTIsConnected(&mc)) != MQSUCCESS) {
+			HAL_Delay(MIN(wait, MIN(EVENT_WAIT_MS, mqtt_reconnect_wait_ms(&reconnect) + 1)));
+			continue;
 		}
 
-		/* 2) Service keepalive + incoming packets */
-		int rc = MQTTYield(&mc, YIELD_MS);
+		/* 3) Wait for the next incoming packet, at most until the next acquisition, sample or age flush of the batch */
+		wait = MIN(wait, SAMPLE_INTERVAL_MS - MIN(SAMPLE_INTERVAL_MS, HAL_GetTick() - last_sample));
+		wait = MIN(wait, mqtt_batch_wait_ms(&telemetry_batch));
+#ifdef SENSORS
+		wait = MIN(wait, mqtt_batch_wait_ms(&stats_batch));
+#endif
+		int rc = MQTTWaitEvent(&mc, MIN(wait, EVENT_WAIT_MS));
+		if (rc < 0) {
+			msg_error("MQTT: connection lost rc=%d -> reconnecting\n", rc);
+			mqtt_reconnect_lost(&reconnect);
+			continue;
+		}
+
+		/* 4) Forward the queued telemetry, in order */
+		rc = mqtt_queue_drain(&telemetry_queue, &mc);
 		if (rc != SUCCESS) {
-			msg_error("MQTT: yield failed rc=%d -> reset\n", rc);
-			mqtt_hard_reset(&net, &mc);
-			HAL_Delay(500);
+			msg_error("MQTT: publish failed rc=%d -> reconnecting\n", rc);
+			mqtt_reconnect_lost(&reconnect);
 			continue;
 		}
+	}
+}
 
-		/* 3) Publish periodically */
-		uint32_t now = HAL_GetTick();
-		if ((now - last_pub) >= PUB_INTERVAL_MS) {
-			rc = mqtt_client_publish(&mc, &dev); /* make this return SUCCESS/FAIL */
-			if (rc != SUCCESS) {
-				msg_error("MQTT: publish failed rc=%d -> reset\n", rc);
-				mqtt_hard_reset(&net, &mc);
-				HAL_Delay(500);
-				continue;
+
+/* Last values of the sensors into the batch, no bus access; the first sample of a batch gives its timestamp.
+ * With the sensors, a sample is batched by exception: a channel changed, its heartbeat, or requested. */
+static void mqtt_client_sample(bool requested) {
+	telemetry_sample_t sample;
+#ifdef SENSORS
+	sensors_snapshot_t snap;
+	uint32_t now = HAL_GetTick();
+
+	sensors_snapshot(&snap);
+	/* A channel not read yet holds 0: no sample of it, nor reference of its deadband. */
+	if (!(snap.valid & (1u << SENSOR_CH_TEMPERATURE)) || !(snap.valid & (1u << SENSOR_CH_HUMIDITY))) {
+		return;
+	}
+	pub_data.temperature = snap.value[SENSOR_CH_TEMPERATURE];
+	pub_data.humidity = snap.value[SENSOR_CH_HUMIDITY];
+
+	if (!(sensors_deadband_check(&telemetry_deadband, SENSOR_CH_TEMPERATURE, pub_data.temperature, now)
+			| sensors_deadband_check(&telemetry_deadband, SENSOR_CH_HUMIDITY, pub_data.humidity, now))
+			&& !requested) {
+		return;
+	}
+	sensors_deadband_reported(&telemetry_deadband, SENSOR_CH_TEMPERATURE, pub_data.temperature, now);
+	sensors_deadband_reported(&telemetry_deadband, SENSOR_CH_HUMIDITY, pub_data.humidity, now);
+#else
+	(void) requested;
+#endif
+	if (telemetry_batch.count == 0) {
+		getTimestamp(ts.ts, sizeof(ts.ts));
+		pub_data.tstamp = &(ts.ts[0]);
+	}
+	sample.dt = mqtt_batch_elapsed_ms(&telemetry_batch);
+	sample.temperature = (pub_data.temperature * 9.0f / 5.0f) + 32.0f;	// from celcius to farenheit
+	sample.humidity = pub_data.humidity;
+	mqtt_batch_add(&telemetry_batch, &sample);
+}
+
+#ifdef SENSORS
+/* Summaries of the windows closed since the last call, into the stats batch. */
+static void mqtt_client_aggregate(void) {
+	sensors_agg_summary_t summary;
+	stats_record_t record;
+	size_t i;
+
+	for (i = 0; i < STATS_CHANNELS; ++i) {
+		while (sensors_agg_poll(&stats_agg[i], &summary)) {
+			record.channel = stats_channels[i].name;
+			record.window_s = (summary.end_tick - summary.start_tick) / 1000;
+			record.count = summary.count;
+			record.min = summary.min;
+			record.max = summary.max;
+			record.mean = summary.mean;
+			record.variance = summary.variance;
+			record.p50 = summary.p50;
+			record.p90 = summary.p90;
+			record.p99 = summary.p99;
+			if (mqtt_batch_add(&stats_batch, &record)) {
+				if (mqtt_client_publish_stats(&dev) != MQSUCCESS) {
+					msg_error("MQTT: stats batch lost\n");
+				}
 			}
-			last_pub = now;
 		}
 	}
 }
 
+static int mqtt_client_publish_stats(device_config_t* dev) {
+	char stamp[sizeof(ts.ts)];	/* ts holds the timestamp of the telemetry batch */
+	json_writer_t w;
+	int len;
+
+	snprintf(mqtt_pubtopic, MQTT_TOPIC_BUFFER_SIZE, "/sensors/%s/stats",
+			dev->MQClientId);
+
+#if (TELEMETRY_FORMAT == PAYLOAD_CBOR)
+	json_writer_init_cbor(&w, mqtt_msg, MQTT_MSG_BUFFER_SIZE);
+#else
+	json_writer_init(&w, mqtt_msg, MQTT_MSG_BUFFER_SIZE);
+#endif
+	getTimestamp(stamp, sizeof(stamp));
+	json_write_string(&w, "ID", dev->MQClientId);
+	json_write_string(&w, "timestamp", stamp);
+	mqtt_batch_write(&stats_batch, &w, "stats");
+	len = json_writer_end(&w);
+	mqtt_batch_clear(&stats_batch);
+
+	return mqtt_client_queue(len);
+}
+#endif
 
-static int mqtt_client_publish(MQTTClient *client, device_config_t* dev) {
-	MQTTMessage mqmsg;
+
+static int mqtt_client_publish(device_config_t* dev) {
+	json_writer_t w;
+	int len;
 
 	snprintf(mqtt_pubtopic, MQTT_TOPIC_BUFFER_SIZE, "/sensors/%s",
 			dev->MQClientId);
-#ifdef SENSORS
-	/*Read data from sensors*/
-	pub_data.temperature = BSP_TSENSOR_ReadTemp();
-	pub_data.humidity = BSP_HSENSOR_ReadHumidity();
+
+	/* compact JSON (or CBOR), written straight into the message buffer: no heap, no tree.
+	 * The shared members once, then the samples of the batch. */
+#if (TELEMETRY_FORMAT == PAYLOAD_CBOR)
+	json_writer_init_cbor(&w, mqtt_msg, MQTT_MSG_BUFFER_SIZE);
+#else
+	json_writer_init(&w, mqtt_msg, MQTT_MSG_BUFFER_SIZE);
 #endif
-	getTimestamp(ts.ts, sizeof(ts.ts));
-	pub_data.tstamp = &(ts.ts[0]);
-
-	/*create Json object to publish data*/
-	cJSON *publish_data = cJSON_CreateObject();
-	cJSON_AddStringToObject(publish_data, "ID", dev->MQClientId);
-	cJSON_AddBoolToObject(publish_data, "LedOn", status_data.LedOn);
-	cJSON_AddNumberToObject(publish_data, "Temperature",
-			(int)(pub_data.temperature * 9.0 / 5.0) + 32.0);	// from celcius to farenheit
-	cJSON_AddNumberToObject(publish_data, "Humidity", (int)pub_data.humidity);
-	cJSON_AddStringToObject(publish_data, "timestamp", pub_data.tstamp);
-	cJSON_AddStringToObject(publish_data, "MacAddress", pub_data.mac);
-	// Convert JSON to String
-	char *msg = cJSON_Print(publish_data);
-	if (msg == NULL) {
-	    cJSON_Delete(publish_data);
-	    return -1; // Handle allocation failure
-	}
-	strcpy(mqtt_msg, msg);
-	cJSON_Delete(publish_data);
-	rc = strlen(mqtt_msg);
-	free(msg);
+	json_write_string(&w, "ID", dev->MQClientId);
+	json_write_fields(&w, status_fields, JSON_FIELDS(status_fields), &status_data);
+	json_write_fields(&w, pub_fields, JSON_FIELDS(pub_fields), &pub_data);
+	json_write_uint(&w, "Reconnects", reconnect.reconnects);
+	json_write_uint(&w, "ReconnectMs", reconnect.last_ms);
+	json_write_uint(&w, "AckRttMs", mc.inflightStats.rtt_last_ms);
+	json_write_uint(&w, "Retries", mc.inflightStats.retries);
+	mqtt_batch_write(&telemetry_batch, &w, "samples");
+	len = json_writer_end(&w);
+	mqtt_batch_clear(&telemetry_batch);	/* queued from now on, or lost */
+
+	return mqtt_client_queue(len);
+}
+
+/* Queue the message of mqtt_msg, of len bytes (< 0: the formatting failed), to mqtt_pubtopic. */
+static int mqtt_client_queue(int len) {
+	MQTTMessage mqmsg = { 0 };
 
-	if ((rc < 0) || (rc >= MQTT_MSG_BUFFER_SIZE)) {
+	if (len < 0) {
 		msg_error("MQTT Telemetry message formatting error...");
+		rc = len;
 	} else {
-		mqmsg.qos = QOS0;
+		mqmsg.qos = QOS1;	/* acknowledged: leaves the queue once received */
 		mqmsg.payload = (char*) mqtt_msg;
-		mqmsg.payloadlen = strlen(mqtt_msg);
+		mqmsg.payloadlen = len;
 
-		rc = MQTTPublish(client, mqtt_pubtopic, &mqmsg);
-
-		if (rc != MQSUCCESS) {
-			msg_error("Failed mqtt publishing %s on %s",
-					(char* )(mqmsg.payload), mqtt_pubtopic);
-		}
+		rc = mqtt_queue_push(&telemetry_queue, mqtt_pubtopic, &mqmsg);
 
 		if (rc == MQSUCCESS) {
 			/* Visual notification of the telemetry publication: LED blink. */
 			msg_info("#\n");
-			msg_info("MQTT publication topic: %s \tpayload: %s", mqtt_pubtopic,
-					mqtt_msg);
+#if (TELEMETRY_FORMAT == PAYLOAD_CBOR)
+			msg_info("MQTT batch queued (%lu pending) topic: %s \tCBOR payload: %d bytes",
+					(unsigned long)mqtt_queue_count(&telemetry_queue), mqtt_pubtopic, (int)mqmsg.payloadlen);
+#else
+			msg_info("MQTT batch queued (%lu pending) topic: %s \tpayload: %s",
+					(unsigned long)mqtt_queue_count(&telemetry_queue), mqtt_pubtopic, mqtt_msg);
+#endif
 		} else {
 			msg_error("Telemetry publication failed...");
 		}
@@ -192,18 +437,27 @@ static int mqtt_client_publish(MQTTClient *client, device_config_t* dev) {
  *        TODO: Maybe store couples of hander/contextHanders so that the context could
  *              be retrieved from the handler address. */
 static void allpurposeMessageHandler(MessageData *data) {
+	const unsigned char *payload = (const unsigned char*) data->message->payload;
+	cJSON *root;
+
+	/* JSON or CBOR: a CBOR map starts with a byte of major type 5, 0xA0 to 0xBF */
+	if ((data->message->payloadlen > 0) && ((payload[0] >> 5) == CBOR_MAJOR_MAP)) {
+		msg_info("Received message: length: %d topic: %s content: CBOR, %d bytes\n",
+				data->topicName->lenstring.len, data->topicName->lenstring.data,
+				(int)data->message->payloadlen);
+		root = cJSON_FromCBOR(payload, data->message->payloadlen);
+	} else {
+		snprintf(mqtt_msg, MIN(MQTT_MSG_BUFFER_SIZE, data->message->payloadlen + 1),
+				"%s", (char*) data->message->payload);
 
-	snprintf(mqtt_msg, MIN(MQTT_MSG_BUFFER_SIZE, data->message->payloadlen + 1),
-			"%s", (char*) data->message->payload);
-
-	msg_info("Received message: length: %d topic: %s content: %s\n",
-			data->topicName->lenstring.len, data->topicName->lenstring.data,
-			mqtt_msg);
-
-	cJSON *json = cJSON_Parse(mqtt_msg);
+		msg_info("Received message: length: %d topic: %s content: %s\n",
+				data->topicName->lenstring.len, data->topicName->lenstring.data,
+				mqtt_msg);
 
+		root = cJSON_Parse(mqtt_msg);
+	}
 
-	json = cJSON_GetObjectItemCaseSensitive(json, "LedOn");
+	cJSON *json = cJSON_GetObjectItemCaseSensitive(root, "LedOn");
 	if (json != NULL) {
 		if (cJSON_IsBool(json) == true) {
 			status_data.LedOn = (cJSON_IsTrue(json) == true)?true:false;
@@ -212,7 +466,17 @@ static void allpurposeMessageHandler(MessageData *data) {
 			msg_error("JSON parsing error of LedOn value.\n");
 		}
 	}
-	cJSON_Delete(json);
+#ifdef SENSORS
+	json = cJSON_GetObjectItemCaseSensitive(root, "Deadband");
+	if (json != NULL) {
+		if (sensors_deadband_from_json(&telemetry_deadband, json) < 0) {
+			msg_error("JSON parsing error of Deadband value.\n");
+		} else {
+			msg_info("Telemetry deadband updated\n");
+		}
+	}
+#endif
+	cJSON_Delete(root);
 }
 
 
@@ -223,11 +487,8 @@ char key[2048];
 void mqtt_start(void)
  {
 #ifdef SENSORS
-	if (BSP_TSENSOR_Init() != TSENSOR_OK){
-		msg_error("Temperature sensor failed init HTS221...");
-	}
-	if (BSP_HSENSOR_Init() != HSENSOR_OK){
-		msg_error("Humidity sensor failed init HTS221...");
+	if (init_sensors_sampling() != 0){
+		msg_error("Sensors failed init, sampling...");
 	}
 #endif
 	/* https://testclient-cloud.mqtt.cool/ */
@@ -241,12 +502,22 @@ void mqtt_start(void)
 	dev.MQClientId = "IOT_STM32";
 	dev.HostName = "a1rowpbf3j3tx6-ats.iot.us-east-2.amazonaws.com";
 	dev.HostPort = 8883;
+#ifdef USE_DER_CREDENTIALS
+	/* DER arrays stay in flash, no PEM decoding at connect time */
+	dev.tls_ca_certs = (const char*)AWS_ROOT_CA1_DER;
+	dev.tls_ca_certs_len = AWS_ROOT_CA1_DER_LEN;
+	dev.tls_dev_cert = (const char*)AWS_CERTIFICATE_DER;
+	dev.tls_dev_cert_len = AWS_CERTIFICATE_DER_LEN;
+	dev.tls_dev_key = (const char*)AWS_PRIVATE_KEY_DER;
+	dev.tls_dev_key_len = AWS_PRIVATE_KEY_DER_LEN;
+#else
 	dev.tls_ca_certs = AWS_ROOT_CA1;
 	dev.tls_ca_certs_len = strlen(AWS_ROOT_CA1);
 	dev.tls_dev_cert = AWS_CERTIFICATE;
 	dev.tls_dev_cert_len = strlen(AWS_CERTIFICATE);
 	dev.tls_dev_key = AWS_PRIVATE_KEY;
 	dev.tls_dev_key_len = strlen(AWS_PRIVATE_KEY);
+#endif
 
 	/*HiveMQ*/
 //	dev.HostName = "17a7d54f7ea545de987ea3e8b031234a.s1.eu.hivemq.cloud";
@@ -260,6 +531,16 @@ void mqtt_start(void)
 //	dev.tls_dev_cert = NULL;
 //	dev.tls_dev_key = NULL;
 
+	/* On-prem broker, TLS-PSK: no certificate on either side */
+//	static const uint8_t psk[16] = { 0 };	/* provisioned key */
+//	dev.HostName = "broker.local";
+//	dev.MQClientId = "IOT_STM32";
+//	dev.HostPort = 8883;
+//	dev.ConnSecurity = CONN_SEC_PSK;
+//	dev.tls_psk = psk;
+//	dev.tls_psk_len = sizeof(psk);
+//	dev.tls_psk_identity = "IOT_STM32";
+
 	net_macaddr_t  macAddr;
 
 	/* Network init, just in case there network is not connected yet*/
@@ -285,11 +566,54 @@ void mqtt_start(void)
 	MQTTClientInit(&mc, &net, MQTT_CMD_TIMEOUT, mqtt_send_buffer,
 	MQTT_SEND_BUFFER_SIZE, mqtt_read_buffer, MQTT_READ_BUFFER_SIZE);
 
+	mqtt_batch_init(&telemetry_batch, telemetry_samples, TELEMETRY_BATCH_SAMPLES, sizeof(telemetry_samples[0]),
+			sample_fields, JSON_FIELDS(sample_fields), mqtt_tick);
+	telemetry_batch.policy.max_age_ms = PUB_INTERVAL_MS;
+	telemetry_batch.policy.urgent_offset = offsetof(telemetry_sample_t, temperature);
+	telemetry_batch.policy.urgent_low = TELEMETRY_URGENT_LOW_F;
+	telemetry_batch.policy.urgent_high = TELEMETRY_URGENT_HIGH_F;
+#ifdef SENSORS
+	{
+		size_t i, used = 0;
+
+		for (i = 0; i < STATS_CHANNELS; ++i) {
+			if (sensors_agg_init(&stats_agg[i], &stats_channels[i].config, &stats_panes[used], STATS_PANES - used) != 0) {
+				msg_error("Stats of %s: bad window\n", stats_channels[i].name);
+			} else {
+				used += stats_agg[i].pane_count;
+			}
+		}
+	}
+	mqtt_batch_init(&stats_batch, stats_records, STATS_BATCH_RECORDS, sizeof(stats_records[0]),
+			stats_fields, JSON_FIELDS(stats_fields), mqtt_tick);
+	stats_batch.policy.max_age_ms = STATS_FLUSH_MS;
+
+	{
+		sensors_deadband_config_t db = { TELEMETRY_DEADBAND_TEMP_C, 0.0f, TELEMETRY_HEARTBEAT_MS, TELEMETRY_MIN_REPORT_MS };
+
+		sensors_deadband_init(&telemetry_deadband);
+		sensors_deadband_set(&telemetry_deadband, SENSOR_CH_TEMPERATURE, &db);
+		db.abs = TELEMETRY_DEADBAND_HUMIDITY;
+		sensors_deadband_set(&telemetry_deadband, SENSOR_CH_HUMIDITY, &db);
+	}
+#endif
+
+	mqtt_queue_ram_init(&telemetry_queue_be, telemetry_queue_ram, TELEMETRY_QUEUE_SLOTS, TELEMETRY_QUEUE_SLOT_SIZE);
+	if ((mqtt_queue_init(&telemetry_queue, &telemetry_queue_be, TELEMETRY_QUEUE_POLICY, telemetry_queue_stage) != MQSUCCESS)
+			|| (mqtt_queue_attach(&telemetry_queue, &mc) != MQSUCCESS)) {
+		msg_error("Telemetry queue init failed\n");
+	}
+
 	/* MQTT connect */
 	options.clientID.cstring = dev.MQClientId;
 	options.username.cstring = dev.MQUserName;
 	options.password.cstring = dev.MQUserPwd;
 	options.keepAliveInterval = 60;
+	options.cleansession = 0;	/* resumed on reconnection, with the unacknowledged telemetry */
+#if defined(MQTTV5)
+	options.MQTTVersion = 5;	/* topic aliases: the sensor topics are sent once per connection */
+	MQTTSetSessionExpiry(&mc, MQTT_SESSION_EXPIRY_S);
+#endif
 	options.will.message.cstring = "will message";
 	options.will.qos = 1;
 	options.will.retained = 0;
@@ -309,7 +633,15 @@ void mqtt_start(void)
 		msg_error("Failed subscribing to the %s topic rc = %d.", mqtt_subtopic, rc);
 	} else {
 		msg_info("Subscribed to %s.", mqtt_subtopic);
+		/* the retained control state comes again on every subscription: parse and apply it only when it changes */
+		MQTTSetLastValueCache(&mc, mqtt_subtopic, 1);
 	}
 
+	mqtt_reconnect_init(&reconnect, mqtt_reconnect_cb, NULL, mqtt_tick,
+			((uint32_t)macAddr.mac[2] << 24) | ((uint32_t)macAddr.mac[3] << 16) | ((uint32_t)macAddr.mac[4] << 8) | macAddr.mac[5]);
+	reconnect.min_ms = RECONN_MIN_MS;
+	reconnect.max_ms = RECONN_MAX_MS;
+	reconnect.backoff_ms = RECONN_MIN_MS;
+
 	Led_SetState(true);
 }
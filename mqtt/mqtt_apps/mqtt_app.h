@@ -8,13 +8,51 @@
 #ifndef WIFI_NET_MQTT_MQTT_APPS_MQTT_APP_H_
 #define WIFI_NET_MQTT_MQTT_APPS_MQTT_APP_H_
 
-#define YIELD_MS          200
-#define PUB_INTERVAL_MS  60000	/* in milliseconds*/
+#define EVENT_WAIT_MS     100	/* longest socket read: an mqtt_sample_ready() is seen within */
+#define SAMPLE_INTERVAL_MS 1000	/* sensors read at 1 Hz */
+#define PUB_INTERVAL_MS  60000	/* in milliseconds: longest wait of a sample in the batch */
 #define RECONN_MIN_MS    1000
 #define RECONN_MAX_MS   	30000
+#define MQTT_SESSION_EXPIRY_S	3600	/* MQTT 5: the broker keeps the session for an hour after a loss */
+
+/* Store-and-forward telemetry queue (RAM ring) */
+#define TELEMETRY_QUEUE_SLOTS      8
+#define TELEMETRY_QUEUE_SLOT_SIZE  640	/* queue header + topic + JSON payload of a batch */
+#define TELEMETRY_QUEUE_POLICY     MQTT_QUEUE_DROP_OLDEST
+
+/* Payload format per topic: the telemetry in TELEMETRY_FORMAT; the control messages are taken in either, detected */
+#define PAYLOAD_JSON               0
+#define PAYLOAD_CBOR               1	/* json/inc/cbor.h: same content, ~20-45% fewer bytes */
+#define TELEMETRY_FORMAT           PAYLOAD_JSON
+
+/* Telemetry batches: the samples go out TELEMETRY_BATCH_SAMPLES per message, ~45 bytes each */
+#define TELEMETRY_BATCH_SAMPLES    8
+#define TELEMETRY_URGENT_LOW_F     32.0f	/* a temperature out of [LOW, HIGH] is published at once */
+#define TELEMETRY_URGENT_HIGH_F    104.0f
+
+/* Report by exception (SENSORS builds): a sample is batched when a channel moved out of its deadband,
+ * or on the heartbeat; changed at runtime by a "Deadband" member on the control topic, or the REST API */
+#define TELEMETRY_DEADBAND_TEMP_C     0.3f
+#define TELEMETRY_DEADBAND_HUMIDITY   1.0f	/* %RH */
+#define TELEMETRY_HEARTBEAT_MS        600000	/* a sample at least every 10 minutes */
+#define TELEMETRY_MIN_REPORT_MS       5000	/* at most one sample per 5 seconds */
+
+/* Windowed statistics of the sensors (SENSORS builds), on /sensors/<id>/stats: a record per channel and window */
+#define STATS_WINDOW_MS            60000	/* the accelerometer, sampled at 50 Hz, summarized once a minute */
+#define STATS_SLIDING_WINDOWS      5	/* the temperature over the last 5 windows, every window */
+#define STATS_BATCH_RECORDS        4	/* ~120 bytes each in JSON */
+#define STATS_FLUSH_MS             2000	/* the records of a window wait for the others at most as long */
+
+#ifdef SENSORS
+#include "sensors_deadband.h"
+/* Deadband filter of the telemetry, for rest_sensors_bind() */
+extern sensors_deadband_t telemetry_deadband;
+#endif
 
 void mqtt_start(void);
 void mqtt_main(void);
+/* Take a sample now and publish it with its batch: callable from an interrupt. */
+void mqtt_sample_ready(void);
 
 
 #endif /* WIFI_NET_MQTT_MQTT_APPS_MQTT_APP_H_ */
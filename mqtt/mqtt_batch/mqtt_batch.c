@@ -0,0 +1,128 @@
+/*
+ * mqtt_batch.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Daruin Solano
+ */
+
+#include "mqtt_batch.h"
+
+#include <string.h>
+
+
+static bool batch_urgent(const mqtt_batch_t* b, const void* sample)
+{
+	float v;
+
+	if (b->policy.urgent_offset == MQTT_BATCH_NO_URGENT) {
+		return false;
+	}
+	memcpy(&v, (const uint8_t*)sample + b->policy.urgent_offset, sizeof(v));
+	return (v < b->policy.urgent_low) || (v > b->policy.urgent_high);
+}
+
+
+void mqtt_batch_init(mqtt_batch_t* b, void* samples, uint16_t capacity, size_t sample_size,
+		const json_field_t* fields, size_t field_count, uint32_t (*tick)(void))
+{
+	memset(b, 0, sizeof(*b));
+	b->samples = (uint8_t*)samples;
+	b->capacity = capacity;
+	b->sample_size = sample_size;
+	b->fields = fields;
+	b->field_count = field_count;
+	b->tick = tick;
+	b->policy.max_samples = capacity;
+	b->policy.max_age_ms = MQTT_BATCH_MAX_AGE_MS;
+	b->policy.urgent_offset = MQTT_BATCH_NO_URGENT;
+}
+
+
+bool mqtt_batch_add(mqtt_batch_t* b, const void* sample)
+{
+	uint16_t max = ((b->policy.max_samples > 0) && (b->policy.max_samples < b->capacity)) ?
+			b->policy.max_samples : b->capacity;
+
+	if (b->count >= b->capacity) {
+		b->dropped++;
+		return true;
+	}
+	if (b->count == 0) {
+		b->first_tick = b->tick();
+	}
+	memcpy(b->samples + (size_t)b->count * b->sample_size, sample, b->sample_size);
+	b->count++;
+	b->added++;
+
+	/* the first reason is kept */
+	if (b->due == MQTT_BATCH_NONE) {
+		if (batch_urgent(b, sample)) {
+			b->due = MQTT_BATCH_URGENT;
+		} else if (b->count >= max) {
+			b->due = MQTT_BATCH_SIZE;
+		}
+	}
+	return mqtt_batch_due(b);
+}
+
+
+void mqtt_batch_request(mqtt_batch_t* b)
+{
+	if (b->due == MQTT_BATCH_NONE) {
+		b->due = MQTT_BATCH_REQUEST;
+	}
+}
+
+
+bool mqtt_batch_due(mqtt_batch_t* b)
+{
+	if (b->count == 0) {
+		return false;
+	}
+	if ((b->due == MQTT_BATCH_NONE) && (b->policy.max_age_ms > 0)
+			&& (mqtt_batch_elapsed_ms(b) >= b->policy.max_age_ms)) {
+		b->due = MQTT_BATCH_AGE;
+	}
+	return (b->due != MQTT_BATCH_NONE);
+}
+
+
+uint32_t mqtt_batch_elapsed_ms(const mqtt_batch_t* b)
+{
+	return (b->count == 0) ? 0 : (b->tick() - b->first_tick);
+}
+
+
+uint32_t mqtt_batch_wait_ms(const mqtt_batch_t* b)
+{
+	uint32_t elapsed;
+
+	if (b->count == 0) {
+		return UINT32_MAX;
+	}
+	if (b->due != MQTT_BATCH_NONE) {
+		return 0;
+	}
+	if (b->policy.max_age_ms == 0) {
+		return UINT32_MAX;
+	}
+	elapsed = mqtt_batch_elapsed_ms(b);
+	return (elapsed >= b->policy.max_age_ms) ? 0 : (b->policy.max_age_ms - elapsed);
+}
+
+
+void mqtt_batch_write(const mqtt_batch_t* b, json_writer_t* w, const char* key)
+{
+	json_write_records(w, key, b->fields, b->field_count, b->samples, b->sample_size, b->count);
+}
+
+
+void mqtt_batch_clear(mqtt_batch_t* b)
+{
+	if (b->count > 0) {
+		b->batches++;
+		b->flushes[b->due]++;
+	}
+	b->count = 0;
+	b->due = MQTT_BATCH_NONE;
+}
@@ -0,0 +1,110 @@
+/*
+ * mqtt_batch.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Daruin Solano
+ *
+ *  Batching stage of the telemetry, between the sampling and the publication.
+ *
+ *  The samples, records of a fixed size described by a json_writer schema,
+ *  are accumulated and go out together as one message: the MQTT header, the
+ *  topic, the TLS record and the module transaction are paid once per batch
+ *  instead of once per sample. The batch is to be flushed when:
+ *  - it holds policy.max_samples samples (size);
+ *  - its first sample is policy.max_age_ms old (age);
+ *  - a sample has an urgent value: its float member at policy.urgent_offset
+ *    is out of [urgent_low, urgent_high] (urgent), an alarm does not wait;
+ *  - the application asks for it, mqtt_batch_request() (request).
+ *
+ *  The application writes the payload: the members shared by the samples
+ *  (ID, MacAddress, ...) once, then the samples as an array:
+ *
+ *    if (mqtt_batch_add(&batch, &sample) || mqtt_batch_due(&batch)) {
+ *      json_writer_init(&w, msg, sizeof(msg));
+ *      json_write_string(&w, "ID", id);
+ *      mqtt_batch_write(&batch, &w, "samples");
+ *      len = json_writer_end(&w);
+ *      ... queue or publish msg ...
+ *      mqtt_batch_clear(&batch);
+ *    }
+ *
+ *  Size policy.max_samples so that a full batch fits in the message buffer.
+ *
+ *  Not thread-safe: call from the task of the MQTT client.
+ */
+
+#ifndef MQTT_MQTT_BATCH_MQTT_BATCH_H_
+#define MQTT_MQTT_BATCH_MQTT_BATCH_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "json_writer.h"
+
+#if !defined(MQTT_BATCH_MAX_AGE_MS)
+#define MQTT_BATCH_MAX_AGE_MS       60000   /* redefinable - default age flush */
+#endif
+
+#define MQTT_BATCH_NO_URGENT        (-1)    /**< policy.urgent_offset: no urgent flush. */
+
+typedef enum {
+  MQTT_BATCH_NONE = 0,          /**< Not due. */
+  MQTT_BATCH_SIZE,
+  MQTT_BATCH_AGE,
+  MQTT_BATCH_URGENT,
+  MQTT_BATCH_REQUEST,
+} mqtt_batch_reason_t;
+
+typedef struct {
+  uint16_t max_samples;         /**< Size flush, up to the capacity of the batch. */
+  uint32_t max_age_ms;          /**< Age flush, from the first sample; 0: none. */
+  int16_t urgent_offset;        /**< Offset of the float member checked, MQTT_BATCH_NO_URGENT: none. */
+  float urgent_low;             /**< Urgent below... */
+  float urgent_high;            /**< ... or above. */
+} mqtt_batch_policy_t;
+
+typedef struct {
+  uint8_t* samples;             /**< capacity samples of sample_size bytes, of the application. */
+  size_t sample_size;
+  uint16_t capacity;
+  const json_field_t* fields;   /**< Schema of the samples. */
+  size_t field_count;
+  uint32_t (*tick)(void);       /**< Time in ms, e.g. HAL_GetTick. */
+  mqtt_batch_policy_t policy;
+  uint16_t count;               /**< Samples in the batch. */
+  uint32_t first_tick;          /**< Time of the first sample, ms. */
+  mqtt_batch_reason_t due;      /**< Why the batch is to be flushed, MQTT_BATCH_NONE while it is not. */
+  /* Metrics */
+  uint32_t added;               /**< Samples batched. */
+  uint32_t dropped;             /**< Samples refused: the batch was full. */
+  uint32_t batches;             /**< Batches flushed... */
+  uint32_t flushes[MQTT_BATCH_REQUEST + 1];	/**< ... per reason. */
+} mqtt_batch_t;
+
+/** samples: room for capacity samples of sample_size bytes. The policy flushes at capacity samples,
+ *  MQTT_BATCH_MAX_AGE_MS, on no urgent value: change b->policy after the init. */
+void mqtt_batch_init(mqtt_batch_t* b, void* samples, uint16_t capacity, size_t sample_size,
+		const json_field_t* fields, size_t field_count, uint32_t (*tick)(void));
+
+/** Copy a sample into the batch. @return true if the batch is to be flushed now */
+bool mqtt_batch_add(mqtt_batch_t* b, const void* sample);
+
+/** Flush the batch as soon as it holds a sample. */
+void mqtt_batch_request(mqtt_batch_t* b);
+
+/** @return true if the batch is to be flushed now: size, age, urgent value or request */
+bool mqtt_batch_due(mqtt_batch_t* b);
+
+/** Time since the first sample, ms: 0 if empty. For a time offset member of the next sample. */
+uint32_t mqtt_batch_elapsed_ms(const mqtt_batch_t* b);
+
+/** Time until the age flush, ms: 0 if due, UINT32_MAX if empty or no age flush. */
+uint32_t mqtt_batch_wait_ms(const mqtt_batch_t* b);
+
+/** Write the samples as the array member key of the object of w. */
+void mqtt_batch_write(const mqtt_batch_t* b, json_writer_t* w, const char* key);
+
+/** Empty the batch, once queued (or lost), and count the flush. */
+void mqtt_batch_clear(mqtt_batch_t* b);
+
+#endif /* MQTT_MQTT_BATCH_MQTT_BATCH_H_ */
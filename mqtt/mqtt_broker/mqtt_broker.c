@@ -0,0 +1,565 @@
+/*
+ * mqtt_broker.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Daruin Solano
+ */
+
+#include <string.h>
+#include "mqtt_broker.h"
+#include "msg.h"
+
+#define CONNACK_ACCEPTED            0
+#define CONNACK_BAD_PROTOCOL        1
+#define CONNACK_BAD_CLIENTID        2
+
+typedef struct {
+	mqtt_broker_t* b;
+	uint32_t sessions;
+} route_t;
+
+
+static int session_no(const mqtt_broker_t* b, const mqtt_broker_session_t* s)
+{
+	return (int)(s - b->sessions);
+}
+
+
+static int session_send(mqtt_broker_session_t* s, const uint8_t* buf, int len)
+{
+	if (s->lost || (len <= 0) || (s->tp->send(s->conn, buf, (size_t)len) < 0)) {
+		s->lost = true;     /* closed by mqtt_broker_poll() */
+		return -1;
+	}
+	return 0;
+}
+
+
+/* End a session: its subscriptions are removed, the connection is closed. */
+static void session_close(mqtt_broker_t* b, mqtt_broker_session_t* s)
+{
+	uint32_t bit = 1UL << session_no(b, s);
+	int i;
+
+	for (i = 0; i < MQTT_BROKER_MAX_SUBS; i++) {
+		mqtt_broker_sub_t* sub = &b->subs[i];
+
+		if ((sub->sessions & bit) && ((sub->sessions &= ~bit) == 0)) {
+			MQTTTopicIndex_remove(&b->index, sub->filter);
+		}
+	}
+	msg_debug("mqtt_broker: session %d (%s) closed\n", session_no(b, s), s->client_id);
+	s->tp->close(s->conn);
+	memset(s, 0, sizeof(*s));
+}
+
+
+static void route_visit(void* arg, MQTTTopicNode* node)
+{
+	route_t* r = (route_t*)arg;
+
+	r->sessions |= ((mqtt_broker_sub_t*)node->context)->sessions;
+}
+
+
+/* Deliver to the sessions whose subscriptions match, once per session, at QoS0. */
+static int route(mqtt_broker_t* b, MQTTString* topic, const void* payload, size_t len, unsigned char retained, uint32_t only)
+{
+	route_t r = { b, 0 };
+	int count = 0;
+	int pkt;
+	int i;
+
+	MQTTTopicIndex_match(&b->index, topic, route_visit, &r);
+	r.sessions &= only;
+	if (r.sessions == 0) {
+		return 0;
+	}
+	pkt = MQTTSerialize_publish(b->tx, sizeof(b->tx), 0, 0, retained, 0, *topic, (unsigned char*)payload, (int)len);
+	if (pkt <= 0) {
+		msg_error("mqtt_broker: message too large to be routed (%lu bytes)\n", (unsigned long)len);
+		return 0;
+	}
+	for (i = 0; i < MQTT_BROKER_MAX_CLIENTS; i++) {
+		mqtt_broker_session_t* s = &b->sessions[i];
+
+		if ((r.sessions & (1UL << i)) && s->connected) {
+			count += (session_send(s, b->tx, pkt) == 0) ? 1 : 0;
+		}
+	}
+	b->routed += count;
+	return count;
+}
+
+
+static mqtt_broker_retained_t* retained_find(mqtt_broker_t* b, const char* topic, size_t len)
+{
+	int i;
+
+	for (i = 0; i < MQTT_BROKER_MAX_RETAINED; i++) {
+		if ((strlen(b->retained[i].topic) == len) && (memcmp(b->retained[i].topic, topic, len) == 0)) {
+			return &b->retained[i];
+		}
+	}
+	return NULL;
+}
+
+
+/* Keep the last retained message of the topic; an empty payload deletes it. */
+static void retain(mqtt_broker_t* b, const char* topic, size_t topic_len, const void* payload, size_t len)
+{
+	mqtt_broker_retained_t* r = retained_find(b, topic, topic_len);
+
+	if (len == 0) {
+		if (r != NULL) {
+			r->topic[0] = '\0';
+		}
+		return;
+	}
+	if ((r == NULL) && ((r = retained_find(b, "", 0)) == NULL)) {
+		msg_error("mqtt_broker: no room to retain %.*s\n", (int)topic_len, topic);
+		return;
+	}
+	if ((len > MQTT_BROKER_RETAINED_SIZE) || (topic_len >= MQTT_BROKER_TOPIC_MAX)) {
+		msg_error("mqtt_broker: %.*s too large to be retained\n", (int)topic_len, topic);
+		r->topic[0] = '\0';     /* the previous value is obsolete anyway */
+		return;
+	}
+	memcpy(r->topic, topic, topic_len);
+	r->topic[topic_len] = '\0';
+	memcpy(r->payload, payload, len);
+	r->len = (uint16_t)len;
+}
+
+
+/* Route a message; forward it to the bridge if it comes from a LAN client. */
+static int publish(mqtt_broker_t* b, MQTTString* topic, const void* payload, size_t len, int qos, unsigned char retained, bool from_lan)
+{
+	const char* name = (topic->cstring != NULL) ? topic->cstring : topic->lenstring.data;
+	size_t name_len = (topic->cstring != NULL) ? strlen(topic->cstring) : (size_t)topic->lenstring.len;
+	int count;
+	int i;
+
+	if (retained) {
+		retain(b, name, name_len, payload, len);
+	}
+	count = route(b, topic, payload, len, 0, UINT32_MAX);
+
+	if (from_lan && (b->forward != NULL) && (name_len < MQTT_BROKER_TOPIC_MAX)) {
+		for (i = 0; i < b->bridge_count; i++) {
+			if (MQTTTopic_matches(b->bridge_filters[i], name, name_len)) {
+				char topic_name[MQTT_BROKER_TOPIC_MAX];
+
+				memcpy(topic_name, name, name_len);
+				topic_name[name_len] = '\0';
+				b->forward(b->forward_ctx, topic_name, payload, len, qos, retained);
+				b->forwarded++;
+				break;
+			}
+		}
+	}
+	return count;
+}
+
+
+static int handle_connect(mqtt_broker_t* b, mqtt_broker_session_t* s, uint8_t* pkt, int len)
+{
+	MQTTPacket_connectData data = MQTTPacket_connectData_initializer;
+	unsigned char rc = CONNACK_ACCEPTED;
+	size_t id_len;
+	int i;
+
+	if (s->connected) {
+		return -1;      /* protocol violation */
+	}
+	/* Only 3.1 ("MQIsdp" 3) and 3.1.1 ("MQTT" 4) are parsed, the other levels are refused. */
+	if (MQTTDeserialize_connect(&data, pkt, len) != 1) {
+		(void)session_send(s, b->tx, MQTTSerialize_connack(b->tx, sizeof(b->tx), CONNACK_BAD_PROTOCOL, 0));
+		return -1;
+	}
+	id_len = (data.clientID.cstring != NULL) ? strlen(data.clientID.cstring) : (size_t)data.clientID.lenstring.len;
+	if ((id_len >= MQTT_BROKER_CLIENTID_MAX) || ((id_len == 0) && !data.cleansession)) {
+		rc = CONNACK_BAD_CLIENTID;
+	}
+	if (rc != CONNACK_ACCEPTED) {
+		(void)session_send(s, b->tx, MQTTSerialize_connack(b->tx, sizeof(b->tx), rc, 0));
+		return -1;
+	}
+
+	memcpy(s->client_id, (data.clientID.cstring != NULL) ? data.clientID.cstring : data.clientID.lenstring.data, id_len);
+	s->client_id[id_len] = '\0';
+	/* A client connecting again takes over its previous session. */
+	for (i = 0; i < MQTT_BROKER_MAX_CLIENTS; i++) {
+		mqtt_broker_session_t* other = &b->sessions[i];
+
+		if ((other != s) && other->connected && (id_len > 0) && (strcmp(other->client_id, s->client_id) == 0)) {
+			session_close(b, other);
+		}
+	}
+	s->keepalive = data.keepAliveInterval;
+	s->connected = true;
+	msg_info("mqtt_broker: session %d connected: %s\n", session_no(b, s), s->client_id);
+	return session_send(s, b->tx, MQTTSerialize_connack(b->tx, sizeof(b->tx), CONNACK_ACCEPTED, 0));
+}
+
+
+static int subscribe(mqtt_broker_t* b, mqtt_broker_session_t* s, MQTTString* filter)
+{
+	uint32_t bit = 1UL << session_no(b, s);
+	mqtt_broker_sub_t* sub;
+	MQTTTopicNode* node;
+	char name[MQTT_BROKER_TOPIC_MAX];
+	int i;
+
+	if ((filter->lenstring.len <= 0) || (filter->lenstring.len >= MQTT_BROKER_TOPIC_MAX)) {
+		return -1;
+	}
+	memcpy(name, filter->lenstring.data, filter->lenstring.len);
+	name[filter->lenstring.len] = '\0';
+
+	if ((node = MQTTTopicIndex_find(&b->index, name)) != NULL) {
+		sub = (mqtt_broker_sub_t*)node->context;
+	} else {
+		for (i = 0, sub = NULL; (i < MQTT_BROKER_MAX_SUBS) && (sub == NULL); i++) {
+			if (b->subs[i].sessions == 0) {
+				sub = &b->subs[i];
+			}
+		}
+		if (sub == NULL) {
+			msg_error("mqtt_broker: no room for the subscription to %s\n", name);
+			return -1;
+		}
+		strcpy(sub->filter, name);
+		if (MQTTTopicIndex_add(&b->index, sub->filter, NULL, sub) != 0) {
+			msg_error("mqtt_broker: out of topic nodes for %s\n", name);
+			return -1;
+		}
+	}
+	sub->sessions |= bit;
+	return 0;
+}
+
+
+static int handle_subscribe(mqtt_broker_t* b, mqtt_broker_session_t* s, uint8_t* pkt, int len)
+{
+	MQTTString filters[MQTT_BROKER_MAX_SUBS];
+	int qos[MQTT_BROKER_MAX_SUBS];
+	unsigned short id;
+	unsigned char dup;
+	int count;
+	int i, j;
+
+	if (MQTTDeserialize_subscribe(&dup, &id, MQTT_BROKER_MAX_SUBS, &count, filters, qos, pkt, len) != 1) {
+		return -1;
+	}
+	for (i = 0; i < count; i++) {
+		qos[i] = (subscribe(b, s, &filters[i]) == 0) ? 0 : 0x80;   /* deliveries are QoS0 */
+	}
+	if (session_send(s, b->tx, MQTTSerialize_suback(b->tx, sizeof(b->tx), id, count, qos)) != 0) {
+		return -1;
+	}
+
+	/* Then the retained messages of the new subscriptions. */
+	for (i = 0; i < MQTT_BROKER_MAX_RETAINED; i++) {
+		mqtt_broker_retained_t* r = &b->retained[i];
+
+		for (j = 0; (r->topic[0] != '\0') && (j < count); j++) {
+			char filter[MQTT_BROKER_TOPIC_MAX];
+
+			if (qos[j] != 0) {
+				continue;
+			}
+			memcpy(filter, filters[j].lenstring.data, filters[j].lenstring.len);
+			filter[filters[j].lenstring.len] = '\0';
+			if (MQTTTopic_matches(filter, r->topic, strlen(r->topic))) {
+				MQTTString topic = MQTTString_initializer;
+
+				topic.cstring = r->topic;
+				route(b, &topic, r->payload, r->len, 1, 1UL << session_no(b, s));
+				break;
+			}
+		}
+	}
+	return 0;
+}
+
+
+static int handle_unsubscribe(mqtt_broker_t* b, mqtt_broker_session_t* s, uint8_t* pkt, int len)
+{
+	MQTTString filters[MQTT_BROKER_MAX_SUBS];
+	uint32_t bit = 1UL << session_no(b, s);
+	unsigned short id;
+	unsigned char dup;
+	int count;
+	int i;
+
+	if (MQTTDeserialize_unsubscribe(&dup, &id, MQTT_BROKER_MAX_SUBS, &count, filters, pkt, len) != 1) {
+		return -1;
+	}
+	for (i = 0; i < count; i++) {
+		char name[MQTT_BROKER_TOPIC_MAX];
+		MQTTTopicNode* node;
+
+		if ((filters[i].lenstring.len <= 0) || (filters[i].lenstring.len >= MQTT_BROKER_TOPIC_MAX)) {
+			continue;
+		}
+		memcpy(name, filters[i].lenstring.data, filters[i].lenstring.len);
+		name[filters[i].lenstring.len] = '\0';
+		if ((node = MQTTTopicIndex_find(&b->index, name)) != NULL) {
+			mqtt_broker_sub_t* sub = (mqtt_broker_sub_t*)node->context;
+
+			if ((sub->sessions &= ~bit) == 0) {
+				MQTTTopicIndex_remove(&b->index, sub->filter);
+			}
+		}
+	}
+	return session_send(s, b->tx, MQTTSerialize_unsuback(b->tx, sizeof(b->tx), id));
+}
+
+
+/* Position of a QoS2 packet id awaiting PUBREL, or -1. */
+static int qos2_find(const mqtt_broker_session_t* s, unsigned short id)
+{
+	int i;
+
+	for (i = 0; i < s->qos2_count; i++) {
+		if (s->qos2_ids[i] == id) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+
+/* Record a QoS2 packet id until its PUBREL; when full, the oldest is forgotten. */
+static void qos2_add(mqtt_broker_session_t* s, unsigned short id)
+{
+	if (s->qos2_count == MQTT_BROKER_MAX_QOS2) {
+		msg_error("mqtt_broker: %s, too many QoS2 publications awaiting PUBREL\n", s->client_id);
+		memmove(&s->qos2_ids[0], &s->qos2_ids[1], (MQTT_BROKER_MAX_QOS2 - 1) * sizeof(s->qos2_ids[0]));
+		s->qos2_count--;
+	}
+	s->qos2_ids[s->qos2_count++] = id;
+}
+
+
+static void qos2_release(mqtt_broker_session_t* s, unsigned short id)
+{
+	int i = qos2_find(s, id);
+
+	if (i >= 0) {
+		memmove(&s->qos2_ids[i], &s->qos2_ids[i + 1], (s->qos2_count - i - 1) * sizeof(s->qos2_ids[0]));
+		s->qos2_count--;
+	}
+}
+
+
+static int handle_publish(mqtt_broker_t* b, mqtt_broker_session_t* s, uint8_t* pkt, int len)
+{
+	unsigned char dup, retained;
+	unsigned short id;
+	int qos;
+	MQTTString topic;
+	unsigned char* payload;
+	int payload_len;
+	int ack = 0;
+
+	if (MQTTDeserialize_publish(&dup, &qos, &retained, &id, &topic, &payload, &payload_len, pkt, len) != 1) {
+		return -1;
+	}
+	/* Acknowledge first: the routing below reuses the transmit buffer. */
+	if (qos == 1) {
+		ack = MQTTSerialize_ack(b->tx, sizeof(b->tx), PUBACK, 0, id);
+	} else if (qos == 2) {
+		ack = MQTTSerialize_ack(b->tx, sizeof(b->tx), PUBREC, 0, id);
+	}
+	if ((qos > 0) && (session_send(s, b->tx, ack) != 0)) {
+		return -1;
+	}
+	if (qos == 2) {
+		if (qos2_find(s, id) >= 0) {
+			return 0;	/* retransmitted before PUBREL: already routed */
+		}
+		qos2_add(s, id);
+	}
+	publish(b, &topic, payload, (size_t)payload_len, qos, retained, true);
+	return 0;
+}
+
+
+/* Process one complete packet. @return 0, or -1 to end the session */
+static int handle_packet(mqtt_broker_t* b, mqtt_broker_session_t* s, uint8_t* pkt, int len)
+{
+	MQTTHeader header = {0};
+	unsigned short id;
+	unsigned char type, dup;
+
+	header.byte = pkt[0];
+	if (!s->connected && (header.bits.type != CONNECT)) {
+		return -1;
+	}
+	switch (header.bits.type) {
+	case CONNECT:
+		return handle_connect(b, s, pkt, len);
+	case PUBLISH:
+		return handle_publish(b, s, pkt, len);
+	case PUBREL:
+		if (MQTTDeserialize_ack(&type, &dup, &id, pkt, len) != 1) {
+			return -1;
+		}
+		qos2_release(s, id);
+		return session_send(s, b->tx, MQTTSerialize_ack(b->tx, sizeof(b->tx), PUBCOMP, 0, id));
+	case SUBSCRIBE:
+		return handle_subscribe(b, s, pkt, len);
+	case UNSUBSCRIBE:
+		return handle_unsubscribe(b, s, pkt, len);
+	case PINGREQ:
+		b->tx[0] = PINGRESP << 4;
+		b->tx[1] = 0;
+		return session_send(s, b->tx, 2);
+	case PUBACK:
+	case PUBREC:
+	case PUBCOMP:
+		return 0;       /* nothing sent above QoS0 */
+	case DISCONNECT:
+	default:
+		return -1;
+	}
+}
+
+
+/* Length of the packet at the start of buf: 0 if incomplete, -1 if malformed. */
+static int frame_length(const uint8_t* buf, size_t len)
+{
+	size_t hdr = 1;
+	int rem_len = 0;
+	int multiplier = 1;
+	uint8_t c;
+
+	do {
+		if (hdr > 4) {
+			return -1;      /* remaining length over 4 bytes */
+		}
+		if (hdr >= len) {
+			return 0;
+		}
+		c = buf[hdr++];
+		rem_len += (c & 127) * multiplier;
+		multiplier *= 128;
+	} while (c & 128);
+	return (len >= hdr + rem_len) ? (int)(hdr + rem_len) : ((hdr + rem_len > MQTT_BROKER_PACKET_SIZE) ? -1 : 0);
+}
+
+
+/* Frame and process the packets received on a session, as the client readPacket() does. */
+static int session_poll(mqtt_broker_t* b, mqtt_broker_session_t* s)
+{
+	int packets = 0;
+	int len = 0;
+	int rc = 0;
+
+	while (!s->lost && (rc = s->tp->recv(s->conn, s->rx + s->rx_len, sizeof(s->rx) - s->rx_len)) > 0) {
+		s->rx_len += rc;
+		while ((len = frame_length(s->rx, s->rx_len)) > 0) {
+			s->last_rx = b->now;
+			packets++;
+			if ((handle_packet(b, s, s->rx, len) != 0) || s->lost) {
+				break;
+			}
+			s->rx_len -= len;
+			memmove(s->rx, s->rx + len, s->rx_len);
+		}
+		if (len != 0) {
+			s->lost = true;
+			break;
+		}
+	}
+	if (len < 0) {
+		msg_error("mqtt_broker: session %d: malformed or oversized packet\n", session_no(b, s));
+	}
+	if ((rc < 0) || s->lost) {
+		session_close(b, s);
+	}
+	return packets;
+}
+
+
+void mqtt_broker_init(mqtt_broker_t* b)
+{
+	memset(b, 0, sizeof(*b));
+	MQTTTopicIndex_init(&b->index);
+}
+
+
+int mqtt_broker_attach(mqtt_broker_t* b, void* conn, const mqtt_broker_transport_t* tp, uint32_t now)
+{
+	int i;
+
+	for (i = 0; i < MQTT_BROKER_MAX_CLIENTS; i++) {
+		mqtt_broker_session_t* s = &b->sessions[i];
+
+		if (s->conn == NULL) {
+			memset(s, 0, sizeof(*s));
+			s->conn = conn;
+			s->tp = tp;
+			s->last_rx = now;
+			return i;
+		}
+	}
+	msg_error("mqtt_broker: all the %d sessions are in use\n", MQTT_BROKER_MAX_CLIENTS);
+	return -1;
+}
+
+
+int mqtt_broker_poll(mqtt_broker_t* b, uint32_t now)
+{
+	int packets = 0;
+	int i;
+
+	b->now = now;
+	for (i = 0; i < MQTT_BROKER_MAX_CLIENTS; i++) {
+		mqtt_broker_session_t* s = &b->sessions[i];
+		/* 1.5 keepalive without a packet, or no CONNECT within 10s */
+		uint32_t timeout = s->connected ? (uint32_t)s->keepalive * 1500UL : 10000UL;
+
+		if (s->conn == NULL) {
+			continue;
+		}
+		packets += session_poll(b, s);
+		if ((s->conn != NULL) && (timeout != 0) && ((now - s->last_rx) > timeout)) {
+			msg_info("mqtt_broker: session %d (%s) timed out\n", i, s->client_id);
+			session_close(b, s);
+		}
+	}
+	return packets;
+}
+
+
+int mqtt_broker_publish(mqtt_broker_t* b, const char* topic, const void* payload, size_t len, bool retained)
+{
+	MQTTString name = MQTTString_initializer;
+
+	name.cstring = (char*)topic;
+	return publish(b, &name, payload, len, 0, retained, false);
+}
+
+
+void mqtt_broker_set_bridge(mqtt_broker_t* b, const char* const* filters, int count, mqtt_broker_forward_t forward, void* ctx)
+{
+	b->bridge_filters = filters;
+	b->bridge_count = count;
+	b->forward = forward;
+	b->forward_ctx = ctx;
+}
+
+
+int mqtt_broker_sessions(const mqtt_broker_t* b)
+{
+	int count = 0;
+	int i;
+
+	for (i = 0; i < MQTT_BROKER_MAX_CLIENTS; i++) {
+		count += b->sessions[i].connected ? 1 : 0;
+	}
+	return count;
+}
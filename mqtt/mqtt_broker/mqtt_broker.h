@@ -0,0 +1,142 @@
+/*
+ * mqtt_broker.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Daruin Solano
+ *
+ *  Lightweight MQTT 3.1/3.1.1 broker for the LAN sensor nodes, built on the
+ *  server side packet codecs of mqtt_packet (MQTTDeserialize_connect,
+ *  MQTTSerialize_connack, MQTTDeserialize_subscribe...).
+ *
+ *  - Up to MQTT_BROKER_MAX_CLIENTS sessions, each one on a connection
+ *    provided by the caller through mqtt_broker_transport_t callbacks:
+ *    net_srv on the board (mqtt_broker_srv.c), POSIX sockets on Linux
+ *    (mqtt_broker_posix.c).
+ *  - Topic routing with the '+' and '#' wildcards, through the
+ *    subscription index of the MQTT client (MQTTTopicIndex): the broker
+ *    subscriptions share the MAX_TOPIC_NODES of the build.
+ *  - Retained messages: up to MQTT_BROKER_MAX_RETAINED, of at most
+ *    MQTT_BROKER_RETAINED_SIZE bytes, sent to the new subscribers.
+ *  - Bridge: the messages published by the LAN clients on the bridge topic
+ *    filters are also passed to a forward callback, e.g.
+ *    mqtt_broker_bridge_forward() to publish them upstream with the
+ *    MQTTClient of the application. mqtt_broker_publish() injects messages
+ *    the other way, and is never forwarded back.
+ *
+ *  Lightweight means:
+ *  - QoS1/2 publications are acknowledged (PUBACK, PUBREC/PUBCOMP) and
+ *    routed on receipt; the deliveries to the subscribers are QoS0, which
+ *    is also the QoS granted in SUBACK. The packet ids of the QoS2 ones
+ *    are kept until their PUBREL, up to MQTT_BROKER_MAX_QOS2 a session:
+ *    a retransmission in between is acknowledged again, not routed;
+ *  - no persistent session: sessionPresent is always 0, and the
+ *    subscriptions go with the connection;
+ *  - no will message, no authentication.
+ *
+ *  Not thread-safe: attach, poll and publish from the same task.
+ */
+
+#ifndef MQTT_MQTT_BROKER_MQTT_BROKER_H_
+#define MQTT_MQTT_BROKER_MQTT_BROKER_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "MQTTPacket.h"
+#include "MQTTTopicIndex.h"
+
+#if !defined(MQTT_BROKER_MAX_CLIENTS)
+#define MQTT_BROKER_MAX_CLIENTS     4     /* redefinable - simultaneous LAN connections, up to 32 */
+#endif
+#if !defined(MQTT_BROKER_MAX_SUBS)
+#define MQTT_BROKER_MAX_SUBS        16    /* redefinable - distinct topic filters of all the sessions */
+#endif
+#if !defined(MQTT_BROKER_MAX_RETAINED)
+#define MQTT_BROKER_MAX_RETAINED    8     /* redefinable - retained topics */
+#endif
+#if !defined(MQTT_BROKER_RETAINED_SIZE)
+#define MQTT_BROKER_RETAINED_SIZE   128   /* redefinable - max payload of a retained message */
+#endif
+#if !defined(MQTT_BROKER_PACKET_SIZE)
+#define MQTT_BROKER_PACKET_SIZE     512   /* redefinable - max packet size, per session receive buffer */
+#endif
+#if !defined(MQTT_BROKER_MAX_QOS2)
+#define MQTT_BROKER_MAX_QOS2        8     /* redefinable - QoS2 publications of a session awaiting PUBREL: MAX_INFLIGHT_MESSAGES of the client */
+#endif
+#define MQTT_BROKER_TOPIC_MAX       64    /**< Max topic name or filter length, \0 included. */
+#define MQTT_BROKER_CLIENTID_MAX    24    /**< Max client identifier length, \0 included. */
+
+/** Connection of a session. */
+typedef struct {
+  /** Non-blocking read: number of bytes read, 0 if none available, < 0 if the connection is lost. */
+  int  (*recv)(void* conn, uint8_t* buf, size_t len);
+  /** Write all the bytes: 0 on success, < 0 if the connection is lost. */
+  int  (*send)(void* conn, const uint8_t* buf, size_t len);
+  /** Called once, when the session ends. */
+  void (*close)(void* conn);
+} mqtt_broker_transport_t;
+
+/** Bridge callback: a LAN client published on one of the bridge filters. topic is \0 terminated. */
+typedef void (*mqtt_broker_forward_t)(void* ctx, const char* topic, const void* payload, size_t len, int qos, bool retained);
+
+typedef struct {
+  void* conn;                           /**< NULL: free session. */
+  const mqtt_broker_transport_t* tp;
+  bool connected;                       /**< CONNECT received. */
+  bool lost;                            /**< Send failed or protocol error, to be closed. */
+  char client_id[MQTT_BROKER_CLIENTID_MAX];
+  uint16_t keepalive;                   /**< Seconds, 0: none. */
+  uint32_t last_rx;                     /**< Time of the last packet, ms. */
+  uint16_t qos2_ids[MQTT_BROKER_MAX_QOS2]; /**< QoS2 publications routed, awaiting PUBREL, oldest first. */
+  uint8_t qos2_count;
+  size_t rx_len;
+  uint8_t rx[MQTT_BROKER_PACKET_SIZE];
+} mqtt_broker_session_t;
+
+typedef struct {
+  char filter[MQTT_BROKER_TOPIC_MAX];
+  uint32_t sessions;                    /**< Bit per subscribed session, 0: free entry. */
+} mqtt_broker_sub_t;
+
+typedef struct {
+  char topic[MQTT_BROKER_TOPIC_MAX];    /**< "": free entry. */
+  uint16_t len;
+  uint8_t payload[MQTT_BROKER_RETAINED_SIZE];
+} mqtt_broker_retained_t;
+
+typedef struct {
+  mqtt_broker_session_t sessions[MQTT_BROKER_MAX_CLIENTS];
+  mqtt_broker_sub_t subs[MQTT_BROKER_MAX_SUBS];
+  mqtt_broker_retained_t retained[MQTT_BROKER_MAX_RETAINED];
+  MQTTTopicIndex index;                 /**< Topic filter -> mqtt_broker_sub_t. */
+  uint8_t tx[MQTT_BROKER_PACKET_SIZE];
+  uint32_t now;                         /**< Time of the last mqtt_broker_poll(), ms. */
+  const char* const* bridge_filters;
+  int bridge_count;
+  mqtt_broker_forward_t forward;
+  void* forward_ctx;
+  uint32_t routed;                      /**< Statistics: messages delivered to the sessions. */
+  uint32_t forwarded;                   /**< Statistics: messages passed to the bridge. */
+} mqtt_broker_t;
+
+void mqtt_broker_init(mqtt_broker_t* b);
+
+/** Start a session on a new connection. @return the session number, or -1 if all are in use (conn is not closed). */
+int  mqtt_broker_attach(mqtt_broker_t* b, void* conn, const mqtt_broker_transport_t* tp, uint32_t now);
+
+/** Read and process the packets of all the sessions, and drop the sessions whose keepalive expired.
+ *  @param now - time in ms, e.g. HAL_GetTick()
+ *  @return number of packets processed */
+int  mqtt_broker_poll(mqtt_broker_t* b, uint32_t now);
+
+/** Publish a message of the device itself, or received from upstream, to the LAN subscribers.
+ *  It is not forwarded to the bridge. @return number of sessions it was delivered to */
+int  mqtt_broker_publish(mqtt_broker_t* b, const char* topic, const void* payload, size_t len, bool retained);
+
+/** Forward the LAN publications matching one of the filters. The filters are not copied. */
+void mqtt_broker_set_bridge(mqtt_broker_t* b, const char* const* filters, int count, mqtt_broker_forward_t forward, void* ctx);
+
+/** Number of connected sessions. */
+int  mqtt_broker_sessions(const mqtt_broker_t* b);
+
+#endif /* MQTT_MQTT_BROKER_MQTT_BROKER_H_ */
@@ -0,0 +1,67 @@
+/*
+ * mqtt_broker_bridge.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Daruin Solano
+ */
+
+#include <string.h>
+#include "mqtt_broker_bridge.h"
+#include "msg.h"
+
+
+void mqtt_broker_bridge_forward(void* ctx, const char* topic, const void* payload, size_t len, int qos, bool retained)
+{
+	mqtt_broker_bridge_t* bridge = (mqtt_broker_bridge_t*)ctx;
+	MQTTMessage msg;
+	int rc = FAILURE;
+
+	memset(&msg, 0, sizeof(msg));
+	msg.qos = (qos < (int)bridge->qos) ? (enum QoS)qos : bridge->qos;
+	msg.retained = retained;
+	msg.payload = (void*)payload;
+	msg.payloadlen = len;
+
+	if (bridge->queue != NULL) {
+		rc = mqtt_queue_push(bridge->queue, topic, &msg);
+	} else if (MQTTIsConnected(bridge->client)) {
+		rc = MQTTPublish(bridge->client, topic, &msg);
+	}
+	if (rc != MQSUCCESS) {
+		bridge->dropped++;
+		msg_debug("mqtt_broker_bridge: %s not forwarded (%d)\n", topic, rc);
+	}
+}
+
+
+/* Upstream message: to the LAN subscribers, the broker is the handler context. */
+static void mqtt_broker_bridge_downlink(MessageData* md)
+{
+	char topic[MQTT_BROKER_TOPIC_MAX];
+	int len = md->topicName->lenstring.len;
+
+	if (md->context == NULL) {
+		return;
+	}
+	if (len >= MQTT_BROKER_TOPIC_MAX) {
+		msg_error("mqtt_broker_bridge: topic too long (%d)\n", len);
+		return;
+	}
+	memcpy(topic, md->topicName->lenstring.data, len);
+	topic[len] = '\0';
+	mqtt_broker_publish((mqtt_broker_t*)md->context, topic, md->message->payload, md->message->payloadlen,
+			md->message->retained);
+}
+
+
+int mqtt_broker_bridge_subscribe(mqtt_broker_bridge_t* bridge, mqtt_broker_t* b, const char* filter)
+{
+	MQTTSubackData data;
+	int rc;
+
+	rc = MQTTSubscribeWithContext(bridge->client, filter, bridge->qos, mqtt_broker_bridge_downlink, b, &data);
+	if (rc != MQSUCCESS) {
+		msg_error("mqtt_broker_bridge: subscription to %s failed (%d)\n", filter, rc);
+	}
+	return rc;
+}
@@ -0,0 +1,38 @@
+/*
+ * mqtt_broker_bridge.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Daruin Solano
+ *
+ *  Bridge between the LAN broker and the upstream MQTTClient of the
+ *  application:
+ *  - uplink: mqtt_broker_bridge_forward() is the mqtt_broker_forward_t of
+ *    mqtt_broker_set_bridge(). The messages are pushed to the outbound queue
+ *    if there is one (delivered once the client is connected), else
+ *    published at once if the client is connected, else dropped;
+ *  - downlink: mqtt_broker_bridge_subscribe() subscribes the client to an
+ *    upstream filter, and mqtt_broker_publish() the messages received on it
+ *    to the LAN subscribers.
+ *
+ *  The topics are not remapped, and the messages coming from upstream are
+ *  never forwarded back.
+ */
+
+#ifndef MQTT_MQTT_BROKER_MQTT_BROKER_BRIDGE_H_
+#define MQTT_MQTT_BROKER_MQTT_BROKER_BRIDGE_H_
+
+#include "mqtt_broker.h"
+#include "MQTTClient.h"
+#include "mqtt_queue.h"
+
+typedef struct {
+  MQTTClient* client;
+  mqtt_queue_t* queue;      /**< Optional, NULL: publish directly. */
+  enum QoS qos;             /**< Max upstream QoS, the QoS of the LAN publication if lower. */
+  uint32_t dropped;         /**< Statistics: uplink messages lost. */
+} mqtt_broker_bridge_t;
+
+void mqtt_broker_bridge_forward(void* ctx, const char* topic, const void* payload, size_t len, int qos, bool retained);
+int  mqtt_broker_bridge_subscribe(mqtt_broker_bridge_t* bridge, mqtt_broker_t* b, const char* filter);
+
+#endif /* MQTT_MQTT_BROKER_MQTT_BROKER_BRIDGE_H_ */
@@ -0,0 +1,168 @@
+/*
+ * mqtt_broker_posix.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Daruin Solano
+ *
+ *  POSIX sockets transport of the broker, to run it on a Linux gateway or on
+ *  the development host: make -C mqtt/bench build/mqtt_broker builds it with
+ *  the main() below (-DMQTT_BROKER_MAIN).
+ */
+
+#if defined(__linux__)
+
+#include <string.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <errno.h>
+#include <time.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include "mqtt_broker_posix.h"
+#include "msg.h"
+
+typedef struct {
+	int fd;             /* -1: free */
+} posix_conn_t;
+
+static posix_conn_t posix_conns[MQTT_BROKER_MAX_CLIENTS];
+
+
+static int posix_recv(void* conn, uint8_t* buf, size_t len)
+{
+	ssize_t rc = recv(((posix_conn_t*)conn)->fd, buf, len, MSG_DONTWAIT);
+
+	if (rc < 0) {
+		return ((errno == EAGAIN) || (errno == EWOULDBLOCK) || (errno == EINTR)) ? 0 : -1;
+	}
+	return (rc == 0) ? -1 : (int)rc;       /* 0: closed by the client */
+}
+
+
+static int posix_send(void* conn, const uint8_t* buf, size_t len)
+{
+	while (len > 0) {
+		ssize_t rc = send(((posix_conn_t*)conn)->fd, buf, len, MSG_NOSIGNAL);
+
+		if (rc < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			return -1;
+		}
+		buf += rc;
+		len -= rc;
+	}
+	return 0;
+}
+
+
+static void posix_close(void* conn)
+{
+	close(((posix_conn_t*)conn)->fd);
+	((posix_conn_t*)conn)->fd = -1;
+}
+
+
+static const mqtt_broker_transport_t posix_transport = { posix_recv, posix_send, posix_close };
+
+
+uint32_t mqtt_broker_posix_now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint32_t)(ts.tv_sec * 1000UL + ts.tv_nsec / 1000000UL);
+}
+
+
+int mqtt_broker_posix_listen(uint16_t port)
+{
+	struct sockaddr_in addr;
+	int one = 1;
+	int fd;
+	int i;
+
+	for (i = 0; i < MQTT_BROKER_MAX_CLIENTS; i++) {
+		posix_conns[i].fd = -1;
+	}
+	if ((fd = socket(AF_INET, SOCK_STREAM, 0)) < 0) {
+		msg_error("mqtt_broker_posix_listen: socket() failed (%d)\n", errno);
+		return -1;
+	}
+	setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_ANY);
+	addr.sin_port = htons(port);
+	if ((bind(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0) || (listen(fd, MQTT_BROKER_MAX_CLIENTS) != 0)) {
+		msg_error("mqtt_broker_posix_listen: port %d: error %d\n", port, errno);
+		close(fd);
+		return -1;
+	}
+	fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+	return fd;
+}
+
+
+int mqtt_broker_posix_run_once(mqtt_broker_t* b, int listen_fd, uint32_t wait_ms)
+{
+	struct pollfd fds[MQTT_BROKER_MAX_CLIENTS + 1];
+	int nfds = 0;
+	int fd;
+	int i;
+
+	fds[nfds].fd = listen_fd;
+	fds[nfds++].events = POLLIN;
+	for (i = 0; i < MQTT_BROKER_MAX_CLIENTS; i++) {
+		if (posix_conns[i].fd >= 0) {
+			fds[nfds].fd = posix_conns[i].fd;
+			fds[nfds++].events = POLLIN;
+		}
+	}
+	poll(fds, nfds, (int)wait_ms);
+
+	while ((fd = accept(listen_fd, NULL, NULL)) >= 0) {
+		int one = 1;
+
+		setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+		for (i = 0; (i < MQTT_BROKER_MAX_CLIENTS) && (posix_conns[i].fd >= 0); i++) {
+		}
+		if ((i == MQTT_BROKER_MAX_CLIENTS) || (mqtt_broker_attach(b, &posix_conns[i], &posix_transport, mqtt_broker_posix_now()) < 0)) {
+			close(fd);
+			continue;
+		}
+		posix_conns[i].fd = fd;
+	}
+	return mqtt_broker_poll(b, mqtt_broker_posix_now());
+}
+
+
+#if defined(MQTT_BROKER_MAIN)
+#include <stdio.h>
+
+int main(int argc, char** argv)
+{
+	static mqtt_broker_t broker;
+	uint16_t port = (argc > 1) ? (uint16_t)atoi(argv[1]) : 1883;
+	int fd;
+
+	mqtt_broker_init(&broker);
+	if ((fd = mqtt_broker_posix_listen(port)) < 0) {
+		return 1;
+	}
+	printf("mqtt_broker: listening on port %d, %d sessions, %u bytes\n", port, MQTT_BROKER_MAX_CLIENTS,
+			(unsigned)sizeof(broker));
+	fflush(stdout);
+	for (;;) {
+		mqtt_broker_posix_run_once(&broker, fd, 1000);
+	}
+	return 0;
+}
+#endif /* MQTT_BROKER_MAIN */
+
+#endif /* __linux__ */
@@ -0,0 +1,24 @@
+/*
+ * mqtt_broker_posix.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Daruin Solano
+ *
+ *  LAN listener of the broker on POSIX sockets (Linux).
+ */
+
+#ifndef MQTT_MQTT_BROKER_MQTT_BROKER_POSIX_H_
+#define MQTT_MQTT_BROKER_MQTT_BROKER_POSIX_H_
+
+#include "mqtt_broker.h"
+
+/** @return the non-blocking listening socket, or -1 */
+int  mqtt_broker_posix_listen(uint16_t port);
+
+/** Wait at most wait_ms for activity, accept the new clients, then poll the broker. */
+int  mqtt_broker_posix_run_once(mqtt_broker_t* b, int listen_fd, uint32_t wait_ms);
+
+/** Monotonic time in ms, for mqtt_broker_poll(). */
+uint32_t mqtt_broker_posix_now(void);
+
+#endif /* MQTT_MQTT_BROKER_MQTT_BROKER_POSIX_H_ */
@@ -0,0 +1,97 @@
+/*
+ * mqtt_broker_srv.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Daruin Solano
+ */
+
+#include <string.h>
+#include "mqtt_broker_srv.h"
+#include "msg.h"
+
+
+static int srv_recv(void* conn, uint8_t* buf, size_t len)
+{
+	mqtt_broker_srv_t* s = (mqtt_broker_srv_t*)conn;
+	int rc = net_sock_recv(s->srv.sock, buf, len);
+
+	if ((rc == 0) || (rc == NET_TIMEOUT) || (rc == NET_NO_DATA)) {
+		return 0;
+	}
+	return (rc < 0) ? -1 : rc;      /* NET_EOF: closed by the client */
+}
+
+
+static int srv_send(void* conn, const uint8_t* buf, size_t len)
+{
+	mqtt_broker_srv_t* s = (mqtt_broker_srv_t*)conn;
+
+	while (len > 0) {
+		int rc = net_sock_send(s->srv.sock, buf, len);
+
+		if (rc <= 0) {
+			return -1;
+		}
+		buf += rc;
+		len -= rc;
+	}
+	return 0;
+}
+
+
+static void srv_close(void* conn)
+{
+	mqtt_broker_srv_t* s = (mqtt_broker_srv_t*)conn;
+
+	net_srv_next_conn(&s->srv);
+	s->attached = false;
+}
+
+
+static const mqtt_broker_transport_t srv_transport = { srv_recv, srv_send, srv_close };
+
+
+int mqtt_broker_srv_start(mqtt_broker_srv_t* s, mqtt_broker_t* b, net_hnd_t hnet, uint16_t port)
+{
+	memset(s, 0, sizeof(*s));
+	s->broker = b;
+	s->srv.localport = port;
+	s->srv.protocol = NET_PROTO_TCP;
+	s->srv.name = "mqtt";
+
+	if (net_srv_bind(hnet, NULL, &s->srv) != NET_OK) {
+		msg_error("mqtt_broker_srv_start: net_srv_bind failed\n");
+		return NET_ERR;
+	}
+	msg_info("mqtt_broker: listening on port %d\n", port);
+	return NET_OK;
+}
+
+
+int mqtt_broker_srv_run_once(mqtt_broker_srv_t* s, uint32_t wait_ms)
+{
+	if (!s->attached && (net_srv_accept(&s->srv, wait_ms) == NET_OK)) {
+		net_sock_setopt(s->srv.sock, "sock_read_timeout", (const uint8_t*)MQTT_BROKER_SRV_READ_TIMEOUT,
+				strlen(MQTT_BROKER_SRV_READ_TIMEOUT) + 1);
+		if (mqtt_broker_attach(s->broker, s, &srv_transport, HAL_GetTick()) >= 0) {
+			s->attached = true;
+		} else {
+			net_srv_next_conn(&s->srv);
+		}
+	}
+	return mqtt_broker_poll(s->broker, HAL_GetTick());
+}
+
+
+void mqtt_broker_srv_stop(mqtt_broker_srv_t* s)
+{
+	int i;
+
+	for (i = 0; i < MQTT_BROKER_MAX_CLIENTS; i++) {
+		if (s->broker->sessions[i].conn == s) {
+			s->broker->sessions[i].lost = true;
+		}
+	}
+	mqtt_broker_poll(s->broker, HAL_GetTick());     /* closes the session */
+	net_srv_close(&s->srv);
+}
@@ -0,0 +1,37 @@
+/*
+ * mqtt_broker_srv.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Daruin Solano
+ *
+ *  LAN listener of the broker on net_srv (es-WiFi module server).
+ *
+ *  The module server carries a single client connection at a time, on the
+ *  socket of the server: with it the broker serves one LAN client, and the
+ *  next one is accepted once it disconnects. The broker itself is not
+ *  limited, other transports may attach more sessions to it.
+ */
+
+#ifndef MQTT_MQTT_BROKER_MQTT_BROKER_SRV_H_
+#define MQTT_MQTT_BROKER_MQTT_BROKER_SRV_H_
+
+#include "mqtt_broker.h"
+#include "net_internal.h"
+
+#define MQTT_BROKER_SRV_PORT          1883
+#define MQTT_BROKER_SRV_READ_TIMEOUT  "10"    /* ms, per mqtt_broker_poll() */
+
+typedef struct {
+  net_srv_conn_t srv;
+  mqtt_broker_t* broker;
+  bool attached;              /**< A LAN client is connected on srv.sock. */
+} mqtt_broker_srv_t;
+
+int  mqtt_broker_srv_start(mqtt_broker_srv_t* s, mqtt_broker_t* b, net_hnd_t hnet, uint16_t port);
+
+/** Accept a client if none is connected, waiting at most wait_ms, then poll the broker. */
+int  mqtt_broker_srv_run_once(mqtt_broker_srv_t* s, uint32_t wait_ms);
+
+void mqtt_broker_srv_stop(mqtt_broker_srv_t* s);
+
+#endif /* MQTT_MQTT_BROKER_MQTT_BROKER_SRV_H_ */
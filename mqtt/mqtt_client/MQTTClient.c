@@ -14,17 +14,35 @@
  *   Allan Stockdill-Mander/Ian Craggs - initial API and implementation and/or initial documentation
  *   Ian Craggs - fix for #96 - check rem_len in readPacket
  *   Ian Craggs - add ability to set message handler separately #6
+ *   Daruin Solano - asynchronous QoS1/2 publication with an in-flight window
+ *   Daruin Solano - topic trie subscription index, message handler context
+ *   Daruin Solano - buffered packet reader: read what is available, keep the leftovers
+ *   Daruin Solano - zero-copy publication: the payload is sent from the caller's buffer
+ *   Daruin Solano - MQTT 5: properties, topic aliases, reason codes, session expiry, receive maximum
  *******************************************************************************/
 #include "MQTTClient.h"
 
 #include <string.h>
+#include <limits.h>
 
-static int deliverMessage(MQTTClient* c, MQTTString* topicName, MQTTMessage* message);
+struct Delivery
+{
+    MQTTClient* c;
+    MQTTString* topicName;
+    MQTTMessage* message;
+#if defined(MQTTV5)
+    MQTTProperties* properties;
+#endif
+};
+
+static int deliverMessage(MQTTClient* c, struct Delivery* d);
 static int keepalive(MQTTClient* c);
 static void MQTTCleanSession(MQTTClient* c);
 static void MQTTCloseSession(MQTTClient* c);
 static int cycle(MQTTClient* c, Timer* timer);
 static int waitfor(MQTTClient* c, int packet_type, Timer* timer);
+static int waitforAck(MQTTClient* c, int packet_type, unsigned short id, Timer* timer);
+static int retryInflight(MQTTClient* c);
 void MQTTRun(void* parm);
 
 
@@ -32,33 +50,239 @@ void MQTTRun(void* parm);
 static void NewMessageData(MessageData* md, MQTTString* aTopicName, MQTTMessage* aMessage) {
     md->topicName = aTopicName;
     md->message = aMessage;
+    md->context = NULL;
+#if defined(MQTTV5)
+    md->properties = NULL;
+#endif
+}
+
+
+/* The in-flight table is indexed by packet id: an id can only be in its own slot */
+static struct InflightMessage* findInflight(MQTTClient* c, unsigned short id)
+{
+    struct InflightMessage* m = &c->inflight[id % MAX_INFLIGHT_MESSAGES];
+
+    return (id != 0 && m->id == id) ? m : NULL;
 }
 
 
 static int getNextPacketId(MQTTClient *c) {
-    return c->next_packetid = (c->next_packetid == MAX_PACKET_ID) ? 1 : c->next_packetid + 1;
+    do  /* skip the ids still in flight */
+        c->next_packetid = (c->next_packetid == MAX_PACKET_ID) ? 1 : c->next_packetid + 1;
+    while (findInflight(c, c->next_packetid) != NULL);
+    return c->next_packetid;
 }
 
 
-static int sendPacket(MQTTClient* c, int length, Timer* timer)
+/* Slot of a new in-flight publication, whose id is set: the next packet id with a free slot.
+ * The consecutive ids go through all the slots, so it takes at most MAX_INFLIGHT_MESSAGES + 1 ids. */
+static struct InflightMessage* allocInflight(MQTTClient* c)
+{
+    struct InflightMessage* m;
+
+    if (c->inflight_count >= MAX_INFLIGHT_MESSAGES)
+        return NULL;
+    do
+        m = &c->inflight[getNextPacketId(c) % MAX_INFLIGHT_MESSAGES];
+    while (m->id != 0);
+    m->id = c->next_packetid;
+    m->retransmitted = 0;
+    if (c->inflight_count++ == 0)
+        TimerCountdownMS(&c->inflight_retry, c->command_timeout_ms);   /* the first deadline is its own */
+    return m;
+}
+
+
+/* Acknowledgement of the last packet sent for m: round trip time sample, unless it was retransmitted */
+static void ackInflight(MQTTClient* c, struct InflightMessage* m)
+{
+    MQTTInflightStats* s = &c->inflightStats;
+    unsigned int rtt;
+
+    s->acks++;
+    if (m->retransmitted)
+        return;
+    rtt = c->command_timeout_ms - TimerLeftMS(&m->retry);
+    s->rtt_last_ms = rtt;
+    if (s->rtt_samples == 0 || rtt < s->rtt_min_ms)
+        s->rtt_min_ms = rtt;
+    if (rtt > s->rtt_max_ms)
+        s->rtt_max_ms = rtt;
+    s->rtt_total_ms += rtt;
+    s->rtt_samples++;
+}
+
+
+static void completeInflight(MQTTClient* c, struct InflightMessage* m, int rc)
+{
+    unsigned short id = m->id;
+    void* context = m->context;
+
+    m->id = 0;  /* free the slot first: the handler may queue the next publication */
+    c->inflight_count--;
+    if (c->publishComplete != NULL)
+        c->publishComplete(context, id, rc);
+}
+
+
+static void failInflight(MQTTClient* c)
+{
+    int i;
+
+    for (i = 0; i < MAX_INFLIGHT_MESSAGES; ++i)
+    {
+        if (c->inflight[i].id != 0)
+            completeInflight(c, &c->inflight[i], FAILURE);
+    }
+}
+
+
+#if defined(MQTTV5)
+/* Outgoing alias of a topic name: > 0 if the server already has it, < 0 for a new alias to be set
+ * by this publication (minus the alias), 0 if none is available */
+static int topicAlias(MQTTClient* c, const char* topicName)
+{
+    int i;
+
+    for (i = 0; i < c->topicAliasCount; ++i)
+    {
+        if (strcmp(c->topicAliases[i], topicName) == 0)
+            return i + 1;
+    }
+    if (i < c->topicAliasMaximum && strlen(topicName) < MAX_TOPIC_ALIAS_SIZE)
+        return -(i + 1);
+    return 0;
+}
+#endif
+
+
+/* PUBACK, PUBREC, PUBREL or PUBCOMP in readbuf. reasonCode: MQTT 5, >= 0x80 for a failure */
+static int deserializeAck(MQTTClient* c, unsigned char* type, unsigned char* dup, unsigned short* id, unsigned char* reasonCode)
+{
+    *reasonCode = 0;
+#if defined(MQTTV5)
+    if (c->MQTTVersion == 5)
+    {
+        int rc = MQTTV5Deserialize_ack(type, dup, id, reasonCode, NULL, c->readbuf, c->readbuf_size);
+
+        if (rc == 1 && *reasonCode >= 0x80)
+            c->reasonCode = *reasonCode;
+        return rc;
+    }
+#endif
+    return MQTTDeserialize_ack(type, dup, id, c->readbuf, c->readbuf_size);
+}
+
+
+static int sendBuffer(MQTTClient* c, unsigned char* buf, int length, Timer* timer)
 {
     int rc = FAILURE,
         sent = 0;
 
     while (sent < length && !TimerIsExpired(timer))
     {
-        rc = c->ipstack->mqttwrite(c->ipstack, &c->buf[sent], length - sent, TimerLeftMS(timer)); // length changed by length - sent for long packets and non blocking sockets
+        rc = c->ipstack->mqttwrite(c->ipstack, &buf[sent], length - sent, TimerLeftMS(timer)); // length changed by length - sent for long packets and non blocking sockets
         if (rc < 0)  // there was an error writing the data
             break;
         sent += rc;
     }
-    if (sent == length)
-    {
+    return (sent == length) ? MQSUCCESS : FAILURE;
+}
+
+
+static int sendPacket(MQTTClient* c, int length, Timer* timer)
+{
+    int rc = sendBuffer(c, c->buf, length, timer);
+
+    if (rc == MQSUCCESS)
         TimerCountdown(&c->last_sent, c->keepAliveInterval); // record the fact that we have successfully sent the packet
-        rc = MQSUCCESS;
+    return rc;
+}
+
+
+/* Send a PUBLISH: the header is serialized into c->buf, the payload is written from the caller's buffer.
+ * Both writes are combined by the transport when it can (mqttflush); otherwise the payload is copied
+ * into c->buf if it fits, so that the packet still goes in one write.
+ * MQTT 5: the topic name is sent once with a new alias, then only the alias. */
+static int sendPublish(MQTTClient* c, unsigned char dup, int qos, unsigned char retained, unsigned short id,
+        const char* topicName, void* payload, size_t payloadlen, Timer* timer)
+{
+    MQTTString topic = MQTTString_initializer;
+    int len = 0,
+        rc = FAILURE;
+#if defined(MQTTV5)
+    MQTTProperty aliasProperty[1];
+    MQTTProperties props = MQTTProperties_initializer;
+    MQTTProperties* properties = NULL;     /* MQTT 3.1.1 */
+    int alias = 0;
+
+    if (c->MQTTVersion == 5)
+    {
+        properties = &props;
+        props.array = aliasProperty;
+        props.max_count = 1;
+        if ((alias = topicAlias(c, topicName)) != 0)
+        {
+            MQTTProperty prop;
+
+            prop.identifier = MQTTPROPERTY_CODE_TOPIC_ALIAS;
+            prop.value.integer2 = (unsigned short)((alias > 0) ? alias : -alias);
+            MQTTProperties_add(&props, &prop);
+        }
     }
-    else
+    topic.cstring = (char *)((alias > 0) ? "" : topicName);
+    if (c->ipstack->mqttflush == NULL &&
+        (len = MQTTV5Serialize_publish(c->buf, c->buf_size, dup, qos, retained, id,
+              topic, properties, (unsigned char*)payload, payloadlen)) > 0)
+    {
+        if (c->maximumPacketSize > 0 && (unsigned int)len > c->maximumPacketSize)
+            return BUFFER_OVERFLOW;
+        rc = sendPacket(c, len, timer);
+    }
+    else if ((len = MQTTV5Serialize_publishHeader(c->buf, c->buf_size, dup, qos, retained, id,
+              topic, properties, payloadlen)) > 0)
+    {
+        if (c->maximumPacketSize > 0 && len + payloadlen > c->maximumPacketSize)
+            return BUFFER_OVERFLOW;
+#else
+    topic.cstring = (char *)topicName;
+    if (c->ipstack->mqttflush == NULL &&
+        (len = MQTTSerialize_publish(c->buf, c->buf_size, dup, qos, retained, id,
+              topic, (unsigned char*)payload, payloadlen)) > 0)
+        rc = sendPacket(c, len, timer);
+    else if ((len = MQTTSerialize_publishHeader(c->buf, c->buf_size, dup, qos, retained, id, topic, payloadlen)) > 0)
+    {
+#endif
+        if ((rc = sendBuffer(c, c->buf, len, timer)) == MQSUCCESS
+            && (rc = sendBuffer(c, (unsigned char*)payload, payloadlen, timer)) == MQSUCCESS
+            && c->ipstack->mqttflush != NULL && c->ipstack->mqttflush(c->ipstack) < 0)
+            rc = FAILURE;
+        if (rc == MQSUCCESS)
+            TimerCountdown(&c->last_sent, c->keepAliveInterval);
+    }
+#if defined(MQTTV5)
+    if (rc == MQSUCCESS && alias < 0)   /* the server has the alias now */
+        strcpy(c->topicAliases[c->topicAliasCount++], topicName);
+#endif
+    return rc;
+}
+
+
+/* (Re)send an in-flight publication: the PUBLISH until it is received, then the PUBREL for QoS2. */
+static int sendInflight(MQTTClient* c, struct InflightMessage* m, unsigned char dup, Timer* timer)
+{
+    int len = 0,
         rc = FAILURE;
+
+    if (m->packet_type == PUBCOMP)
+    {
+        if ((len = MQTTSerialize_ack(c->buf, c->buf_size, PUBREL, 0, m->id)) > 0)
+            rc = sendPacket(c, len, timer);
+    }
+    else
+        rc = sendPublish(c, dup, m->qos, m->retained, m->id, m->topicName, m->payload, m->payloadlen, timer);
+    if (rc == MQSUCCESS)
+        TimerCountdownMS(&m->retry, c->command_timeout_ms);
     return rc;
 }
 
@@ -66,90 +290,118 @@ static int sendPacket(MQTTClient* c, int length, Timer* timer)
 void MQTTClientInit(MQTTClient* c, Network* network, unsigned int command_timeout_ms,
 		unsigned char* sendbuf, size_t sendbuf_size, unsigned char* readbuf, size_t readbuf_size)
 {
-    int i;
     c->ipstack = network;
 
-    for (i = 0; i < MAX_MESSAGE_HANDLERS; ++i)
-        c->messageHandlers[i].topicFilter = 0;
+    MQTTTopicIndex_init(&c->messageHandlers);
     c->command_timeout_ms = command_timeout_ms;
     c->buf = sendbuf;
     c->buf_size = sendbuf_size;
     c->readbuf = readbuf;
     c->readbuf_size = readbuf_size;
+    c->readbuf_len = 0;
+    c->readbuf_packet = 0;
     c->isconnected = 0;
     c->cleansession = 0;
     c->ping_outstanding = 0;
     c->defaultMessageHandler = NULL;
 	  c->next_packetid = 1;
+    memset(c->inflight, 0, sizeof(c->inflight));
+    c->inflight_window = MAX_INFLIGHT_MESSAGES;
+    c->inflight_count = 0;
+    TimerInit(&c->inflight_retry);
+    memset(&c->inflightStats, 0, sizeof(c->inflightStats));
+    memset(c->lastValues, 0, sizeof(c->lastValues));
+    c->publishComplete = NULL;
+#if defined(MQTTV5)
+    c->MQTTVersion = 4;
+    c->reasonCode = 0;
+    c->sessionExpiryInterval = 0;
+    c->receiveMaximum = 65535;
+    c->topicAliasMaximum = 0;
+    c->maximumPacketSize = 0;
+    c->topicAliasCount = 0;
+#endif
     TimerInit(&c->last_sent);
     TimerInit(&c->last_received);
 #if defined(MQTT_TASK)
     MutexInit(&c->mutex);
+    MQTTPublishQueue_init(&c->publishQueue);
 #endif
 }
 
 
-static int decodePacket(MQTTClient* c, int* value, int timeout)
+/* Fixed header length of the packet at the beginning of readbuf: 0 if not received yet, MQTTPACKET_READ_ERROR if bad */
+static int decodePacket(MQTTClient* c, int* value)
 {
     unsigned char i;
     int multiplier = 1;
-    int len = 0;
-    const int MAX_NO_OF_REMAINING_LENGTH_BYTES = 4;
+    size_t len = 1;
+    const size_t MAX_NO_OF_REMAINING_LENGTH_BYTES = 4;
 
     *value = 0;
     do
     {
-        int rc = MQTTPACKET_READ_ERROR;
-
-        if (++len > MAX_NO_OF_REMAINING_LENGTH_BYTES)
-        {
-            rc = MQTTPACKET_READ_ERROR; /* bad data */
-            goto exit;
-        }
-        rc = c->ipstack->mqttread(c->ipstack, &i, 1, timeout);
-        if (rc != 1)
-            goto exit;
+        if (len > MAX_NO_OF_REMAINING_LENGTH_BYTES)
+            return MQTTPACKET_READ_ERROR; /* bad data */
+        if (len >= c->readbuf_len)
+            return 0;
+        i = c->readbuf[len++];
         *value += (i & 127) * multiplier;
         multiplier *= 128;
     } while ((i & 128) != 0);
-exit:
-    return len;
+    return (int)len;
 }
 
 
+/* Frame the next packet out of readbuf. The transport is read for what is available, not byte by byte:
+ * the bytes read ahead stay in readbuf for the next calls, and so does an incomplete packet on timeout. */
 static int readPacket(MQTTClient* c, Timer* timer)
 {
     MQTTHeader header = {0};
     int len = 0;
     int rem_len = 0;
+    int rc = 0;
 
-    /* 1. read the header byte.  This has the packet type in it */
-    int rc = c->ipstack->mqttread(c->ipstack, c->readbuf, 1, TimerLeftMS(timer));
-    if (rc != 1)
-        goto exit;
-
-    len = 1;
-    /* 2. read the remaining length.  This is variable in itself */
-    decodePacket(c, &rem_len, TimerLeftMS(timer));
-    len += MQTTPacket_encode(c->readbuf + 1, rem_len); /* put the original remaining length back into the buffer */
-
-    if (rem_len > (c->readbuf_size - len))
+    /* 1. drop the previous packet, the bytes after it are the beginning of the next one */
+    if (c->readbuf_packet > 0)
     {
-        rc = BUFFER_OVERFLOW;
-        goto exit;
+        c->readbuf_len -= c->readbuf_packet;
+        memmove(c->readbuf, c->readbuf + c->readbuf_packet, c->readbuf_len);
+        c->readbuf_packet = 0;
     }
 
-    /* 3. read the rest of the buffer using a callback to supply the rest of the data */
-    if (rem_len > 0)
+    for (;;)
     {
-      rc = c->ipstack->mqttread(c->ipstack, c->readbuf + len, rem_len, TimerLeftMS(timer));
-      if (rc != rem_len)
-      {
-        rc = 0;
-        goto exit;
-      }
+        /* 2. decode the header byte and the remaining length, which is variable in itself */
+        if (c->readbuf_len > 0)
+        {
+            if ((len = decodePacket(c, &rem_len)) == MQTTPACKET_READ_ERROR)
+            {
+                rc = FAILURE;
+                goto exit;
+            }
+            if (len > 0 && rem_len > (int)c->readbuf_size - len)
+            {
+                rc = BUFFER_OVERFLOW;
+                goto exit;
+            }
+            if (len > 0 && c->readbuf_len >= (size_t)(len + rem_len))
+                break;      /* complete packet */
+        }
+        if (rc > 0 && TimerIsExpired(timer))
+        {
+            rc = 0;         /* incomplete in time: keep the bytes for the next cycle */
+            goto exit;
+        }
+
+        /* 3. read whatever is available */
+        rc = c->ipstack->mqttread(c->ipstack, c->readbuf + c->readbuf_len, c->readbuf_size - c->readbuf_len, TimerLeftMS(timer));
+        if (rc <= 0)
+            goto exit;      /* nothing available, or an error */
+        c->readbuf_len += rc;
     }
 
+    c->readbuf_packet = len + rem_len;
     header.byte = c->readbuf[0];
     rc = header.bits.type;
     if (c->keepAliveInterval > 0)
@@ -159,62 +411,96 @@ exit:
 }
 
 
-// assume topic filter and name is in correct format
-// # can only be at end
-// + and # can only be next to separator
-static char isTopicMatched(char* topicFilter, MQTTString* topicName)
+/* FNV-1a */
+static unsigned int hashBytes(unsigned int h, const void* data, size_t len)
 {
-    char* curf = topicFilter;
-    char* curn = topicName->lenstring.data;
-    char* curn_end = curn + topicName->lenstring.len;
+    const unsigned char* p = (const unsigned char*)data;
 
-    while (*curf && curn < curn_end)
+    while (len--)
     {
-        if (*curn == '/' && *curf != '/')
-            break;
-        if (*curf != '+' && *curf != '#' && *curf != *curn)
-            break;
-        if (*curf == '+')
-        {   // skip until we meet the next separator, or end of string
-            char* nextpos = curn + 1;
-            while (nextpos < curn_end && *nextpos != '/')
-                nextpos = ++curn + 1;
-        }
-        else if (*curf == '#')
-            curn = curn_end - 1;    // skip until end of string
-        curf++;
-        curn++;
-    };
+        h ^= *p++;
+        h *= 16777619u;
+    }
+    return h;
+}
 
-    return (curn == curn_end) && (*curf == '\0');
+
+static unsigned int hashFilter(const char* topicFilter)
+{
+    return hashBytes(2166136261u, topicFilter, strlen(topicFilter));
 }
 
 
-int deliverMessage(MQTTClient* c, MQTTString* topicName, MQTTMessage* message)
+static struct LastValue* findLastValue(MQTTClient* c, const char* topicFilter)
 {
+    unsigned int filter = hashFilter(topicFilter);
     int i;
-    int rc = FAILURE;
 
-    // we have to find the right message handler - indexed by topic
-    for (i = 0; i < MAX_MESSAGE_HANDLERS; ++i)
+    for (i = 0; i < MAX_CACHED_VALUES; ++i)
     {
-        if (c->messageHandlers[i].topicFilter != 0 && (MQTTPacket_equals(topicName, (char*)c->messageHandlers[i].topicFilter) ||
-                isTopicMatched((char*)c->messageHandlers[i].topicFilter, topicName)))
-        {
-            if (c->messageHandlers[i].fp != NULL)
-            {
-                MessageData md;
-                NewMessageData(&md, topicName, message);
-                c->messageHandlers[i].fp(&md);
-                rc = MQSUCCESS;
-            }
-        }
+        if (c->lastValues[i].used && c->lastValues[i].filter == filter)
+            return &c->lastValues[i];
+    }
+    return NULL;
+}
+
+
+/* Keep the message if it differs from the last one of the subscription: it is delivered then */
+static int lastValueChanged(struct LastValue* lv, MQTTString* topicName, MQTTMessage* message)
+{
+    const char* topic = topicName->cstring ? topicName->cstring : topicName->lenstring.data;
+    unsigned int hash = hashBytes(2166136261u, topic, MQTTstrlen(*topicName));
+
+    hash = hashBytes(hash, message->payload, message->payloadlen);
+    if (lv->received && lv->hash == hash && lv->len == message->payloadlen &&
+            (message->payloadlen > MAX_CACHED_VALUE_SIZE || memcmp(lv->value, message->payload, message->payloadlen) == 0))
+    {
+        lv->unchanged++;
+        return 0;
     }
+    lv->received = 1;
+    lv->hash = hash;
+    lv->len = message->payloadlen;
+    if (message->payloadlen <= MAX_CACHED_VALUE_SIZE)
+        memcpy(lv->value, message->payload, message->payloadlen);
+    return 1;
+}
+
+
+static void deliverToHandler(void* arg, MQTTTopicNode* node)
+{
+    struct Delivery* d = (struct Delivery*)arg;
+
+    if (node->cache > 0 && !lastValueChanged(&d->c->lastValues[node->cache - 1], d->topicName, d->message))
+        return;
+    if (node->fp != NULL)
+    {
+        MessageData md;
+        NewMessageData(&md, d->topicName, d->message);
+        md.context = node->context;
+#if defined(MQTTV5)
+        md.properties = d->properties;
+#endif
+        node->fp(&md);
+    }
+}
+
+
+int deliverMessage(MQTTClient* c, struct Delivery* d)
+{
+    int rc = FAILURE;
+
+    // we have to find the right message handlers - indexed by topic
+    if (MQTTTopicIndex_match(&c->messageHandlers, d->topicName, deliverToHandler, d) > 0)
+        rc = MQSUCCESS;
 
     if (rc == FAILURE && c->defaultMessageHandler != NULL)
     {
         MessageData md;
-        NewMessageData(&md, topicName, message);
+        NewMessageData(&md, d->topicName, d->message);
+#if defined(MQTTV5)
+        md.properties = d->properties;
+#endif
         c->defaultMessageHandler(&md);
         rc = MQSUCCESS;
     }
@@ -255,10 +541,40 @@ exit:
 
 void MQTTCleanSession(MQTTClient* c)
 {
-    int i = 0;
+    MQTTTopicIndex_init(&c->messageHandlers);
+}
+
 
-    for (i = 0; i < MAX_MESSAGE_HANDLERS; ++i)
-        c->messageHandlers[i].topicFilter = NULL;
+int retryInflight(MQTTClient* c)
+{
+    int i, left;
+    int rc = MQSUCCESS;
+    int next = c->command_timeout_ms;
+    Timer timer;
+
+    /* nothing is due before inflight_retry: most cycles stop here */
+    if (c->inflight_count == 0 || !TimerIsExpired(&c->inflight_retry))
+        return MQSUCCESS;
+
+    TimerInit(&timer);
+    TimerCountdownMS(&timer, c->command_timeout_ms);
+    for (i = 0; i < MAX_INFLIGHT_MESSAGES && rc == MQSUCCESS; ++i)
+    {
+        struct InflightMessage* m = &c->inflight[i];
+
+        if (m->id == 0)
+            continue;
+        if (TimerIsExpired(&m->retry))
+        {
+            m->retransmitted = 1;
+            c->inflightStats.retries++;
+            rc = sendInflight(c, m, 1, &timer);
+        }
+        else if ((left = TimerLeftMS(&m->retry)) < next)
+            next = left;
+    }
+    TimerCountdownMS(&c->inflight_retry, next);
+    return rc;
 }
 
 
@@ -266,20 +582,56 @@ void MQTTCloseSession(MQTTClient* c)
 {
     c->ping_outstanding = 0;
     c->isconnected = 0;
+    c->readbuf_len = c->readbuf_packet = 0;   /* the bytes of the connection are worthless now */
     if (c->cleansession){
     	MQTTCleanSession(c);
+    	failInflight(c);
     	c->ipstack->mqttdisconnect(c->ipstack);
     }
 }
 
 
+/* Time until the client has to send on its own: PINGREQ, or the retransmission of an in-flight publication */
+static int nextDeadline(MQTTClient* c)
+{
+    int due = INT_MAX;
+    int left;
+
+    if (!c->isconnected)
+        return due;
+    if (c->keepAliveInterval > 0)
+    {
+        due = TimerLeftMS(&c->last_sent);
+        if ((left = TimerLeftMS(&c->last_received)) < due)
+            due = left;
+    }
+    if (c->inflight_count > 0 && (left = TimerLeftMS(&c->inflight_retry)) < due)
+        due = left;
+    return due;
+}
+
+
 int cycle(MQTTClient* c, Timer* timer)
 {
     int len = 0,
         rc = MQSUCCESS;
+    Timer send_timer;   /* the acks get the command timeout: the read timeout may be over once the packet is in */
+    Timer read_timer;
+    int due,
+        left = TimerLeftMS(timer);
+
+    if (left > 0 && (due = nextDeadline(c)) < left)
+    {
+        /* the read returns on data, or in time for the keepalive and the retransmissions below */
+        TimerInit(&read_timer);
+        TimerCountdownMS(&read_timer, due);
+        timer = &read_timer;
+    }
 
     int packet_type = readPacket(c, timer);     /* read the socket, see what work is due */
 
+    TimerInit(&send_timer);
+
     switch (packet_type)
     {
         default:
@@ -289,30 +641,65 @@ int cycle(MQTTClient* c, Timer* timer)
         case 0: /* timed out reading packet */
             break;
         case CONNACK:
-        case PUBACK:
         case SUBACK:
+        case UNSUBACK:
             break;
+        case PUBACK:
+        case PUBCOMP:
+        {
+            unsigned short mypacketid;
+            unsigned char dup, type, reasonCode;
+            struct InflightMessage* m;
+            if (deserializeAck(c, &type, &dup, &mypacketid, &reasonCode) != 1)
+            {
+                rc = FAILURE;
+                goto exit;
+            }
+            if ((m = findInflight(c, mypacketid)) != NULL && m->packet_type == packet_type)
+            {
+                ackInflight(c, m);
+                completeInflight(c, m, (reasonCode >= 0x80) ? REFUSED : MQSUCCESS);
+            }
+            break;
+        }
         case PUBLISH:
         {
             MQTTString topicName;
             MQTTMessage msg;
             int intQoS;
+            struct Delivery d = {c, &topicName, &msg};
             msg.payloadlen = 0; /* this is a size_t, but deserialize publish sets this as int */
+#if defined(MQTTV5)
+            MQTTProperty properties[MAX_MESSAGE_PROPERTIES];
+            MQTTProperties props = MQTTProperties_initializer;
+            props.array = properties;
+            props.max_count = MAX_MESSAGE_PROPERTIES;
+            d.properties = NULL;
+            if (c->MQTTVersion == 5)
+            {
+                d.properties = &props;
+                if (MQTTV5Deserialize_publish(&msg.dup, &intQoS, &msg.retained, &msg.id, &topicName, &props,
+                   (unsigned char**)&msg.payload, (int*)&msg.payloadlen, c->readbuf, c->readbuf_size) != 1)
+                    goto exit;
+            }
+            else
+#endif
             if (MQTTDeserialize_publish(&msg.dup, &intQoS, &msg.retained, &msg.id, &topicName,
                (unsigned char**)&msg.payload, (int*)&msg.payloadlen, c->readbuf, c->readbuf_size) != 1)
                 goto exit;
             msg.qos = (enum QoS)intQoS;
-            deliverMessage(c, &topicName, &msg);
+            deliverMessage(c, &d);
             if (msg.qos != QOS0)
             {
                 if (msg.qos == QOS1)
                     len = MQTTSerialize_ack(c->buf, c->buf_size, PUBACK, 0, msg.id);
                 else if (msg.qos == QOS2)
                     len = MQTTSerialize_ack(c->buf, c->buf_size, PUBREC, 0, msg.id);
+                TimerCountdownMS(&send_timer, c->command_timeout_ms);
                 if (len <= 0)
                     rc = FAILURE;
                 else
-                    rc = sendPacket(c, len, timer);
+                    rc = sendPacket(c, len, &send_timer);
                 if (rc == FAILURE)
                     goto exit; // there was a problem
             }
@@ -322,30 +709,59 @@ int cycle(MQTTClient* c, Timer* timer)
         case PUBREL:
         {
             unsigned short mypacketid;
-            unsigned char dup, type;
-            if (MQTTDeserialize_ack(&type, &dup, &mypacketid, c->readbuf, c->readbuf_size) != 1)
+            unsigned char dup, type, reasonCode;
+            struct InflightMessage* m;
+            if (deserializeAck(c, &type, &dup, &mypacketid, &reasonCode) != 1)
                 rc = FAILURE;
+            else if (packet_type == PUBREC && reasonCode >= 0x80)
+            {
+                /* refused by the server: no PUBREL, the exchange ends here */
+                if ((m = findInflight(c, mypacketid)) != NULL && m->packet_type == PUBREC)
+                {
+                    ackInflight(c, m);
+                    completeInflight(c, m, REFUSED);
+                }
+                break;
+            }
             else if ((len = MQTTSerialize_ack(c->buf, c->buf_size,
                 (packet_type == PUBREC) ? PUBREL : PUBCOMP, 0, mypacketid)) <= 0)
                 rc = FAILURE;
-            else if ((rc = sendPacket(c, len, timer)) != MQSUCCESS) // send the PUBREL packet
-                rc = FAILURE; // there was a problem
+            else
+            {
+                TimerCountdownMS(&send_timer, c->command_timeout_ms);
+                if ((rc = sendPacket(c, len, &send_timer)) != MQSUCCESS) // send the PUBREL packet
+                    rc = FAILURE; // there was a problem
+            }
             if (rc == FAILURE)
                 goto exit; // there was a problem
+            if (packet_type == PUBREC && (m = findInflight(c, mypacketid)) != NULL && m->packet_type == PUBREC)
+            {
+                ackInflight(c, m);
+                m->packet_type = PUBCOMP;   /* released: now waiting for the PUBCOMP */
+                m->retransmitted = 0;
+                TimerCountdownMS(&m->retry, c->command_timeout_ms);
+            }
             break;
         }
 
-        case PUBCOMP:
-            break;
         case PINGRESP:
             c->ping_outstanding = 0;
             break;
+#if defined(MQTTV5)
+        case DISCONNECT:    /* the server closes the connection, with the reason */
+            if (MQTTV5Deserialize_disconnect(NULL, &c->reasonCode, c->readbuf, c->readbuf_size) != 1)
+                c->reasonCode = MQTTREASONCODE_UNSPECIFIED_ERROR;
+            rc = FAILURE;
+            goto exit;
+#endif
     }
 
     if (keepalive(c) != MQSUCCESS) {
         //check only keepalive FAILURE status so that previous FAILURE status can be considered as FAULT
         rc = FAILURE;
     }
+    else if (c->isconnected && retryInflight(c) != MQSUCCESS)
+        rc = FAILURE;
 
 exit:
     if (rc == MQSUCCESS)
@@ -356,6 +772,27 @@ exit:
 }
 
 
+int MQTTWaitEvent(MQTTClient* c, int timeout_ms)
+{
+    int rc = 0;
+    Timer timer;
+
+    TimerInit(&timer);
+    TimerCountdownMS(&timer, timeout_ms);
+
+    do
+    {
+        if ((rc = cycle(c, &timer)) < 0)
+        {
+            rc = FAILURE;
+            break;
+        }
+    } while (rc == 0 && !TimerIsExpired(&timer));
+
+    return rc;
+}
+
+
 int MQTTYield(MQTTClient* c, int timeout_ms)
 {
     int rc = MQSUCCESS;
@@ -377,6 +814,34 @@ int MQTTYield(MQTTClient* c, int timeout_ms)
 }
 
 
+#if defined(MQTT_TASK)
+static int publishAsync(MQTTClient* c, const char* topicName, MQTTMessage* message, void* context);
+
+/* Network task: send the queued publications, in order, while the in-flight window allows */
+static void sendQueued(MQTTClient* c)
+{
+    MQTTQueuedPublish* p;
+    MQTTMessage message;
+    int rc;
+
+    while (c->isconnected && (p = MQTTPublishQueue_front(&c->publishQueue)) != NULL)
+    {
+        message.qos = (enum QoS)p->qos;
+        message.retained = p->retained;
+        message.dup = 0;
+        message.payload = p->payload;
+        message.payloadlen = p->payloadlen;
+        rc = publishAsync(c, p->topicName, &message, p->context);
+        if (rc == WINDOW_FULL || (rc == FAILURE && !c->isconnected))
+            break;  /* kept: sent once acknowledgements free the window, or after the reconnection */
+        if (rc != MQSUCCESS && c->publishComplete != NULL)
+            c->publishComplete(p->context, 0, rc);  /* cannot be sent, e.g. BUFFER_OVERFLOW */
+        MQTTPublishQueue_pop(&c->publishQueue);
+    }
+}
+#endif
+
+
 void MQTTRun(void* parm)
 {
 	Timer timer;
@@ -388,8 +853,12 @@ void MQTTRun(void* parm)
 	{
 #if defined(MQTT_TASK)
 		MutexLock(&c->mutex,0);
-#endif
+		sendQueued(c);
+		/* short reads: the queued publications are not held behind an idle socket */
+		TimerCountdownMS(&timer, MQTT_TASK_POLL_MS);
+#else
 		TimerCountdownMS(&timer, 500); /* Don't wait too long if no traffic is incoming */
+#endif
 		cycle(c, &timer);
 #if defined(MQTT_TASK)
 		MutexUnlock(&c->mutex);
@@ -403,6 +872,20 @@ int MQTTStartTask(MQTTClient* client)
 {
 	return ThreadStart(&client->thread, MQTTRun, client);
 }
+
+
+int MQTTPublishQueued(MQTTClient* c, const char* topicName, MQTTMessage* message, void* context)
+{
+    MQTTQueuedPublish p;
+
+    p.topicName = topicName;
+    p.payload = message->payload;
+    p.payloadlen = message->payloadlen;
+    p.qos = (unsigned char)message->qos;
+    p.retained = message->retained;
+    p.context = context;
+    return (MQTTPublishQueue_push(&c->publishQueue, &p) == 0) ? MQSUCCESS : WINDOW_FULL;
+}
 #endif
 
 
@@ -422,6 +905,76 @@ int waitfor(MQTTClient* c, int packet_type, Timer* timer)
 }
 
 
+/* Wait for the ack of a given packet id: the acks of the asynchronous publications are skipped.
+ * REFUSED if the ack has an MQTT 5 failure reason code. */
+int waitforAck(MQTTClient* c, int packet_type, unsigned short id, Timer* timer)
+{
+    int rc = FAILURE;
+    unsigned short mypacketid = 0;
+    unsigned char dup, type, reasonCode = 0;
+
+    do
+    {
+        if ((rc = waitfor(c, packet_type, timer)) != packet_type)
+            break;
+        if (deserializeAck(c, &type, &dup, &mypacketid, &reasonCode) != 1)
+            rc = FAILURE;
+    }
+    while (rc == packet_type && mypacketid != id);
+
+    return (rc == packet_type && reasonCode >= 0x80) ? REFUSED : rc;
+}
+
+
+
+
+#if defined(MQTTV5)
+/* CONNECT properties: the session expiry, and the largest packet readbuf can hold */
+static int serializeConnect(MQTTClient* c, MQTTPacket_connectData* options)
+{
+    MQTTProperty properties[2];
+    MQTTProperties props = MQTTProperties_initializer;
+    MQTTProperty prop;
+
+    props.array = properties;
+    props.max_count = 2;
+    if (c->sessionExpiryInterval > 0)
+    {
+        prop.identifier = MQTTPROPERTY_CODE_SESSION_EXPIRY_INTERVAL;
+        prop.value.integer4 = c->sessionExpiryInterval;
+        MQTTProperties_add(&props, &prop);
+    }
+    prop.identifier = MQTTPROPERTY_CODE_MAXIMUM_PACKET_SIZE;
+    prop.value.integer4 = (unsigned int)c->readbuf_size;
+    MQTTProperties_add(&props, &prop);
+    return MQTTV5Serialize_connect(c->buf, c->buf_size, options, &props, NULL);
+}
+
+
+/* CONNACK properties: the limits of the server for this connection */
+static int deserializeConnack(MQTTClient* c, MQTTConnackData* data)
+{
+    MQTTProperty properties[MAX_MESSAGE_PROPERTIES];
+    MQTTProperties props = MQTTProperties_initializer;
+    unsigned int value;
+    int rc;
+
+    props.array = properties;
+    props.max_count = MAX_MESSAGE_PROPERTIES;
+    if ((rc = MQTTV5Deserialize_connack(&props, &data->sessionPresent, &data->rc, c->readbuf, c->readbuf_size)) != 1)
+        return rc;
+
+    c->reasonCode = data->rc;
+    c->receiveMaximum = MQTTProperties_getNumericValue(&props, MQTTPROPERTY_CODE_RECEIVE_MAXIMUM, &value) ? value : 65535;
+    c->topicAliasMaximum = 0;
+    if (MQTTProperties_getNumericValue(&props, MQTTPROPERTY_CODE_TOPIC_ALIAS_MAXIMUM, &value))
+        c->topicAliasMaximum = (value < MAX_TOPIC_ALIASES) ? value : MAX_TOPIC_ALIASES;
+    c->maximumPacketSize = MQTTProperties_getNumericValue(&props, MQTTPROPERTY_CODE_MAXIMUM_PACKET_SIZE, &value) ? value : 0;
+    if (MQTTProperties_getNumericValue(&props, MQTTPROPERTY_CODE_SERVER_KEEP_ALIVE, &value))
+        c->keepAliveInterval = value;
+    return rc;
+}
+#endif
 
 
 int MQTTConnectWithResults(MQTTClient* c, MQTTPacket_connectData* options, MQTTConnackData* data)
@@ -445,8 +998,21 @@ int MQTTConnectWithResults(MQTTClient* c, MQTTPacket_connectData* options, MQTTC
 
     c->keepAliveInterval = options->keepAliveInterval;
     c->cleansession = options->cleansession;
+    c->readbuf_len = c->readbuf_packet = 0;
     TimerCountdown(&c->last_received, c->keepAliveInterval);
-    if ((len = MQTTSerialize_connect(c->buf, c->buf_size, options)) <= 0)
+#if defined(MQTTV5)
+    c->MQTTVersion = options->MQTTVersion;
+    c->reasonCode = 0;
+    c->receiveMaximum = 65535;
+    c->topicAliasMaximum = 0;
+    c->maximumPacketSize = 0;
+    c->topicAliasCount = 0;     /* the aliases are per connection */
+    if (options->MQTTVersion == 5)
+        len = serializeConnect(c, options);
+    else
+#endif
+    len = MQTTSerialize_connect(c->buf, c->buf_size, options);
+    if (len <= 0)
         goto exit;
     if ((rc = sendPacket(c, len, &connect_timer)) != MQSUCCESS)  // send the connect packet
         goto exit; // there was a problem
@@ -456,7 +1022,13 @@ int MQTTConnectWithResults(MQTTClient* c, MQTTPacket_connectData* options, MQTTC
     {
         data->rc = 0;
         data->sessionPresent = 0;
-        if (MQTTDeserialize_connack(&data->sessionPresent, &data->rc, c->readbuf, c->readbuf_size) == 1)
+#if defined(MQTTV5)
+        if (c->MQTTVersion == 5)
+            len = deserializeConnack(c, data);
+        else
+#endif
+        len = MQTTDeserialize_connack(&data->sessionPresent, &data->rc, c->readbuf, c->readbuf_size);
+        if (len == 1)
             rc = data->rc;
         else
             rc = FAILURE;
@@ -469,6 +1041,15 @@ exit:
     {
         c->isconnected = 1;
         c->ping_outstanding = 0;
+        if (c->cleansession)
+            failInflight(c);    /* new session: the broker forgot them */
+        else
+        {
+            int i;  /* resumed session: retransmit on the next cycle */
+            for (i = 0; i < MAX_INFLIGHT_MESSAGES; ++i)
+                TimerInit(&c->inflight[i].retry);
+            TimerInit(&c->inflight_retry);
+        }
     }
 
 #if defined(MQTT_TASK)
@@ -486,50 +1067,98 @@ int MQTTConnect(MQTTClient* c, MQTTPacket_connectData* options)
 }
 
 
-int MQTTSetMessageHandler(MQTTClient* c, const char* topicFilter, messageHandler messageHandler)
+int MQTTSetMessageHandlerContext(MQTTClient* c, const char* topicFilter, messageHandler messageHandler, void* context)
 {
     int rc = FAILURE;
-    int i = -1;
+    struct LastValue* lv = findLastValue(c, topicFilter);
 
-    /* first check for an existing matching slot */
-    for (i = 0; i < MAX_MESSAGE_HANDLERS; ++i)
+    if (messageHandler == NULL) /* remove existing */
     {
-        if (c->messageHandlers[i].topicFilter != NULL && strcmp(c->messageHandlers[i].topicFilter, topicFilter) == 0)
-        {
-            if (messageHandler == NULL) /* remove existing */
-            {
-                c->messageHandlers[i].topicFilter = NULL;
-                c->messageHandlers[i].fp = NULL;
-            }
-            rc = MQSUCCESS; /* return i when adding new subscription */
-            break;
-        }
+        if (MQTTTopicIndex_remove(&c->messageHandlers, topicFilter) == 0)
+            rc = MQSUCCESS;
+        if (lv != NULL)
+            memset(lv, 0, sizeof(*lv)); /* the cache goes with the subscription */
     }
-    /* if no existing, look for empty slot (unless we are removing) */
-    if (messageHandler != NULL) {
-        if (rc == FAILURE)
-        {
-            for (i = 0; i < MAX_MESSAGE_HANDLERS; ++i)
-            {
-                if (c->messageHandlers[i].topicFilter == NULL)
-                {
-                    rc = MQSUCCESS;
-                    break;
-                }
-            }
-        }
-        if (i < MAX_MESSAGE_HANDLERS)
-        {
-            c->messageHandlers[i].topicFilter = topicFilter;
-            c->messageHandlers[i].fp = messageHandler;
-        }
+    else if (MQTTTopicIndex_add(&c->messageHandlers, topicFilter, messageHandler, context) == 0)
+    {
+        /* subscribed again after a clean session: link the cache kept from the previous one */
+        if (lv != NULL)
+            MQTTTopicIndex_find(&c->messageHandlers, topicFilter)->cache = (unsigned short)(lv - c->lastValues) + 1;
+        rc = MQSUCCESS;
     }
     return rc;
 }
 
 
-int MQTTSubscribeWithResults(MQTTClient* c, const char* topicFilter, enum QoS qos,
-       messageHandler messageHandler, MQTTSubackData* data)
+int MQTTSetLastValueCache(MQTTClient* c, const char* topicFilter, int enable)
+{
+    int rc = FAILURE;
+    MQTTTopicNode* node;
+    struct LastValue* lv;
+    int i;
+
+#if defined(MQTT_TASK)
+	  MutexLock(&c->mutex,0);
+#endif
+    if ((node = MQTTTopicIndex_find(&c->messageHandlers, topicFilter)) == NULL || node->topicFilter == NULL)
+        goto exit;
+    if ((lv = findLastValue(c, topicFilter)) != NULL)
+        memset(lv, 0, sizeof(*lv));
+    node->cache = 0;
+    if (enable)
+    {
+        for (i = 0; i < MAX_CACHED_VALUES && c->lastValues[i].used; ++i)
+            ;
+        if (i == MAX_CACHED_VALUES)
+            goto exit;
+        c->lastValues[i].used = 1;
+        c->lastValues[i].filter = hashFilter(topicFilter);
+        node->cache = i + 1;
+    }
+    rc = MQSUCCESS;
+
+exit:
+#if defined(MQTT_TASK)
+	  MutexUnlock(&c->mutex);
+#endif
+    return rc;
+}
+
+
+int MQTTGetLastValue(MQTTClient* c, const char* topicFilter, void* buf, size_t size)
+{
+    int rc = FAILURE;
+    struct LastValue* lv;
+
+#if defined(MQTT_TASK)
+	  MutexLock(&c->mutex,0);
+#endif
+    if ((lv = findLastValue(c, topicFilter)) == NULL || !lv->received)
+        goto exit;
+    if (lv->len > size || lv->len > MAX_CACHED_VALUE_SIZE)
+    {
+        rc = BUFFER_OVERFLOW;
+        goto exit;
+    }
+    memcpy(buf, lv->value, lv->len);
+    rc = (int)lv->len;
+
+exit:
+#if defined(MQTT_TASK)
+	  MutexUnlock(&c->mutex);
+#endif
+    return rc;
+}
+
+
+int MQTTSetMessageHandler(MQTTClient* c, const char* topicFilter, messageHandler messageHandler)
+{
+    return MQTTSetMessageHandlerContext(c, topicFilter, messageHandler, NULL);
+}
+
+
+int MQTTSubscribeWithContext(MQTTClient* c, const char* topicFilter, enum QoS qos,
+       messageHandler messageHandler, void* context, MQTTSubackData* data)
 {
     int rc = FAILURE;
     Timer timer;
@@ -546,6 +1175,15 @@ int MQTTSubscribeWithResults(MQTTClient* c, const char* topicFilter, enum QoS qo
     TimerInit(&timer);
     TimerCountdownMS(&timer, c->command_timeout_ms);
 
+#if defined(MQTTV5)
+    if (c->MQTTVersion == 5)
+    {
+        MQTTSubscribe_options options = MQTTSubscribe_options_initializer;
+        options.MaxQoS = qos;
+        len = MQTTV5Serialize_subscribe(c->buf, c->buf_size, 0, getNextPacketId(c), NULL, 1, &topic, &options);
+    }
+    else
+#endif
     len = MQTTSerialize_subscribe(c->buf, c->buf_size, 0, getNextPacketId(c), 1, &topic, (int*)&qos);
     if (len <= 0)
         goto exit;
@@ -557,10 +1195,16 @@ int MQTTSubscribeWithResults(MQTTClient* c, const char* topicFilter, enum QoS qo
         int count = 0;
         unsigned short mypacketid;
         data->grantedQoS = QOS0;
-        if (MQTTDeserialize_suback(&mypacketid, 1, &count, (int*)&data->grantedQoS, c->readbuf, c->readbuf_size) == 1)
+#if defined(MQTTV5)
+        if (c->MQTTVersion == 5)
+            len = MQTTV5Deserialize_suback(&mypacketid, NULL, 1, &count, (int*)&data->grantedQoS, c->readbuf, c->readbuf_size);
+        else
+#endif
+        len = MQTTDeserialize_suback(&mypacketid, 1, &count, (int*)&data->grantedQoS, c->readbuf, c->readbuf_size);
+        if (len == 1)
         {
-            if (data->grantedQoS != 0x80)
-                rc = MQTTSetMessageHandler(c, topicFilter, messageHandler);
+            if (data->grantedQoS < SUBFAIL)     /* MQTT 5: reason codes from 0x80 */
+                rc = MQTTSetMessageHandlerContext(c, topicFilter, messageHandler, context);
         }
     }
     else
@@ -576,6 +1220,13 @@ exit:
 }
 
 
+int MQTTSubscribeWithResults(MQTTClient* c, const char* topicFilter, enum QoS qos,
+       messageHandler messageHandler, MQTTSubackData* data)
+{
+    return MQTTSubscribeWithContext(c, topicFilter, qos, messageHandler, NULL, data);
+}
+
+
 int MQTTSubscribe(MQTTClient* c, const char* topicFilter, enum QoS qos,
        messageHandler messageHandler)
 {
@@ -601,7 +1252,13 @@ int MQTTUnsubscribe(MQTTClient* c, const char* topicFilter)
     TimerInit(&timer);
     TimerCountdownMS(&timer, c->command_timeout_ms);
 
-    if ((len = MQTTSerialize_unsubscribe(c->buf, c->buf_size, 0, getNextPacketId(c), 1, &topic)) <= 0)
+#if defined(MQTTV5)
+    if (c->MQTTVersion == 5)
+        len = MQTTV5Serialize_unsubscribe(c->buf, c->buf_size, 0, getNextPacketId(c), NULL, 1, &topic);
+    else
+#endif
+    len = MQTTSerialize_unsubscribe(c->buf, c->buf_size, 0, getNextPacketId(c), 1, &topic);
+    if (len <= 0)
         goto exit;
     if ((rc = sendPacket(c, len, &timer)) != MQSUCCESS) // send the subscribe packet
         goto exit; // there was a problem
@@ -609,7 +1266,14 @@ int MQTTUnsubscribe(MQTTClient* c, const char* topicFilter)
     if (waitfor(c, UNSUBACK, &timer) == UNSUBACK)
     {
         unsigned short mypacketid;  // should be the same as the packetid above
-        if (MQTTDeserialize_unsuback(&mypacketid, c->readbuf, c->readbuf_size) == 1)
+#if defined(MQTTV5)
+        int count = 0, reasonCode = 0;
+        if (c->MQTTVersion == 5)
+            len = MQTTV5Deserialize_unsuback(&mypacketid, NULL, 1, &count, &reasonCode, c->readbuf, c->readbuf_size);
+        else
+#endif
+        len = MQTTDeserialize_unsuback(&mypacketid, c->readbuf, c->readbuf_size);
+        if (len == 1)
         {
             /* remove the subscription message handler associated with this topic, if there is one */
             MQTTSetMessageHandler(c, topicFilter, NULL);
@@ -632,9 +1296,6 @@ int MQTTPublish(MQTTClient* c, const char* topicName, MQTTMessage* message)
 {
     int rc = FAILURE;
     Timer timer;
-    MQTTString topic = MQTTString_initializer;
-    topic.cstring = (char *)topicName;
-    int len = 0;
 
 #if defined(MQTT_TASK)
 	  MutexLock(&c->mutex,0);
@@ -648,35 +1309,23 @@ int MQTTPublish(MQTTClient* c, const char* topicName, MQTTMessage* message)
     if (message->qos == QOS1 || message->qos == QOS2)
         message->id = getNextPacketId(c);
 
-    len = MQTTSerialize_publish(c->buf, c->buf_size, 0, message->qos, message->retained, message->id,
-              topic, (unsigned char*)message->payload, message->payloadlen);
-    if (len <= 0)
-        goto exit;
-    if ((rc = sendPacket(c, len, &timer)) != MQSUCCESS) // send the subscribe packet
+    if ((rc = sendPublish(c, 0, message->qos, message->retained, message->id, topicName,
+              message->payload, message->payloadlen, &timer)) != MQSUCCESS) // send the publish packet
         goto exit; // there was a problem
 
     if (message->qos == QOS1)
     {
-        if (waitfor(c, PUBACK, &timer) == PUBACK)
-        {
-            unsigned short mypacketid;
-            unsigned char dup, type;
-            if (MQTTDeserialize_ack(&type, &dup, &mypacketid, c->readbuf, c->readbuf_size) != 1)
-                rc = FAILURE;
-        }
-        else
+        if ((rc = waitforAck(c, PUBACK, message->id, &timer)) == PUBACK)
+            rc = MQSUCCESS;
+        else if (rc != REFUSED)
             rc = FAILURE;
     }
     else if (message->qos == QOS2)
     {
-        if (waitfor(c, PUBCOMP, &timer) == PUBCOMP)
-        {
-            unsigned short mypacketid;
-            unsigned char dup, type;
-            if (MQTTDeserialize_ack(&type, &dup, &mypacketid, c->readbuf, c->readbuf_size) != 1)
-                rc = FAILURE;
-        }
-        else
+        /* the PUBREL is sent on the PUBREC, unless it is a refusal */
+        if ((rc = waitforAck(c, PUBREC, message->id, &timer)) == PUBREC)
+            rc = (waitforAck(c, PUBCOMP, message->id, &timer) == PUBCOMP) ? MQSUCCESS : FAILURE;
+        else if (rc != REFUSED)
             rc = FAILURE;
     }
 
@@ -690,6 +1339,94 @@ exit:
 }
 
 
+static int publishAsync(MQTTClient* c, const char* topicName, MQTTMessage* message, void* context)
+{
+    int rc = FAILURE;
+    Timer timer;
+    struct InflightMessage* m = NULL;
+
+	  if (!c->isconnected)
+		    goto exit;
+
+    TimerInit(&timer);
+    TimerCountdownMS(&timer, c->command_timeout_ms);
+
+    if (message->qos == QOS0)
+    {
+        if ((rc = sendPublish(c, 0, QOS0, message->retained, 0, topicName,
+              message->payload, message->payloadlen, &timer)) == MQSUCCESS && c->publishComplete != NULL)
+            c->publishComplete(context, 0, MQSUCCESS);   /* nothing to wait for */
+        goto exit;
+    }
+
+#if defined(MQTTV5)
+    if (c->inflight_count >= c->receiveMaximum)    /* the server paces the publications */
+    {
+        rc = WINDOW_FULL;
+        goto exit;
+    }
+#endif
+    if (c->inflight_count >= c->inflight_window || (m = allocInflight(c)) == NULL)
+    {
+        rc = WINDOW_FULL;
+        goto exit;
+    }
+
+    message->id = m->id;
+    m->qos = message->qos;
+    m->retained = message->retained;
+    m->packet_type = (message->qos == QOS1) ? PUBACK : PUBREC;
+    m->topicName = topicName;
+    m->payload = message->payload;
+    m->payloadlen = message->payloadlen;
+    m->context = context;
+    if ((rc = sendInflight(c, m, 0, &timer)) != MQSUCCESS)
+    {
+        m->id = 0;  /* not sent: the caller keeps the ownership */
+        c->inflight_count--;
+    }
+
+exit:
+    if (rc == FAILURE)
+        MQTTCloseSession(c);
+    return rc;
+}
+
+
+int MQTTPublishAsync(MQTTClient* c, const char* topicName, MQTTMessage* message, void* context)
+{
+    int rc;
+
+#if defined(MQTT_TASK)
+	  MutexLock(&c->mutex,0);
+#endif
+    rc = publishAsync(c, topicName, message, context);
+#if defined(MQTT_TASK)
+	  MutexUnlock(&c->mutex);
+#endif
+    return rc;
+}
+
+
+int MQTTSetInflightWindow(MQTTClient* c, int window, publishCompleteHandler handler)
+{
+    if (window < 1 || window > MAX_INFLIGHT_MESSAGES)
+        return FAILURE;
+    c->inflight_window = window;
+    c->publishComplete = handler;
+    return MQSUCCESS;
+}
+
+
+#if defined(MQTTV5)
+int MQTTSetSessionExpiry(MQTTClient* c, unsigned int seconds)
+{
+    c->sessionExpiryInterval = seconds;
+    return MQSUCCESS;
+}
+#endif
+
+
 int MQTTDisconnect(MQTTClient* c)
 {
     int rc = FAILURE;
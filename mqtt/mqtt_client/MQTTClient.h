@@ -14,6 +14,10 @@
  *    Allan Stockdill-Mander/Ian Craggs - initial API and implementation and/or initial documentation
  *    Ian Craggs - documentation and platform specific header
  *    Ian Craggs - add setMessageHandler function
+ *    Daruin Solano - topic trie subscription index, message handler context
+ *    Daruin Solano - buffered packet reader
+ *    Daruin Solano - zero-copy publication
+ *    Daruin Solano - MQTT 5: properties, topic aliases, reason codes, session expiry, receive maximum
  *******************************************************************************/
 
 #if !defined(__MQTT_CLIENT_C_)
@@ -43,6 +47,7 @@
 
 #ifdef MQTT_TASK
 #include <cmsis_os.h>
+#include "MQTTPublishQueue.h"   /* MAX_QUEUED_PUBLICATIONS: redefinable - publications waiting for the network task */
 #endif
 
 
@@ -61,18 +66,48 @@
 #define MAX_MESSAGE_HANDLERS 5 /* redefinable - how many subscriptions do you want? */
 #endif
 
+#include "MQTTTopicIndex.h"    /* MAX_TOPIC_NODES: redefinable - topic levels of all the subscriptions */
+
+#if !defined(MAX_INFLIGHT_MESSAGES)
+#define MAX_INFLIGHT_MESSAGES 8 /* redefinable - how many unacknowledged QoS1/2 MQTTPublishAsync calls? */
+#endif
+
+#if !defined(MAX_CACHED_VALUES)
+#define MAX_CACHED_VALUES 2 /* redefinable - subscriptions with a last-value cache, see MQTTSetLastValueCache */
+#endif
+#if !defined(MAX_CACHED_VALUE_SIZE)
+#define MAX_CACHED_VALUE_SIZE 256 /* redefinable - longest payload kept by the last-value cache */
+#endif
+
+#if defined(MQTTV5)
+#if !defined(MAX_TOPIC_ALIASES)
+#define MAX_TOPIC_ALIASES 8 /* redefinable - outgoing topic aliases, if the server allows as many */
+#endif
+#if !defined(MAX_TOPIC_ALIAS_SIZE)
+#define MAX_TOPIC_ALIAS_SIZE 64 /* redefinable - longest topic name with an alias, \0 included */
+#endif
+#if !defined(MAX_MESSAGE_PROPERTIES)
+#define MAX_MESSAGE_PROPERTIES 8 /* redefinable - properties passed to the message handlers, the others are skipped */
+#endif
+#endif
+
+#if defined(MQTT_TASK) && !defined(MQTT_TASK_POLL_MS)
+#define MQTT_TASK_POLL_MS 20 /* redefinable - socket read timeout of the network task: max delay of a queued publication */
+#endif
+
 enum QoS { QOS0, QOS1, QOS2, SUBFAIL=0x80 };
 
 /* all failure return codes must be negative */
-enum returnCode { BUFFER_OVERFLOW = -2, FAILURE = -1, MQSUCCESS = 0 };
+enum returnCode { REFUSED = -4, WINDOW_FULL = -3, BUFFER_OVERFLOW = -2, FAILURE = -1, MQSUCCESS = 0 };
 
 /* The Platform specific header must define the Network and Timer structures and functions
  * which operate on them.
  *
 typedef struct Network
 {
-	int (*mqttread)(Network*, unsigned char* read_buffer, int, int);
+	int (*mqttread)(Network*, unsigned char* read_buffer, int, int);    // up to len bytes, what is available: 0 on timeout
 	int (*mqttwrite)(Network*, unsigned char* send_buffer, int, int);
+	int (*mqttflush)(Network*);     // optional: the writes are held until flushed, e.g. a PUBLISH header and its payload
 } Network;*/
 
 /* The Timer structure must be defined in the platform specific header,
@@ -92,6 +127,10 @@ typedef struct MessageData
 {
     MQTTMessage* message;
     MQTTString* topicName;
+    void* context;          /* set with MQTTSetMessageHandlerContext */
+#if defined(MQTTV5)
+    MQTTProperties* properties;     /* of the PUBLISH, NULL for an MQTT 3.1.1 connection */
+#endif
 } MessageData;
 
 typedef struct MQTTConnackData
@@ -107,6 +146,24 @@ typedef struct MQTTSubackData
 
 typedef void (*messageHandler)(MessageData*);
 
+/* Completion of an MQTTPublishAsync call: id is the packet id (0 for QoS0), rc MQSUCCESS or FAILURE,
+ * or REFUSED when the MQTT 5 server acknowledged it with a failure reason code (client->reasonCode).
+ * Called from the client background processing: it must not call back into the client. */
+typedef void (*publishCompleteHandler)(void* context, unsigned short id, int rc);
+
+/* Acknowledgements of the MQTTPublishAsync publications. The round trip times are those of the acks
+ * of packets sent once: the ack of a retransmitted packet cannot tell which copy it answers. */
+typedef struct MQTTInflightStats
+{
+    unsigned int acks;          /* PUBACK, PUBREC and PUBCOMP of in-flight publications */
+    unsigned int retries;       /* PUBLISH (dup) and PUBREL retransmissions */
+    unsigned int rtt_samples;
+    unsigned int rtt_last_ms,
+      rtt_min_ms,
+      rtt_max_ms;
+    unsigned long rtt_total_ms; /* mean: rtt_total_ms / rtt_samples */
+} MQTTInflightStats;
+
 typedef struct MQTTClient
 {
     unsigned int next_packetid,
@@ -119,20 +176,61 @@ typedef struct MQTTClient
     char ping_outstanding;
     int isconnected;
     int cleansession;
+    size_t readbuf_len,     /* bytes received in readbuf */
+      readbuf_packet;       /* length of the packet being processed, at the beginning of readbuf */
 
-    struct MessageHandlers
-    {
-        const char* topicFilter;
-        void (*fp) (MessageData*);
-    } messageHandlers[MAX_MESSAGE_HANDLERS];      /* Message handlers are indexed by subscription topic */
+    MQTTTopicIndex messageHandlers;               /* Message handlers are indexed by subscription topic */
 
     void (*defaultMessageHandler) (MessageData*);
 
+    struct InflightMessage
+    {
+        unsigned short id;          /* 0: free slot, else the slot is inflight[id % MAX_INFLIGHT_MESSAGES] */
+        unsigned char qos;
+        unsigned char retained;
+        unsigned char retransmitted;    /* the packet awaiting packet_type was sent more than once */
+        int packet_type;            /* acknowledgement expected next: PUBACK, PUBREC or PUBCOMP */
+        const char* topicName;
+        void* payload;
+        size_t payloadlen;
+        void* context;
+        Timer retry;                /* retransmission deadline, also the round trip time reference */
+    } inflight[MAX_INFLIGHT_MESSAGES];            /* MQTTPublishAsync publications, until acknowledged */
+    int inflight_window;
+    int inflight_count;                           /* slots in use */
+    Timer inflight_retry;                         /* expires no later than the first retransmission deadline */
+    MQTTInflightStats inflightStats;
+
+    struct LastValue
+    {
+        unsigned int filter;        /* hash of the topic filter, which is not kept: it may be released with the subscription */
+        unsigned char used;
+        unsigned char received;     /* a message was received since the cache was enabled */
+        unsigned int hash;          /* of the topic name and the payload of the last message */
+        size_t len;
+        unsigned int unchanged;     /* messages not delivered: same topic and payload as the last one */
+        unsigned char value[MAX_CACHED_VALUE_SIZE];  /* payload of the last message, if it fits */
+    } lastValues[MAX_CACHED_VALUES];              /* follow their subscription through the sessions */
+
+    publishCompleteHandler publishComplete;
+
+#if defined(MQTTV5)
+    unsigned char MQTTVersion;          /* of the connection: 4 for MQTT 3.1.1, 5 */
+    unsigned char reasonCode;           /* last failure reason code: CONNACK, acks or server DISCONNECT */
+    unsigned int sessionExpiryInterval; /* seconds the server keeps the session after the connection */
+    unsigned short receiveMaximum;      /* server: max unacknowledged QoS1/2 publications */
+    unsigned short topicAliasMaximum;   /* server, capped to MAX_TOPIC_ALIASES: 0 for no alias */
+    unsigned int maximumPacketSize;     /* server: 0 for no limit */
+    int topicAliasCount;                /* aliases 1 to topicAliasCount are set on the connection */
+    char topicAliases[MAX_TOPIC_ALIASES][MAX_TOPIC_ALIAS_SIZE];
+#endif
+
     Network* ipstack;
     Timer last_sent, last_received;
 #if defined(MQTT_TASK)
     Mutex mutex;
     Thread thread;
+    MQTTPublishQueue publishQueue;      /* MQTTPublishQueued publications, sent by the network task */
 #endif
 } MQTTClient;
 
@@ -151,7 +249,9 @@ DLLExport void MQTTClientInit(MQTTClient* client, Network* network, unsigned int
 
 /** MQTT Connect - send an MQTT connect packet down the network and wait for a Connack
  *  The nework object must be connected to the network endpoint before calling this
+ *  In MQTTV5 builds, options->MQTTVersion 5 connects with MQTT 5, 4 with MQTT 3.1.1.
  *  @param options - connect options
+ *  @param data - connack session present and return code, the reason code for MQTT 5
  *  @return success code
  */
 DLLExport int MQTTConnectWithResults(MQTTClient* client, MQTTPacket_connectData* options,
@@ -165,13 +265,46 @@ DLLExport int MQTTConnectWithResults(MQTTClient* client, MQTTPacket_connectData*
 DLLExport int MQTTConnect(MQTTClient* client, MQTTPacket_connectData* options);
 
 /** MQTT Publish - send an MQTT publish packet and wait for all acks to complete for all QoSs
+ *  The payload is not copied into the send buffer when the network combines the writes (mqttflush):
+ *  the send buffer then only needs to hold the topic name and the packet header.
+ *  With MQTT 5, the topic name is replaced by a topic alias from its second publication on.
  *  @param client - the client object to use
  *  @param topic - the topic to publish to
  *  @param message - the message to send
- *  @return success code
+ *  @return success code, REFUSED if the MQTT 5 server acknowledged it with a failure reason code
  */
 DLLExport int MQTTPublish(MQTTClient* client, const char*, MQTTMessage*);
 
+/** MQTT PublishAsync - send an MQTT publish packet and return without waiting for the acks.
+ *  The acks are processed, and the publication retransmitted with DUP on timeout, by MQTTYield.
+ *  The topic and payload are not copied: they must stay valid until the completion handler is called.
+ *  @param client - the client object to use
+ *  @param topic - the topic to publish to
+ *  @param message - the message to send. Its id is set for QoS1/2.
+ *  @param context - passed back to the completion handler
+ *  @return success code, or WINDOW_FULL if the in-flight window is full: yield and try again
+ */
+DLLExport int MQTTPublishAsync(MQTTClient* client, const char* topicName, MQTTMessage* message, void* context);
+
+/** MQTT SetInflightWindow - configure the asynchronous publication
+ *  @param client - the client object to use
+ *  @param window - max number of unacknowledged QoS1/2 publications, 1 to MAX_INFLIGHT_MESSAGES
+ *  @param handler - publication completion callback, or NULL
+ *  @return success code
+ */
+DLLExport int MQTTSetInflightWindow(MQTTClient* client, int window, publishCompleteHandler handler);
+
+#if defined(MQTTV5)
+/** MQTT SetSessionExpiry - Session Expiry Interval of the next MQTT 5 connections
+ *  With cleansession 0, the server keeps the subscriptions and the unacknowledged messages
+ *  for that long after the connection is lost, and the in-flight publications are resumed.
+ *  @param client - the client object to use
+ *  @param seconds - 0: the session ends with the connection, 0xFFFFFFFF: never expires
+ *  @return success code
+ */
+DLLExport int MQTTSetSessionExpiry(MQTTClient* client, unsigned int seconds);
+#endif
+
 /** MQTT SetMessageHandler - set or remove a per topic message handler
  *  @param client - the client object to use
  *  @param topicFilter - the topic filter set the message handler for
@@ -180,6 +313,39 @@ DLLExport int MQTTPublish(MQTTClient* client, const char*, MQTTMessage*);
  */
 DLLExport int MQTTSetMessageHandler(MQTTClient* c, const char* topicFilter, messageHandler messageHandler);
 
+/** MQTT SetMessageHandlerContext - set or remove a per topic message handler, with its context
+ *  @param client - the client object to use
+ *  @param topicFilter - the topic filter set the message handler for
+ *  @param messageHandler - pointer to the message handler function or NULL to remove
+ *  @param context - passed to the message handler in MessageData
+ *  @return success code
+ */
+DLLExport int MQTTSetMessageHandlerContext(MQTTClient* c, const char* topicFilter, messageHandler messageHandler, void* context);
+
+/** MQTT SetLastValueCache - call the message handler of a subscription only when the message changes
+ *  The last message received on the topic filter is kept: its hash, and its payload up to MAX_CACHED_VALUE_SIZE
+ *  bytes (the longer ones are compared by hash and length only). A message with the same topic name and payload
+ *  as the last one is not delivered, e.g. the retained state sent again by the server on every subscription.
+ *  The cache follows the subscription through the reconnections, until it is removed (MQTTUnsubscribe,
+ *  MQTTSetMessageHandler with NULL). With a wildcard filter, it holds the last message of any matching topic.
+ *  @param client - the client object to use
+ *  @param topicFilter - a subscribed topic filter
+ *  @param enable - 1 to cache, 0 to drop the cached value and deliver every message again
+ *  @return success code, FAILURE if not subscribed or the MAX_CACHED_VALUES entries are in use
+ */
+DLLExport int MQTTSetLastValueCache(MQTTClient* client, const char* topicFilter, int enable);
+
+/** MQTT GetLastValue - copy the payload of the last message received on a cached subscription
+ *  No network traffic: the value is the one of the last message processed by MQTTYield or MQTTRun.
+ *  @param client - the client object to use
+ *  @param topicFilter - a topic filter given to MQTTSetLastValueCache
+ *  @param buf - where to copy the payload, not \0 terminated
+ *  @param size - of buf
+ *  @return the payload length, FAILURE if nothing was received or the filter is not cached,
+ *  BUFFER_OVERFLOW if the payload is longer than size or than MAX_CACHED_VALUE_SIZE
+ */
+DLLExport int MQTTGetLastValue(MQTTClient* client, const char* topicFilter, void* buf, size_t size);
+
 /** MQTT Subscribe - send an MQTT subscribe packet and wait for suback before returning.
  *  @param client - the client object to use
  *  @param topicFilter - the topic filter to subscribe to
@@ -197,6 +363,18 @@ DLLExport int MQTTSubscribe(MQTTClient* client, const char* topicFilter, enum Qo
  */
 DLLExport int MQTTSubscribeWithResults(MQTTClient* client, const char* topicFilter, enum QoS, messageHandler, MQTTSubackData* data);
 
+/** MQTT Subscribe - send an MQTT subscribe packet and wait for suback before returning.
+ *  The handler and its context are set together, under the client lock: no message is
+ *  delivered to the handler without its context (see MQTTSetMessageHandlerContext).
+ *  @param client - the client object to use
+ *  @param topicFilter - the topic filter to subscribe to
+ *  @param messageHandler - the message handler of the subscription
+ *  @param context - passed to the message handler in MessageData
+ *  @param data - suback granted QoS returned
+ *  @return success code
+ */
+DLLExport int MQTTSubscribeWithContext(MQTTClient* client, const char* topicFilter, enum QoS, messageHandler, void* context, MQTTSubackData* data);
+
 /** MQTT Subscribe - send an MQTT unsubscribe packet and wait for unsuback before returning.
  *  @param client - the client object to use
  *  @param topicFilter - the topic filter to unsubscribe from
@@ -217,6 +395,16 @@ DLLExport int MQTTDisconnect(MQTTClient* client);
  */
 DLLExport int MQTTYield(MQTTClient* client, int time);
 
+/** MQTT WaitEvent - event driven MQTT background
+ *  Waits for the next incoming packet and processes it, then returns, where MQTTYield would
+ *  go on for its whole time. The reads never block past the next PINGREQ or retransmission
+ *  deadline, so the keepalive and the retries are on time whatever the wait.
+ *  @param client - the client object to use
+ *  @param timeout_ms - the longest wait, in milliseconds, for an incoming packet
+ *  @return the type of the packet processed, 0 if none came in time, or FAILURE
+ */
+DLLExport int MQTTWaitEvent(MQTTClient* client, int timeout_ms);
+
 /** MQTT isConnected
  *  @param client - the client object to use
  *  @return truth value indicating whether the client is connected to the server
@@ -225,11 +413,26 @@ DLLExport int MQTTIsConnected(MQTTClient* client);
 
 #if defined(MQTT_TASK)
 /** MQTT start background thread for a client.  After this, MQTTYield should not be called.
+*  The thread is the network task: it reads the socket and sends the MQTTPublishQueued publications.
 *  @param client - the client object to use
 *  @return success code
 */
 int ThreadStart(Thread* thread, mqttrun_t mqrun, MQTTClient* c);
 DLLExport int MQTTStartTask(MQTTClient* client);
+
+/** MQTT PublishQueued - publish a message from any task, without waiting for the network
+ *  The publication is queued without taking the client mutex: the network task sends it in order,
+ *  as MQTTPublishAsync would, within MQTT_TASK_POLL_MS and as soon as the in-flight window allows.
+ *  It stays queued while the client is disconnected. The completion handler of MQTTSetInflightWindow
+ *  is called once it is acknowledged (QoS1/2) or sent (QoS0), or with an error if it cannot be sent.
+ *  The topic and payload are not copied: they must stay valid until then.
+ *  @param client - the client object to use
+ *  @param topicName - the topic to publish to
+ *  @param message - the message to send
+ *  @param context - passed back to the completion handler
+ *  @return success code, or WINDOW_FULL if the queue is full
+ */
+DLLExport int MQTTPublishQueued(MQTTClient* client, const char* topicName, MQTTMessage* message, void* context);
 #endif
 
 #if defined(__cplusplus)
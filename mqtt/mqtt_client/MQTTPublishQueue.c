@@ -0,0 +1,66 @@
+/*
+ * MQTTPublishQueue.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Daruin Solano
+ */
+
+#include "MQTTPublishQueue.h"
+
+#define QUEUE_MASK (MAX_QUEUED_PUBLICATIONS - 1)
+
+
+void MQTTPublishQueue_init(MQTTPublishQueue* q)
+{
+    unsigned int i;
+
+    for (i = 0; i < MAX_QUEUED_PUBLICATIONS; ++i)
+        atomic_init(&q->cells[i].seq, i);
+    atomic_init(&q->head, 0);
+    q->tail = 0;
+}
+
+
+int MQTTPublishQueue_push(MQTTPublishQueue* q, const MQTTQueuedPublish* pub)
+{
+    unsigned int pos = atomic_load_explicit(&q->head, memory_order_relaxed);
+
+    for (;;)
+    {
+        unsigned int seq = atomic_load_explicit(&q->cells[pos & QUEUE_MASK].seq, memory_order_acquire);
+        int diff = (int)(seq - pos);
+
+        if (diff == 0)
+        {
+            /* free cell: claim it, pos is reloaded if another producer got it first */
+            if (atomic_compare_exchange_weak_explicit(&q->head, &pos, pos + 1,
+                  memory_order_relaxed, memory_order_relaxed))
+                break;
+        }
+        else if (diff < 0)
+            return -1;  /* the cell of the previous lap is not consumed yet: full */
+        else
+            pos = atomic_load_explicit(&q->head, memory_order_relaxed);
+    }
+
+    q->cells[pos & QUEUE_MASK].pub = *pub;
+    atomic_store_explicit(&q->cells[pos & QUEUE_MASK].seq, pos + 1, memory_order_release);
+    return 0;
+}
+
+
+MQTTQueuedPublish* MQTTPublishQueue_front(MQTTPublishQueue* q)
+{
+    unsigned int seq = atomic_load_explicit(&q->cells[q->tail & QUEUE_MASK].seq, memory_order_acquire);
+
+    return (seq == q->tail + 1) ? &q->cells[q->tail & QUEUE_MASK].pub : NULL;
+}
+
+
+void MQTTPublishQueue_pop(MQTTPublishQueue* q)
+{
+    /* the cell is free again for the producers of the next lap */
+    atomic_store_explicit(&q->cells[q->tail & QUEUE_MASK].seq, q->tail + MAX_QUEUED_PUBLICATIONS,
+          memory_order_release);
+    q->tail++;
+}
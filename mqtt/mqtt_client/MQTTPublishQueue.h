@@ -0,0 +1,69 @@
+/*
+ * MQTTPublishQueue.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Daruin Solano
+ *
+ *  Outbound publications of the MQTT_TASK builds: a bounded lock-free
+ *  multi-producer / single-consumer ring.
+ *
+ *  The application tasks push (MQTTPublishQueued) without taking the client
+ *  mutex, the network task (MQTTRun) is the only consumer: it sends the
+ *  queued publications in order between two short socket reads. A producer
+ *  claims a cell with a compare-and-swap of the head, fills it, then
+ *  publishes it through the cell sequence number (release); the consumer
+ *  sees a cell as ready when its sequence number says so (acquire). No
+ *  lock, no interrupt masking, and a task preempted in the middle of a push
+ *  never blocks the other producers (each one owns its cell).
+ *
+ *  The topic and payload are not copied: they must stay valid until the
+ *  publication completes (publishCompleteHandler).
+ */
+
+#ifndef MQTT_MQTT_CLIENT_MQTTPUBLISHQUEUE_H_
+#define MQTT_MQTT_CLIENT_MQTTPUBLISHQUEUE_H_
+
+#include <stddef.h>
+#include <stdatomic.h>
+
+#if !defined(MAX_QUEUED_PUBLICATIONS)
+#define MAX_QUEUED_PUBLICATIONS 16 /* redefinable - power of 2: publications waiting for the network task */
+#endif
+
+#if (MAX_QUEUED_PUBLICATIONS & (MAX_QUEUED_PUBLICATIONS - 1)) != 0
+#error "MAX_QUEUED_PUBLICATIONS must be a power of 2"
+#endif
+
+typedef struct MQTTQueuedPublish
+{
+    const char* topicName;
+    void* payload;
+    size_t payloadlen;
+    unsigned char qos;
+    unsigned char retained;
+    void* context;              /* passed to the publishCompleteHandler */
+} MQTTQueuedPublish;
+
+typedef struct MQTTPublishQueue
+{
+    struct
+    {
+        atomic_uint seq;        /* position + 1 once filled, position + MAX_QUEUED_PUBLICATIONS once consumed */
+        MQTTQueuedPublish pub;
+    } cells[MAX_QUEUED_PUBLICATIONS];
+    atomic_uint head;           /* next position to claim, producers */
+    unsigned int tail;          /* next position to consume, the network task only */
+} MQTTPublishQueue;
+
+void MQTTPublishQueue_init(MQTTPublishQueue* q);
+
+/** Any task: copy a publication at the end of the queue. @return 0, or -1 if the queue is full */
+int MQTTPublishQueue_push(MQTTPublishQueue* q, const MQTTQueuedPublish* pub);
+
+/** Consumer: first publication of the queue, left in place. @return NULL if the queue is empty */
+MQTTQueuedPublish* MQTTPublishQueue_front(MQTTPublishQueue* q);
+
+/** Consumer: release the publication returned by MQTTPublishQueue_front. */
+void MQTTPublishQueue_pop(MQTTPublishQueue* q);
+
+#endif /* MQTT_MQTT_CLIENT_MQTTPUBLISHQUEUE_H_ */
@@ -0,0 +1,338 @@
+/*
+ * MQTTTopicIndex.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Daruin Solano
+ */
+
+#include "MQTTTopicIndex.h"
+
+#include <string.h>
+
+#define NO_NODE     (-1)
+#define FREE_NODE   (-2)
+
+#define IS_LEVEL(s, len, c)   ((len) == 1 && *(s) == (c))
+
+
+/* FNV-1a of the level, seeded with the parent node */
+static unsigned int levelBucket(short parent, const char* s, size_t len)
+{
+    unsigned int h = 2166136261u ^ (unsigned short)parent;
+
+    while (len--)
+    {
+        h ^= (unsigned char)*s++;
+        h *= 16777619u;
+    }
+    return h % MAX_TOPIC_NODES;
+}
+
+
+static short findLiteral(MQTTTopicIndex* idx, short parent, const char* s, size_t len)
+{
+    short n;
+
+    for (n = idx->buckets[levelBucket(parent, s, len)]; n != NO_NODE; n = idx->nodes[n].next)
+    {
+        MQTTTopicNode* node = &idx->nodes[n];
+
+        if (node->parent == parent && node->len == len && memcmp(node->level, s, len) == 0)
+            return n;
+    }
+    return NO_NODE;
+}
+
+
+static short findChild(MQTTTopicIndex* idx, short parent, const char* s, size_t len)
+{
+    if (IS_LEVEL(s, len, '+'))
+        return idx->nodes[parent].plus;
+    if (IS_LEVEL(s, len, '#'))
+        return idx->nodes[parent].hash;
+    return findLiteral(idx, parent, s, len);
+}
+
+
+static short addChild(MQTTTopicIndex* idx, short parent, const char* s, size_t len)
+{
+    short n = idx->free_list;
+    MQTTTopicNode* node;
+
+    if (n == NO_NODE)
+        return NO_NODE;
+    node = &idx->nodes[n];
+    idx->free_list = node->next;
+
+    memset(node, 0, sizeof(*node));
+    node->level = s;
+    node->len = (unsigned short)len;
+    node->parent = parent;
+    node->next = node->plus = node->hash = NO_NODE;
+
+    if (IS_LEVEL(s, len, '+'))
+        idx->nodes[parent].plus = n;
+    else if (IS_LEVEL(s, len, '#'))
+        idx->nodes[parent].hash = n;
+    else
+    {
+        unsigned int b = levelBucket(parent, s, len);
+
+        node->next = idx->buckets[b];
+        idx->buckets[b] = n;
+    }
+    idx->nodes[parent].children++;
+    return n;
+}
+
+
+static void removeChild(MQTTTopicIndex* idx, short n)
+{
+    MQTTTopicNode* node = &idx->nodes[n];
+    MQTTTopicNode* parent = &idx->nodes[node->parent];
+
+    if (parent->plus == n)
+        parent->plus = NO_NODE;
+    else if (parent->hash == n)
+        parent->hash = NO_NODE;
+    else
+    {
+        short* link = &idx->buckets[levelBucket(node->parent, node->level, node->len)];
+
+        while (*link != n)
+            link = &idx->nodes[*link].next;
+        *link = node->next;
+    }
+    parent->children--;
+
+    node->parent = FREE_NODE;
+    node->next = idx->free_list;
+    idx->free_list = n;
+}
+
+
+/* free n and its ancestors, up to the first one still used by a subscription */
+static void prune(MQTTTopicIndex* idx, short n)
+{
+    while (n > 0 && idx->nodes[n].topicFilter == NULL && idx->nodes[n].children == 0)
+    {
+        short parent = idx->nodes[n].parent;
+
+        removeChild(idx, n);
+        n = parent;
+    }
+}
+
+
+/* point the levels of n and its ancestors into topicFilter, the filter ending at n */
+static void setLevels(MQTTTopicIndex* idx, short n, const char* topicFilter)
+{
+    const char* end = topicFilter + strlen(topicFilter);
+
+    while (n > 0)
+    {
+        MQTTTopicNode* node = &idx->nodes[n];
+
+        node->level = end - node->len;
+        end = node->level - 1;
+        n = node->parent;
+    }
+}
+
+
+static short lookup(MQTTTopicIndex* idx, const char* topicFilter)
+{
+    short n = 0;
+    const char* s = topicFilter;
+
+    while (n != NO_NODE)
+    {
+        const char* sep = strchr(s, '/');
+        size_t len = (sep != NULL) ? (size_t)(sep - s) : strlen(s);
+
+        n = findChild(idx, n, s, len);
+        if (sep == NULL)
+            break;
+        s = sep + 1;
+    }
+    return n;
+}
+
+
+void MQTTTopicIndex_init(MQTTTopicIndex* idx)
+{
+    int i;
+
+    memset(idx, 0, sizeof(*idx));
+    for (i = 0; i < MAX_TOPIC_NODES; ++i)
+    {
+        idx->buckets[i] = NO_NODE;
+        idx->nodes[i].parent = FREE_NODE;
+        idx->nodes[i].next = (i + 1 < MAX_TOPIC_NODES) ? i + 1 : NO_NODE;
+    }
+    idx->nodes[0].parent = NO_NODE;    /* root */
+    idx->nodes[0].next = idx->nodes[0].plus = idx->nodes[0].hash = NO_NODE;
+    idx->free_list = (MAX_TOPIC_NODES > 1) ? 1 : NO_NODE;
+}
+
+
+int MQTTTopicIndex_add(MQTTTopicIndex* idx, const char* topicFilter, void (*fp) (struct MessageData*), void* context)
+{
+    short n = 0;
+    const char* s = topicFilter;
+    MQTTTopicNode* node;
+
+    for (;;)
+    {
+        const char* sep = strchr(s, '/');
+        size_t len = (sep != NULL) ? (size_t)(sep - s) : strlen(s);
+        short child = findChild(idx, n, s, len);
+
+        if (child == NO_NODE && (child = addChild(idx, n, s, len)) == NO_NODE)
+        {
+            prune(idx, n);  /* out of nodes: drop the levels added so far */
+            return -1;
+        }
+        n = child;
+        if (sep == NULL)
+            break;
+        s = sep + 1;
+    }
+
+    node = &idx->nodes[n];
+    if (node->topicFilter == NULL)
+    {
+        idx->subscriptions++;
+        node->cache = 0;
+    }
+    node->topicFilter = topicFilter;
+    node->fp = fp;
+    node->context = context;
+    setLevels(idx, n, topicFilter); /* a previous copy of the filter may be released now */
+    return 0;
+}
+
+
+int MQTTTopicIndex_remove(MQTTTopicIndex* idx, const char* topicFilter)
+{
+    short n = lookup(idx, topicFilter);
+    MQTTTopicNode* node;
+    int i;
+
+    if (n == NO_NODE || idx->nodes[n].topicFilter == NULL)
+        return -1;
+
+    /* the subscribed copy of the filter may already be released, use the caller's one until pruned */
+    setLevels(idx, n, topicFilter);
+    node = &idx->nodes[n];
+    node->topicFilter = NULL;
+    node->fp = NULL;
+    node->context = NULL;
+    node->cache = 0;
+    idx->subscriptions--;
+    prune(idx, n);
+
+    /* and move the levels still in use to the filters still subscribed */
+    for (i = 1; i < MAX_TOPIC_NODES; ++i)
+    {
+        if (idx->nodes[i].parent != FREE_NODE && idx->nodes[i].topicFilter != NULL)
+            setLevels(idx, i, idx->nodes[i].topicFilter);
+    }
+    return 0;
+}
+
+
+MQTTTopicNode* MQTTTopicIndex_find(MQTTTopicIndex* idx, const char* topicFilter)
+{
+    short n = lookup(idx, topicFilter);
+
+    return (n != NO_NODE && idx->nodes[n].topicFilter != NULL) ? &idx->nodes[n] : NULL;
+}
+
+
+/* s: next level of the topic name, NULL once all the levels are matched */
+static int matchLevels(MQTTTopicIndex* idx, short n, const char* s, const char* end, MQTTTopicVisitor visit, void* arg)
+{
+    MQTTTopicNode* node = &idx->nodes[n];
+    /* the wildcards at the first level do not match the topics beginning with '$' */
+    int wildcards = (n != 0 || s == end || *s != '$');
+    int count = 0;
+
+    /* '#' matches the remaining levels, none included: "a/#" matches "a" */
+    if (node->hash != NO_NODE && wildcards && idx->nodes[node->hash].topicFilter != NULL)
+    {
+        visit(arg, &idx->nodes[node->hash]);
+        count++;
+    }
+
+    if (s == NULL)
+    {
+        if (node->topicFilter != NULL)
+        {
+            visit(arg, node);
+            count++;
+        }
+    }
+    else
+    {
+        const char* sep = memchr(s, '/', end - s);
+        const char* next = (sep != NULL) ? sep + 1 : NULL;
+        short child = findLiteral(idx, n, s, ((sep != NULL) ? sep : end) - s);
+
+        if (child != NO_NODE)
+            count += matchLevels(idx, child, next, end, visit, arg);
+        if (node->plus != NO_NODE && wildcards)
+            count += matchLevels(idx, node->plus, next, end, visit, arg);
+    }
+    return count;
+}
+
+
+int MQTTTopicIndex_match(MQTTTopicIndex* idx, MQTTString* topicName, MQTTTopicVisitor visit, void* arg)
+{
+    const char* s;
+    size_t len;
+
+    if (topicName->cstring != NULL)
+    {
+        s = topicName->cstring;
+        len = strlen(s);
+    }
+    else
+    {
+        s = topicName->lenstring.data;
+        len = topicName->lenstring.len;
+    }
+    if (idx->subscriptions == 0 || s == NULL)
+        return 0;
+    return matchLevels(idx, 0, s, s + len, visit, arg);
+}
+
+
+int MQTTTopic_matches(const char* topicFilter, const char* topicName, size_t len)
+{
+    const char* f = topicFilter;
+    const char* s = topicName;
+    const char* end = topicName + len;
+
+    if (len > 0 && *s == '$' && (*f == '+' || *f == '#'))
+        return 0;
+    for (;;)
+    {
+        const char* fsep = strchr(f, '/');
+        size_t flen = (fsep != NULL) ? (size_t)(fsep - f) : strlen(f);
+        const char* sep;
+
+        if (IS_LEVEL(f, flen, '#'))
+            return 1;
+        if (s == NULL)
+            return 0;   /* more filter levels than topic levels */
+        sep = memchr(s, '/', end - s);
+        if (!IS_LEVEL(f, flen, '+') && (flen != (size_t)(((sep != NULL) ? sep : end) - s) || memcmp(f, s, flen) != 0))
+            return 0;
+        s = (sep != NULL) ? sep + 1 : NULL;
+        if (fsep == NULL)
+            return s == NULL;
+        f = fsep + 1;
+    }
+}
@@ -0,0 +1,84 @@
+/*
+ * MQTTTopicIndex.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Daruin Solano
+ *
+ *  Subscription index of the MQTT client: a trie of the topic filter levels.
+ *
+ *  Each node is one level of a subscribed topic filter. The literal children
+ *  of all the nodes share one hash table keyed by (parent, level), while the
+ *  '+' and '#' children hang directly from their parent, so that delivering
+ *  a message costs one hash lookup per topic level (plus the wildcard
+ *  branches), whatever the number of subscriptions.
+ *
+ *  The nodes come from a fixed pool of MAX_TOPIC_NODES entries: a filter of
+ *  n levels takes at most n nodes, the levels shared with other filters
+ *  ("devices/+/cmd" and "devices/+/cfg") are stored once.
+ *
+ *  As for the rest of the client, the filter strings are not copied: they
+ *  must stay valid while subscribed.
+ */
+
+#ifndef MQTT_MQTT_CLIENT_MQTTTOPICINDEX_H_
+#define MQTT_MQTT_CLIENT_MQTTTOPICINDEX_H_
+
+#include "MQTTPacket.h"
+
+#if !defined(MAX_MESSAGE_HANDLERS)
+#define MAX_MESSAGE_HANDLERS 5 /* redefinable - how many subscriptions do you want? */
+#endif
+
+#if !defined(MAX_TOPIC_NODES)
+#define MAX_TOPIC_NODES (MAX_MESSAGE_HANDLERS * 4) /* redefinable - topic filter levels of all the subscriptions */
+#endif
+
+struct MessageData;
+
+typedef struct MQTTTopicNode
+{
+    const char* level;          /* not copied: points into one of the filters going through this node */
+    unsigned short len;
+    short parent;               /* -1: root, -2: free node */
+    short next;                 /* next literal child in the same hash bucket, or next free node */
+    short plus;                 /* '+' child, -1 if none */
+    short hash;                 /* '#' child, -1 if none */
+    unsigned short children;
+    unsigned short cache;       /* owner data, 0 when subscribed: MQTTClient last-value cache entry + 1 */
+    const char* topicFilter;    /* set when a subscription ends at this node */
+    void (*fp) (struct MessageData*);
+    void* context;
+} MQTTTopicNode;
+
+typedef struct MQTTTopicIndex
+{
+    MQTTTopicNode nodes[MAX_TOPIC_NODES];   /* nodes[0] is the root */
+    short buckets[MAX_TOPIC_NODES];
+    short free_list;
+    int subscriptions;
+} MQTTTopicIndex;
+
+/* Called for every subscription matching a topic name. */
+typedef void (*MQTTTopicVisitor)(void* arg, MQTTTopicNode* node);
+
+void MQTTTopicIndex_init(MQTTTopicIndex* idx);
+
+/** Add a subscription, or update the handler of an existing one.
+ *  @return 0, or -1 if the node pool is exhausted */
+int MQTTTopicIndex_add(MQTTTopicIndex* idx, const char* topicFilter, void (*fp) (struct MessageData*), void* context);
+
+/** Remove a subscription and the nodes it was the only one to use.
+ *  @return 0, or -1 if the filter was not subscribed */
+int MQTTTopicIndex_remove(MQTTTopicIndex* idx, const char* topicFilter);
+
+/** Find the subscription of a topic filter (exact match, no wildcard expansion). */
+MQTTTopicNode* MQTTTopicIndex_find(MQTTTopicIndex* idx, const char* topicFilter);
+
+/** Call visit for every subscription matching the topic name.
+ *  @return the number of matching subscriptions */
+int MQTTTopicIndex_match(MQTTTopicIndex* idx, MQTTString* topicName, MQTTTopicVisitor visit, void* arg);
+
+/** Match one topic filter against a topic name of len bytes, with the rules of the index. */
+int MQTTTopic_matches(const char* topicFilter, const char* topicName, size_t len);
+
+#endif /* MQTT_MQTT_CLIENT_MQTTTOPICINDEX_H_ */
@@ -0,0 +1,310 @@
+/*
+ * mqtt_facade.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Daruin Solano
+ */
+
+#include "mqtt_facade.h"
+#include "msg.h"
+
+#include <string.h>
+
+
+/* Paho backend ---------------------------------------------------------------*/
+
+static void facade_paho_handler(MessageData* md)
+{
+	mqtt_facade_t* f = (mqtt_facade_t*)md->context;
+
+	if (f == NULL) {
+		return;
+	}
+	f->stats.received++;
+	if (f->handler != NULL) {
+		f->handler(f->handler_ctx, md->topicName->lenstring.data, md->topicName->lenstring.len,
+				md->message->payload, md->message->payloadlen);
+	}
+}
+
+static int facade_paho_subscribe(mqtt_facade_t* f, const char* filter, enum QoS qos)
+{
+	MQTTSubackData data;
+
+	return MQTTSubscribeWithContext(&f->u.paho.client, filter, qos, facade_paho_handler, f, &data);
+}
+
+static void facade_paho_close(mqtt_facade_t* f)
+{
+	Network* n = &f->u.paho.network;
+
+	if (MQTTIsConnected(&f->u.paho.client)) {
+		MQTTDisconnect(&f->u.paho.client);
+	}
+	if (n->sockHandle != NULL) {
+		net_sock_close(n->sockHandle);
+		net_sock_destroy(n->sockHandle);
+		n->sockHandle = NULL;
+	}
+}
+
+/* Same session options as mqtt_app.c: resumed on reconnection, the subscriptions are only renewed if the broker lost them. */
+static int facade_paho_open(mqtt_facade_t* f, bool full)
+{
+	MQTTPacket_connectData options = MQTTPacket_connectData_initializer;
+	MQTTConnackData connack;
+	Network* n = &f->u.paho.network;
+	int rc;
+	int i;
+
+	rc = (full || (n->netHandle == NULL)) ? mqtt_network_init(n, f->dev) : mqtt_network_reconnect(n, f->dev);
+	if (rc != NET_OK) {
+		return FAILURE;
+	}
+
+	options.clientID.cstring = f->dev->MQClientId;
+	options.username.cstring = f->dev->MQUserName;
+	options.password.cstring = f->dev->MQUserPwd;
+	options.keepAliveInterval = f->keepalive;
+	options.cleansession = 0;
+	rc = MQTTConnectWithResults(&f->u.paho.client, &options, &connack);
+	for (i = 0; (rc == MQSUCCESS) && !connack.sessionPresent && (i < f->filter_count); i++) {
+		rc = facade_paho_subscribe(f, f->filters[i], f->filter_qos[i]);
+	}
+	return rc;
+}
+
+/* Module backend -------------------------------------------------------------*/
+
+static void facade_module_close(mqtt_facade_t* f)
+{
+	if (f->u.module.sock != NULL) {
+		net_sock_close(f->u.module.sock);
+		net_sock_destroy(f->u.module.sock);
+		f->u.module.sock = NULL;
+	}
+}
+
+static int facade_module_setopt(net_sockhnd_t sock, const char* name, const char* value, size_t len)
+{
+	return (value == NULL) ? NET_OK : net_sock_setopt(sock, name, (const uint8_t*)value, len);
+}
+
+/* The module connects, subscribes to sub_topic and keeps the session: the MCU only configures it. */
+static int facade_module_open(mqtt_facade_t* f)
+{
+	device_config_t* dev = f->dev;
+	net_sockhnd_t sock = NULL;
+	int rc;
+
+	if ((hnet == NULL) && (net_init(&hnet, NET_IF, net_if_init) != NET_OK)) {
+		return FAILURE;
+	}
+	rc = net_sock_create(hnet, &sock, NET_PROTO_MQTT);
+	if (rc != NET_OK) {
+		msg_error("No MQTT socket of the module (USE_MBED_TLS build?): %d\n", rc);
+		return FAILURE;
+	}
+
+	rc = net_sock_setopt(sock, "mqtt_client_id", (const uint8_t*)dev->MQClientId, strlen(dev->MQClientId) + 1);
+	rc |= net_sock_setopt(sock, "mqtt_pub_topic", (const uint8_t*)f->pub_topic, strlen(f->pub_topic) + 1);
+	rc |= net_sock_setopt(sock, "mqtt_sub_topic", (const uint8_t*)f->sub_topic, strlen(f->sub_topic) + 1);
+	if (dev->HostPort != 1883) {
+		rc |= facade_module_setopt(sock, "tls_ca_certs", dev->tls_ca_certs, dev->tls_ca_certs_len);
+		rc |= facade_module_setopt(sock, "tls_dev_cert", dev->tls_dev_cert, dev->tls_dev_cert_len);
+		rc |= facade_module_setopt(sock, "tls_dev_key", dev->tls_dev_key, dev->tls_dev_key_len);
+	}
+	rc |= net_sock_setopt(sock, "sock_read_timeout", (const uint8_t*)"5000", strlen("5000") + 1);
+	rc |= net_sock_setopt(sock, "sock_write_timeout", (const uint8_t*)"5000", strlen("5000") + 1);
+	f->u.module.read_timeout_ms = 5000;
+	if (rc == NET_OK) {
+		rc = net_sock_open(sock, dev->HostName, NULL, dev->HostPort, 0);
+	}
+	if (rc != NET_OK) {
+		msg_error("Module MQTT connection to %s failed: %d\n", dev->HostName, rc);
+		net_sock_destroy(sock);
+		return FAILURE;
+	}
+	f->u.module.sock = sock;
+	return MQSUCCESS;
+}
+
+/* One payload of sub_topic per read: the module delivers the messages whole. */
+static int facade_module_poll(mqtt_facade_t* f, int timeout_ms)
+{
+	int len;
+
+	if (timeout_ms <= 0) {
+		timeout_ms = 1;
+	}
+	if (timeout_ms != f->u.module.read_timeout_ms) {
+		char stimeout[12];
+		snprintf(stimeout, sizeof(stimeout), "%d", timeout_ms);
+		if (net_sock_setopt(f->u.module.sock, "sock_read_timeout", (const uint8_t*)stimeout, strlen(stimeout) + 1) == NET_OK) {
+			f->u.module.read_timeout_ms = timeout_ms;
+		}
+	}
+
+	len = net_sock_recv(f->u.module.sock, f->u.module.readbuf, sizeof(f->u.module.readbuf));
+	if ((len == NET_TIMEOUT) || (len == 0)) {
+		return MQSUCCESS;
+	}
+	if (len < 0) {
+		return FAILURE;
+	}
+	f->stats.received++;
+	if (f->handler != NULL) {
+		f->handler(f->handler_ctx, f->sub_topic, strlen(f->sub_topic), f->u.module.readbuf, (size_t)len);
+	}
+	return MQSUCCESS;
+}
+
+/* Session lost: counted once, the socket is left to the next connection. */
+static void facade_lost(mqtt_facade_t* f)
+{
+	if (f->connected) {
+		f->connected = false;
+		f->stats.losses++;
+	}
+}
+
+/* Exported functions ---------------------------------------------------------*/
+
+void mqtt_facade_init(mqtt_facade_t* f, mqtt_facade_backend_t backend, device_config_t* dev,
+		const char* pub_topic, const char* sub_topic)
+{
+	memset(f, 0, sizeof(*f));
+	f->backend = backend;
+	f->dev = dev;
+	f->pub_topic = pub_topic;
+	f->sub_topic = sub_topic;
+	f->keepalive = 60;
+	if (backend == MQTT_FACADE_PAHO) {
+		MQTTClientInit(&f->u.paho.client, &f->u.paho.network, MQTT_CMD_TIMEOUT,
+				f->u.paho.sendbuf, sizeof(f->u.paho.sendbuf), f->u.paho.readbuf, sizeof(f->u.paho.readbuf));
+	}
+}
+
+int mqtt_facade_connect(mqtt_facade_t* f, bool full)
+{
+	uint32_t start = HAL_GetTick();
+	int rc;
+
+	mqtt_facade_disconnect(f);
+	if (f->backend == MQTT_FACADE_MODULE) {
+		rc = ((f->pub_topic != NULL) && (f->sub_topic != NULL)) ? facade_module_open(f) : FAILURE;
+	} else {
+		rc = facade_paho_open(f, full);
+	}
+	if (rc != MQSUCCESS) {
+		return FAILURE;
+	}
+
+	f->connected = true;
+	f->stats.connects++;
+	f->stats.connect_ms = HAL_GetTick() - start;
+	if (f->stats.connect_ms > f->stats.connect_ms_max) {
+		f->stats.connect_ms_max = f->stats.connect_ms;
+	}
+	return MQSUCCESS;
+}
+
+int mqtt_facade_reconnect_cb(void* ctx, bool full)
+{
+	return mqtt_facade_connect((mqtt_facade_t*)ctx, full);
+}
+
+int mqtt_facade_subscribe(mqtt_facade_t* f, const char* filter, enum QoS qos, mqtt_facade_handler_t handler, void* ctx)
+{
+	int i;
+
+	f->handler = handler;
+	f->handler_ctx = ctx;
+	if (f->backend == MQTT_FACADE_MODULE) {
+		return ((f->sub_topic != NULL) && (strcmp(filter, f->sub_topic) == 0)) ? MQSUCCESS : FAILURE;
+	}
+
+	for (i = 0; (i < f->filter_count) && (strcmp(f->filters[i], filter) != 0); i++) {
+	}
+	if (i == f->filter_count) {
+		if (f->filter_count == MQTT_FACADE_MAX_SUBS) {
+			return FAILURE;
+		}
+		f->filters[f->filter_count++] = filter;
+	}
+	f->filter_qos[i] = qos;
+	return f->connected ? facade_paho_subscribe(f, filter, qos) : MQSUCCESS;
+}
+
+int mqtt_facade_publish(mqtt_facade_t* f, const char* topic, const void* payload, size_t len, enum QoS qos)
+{
+	uint32_t start = HAL_GetTick();
+	uint32_t elapsed;
+	int rc = FAILURE;
+
+	if (!f->connected) {
+		f->stats.publish_errors++;
+		return FAILURE;
+	}
+	if (f->backend == MQTT_FACADE_MODULE) {
+		if (strcmp(topic, f->pub_topic) == 0) {
+			rc = (net_sock_send(f->u.module.sock, payload, len) == (int)len) ? MQSUCCESS : FAILURE;
+		}
+	} else {
+		MQTTMessage msg;
+
+		memset(&msg, 0, sizeof(msg));
+		msg.qos = qos;
+		msg.payload = (void*)payload;
+		msg.payloadlen = len;
+		rc = MQTTPublish(&f->u.paho.client, topic, &msg);
+	}
+
+	elapsed = HAL_GetTick() - start;
+	if (elapsed > f->stats.publish_ms_max) {
+		f->stats.publish_ms_max = elapsed;
+	}
+	if (rc != MQSUCCESS) {
+		f->stats.publish_errors++;
+		if ((f->backend == MQTT_FACADE_MODULE) || !MQTTIsConnected(&f->u.paho.client)) {
+			facade_lost(f);
+		}
+		return FAILURE;
+	}
+	f->stats.publishes++;
+	return MQSUCCESS;
+}
+
+int mqtt_facade_poll(mqtt_facade_t* f, int timeout_ms)
+{
+	int rc;
+
+	if (!f->connected) {
+		return FAILURE;
+	}
+	if (f->backend == MQTT_FACADE_MODULE) {
+		rc = facade_module_poll(f, timeout_ms);
+	} else {
+		rc = MQTTWaitEvent(&f->u.paho.client, timeout_ms);
+		rc = ((rc == FAILURE) || !MQTTIsConnected(&f->u.paho.client)) ? FAILURE : MQSUCCESS;
+	}
+	if (rc != MQSUCCESS) {
+		facade_lost(f);
+	}
+	return rc;
+}
+
+void mqtt_facade_disconnect(mqtt_facade_t* f)
+{
+	if (f->backend == MQTT_FACADE_MODULE) {
+		facade_module_close(f);
+	} else {
+		facade_paho_close(f);
+	}
+	f->connected = false;
+}
+
+bool mqtt_facade_is_connected(const mqtt_facade_t* f)
+{
+	return f->connected;
+}
@@ -0,0 +1,119 @@
+/*
+ * mqtt_facade.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Daruin Solano
+ *
+ *  One publish/subscribe API over the two MQTT stacks of the board:
+ *  - MQTT_FACADE_PAHO: the Paho client runs on the MCU, over a netsock TCP
+ *    socket, or TLS (mbedTLS in USE_MBED_TLS builds, the TLS of the es-WiFi
+ *    module otherwise);
+ *  - MQTT_FACADE_MODULE: the es-WiFi module runs the MQTT client and its TLS
+ *    (NET_PROTO_MQTT socket, builds without USE_MBED_TLS). The MCU only sends
+ *    and receives payloads: one publication topic and one subscription, both
+ *    given to the module at the connection, QoS of the module.
+ *
+ *  The backend is picked from the configuration, per deployment; the
+ *  application code is the same. Connection, publication, reception and
+ *  loss of the session are counted, whatever the backend.
+ *
+ *    mqtt_facade_init(&f, MQTT_FACADE_MODULE, &dev, "/devices/x/telemetry", "/devices/x/control");
+ *    mqtt_facade_subscribe(&f, "/devices/x/control", QOS0, on_control, NULL);
+ *    mqtt_facade_connect(&f, true);
+ *    mqtt_facade_publish(&f, "/devices/x/telemetry", buf, len, QOS1);
+ *    mqtt_facade_poll(&f, 100);     -> on_control(...) for each message received
+ *
+ *  mqtt_facade_reconnect_cb() is the connect callback of mqtt_reconnect.h.
+ *
+ *  Not thread-safe: call from the task of the MQTT client.
+ */
+
+#ifndef MQTT_MQTT_FACADE_MQTT_FACADE_H_
+#define MQTT_MQTT_FACADE_MQTT_FACADE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "MQTTClient.h"
+
+#if !defined(MQTT_FACADE_MAX_SUBS)
+#define MQTT_FACADE_MAX_SUBS      4     /* redefinable - subscriptions renewed on reconnection, Paho backend */
+#endif
+
+typedef enum {
+  MQTT_FACADE_PAHO = 0,         /**< MQTT client (and mbedTLS) on the MCU */
+  MQTT_FACADE_MODULE            /**< MQTT client and TLS of the es-WiFi module */
+} mqtt_facade_backend_t;
+
+/** Message received on a subscription. topic is not \0 terminated. */
+typedef void (*mqtt_facade_handler_t)(void* ctx, const char* topic, size_t topic_len, const void* payload, size_t len);
+
+typedef struct {
+  uint32_t connects;            /**< Successful connections. */
+  uint32_t connect_ms;          /**< Duration of the last one: socket, TLS, MQTT CONNECT and subscriptions. */
+  uint32_t connect_ms_max;
+  uint32_t losses;              /**< Sessions lost, seen by mqtt_facade_poll() or mqtt_facade_publish(). */
+  uint32_t publishes;
+  uint32_t publish_errors;
+  uint32_t publish_ms_max;      /**< Longest mqtt_facade_publish(): the PUBACK wait included for a QoS1 Paho one. */
+  uint32_t received;
+} mqtt_facade_stats_t;
+
+typedef struct {
+  mqtt_facade_backend_t backend;
+  device_config_t* dev;         /**< Broker, client identifier and credentials. */
+  const char* pub_topic;        /**< Module: the only topic of mqtt_facade_publish(). */
+  const char* sub_topic;        /**< Module: the only subscription. */
+  uint16_t keepalive;           /**< s, Paho: the module has its own. */
+  bool connected;
+  mqtt_facade_handler_t handler;
+  void* handler_ctx;
+  const char* filters[MQTT_FACADE_MAX_SUBS];
+  enum QoS filter_qos[MQTT_FACADE_MAX_SUBS];
+  int filter_count;
+  mqtt_facade_stats_t stats;
+  union {
+    struct {
+      Network network;
+      MQTTClient client;
+      unsigned char sendbuf[MQTT_SEND_BUFFER_SIZE];
+      unsigned char readbuf[MQTT_READ_BUFFER_SIZE];
+    } paho;
+    struct {
+      net_sockhnd_t sock;
+      int read_timeout_ms;      /**< sock_read_timeout of the socket */
+      unsigned char readbuf[MQTT_READ_BUFFER_SIZE];
+    } module;
+  } u;
+} mqtt_facade_t;
+
+/** pub_topic and sub_topic: mandatory for the module backend, ignored by the Paho one. dev must stay valid. */
+void mqtt_facade_init(mqtt_facade_t* f, mqtt_facade_backend_t backend, device_config_t* dev,
+		const char* pub_topic, const char* sub_topic);
+
+/** Open the connection, closing the current one if any, and subscribe again.
+ *  full: resolve the broker address (and set the RTC, on the first Paho connection); required the first time.
+ *  @return MQSUCCESS once the session is up, FAILURE */
+int  mqtt_facade_connect(mqtt_facade_t* f, bool full);
+
+/** mqtt_reconnect_fn_t of mqtt_reconnect.h: ctx is the mqtt_facade_t. */
+int  mqtt_facade_reconnect_cb(void* ctx, bool full);
+
+/** Subscribe now if connected, and on every connection. One handler for all the subscriptions: the last one given.
+ *  Module: filter must be the sub_topic of mqtt_facade_init(), which the module subscribes to.
+ *  @return MQSUCCESS, FAILURE */
+int  mqtt_facade_subscribe(mqtt_facade_t* f, const char* filter, enum QoS qos, mqtt_facade_handler_t handler, void* ctx);
+
+/** Publish, blocking until the PUBACK for a QoS1 Paho publication.
+ *  Module: topic must be the pub_topic of mqtt_facade_init(), qos is that of the module.
+ *  @return MQSUCCESS, FAILURE */
+int  mqtt_facade_publish(mqtt_facade_t* f, const char* topic, const void* payload, size_t len, enum QoS qos);
+
+/** Wait up to timeout_ms for an incoming message and deliver it; keepalive of the Paho client.
+ *  @return MQSUCCESS, or FAILURE if the session is lost */
+int  mqtt_facade_poll(mqtt_facade_t* f, int timeout_ms);
+
+void mqtt_facade_disconnect(mqtt_facade_t* f);
+
+bool mqtt_facade_is_connected(const mqtt_facade_t* f);
+
+#endif /* MQTT_MQTT_FACADE_MQTT_FACADE_H_ */
@@ -92,7 +92,7 @@ typedef struct
 	char struct_id[4];
 	/** The version number of this structure.  Must be 0 */
 	int struct_version;
-	/** Version of MQTT to be used.  3 = 3.1 4 = 3.1.1
+	/** Version of MQTT to be used.  3 = 3.1 4 = 3.1.1 5 = 5 (MQTTV5 builds only)
 	  */
 	unsigned char MQTTVersion;
 	MQTTString clientID;
@@ -134,4 +134,13 @@ DLLExport int MQTTDeserialize_connack(unsigned char* sessionPresent, unsigned ch
 DLLExport int MQTTSerialize_disconnect(unsigned char* buf, int buflen);
 DLLExport int MQTTSerialize_pingreq(unsigned char* buf, int buflen);
 
+#if defined(MQTTV5)
+DLLExport int MQTTV5Serialize_connect(unsigned char* buf, int buflen, MQTTPacket_connectData* options,
+		MQTTProperties* connectProperties, MQTTProperties* willProperties);
+DLLExport int MQTTV5Deserialize_connack(MQTTProperties* connackProperties, unsigned char* sessionPresent,
+		unsigned char* reasonCode, unsigned char* buf, int buflen);
+DLLExport int MQTTV5Serialize_disconnect(unsigned char* buf, int buflen, unsigned char reasonCode, MQTTProperties* properties);
+DLLExport int MQTTV5Deserialize_disconnect(MQTTProperties* properties, unsigned char* reasonCode, unsigned char* buf, int buflen);
+#endif
+
 #endif /* MQTTCONNECT_H_ */
@@ -12,22 +12,35 @@
  *
  * Contributors:
  *    Ian Craggs - initial API and implementation and/or initial documentation
+ *    Daruin Solano - MQTT 5 connect, connack and disconnect
  *******************************************************************************/
 
 #include "MQTTPacket.h"
 #include "StackTrace.h"
 
 #include <string.h>
+#if defined(MQTTV5)
+static int MQTTSerialize_connectLength(MQTTPacket_connectData* options, MQTTProperties* connectProperties,
+		MQTTProperties* willProperties);
+#else
 static int MQTTSerialize_connectLength(MQTTPacket_connectData* options);
+#endif
 static int MQTTSerialize_zero(unsigned char* buf, int buflen, unsigned char packettype);
 
 
 /**
   * Determines the length of the MQTT connect packet that would be produced using the supplied connect options.
   * @param options the options to be used to build the connect packet
+  * @param connectProperties the MQTT 5 connect properties, MQTTV5 builds only
+  * @param willProperties the MQTT 5 will properties, MQTTV5 builds only
   * @return the length of buffer needed to contain the serialized version of the packet
   */
+#if defined(MQTTV5)
+int MQTTSerialize_connectLength(MQTTPacket_connectData* options, MQTTProperties* connectProperties,
+		MQTTProperties* willProperties)
+#else
 int MQTTSerialize_connectLength(MQTTPacket_connectData* options)
+#endif
 {
 	int len = 0;
 
@@ -35,9 +48,18 @@ int MQTTSerialize_connectLength(MQTTPacket_connectData* options)
 
 	if (options->MQTTVersion == 3)
 		len = 12; /* variable depending on MQTT or MQIsdp */
-	else if (options->MQTTVersion == 4)
+	else if (options->MQTTVersion == 4 || options->MQTTVersion == 5)
 		len = 10;
 
+#if defined(MQTTV5)
+	if (options->MQTTVersion == 5)
+	{
+		len += MQTTProperties_len(connectProperties);
+		if (options->willFlag)
+			len += MQTTProperties_len(willProperties);
+	}
+#endif
+
 	len += MQTTstrlen(options->clientID)+2;
 	if (options->willFlag)
 		len += MQTTstrlen(options->will.topicName)+2 + MQTTstrlen(options->will.message)+2;
@@ -58,7 +80,27 @@ int MQTTSerialize_connectLength(MQTTPacket_connectData* options)
   * @param options the options to be used to build the connect packet
   * @return serialized length, or error if 0
   */
+#if defined(MQTTV5)
 int MQTTSerialize_connect(unsigned char* buf, int buflen, MQTTPacket_connectData* options)
+{
+	return MQTTV5Serialize_connect(buf, buflen, options, NULL, NULL);
+}
+
+
+/**
+  * Serializes the connect options into the buffer, with the MQTT 5 properties if options->MQTTVersion is 5.
+  * @param buf the buffer into which the packet will be serialized
+  * @param len the length in bytes of the supplied buffer
+  * @param options the options to be used to build the connect packet
+  * @param connectProperties the connect properties, or NULL for none
+  * @param willProperties the will properties, or NULL for none
+  * @return serialized length, or error if 0
+  */
+int MQTTV5Serialize_connect(unsigned char* buf, int buflen, MQTTPacket_connectData* options,
+		MQTTProperties* connectProperties, MQTTProperties* willProperties)
+#else
+int MQTTSerialize_connect(unsigned char* buf, int buflen, MQTTPacket_connectData* options)
+#endif
 {
 	unsigned char *ptr = buf;
 	MQTTHeader header = {0};
@@ -67,7 +109,11 @@ int MQTTSerialize_connect(unsigned char* buf, int buflen, MQTTPacket_connectData
 	int rc = -1;
 
 	FUNC_ENTRY;
+#if defined(MQTTV5)
+	if (MQTTPacket_len(len = MQTTSerialize_connectLength(options, connectProperties, willProperties)) > buflen)
+#else
 	if (MQTTPacket_len(len = MQTTSerialize_connectLength(options)) > buflen)
+#endif
 	{
 		rc = MQTTPACKET_BUFFER_TOO_SHORT;
 		goto exit;
@@ -79,10 +125,10 @@ int MQTTSerialize_connect(unsigned char* buf, int buflen, MQTTPacket_connectData
 
 	ptr += MQTTPacket_encode(ptr, len); /* write remaining length */
 
-	if (options->MQTTVersion == 4)
+	if (options->MQTTVersion == 4 || options->MQTTVersion == 5)
 	{
 		writeCString(&ptr, "MQTT");
-		writeChar(&ptr, (char) 4);
+		writeChar(&ptr, (char) options->MQTTVersion);
 	}
 	else
 	{
@@ -106,9 +152,17 @@ int MQTTSerialize_connect(unsigned char* buf, int buflen, MQTTPacket_connectData
 
 	writeChar(&ptr, flags.all);
 	writeInt(&ptr, options->keepAliveInterval);
+#if defined(MQTTV5)
+	if (options->MQTTVersion == 5)
+		MQTTProperties_write(&ptr, connectProperties);
+#endif
 	writeMQTTString(&ptr, options->clientID);
 	if (options->willFlag)
 	{
+#if defined(MQTTV5)
+		if (options->MQTTVersion == 5)
+			MQTTProperties_write(&ptr, willProperties);
+#endif
 		writeMQTTString(&ptr, options->will.topicName);
 		writeMQTTString(&ptr, options->will.message);
 	}
@@ -162,6 +216,50 @@ exit:
 }
 
 
+#if defined(MQTTV5)
+/**
+  * Deserializes the supplied (wire) buffer into MQTT 5 connack data
+  * @param connackProperties returned connack properties: the broker limits, or NULL to skip them
+  * @param sessionPresent the session present flag returned
+  * @param reasonCode returned reason code, 0x80 and above is a failure
+  * @param buf the raw buffer data, of the correct length determined by the remaining length field
+  * @param len the length in bytes of the data in the supplied buffer
+  * @return error code.  1 is success, 0 is failure
+  */
+int MQTTV5Deserialize_connack(MQTTProperties* connackProperties, unsigned char* sessionPresent,
+		unsigned char* reasonCode, unsigned char* buf, int buflen)
+{
+	MQTTHeader header = {0};
+	unsigned char* curdata = buf;
+	unsigned char* enddata = NULL;
+	int rc = 0;
+	int mylen;
+	MQTTConnackFlags flags = {0};
+
+	FUNC_ENTRY;
+	header.byte = readChar(&curdata);
+	if (header.bits.type != CONNACK)
+		goto exit;
+
+	curdata += MQTTPacket_decodeBuf(curdata, &mylen); /* read remaining length */
+	enddata = curdata + mylen;
+	if (enddata - curdata < 2)
+		goto exit;
+
+	flags.all = readChar(&curdata);
+	*sessionPresent = flags.bits.sessionpresent;
+	*reasonCode = readChar(&curdata);
+
+	if (enddata - curdata > 0 && !MQTTProperties_read(connackProperties, &curdata, enddata))
+		goto exit;
+	rc = 1;
+exit:
+	FUNC_EXIT_RC(rc);
+	return rc;
+}
+#endif
+
+
 /**
   * Serializes a 0-length packet into the supplied buffer, ready for writing to a socket
   * @param buf the buffer into which the packet will be serialized
@@ -205,6 +303,84 @@ int MQTTSerialize_disconnect(unsigned char* buf, int buflen)
 }
 
 
+#if defined(MQTTV5)
+/**
+  * Serializes an MQTT 5 disconnect packet into the supplied buffer, ready for writing to a socket
+  * @param buf the buffer into which the packet will be serialized
+  * @param buflen the length in bytes of the supplied buffer, to avoid overruns
+  * @param reasonCode the disconnect reason code
+  * @param properties the disconnect properties, or NULL for none
+  * @return serialized length, or error if 0
+  */
+int MQTTV5Serialize_disconnect(unsigned char* buf, int buflen, unsigned char reasonCode, MQTTProperties* properties)
+{
+	MQTTHeader header = {0};
+	int rc = -1;
+	int rem_len = 0;
+	unsigned char *ptr = buf;
+
+	FUNC_ENTRY;
+	if (reasonCode == MQTTREASONCODE_NORMAL_DISCONNECTION && properties == NULL)
+	{
+		rc = MQTTSerialize_zero(buf, buflen, DISCONNECT);   /* the short form */
+		goto exit;
+	}
+	rem_len = 1 + ((properties != NULL) ? MQTTProperties_len(properties) : 0);
+	if (MQTTPacket_len(rem_len) > buflen)
+	{
+		rc = MQTTPACKET_BUFFER_TOO_SHORT;
+		goto exit;
+	}
+	header.bits.type = DISCONNECT;
+	writeChar(&ptr, header.byte); /* write header */
+
+	ptr += MQTTPacket_encode(ptr, rem_len); /* write remaining length */
+	writeChar(&ptr, reasonCode);
+	if (properties != NULL)
+		MQTTProperties_write(&ptr, properties);
+	rc = ptr - buf;
+exit:
+	FUNC_EXIT_RC(rc);
+	return rc;
+}
+
+
+/**
+  * Deserializes the supplied (wire) buffer into the MQTT 5 disconnect data sent by a server
+  * @param properties returned disconnect properties, or NULL to skip them
+  * @param reasonCode returned reason code
+  * @param buf the raw buffer data, of the correct length determined by the remaining length field
+  * @param buflen the length in bytes of the data in the supplied buffer
+  * @return error code.  1 is success, 0 is failure
+  */
+int MQTTV5Deserialize_disconnect(MQTTProperties* properties, unsigned char* reasonCode, unsigned char* buf, int buflen)
+{
+	MQTTHeader header = {0};
+	unsigned char* curdata = buf;
+	unsigned char* enddata = NULL;
+	int rc = 0;
+	int mylen;
+
+	FUNC_ENTRY;
+	header.byte = readChar(&curdata);
+	if (header.bits.type != DISCONNECT)
+		goto exit;
+
+	curdata += MQTTPacket_decodeBuf(curdata, &mylen); /* read remaining length */
+	enddata = curdata + mylen;
+	*reasonCode = MQTTREASONCODE_NORMAL_DISCONNECTION;
+	if (enddata - curdata >= 1)
+		*reasonCode = readChar(&curdata);
+	if (enddata - curdata > 0 && !MQTTProperties_read(properties, &curdata, enddata))
+		goto exit;
+	rc = 1;
+exit:
+	FUNC_EXIT_RC(rc);
+	return rc;
+}
+#endif
+
+
 /**
   * Serializes a disconnect packet into the supplied buffer, ready for writing to a socket
   * @param buf the buffer into which the packet will be serialized
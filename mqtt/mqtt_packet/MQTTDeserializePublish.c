@@ -12,6 +12,7 @@
  *
  * Contributors:
  *    Ian Craggs - initial API and implementation and/or initial documentation
+ *    Daruin Solano - MQTT 5 publish and acks
  *******************************************************************************/
 
 #include "StackTrace.h"
@@ -69,6 +70,54 @@ exit:
 }
 
 
+#if defined(MQTTV5)
+/**
+  * Deserializes the supplied (wire) buffer into MQTT 5 publish data
+  * @param properties returned publish properties, e.g. the topic alias, or NULL to skip them
+  * @return error code.  1 is success
+  */
+int MQTTV5Deserialize_publish(unsigned char* dup, int* qos, unsigned char* retained, unsigned short* packetid, MQTTString* topicName,
+		MQTTProperties* properties, unsigned char** payload, int* payloadlen, unsigned char* buf, int buflen)
+{
+	MQTTHeader header = {0};
+	unsigned char* curdata = buf;
+	unsigned char* enddata = NULL;
+	int rc = 0;
+	int mylen = 0;
+
+	FUNC_ENTRY;
+	header.byte = readChar(&curdata);
+	if (header.bits.type != PUBLISH)
+		goto exit;
+	*dup = header.bits.dup;
+	*qos = header.bits.qos;
+	*retained = header.bits.retain;
+
+	curdata += MQTTPacket_decodeBuf(curdata, &mylen); /* read remaining length */
+	enddata = curdata + mylen;
+
+	if (!readMQTTLenString(topicName, &curdata, enddata))
+		goto exit;
+
+	if (*qos > 0)
+	{
+		if (enddata - curdata < 2)
+			goto exit;
+		*packetid = readInt(&curdata);
+	}
+	if (!MQTTProperties_read(properties, &curdata, enddata))
+		goto exit;
+
+	*payloadlen = enddata - curdata;
+	*payload = curdata;
+	rc = 1;
+exit:
+	FUNC_EXIT_RC(rc);
+	return rc;
+}
+#endif
+
+
 
 /**
   * Deserializes the supplied (wire) buffer into an ack
@@ -105,3 +154,51 @@ exit:
 	return rc;
 }
 
+
+#if defined(MQTTV5)
+/**
+  * Deserializes the supplied (wire) buffer into an MQTT 5 ack
+  * @param packettype returned integer - the MQTT packet type
+  * @param dup returned integer - the MQTT dup flag
+  * @param packetid returned integer - the MQTT packet identifier
+  * @param reasonCode returned reason code, success when the packet has none
+  * @param properties returned ack properties, or NULL to skip them
+  * @param buf the raw buffer data, of the correct length determined by the remaining length field
+  * @param buflen the length in bytes of the data in the supplied buffer
+  * @return error code.  1 is success, 0 is failure
+  */
+int MQTTV5Deserialize_ack(unsigned char* packettype, unsigned char* dup, unsigned short* packetid,
+		unsigned char* reasonCode, MQTTProperties* properties, unsigned char* buf, int buflen)
+{
+	MQTTHeader header = {0};
+	unsigned char* curdata = buf;
+	unsigned char* enddata = NULL;
+	int rc = 0;
+	int mylen;
+
+	FUNC_ENTRY;
+	header.byte = readChar(&curdata);
+	*dup = header.bits.dup;
+	*packettype = header.bits.type;
+
+	curdata += MQTTPacket_decodeBuf(curdata, &mylen); /* read remaining length */
+	enddata = curdata + mylen;
+
+	if (enddata - curdata < 2)
+		goto exit;
+	*packetid = readInt(&curdata);
+
+	*reasonCode = MQTTREASONCODE_SUCCESS;
+	if (properties != NULL)
+		properties->count = properties->length = 0;
+	if (enddata - curdata >= 1)
+		*reasonCode = readChar(&curdata);
+	if (enddata - curdata > 0 && !MQTTProperties_read(properties, &curdata, enddata))
+		goto exit;
+	rc = 1;
+exit:
+	FUNC_EXIT_RC(rc);
+	return rc;
+}
+#endif
+
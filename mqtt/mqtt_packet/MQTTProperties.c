@@ -0,0 +1,314 @@
+/*
+ * MQTTProperties.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Daruin Solano
+ */
+
+#include "MQTTPacket.h"
+#include "StackTrace.h"
+
+#include <string.h>
+
+#if defined(MQTTV5)
+
+static const struct nameToType
+{
+	enum MQTTPropertyCodes name;
+	enum MQTTPropertyTypes type;
+} namesToTypes[] =
+{
+	{MQTTPROPERTY_CODE_PAYLOAD_FORMAT_INDICATOR, MQTTPROPERTY_TYPE_BYTE},
+	{MQTTPROPERTY_CODE_MESSAGE_EXPIRY_INTERVAL, MQTTPROPERTY_TYPE_FOUR_BYTE_INTEGER},
+	{MQTTPROPERTY_CODE_CONTENT_TYPE, MQTTPROPERTY_TYPE_UTF_8_ENCODED_STRING},
+	{MQTTPROPERTY_CODE_RESPONSE_TOPIC, MQTTPROPERTY_TYPE_UTF_8_ENCODED_STRING},
+	{MQTTPROPERTY_CODE_CORRELATION_DATA, MQTTPROPERTY_TYPE_BINARY_DATA},
+	{MQTTPROPERTY_CODE_SUBSCRIPTION_IDENTIFIER, MQTTPROPERTY_TYPE_VARIABLE_BYTE_INTEGER},
+	{MQTTPROPERTY_CODE_SESSION_EXPIRY_INTERVAL, MQTTPROPERTY_TYPE_FOUR_BYTE_INTEGER},
+	{MQTTPROPERTY_CODE_ASSIGNED_CLIENT_IDENTIFER, MQTTPROPERTY_TYPE_UTF_8_ENCODED_STRING},
+	{MQTTPROPERTY_CODE_SERVER_KEEP_ALIVE, MQTTPROPERTY_TYPE_TWO_BYTE_INTEGER},
+	{MQTTPROPERTY_CODE_AUTHENTICATION_METHOD, MQTTPROPERTY_TYPE_UTF_8_ENCODED_STRING},
+	{MQTTPROPERTY_CODE_AUTHENTICATION_DATA, MQTTPROPERTY_TYPE_BINARY_DATA},
+	{MQTTPROPERTY_CODE_REQUEST_PROBLEM_INFORMATION, MQTTPROPERTY_TYPE_BYTE},
+	{MQTTPROPERTY_CODE_WILL_DELAY_INTERVAL, MQTTPROPERTY_TYPE_FOUR_BYTE_INTEGER},
+	{MQTTPROPERTY_CODE_REQUEST_RESPONSE_INFORMATION, MQTTPROPERTY_TYPE_BYTE},
+	{MQTTPROPERTY_CODE_RESPONSE_INFORMATION, MQTTPROPERTY_TYPE_UTF_8_ENCODED_STRING},
+	{MQTTPROPERTY_CODE_SERVER_REFERENCE, MQTTPROPERTY_TYPE_UTF_8_ENCODED_STRING},
+	{MQTTPROPERTY_CODE_REASON_STRING, MQTTPROPERTY_TYPE_UTF_8_ENCODED_STRING},
+	{MQTTPROPERTY_CODE_RECEIVE_MAXIMUM, MQTTPROPERTY_TYPE_TWO_BYTE_INTEGER},
+	{MQTTPROPERTY_CODE_TOPIC_ALIAS_MAXIMUM, MQTTPROPERTY_TYPE_TWO_BYTE_INTEGER},
+	{MQTTPROPERTY_CODE_TOPIC_ALIAS, MQTTPROPERTY_TYPE_TWO_BYTE_INTEGER},
+	{MQTTPROPERTY_CODE_MAXIMUM_QOS, MQTTPROPERTY_TYPE_BYTE},
+	{MQTTPROPERTY_CODE_RETAIN_AVAILABLE, MQTTPROPERTY_TYPE_BYTE},
+	{MQTTPROPERTY_CODE_USER_PROPERTY, MQTTPROPERTY_TYPE_UTF_8_STRING_PAIR},
+	{MQTTPROPERTY_CODE_MAXIMUM_PACKET_SIZE, MQTTPROPERTY_TYPE_FOUR_BYTE_INTEGER},
+	{MQTTPROPERTY_CODE_WILDCARD_SUBSCRIPTION_AVAILABLE, MQTTPROPERTY_TYPE_BYTE},
+	{MQTTPROPERTY_CODE_SUBSCRIPTION_IDENTIFIERS_AVAILABLE, MQTTPROPERTY_TYPE_BYTE},
+	{MQTTPROPERTY_CODE_SHARED_SUBSCRIPTION_AVAILABLE, MQTTPROPERTY_TYPE_BYTE}
+};
+
+
+int MQTTProperty_getType(int identifier)
+{
+	int i;
+
+	for (i = 0; i < (int)(sizeof(namesToTypes) / sizeof(namesToTypes[0])); ++i)
+	{
+		if (namesToTypes[i].name == identifier)
+			return namesToTypes[i].type;
+	}
+	return -1;
+}
+
+
+/**
+  * Length of a variable byte integer
+  * @param value the integer to be encoded
+  * @return its encoded length, 1 to 4 bytes
+  */
+static int MQTTProperty_VBIlen(unsigned int value)
+{
+	return (value < 128) ? 1 : (value < 16384) ? 2 : (value < 2097152) ? 3 : 4;
+}
+
+
+/* Encoded length of one property, identifier included */
+static int MQTTProperty_len(const MQTTProperty* prop)
+{
+	int len = 1;
+
+	switch (MQTTProperty_getType(prop->identifier))
+	{
+		case MQTTPROPERTY_TYPE_BYTE:
+			len += 1;
+			break;
+		case MQTTPROPERTY_TYPE_TWO_BYTE_INTEGER:
+			len += 2;
+			break;
+		case MQTTPROPERTY_TYPE_FOUR_BYTE_INTEGER:
+			len += 4;
+			break;
+		case MQTTPROPERTY_TYPE_VARIABLE_BYTE_INTEGER:
+			len += MQTTProperty_VBIlen(prop->value.integer4);
+			break;
+		case MQTTPROPERTY_TYPE_BINARY_DATA:
+		case MQTTPROPERTY_TYPE_UTF_8_ENCODED_STRING:
+			len += 2 + prop->value.data.len;
+			break;
+		case MQTTPROPERTY_TYPE_UTF_8_STRING_PAIR:
+			len += 2 + prop->value.data.len + 2 + prop->value.value.len;
+			break;
+	}
+	return len;
+}
+
+
+int MQTTProperties_len(MQTTProperties* props)
+{
+	int len = (props != NULL) ? props->length : 0;
+
+	return MQTTProperty_VBIlen(len) + len;
+}
+
+
+int MQTTProperties_add(MQTTProperties* props, const MQTTProperty* prop)
+{
+	int rc = -1;
+
+	FUNC_ENTRY;
+	if (props->count < props->max_count && MQTTProperty_getType(prop->identifier) >= 0)
+	{
+		props->array[props->count++] = *prop;
+		props->length += MQTTProperty_len(prop);
+		rc = 0;
+	}
+	FUNC_EXIT_RC(rc);
+	return rc;
+}
+
+
+static void writeLenString(unsigned char** pptr, const MQTTLenString* s)
+{
+	writeInt(pptr, s->len);
+	memcpy(*pptr, s->data, s->len);
+	*pptr += s->len;
+}
+
+
+int MQTTProperties_write(unsigned char** pptr, const MQTTProperties* properties)
+{
+	unsigned char* start = *pptr;
+	int i;
+
+	FUNC_ENTRY;
+	if (properties == NULL)
+	{
+		writeChar(pptr, 0);
+		goto exit;
+	}
+	*pptr += MQTTPacket_encode(*pptr, properties->length);
+	for (i = 0; i < properties->count; ++i)
+	{
+		const MQTTProperty* prop = &properties->array[i];
+
+		*pptr += MQTTPacket_encode(*pptr, prop->identifier);
+		switch (MQTTProperty_getType(prop->identifier))
+		{
+			case MQTTPROPERTY_TYPE_BYTE:
+				writeChar(pptr, prop->value.byte);
+				break;
+			case MQTTPROPERTY_TYPE_TWO_BYTE_INTEGER:
+				writeInt(pptr, prop->value.integer2);
+				break;
+			case MQTTPROPERTY_TYPE_FOUR_BYTE_INTEGER:
+				writeInt(pptr, (int)(prop->value.integer4 >> 16));
+				writeInt(pptr, (int)(prop->value.integer4 & 0xFFFF));
+				break;
+			case MQTTPROPERTY_TYPE_VARIABLE_BYTE_INTEGER:
+				*pptr += MQTTPacket_encode(*pptr, (int)prop->value.integer4);
+				break;
+			case MQTTPROPERTY_TYPE_BINARY_DATA:
+			case MQTTPROPERTY_TYPE_UTF_8_ENCODED_STRING:
+				writeLenString(pptr, &prop->value.data);
+				break;
+			case MQTTPROPERTY_TYPE_UTF_8_STRING_PAIR:
+				writeLenString(pptr, &prop->value.data);
+				writeLenString(pptr, &prop->value.value);
+				break;
+		}
+	}
+exit:
+	FUNC_EXIT_RC(*pptr - start);
+	return (int)(*pptr - start);
+}
+
+
+/* Variable byte integer, bounded by enddata. 1 is success, 0 is failure */
+static int readVBI(unsigned int* value, unsigned char** pptr, unsigned char* enddata)
+{
+	unsigned int multiplier = 1;
+	int len = 0;
+	unsigned char c;
+
+	*value = 0;
+	do
+	{
+		if (++len > 4 || *pptr >= enddata)
+			return 0;
+		c = readChar(pptr);
+		*value += (c & 127) * multiplier;
+		multiplier *= 128;
+	} while ((c & 128) != 0);
+	return 1;
+}
+
+
+static int readLenString(MQTTLenString* s, unsigned char** pptr, unsigned char* enddata)
+{
+	if (enddata - *pptr < 2)
+		return 0;
+	s->len = readInt(pptr);
+	if (enddata - *pptr < s->len)
+		return 0;
+	s->data = (char*)*pptr;
+	*pptr += s->len;
+	return 1;
+}
+
+
+int MQTTProperties_read(MQTTProperties* properties, unsigned char** pptr, unsigned char* enddata)
+{
+	unsigned int length = 0;
+	unsigned char* propend;
+	int rc = 0;
+
+	FUNC_ENTRY;
+	if (properties != NULL)
+		properties->count = properties->length = 0;
+	if (!readVBI(&length, pptr, enddata) || (unsigned int)(enddata - *pptr) < length)
+		goto exit;
+	propend = *pptr + length;
+	if (properties != NULL)
+		properties->length = (int)length;
+
+	while (*pptr < propend)
+	{
+		MQTTProperty prop;
+		unsigned int id = 0;
+
+		memset(&prop, 0, sizeof(prop));
+		if (!readVBI(&id, pptr, propend))
+			goto exit;
+		prop.identifier = (enum MQTTPropertyCodes)id;
+		switch (MQTTProperty_getType(id))
+		{
+			case MQTTPROPERTY_TYPE_BYTE:
+				if (propend - *pptr < 1)
+					goto exit;
+				prop.value.byte = readChar(pptr);
+				break;
+			case MQTTPROPERTY_TYPE_TWO_BYTE_INTEGER:
+				if (propend - *pptr < 2)
+					goto exit;
+				prop.value.integer2 = (unsigned short)readInt(pptr);
+				break;
+			case MQTTPROPERTY_TYPE_FOUR_BYTE_INTEGER:
+				if (propend - *pptr < 4)
+					goto exit;
+				prop.value.integer4 = (unsigned int)readInt(pptr) << 16;
+				prop.value.integer4 |= (unsigned int)readInt(pptr);
+				break;
+			case MQTTPROPERTY_TYPE_VARIABLE_BYTE_INTEGER:
+				if (!readVBI(&prop.value.integer4, pptr, propend))
+					goto exit;
+				break;
+			case MQTTPROPERTY_TYPE_BINARY_DATA:
+			case MQTTPROPERTY_TYPE_UTF_8_ENCODED_STRING:
+				if (!readLenString(&prop.value.data, pptr, propend))
+					goto exit;
+				break;
+			case MQTTPROPERTY_TYPE_UTF_8_STRING_PAIR:
+				if (!readLenString(&prop.value.data, pptr, propend) || !readLenString(&prop.value.value, pptr, propend))
+					goto exit;
+				break;
+			default:
+				goto exit;  /* unknown property: malformed packet */
+		}
+		if (properties != NULL && properties->count < properties->max_count)
+			properties->array[properties->count++] = prop;
+	}
+	rc = 1;
+exit:
+	FUNC_EXIT_RC(rc);
+	return rc;
+}
+
+
+int MQTTProperties_getNumericValue(MQTTProperties* props, enum MQTTPropertyCodes propid, unsigned int* value)
+{
+	int i;
+
+	for (i = 0; props != NULL && i < props->count; ++i)
+	{
+		if (props->array[i].identifier != propid)
+			continue;
+		switch (MQTTProperty_getType(propid))
+		{
+			case MQTTPROPERTY_TYPE_BYTE:
+				*value = props->array[i].value.byte;
+				return 1;
+			case MQTTPROPERTY_TYPE_TWO_BYTE_INTEGER:
+				*value = props->array[i].value.integer2;
+				return 1;
+			case MQTTPROPERTY_TYPE_FOUR_BYTE_INTEGER:
+			case MQTTPROPERTY_TYPE_VARIABLE_BYTE_INTEGER:
+				*value = props->array[i].value.integer4;
+				return 1;
+			default:
+				return 0;
+		}
+	}
+	return 0;
+}
+
+#endif /* MQTTV5 */
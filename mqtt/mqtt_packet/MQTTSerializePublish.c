@@ -13,6 +13,8 @@
  * Contributors:
  *    Ian Craggs - initial API and implementation and/or initial documentation
  *    Ian Craggs - fix for https://bugs.eclipse.org/bugs/show_bug.cgi?id=453144
+ *    Daruin Solano - serialize the publish header only, for the zero-copy publication
+ *    Daruin Solano - MQTT 5 publish and acks
  *******************************************************************************/
 
 #include "MQTTPacket.h"
@@ -20,22 +22,35 @@
 
 #include <string.h>
 
+#if defined(MQTTV5)
+static int MQTTSerialize_publishLength(int qos, MQTTString topicName, int payloadlen, MQTTProperties* properties);
+#else
 static int MQTTSerialize_publishLength(int qos, MQTTString topicName, int payloadlen);
+#endif
 
 /**
   * Determines the length of the MQTT publish packet that would be produced using the supplied parameters
   * @param qos the MQTT QoS of the publish (packetid is omitted for QoS 0)
   * @param topicName the topic name to be used in the publish  
   * @param payloadlen the length of the payload to be sent
+  * @param properties the MQTT 5 properties, NULL for MQTT 3.1.1 - MQTTV5 builds only
   * @return the length of buffer needed to contain the serialized version of the packet
   */
+#if defined(MQTTV5)
+int MQTTSerialize_publishLength(int qos, MQTTString topicName, int payloadlen, MQTTProperties* properties)
+#else
 int MQTTSerialize_publishLength(int qos, MQTTString topicName, int payloadlen)
+#endif
 {
 	int len = 0;
 
 	len += 2 + MQTTstrlen(topicName) + payloadlen;
 	if (qos > 0)
 		len += 2; /* packetid */
+#if defined(MQTTV5)
+	if (properties != NULL)
+		len += MQTTProperties_len(properties);
+#endif
 	return len;
 }
 
@@ -55,6 +70,77 @@ int MQTTSerialize_publishLength(int qos, MQTTString topicName, int payloadlen)
   */
 int MQTTSerialize_publish(unsigned char* buf, int buflen, unsigned char dup, int qos, unsigned char retained, unsigned short packetid,
 		MQTTString topicName, unsigned char* payload, int payloadlen)
+#if defined(MQTTV5)
+{
+	return MQTTV5Serialize_publish(buf, buflen, dup, qos, retained, packetid, topicName, NULL, payload, payloadlen);
+}
+
+
+/**
+  * Serializes the supplied publish data into the supplied buffer, with MQTT 5 properties
+  * @param properties the publish properties, e.g. the topic alias. NULL for MQTT 3.1.1
+  * @return the length of the serialized data.  <= 0 indicates error
+  */
+int MQTTV5Serialize_publish(unsigned char* buf, int buflen, unsigned char dup, int qos, unsigned char retained, unsigned short packetid,
+		MQTTString topicName, MQTTProperties* properties, unsigned char* payload, int payloadlen)
+#endif
+{
+	int rc = 0;
+
+	FUNC_ENTRY;
+#if defined(MQTTV5)
+	if (MQTTPacket_len(MQTTSerialize_publishLength(qos, topicName, payloadlen, properties)) > buflen)
+#else
+	if (MQTTPacket_len(MQTTSerialize_publishLength(qos, topicName, payloadlen)) > buflen)
+#endif
+	{
+		rc = MQTTPACKET_BUFFER_TOO_SHORT;
+		goto exit;
+	}
+
+#if defined(MQTTV5)
+	rc = MQTTV5Serialize_publishHeader(buf, buflen, dup, qos, retained, packetid, topicName, properties, payloadlen);
+#else
+	rc = MQTTSerialize_publishHeader(buf, buflen, dup, qos, retained, packetid, topicName, payloadlen);
+#endif
+	memcpy(buf + rc, payload, payloadlen);
+	rc += payloadlen;
+
+exit:
+	FUNC_EXIT_RC(rc);
+	return rc;
+}
+
+
+/**
+  * Serializes the supplied publish data into the supplied buffer, but the payload: everything up to the
+  * packet identifier. The payload, of payloadlen bytes, is to be sent right after from its own buffer.
+  * @param buf the buffer into which the packet header will be serialized
+  * @param buflen the length in bytes of the supplied buffer
+  * @param dup integer - the MQTT dup flag
+  * @param qos integer - the MQTT QoS value
+  * @param retained integer - the MQTT retained flag
+  * @param packetid integer - the MQTT packet identifier
+  * @param topicName MQTTString - the MQTT topic in the publish
+  * @param payloadlen integer - the length of the MQTT payload
+  * @return the length of the serialized header.  <= 0 indicates error
+  */
+int MQTTSerialize_publishHeader(unsigned char* buf, int buflen, unsigned char dup, int qos, unsigned char retained, unsigned short packetid,
+		MQTTString topicName, int payloadlen)
+#if defined(MQTTV5)
+{
+	return MQTTV5Serialize_publishHeader(buf, buflen, dup, qos, retained, packetid, topicName, NULL, payloadlen);
+}
+
+
+/**
+  * Serializes the supplied publish data into the supplied buffer, but the payload, with MQTT 5 properties
+  * @param properties the publish properties, e.g. the topic alias. NULL for MQTT 3.1.1
+  * @return the length of the serialized header.  <= 0 indicates error
+  */
+int MQTTV5Serialize_publishHeader(unsigned char* buf, int buflen, unsigned char dup, int qos, unsigned char retained, unsigned short packetid,
+		MQTTString topicName, MQTTProperties* properties, int payloadlen)
+#endif
 {
 	unsigned char *ptr = buf;
 	MQTTHeader header = {0};
@@ -62,7 +148,12 @@ int MQTTSerialize_publish(unsigned char* buf, int buflen, unsigned char dup, int
 	int rc = 0;
 
 	FUNC_ENTRY;
-	if (MQTTPacket_len(rem_len = MQTTSerialize_publishLength(qos, topicName, payloadlen)) > buflen)
+#if defined(MQTTV5)
+	rem_len = MQTTSerialize_publishLength(qos, topicName, payloadlen, properties);
+#else
+	rem_len = MQTTSerialize_publishLength(qos, topicName, payloadlen);
+#endif
+	if (MQTTPacket_len(rem_len) - payloadlen > buflen)
 	{
 		rc = MQTTPACKET_BUFFER_TOO_SHORT;
 		goto exit;
@@ -80,9 +171,10 @@ int MQTTSerialize_publish(unsigned char* buf, int buflen, unsigned char dup, int
 
 	if (qos > 0)
 		writeInt(&ptr, packetid);
-
-	memcpy(ptr, payload, payloadlen);
-	ptr += payloadlen;
+#if defined(MQTTV5)
+	if (properties != NULL)
+		MQTTProperties_write(&ptr, properties);
+#endif
 
 	rc = ptr - buf;
 
@@ -128,6 +220,56 @@ exit:
 }
 
 
+#if defined(MQTTV5)
+/**
+  * Serializes an MQTT 5 ack packet into the supplied buffer. Success without properties is the 3.1.1 packet.
+  * @param buf the buffer into which the packet will be serialized
+  * @param buflen the length in bytes of the supplied buffer
+  * @param type the MQTT packet type
+  * @param dup the MQTT dup flag
+  * @param packetid the MQTT packet identifier
+  * @param reasonCode the reason code, 0x80 and above is a failure
+  * @param properties the ack properties, or NULL for none
+  * @return serialized length, or error if 0
+  */
+int MQTTV5Serialize_ack(unsigned char* buf, int buflen, unsigned char packettype, unsigned char dup, unsigned short packetid,
+		unsigned char reasonCode, MQTTProperties* properties)
+{
+	MQTTHeader header = {0};
+	int rc = 0;
+	int rem_len = 2;
+	unsigned char *ptr = buf;
+
+	FUNC_ENTRY;
+	if (reasonCode == MQTTREASONCODE_SUCCESS && properties == NULL)
+	{
+		rc = MQTTSerialize_ack(buf, buflen, packettype, dup, packetid);
+		goto exit;
+	}
+	rem_len += 1 + ((properties != NULL) ? MQTTProperties_len(properties) : 0);
+	if (MQTTPacket_len(rem_len) > buflen)
+	{
+		rc = MQTTPACKET_BUFFER_TOO_SHORT;
+		goto exit;
+	}
+	header.bits.type = packettype;
+	header.bits.dup = dup;
+	header.bits.qos = (packettype == PUBREL) ? 1 : 0;
+	writeChar(&ptr, header.byte); /* write header */
+
+	ptr += MQTTPacket_encode(ptr, rem_len); /* write remaining length */
+	writeInt(&ptr, packetid);
+	writeChar(&ptr, reasonCode);
+	if (properties != NULL)
+		MQTTProperties_write(&ptr, properties);
+	rc = ptr - buf;
+exit:
+	FUNC_EXIT_RC(rc);
+	return rc;
+}
+#endif
+
+
 /**
   * Serializes a puback packet into the supplied buffer.
   * @param buf the buffer into which the packet will be serialized
@@ -35,5 +35,24 @@ DLLExport int MQTTSerialize_suback(unsigned char* buf, int buflen, unsigned shor
 
 DLLExport int MQTTDeserialize_suback(unsigned short* packetid, int maxcount, int* count, int grantedQoSs[], unsigned char* buf, int len);
 
+#if defined(MQTTV5)
+/** MQTT 5 subscription options */
+typedef struct MQTTSubscribe_options
+{
+	unsigned char MaxQoS;             /**< the max QoS of the deliveries, the requested QoS of 3.1.1 */
+	unsigned char noLocal;            /**< 1: the messages published by this client are not delivered back */
+	unsigned char retainAsPublished;  /**< 1: the retained flag is kept as published */
+	unsigned char retainHandling;     /**< 0: send the retained messages, 1: only for a new subscription, 2: never */
+} MQTTSubscribe_options;
+
+#define MQTTSubscribe_options_initializer {0, 0, 0, 0}
+
+DLLExport int MQTTV5Serialize_subscribe(unsigned char* buf, int buflen, unsigned char dup, unsigned short packetid,
+		MQTTProperties* properties, int count, MQTTString topicFilters[], MQTTSubscribe_options options[]);
+
+DLLExport int MQTTV5Deserialize_suback(unsigned short* packetid, MQTTProperties* properties, int maxcount, int* count,
+		int reasonCodes[], unsigned char* buf, int len);
+#endif
+
 
 #endif /* MQTTSUBSCRIBE_H_ */
@@ -0,0 +1,322 @@
+/*
+ * mqtt_queue.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Daruin Solano
+ */
+
+#include <string.h>
+#include "mqtt_queue.h"
+#include "msg.h"
+
+#define MQTT_QUEUE_MAGIC    0x3151514DUL   /* "MQQ1" */
+
+enum { STAGED_SENT = 0, STAGED_DONE, STAGED_FAILED, STAGED_RESEND };
+
+static void mqtt_queue_complete(void* context, unsigned short id, int rc);
+
+
+static int slot_read(const mqtt_queue_t* q, uint32_t seq, size_t offset, void* buf, size_t len)
+{
+	return q->be->read(q->be, seq % q->be->slots, offset, buf, len);
+}
+
+
+static int slot_write(const mqtt_queue_t* q, uint32_t seq, size_t offset, const void* buf, size_t len)
+{
+	return q->be->write(q->be, seq % q->be->slots, offset, buf, len);
+}
+
+
+/* Free the oldest slot. The header is cleared so that it is not recovered after a reset. */
+static void pop(mqtt_queue_t* q)
+{
+	uint32_t magic = 0;
+
+	if (slot_write(q, q->tail_seq, 0, &magic, sizeof(magic)) != 0) {
+		msg_error("mqtt_queue: slot %lu release failed\n", (unsigned long)(q->tail_seq % q->be->slots));
+	}
+	q->tail_seq++;
+}
+
+
+/* Replace the payload of the newest message queued on the topic. */
+static int coalesce(mqtt_queue_t* q, const char* topic, uint16_t topic_len, const MQTTMessage* msg)
+{
+	char name[MQTT_QUEUE_TOPIC_MAX];
+	mqtt_queue_hdr_t hdr;
+	uint32_t magic = 0;
+	uint32_t seq;
+
+	for (seq = q->head_seq; seq-- != q->tail_seq; ) {
+		if ((slot_read(q, seq, 0, &hdr, sizeof(hdr)) != 0) || (hdr.magic != MQTT_QUEUE_MAGIC)
+				|| (hdr.topic_len != topic_len)
+				|| (slot_read(q, seq, sizeof(hdr), name, topic_len) != 0)
+				|| (memcmp(name, topic, topic_len) != 0)) {
+			continue;
+		}
+		/* Invalidate, rewrite, then validate: a reset in between loses this message only. */
+		hdr.gen++;
+		hdr.qos = msg->qos;
+		hdr.retained = msg->retained;
+		hdr.payload_len = msg->payloadlen;
+		if ((slot_write(q, seq, 0, &magic, sizeof(magic)) != 0)
+				|| (slot_write(q, seq, sizeof(hdr) + topic_len, msg->payload, msg->payloadlen) != 0)
+				|| (slot_write(q, seq, 0, &hdr, sizeof(hdr)) != 0)) {
+			return FAILURE;
+		}
+		return MQSUCCESS;
+	}
+	return FAILURE;
+}
+
+
+/* Read a message into its staging buffer and publish it. */
+static int stage(mqtt_queue_t* q, MQTTClient* c, uint32_t idx, uint32_t seq)
+{
+	mqtt_queue_staged_t* st = &q->staged[idx];
+	unsigned char* buf = q->stage + idx * q->be->slot_size;
+	mqtt_queue_hdr_t hdr;
+	MQTTMessage m;
+	int rc;
+
+	st->seq = seq;
+	st->id = 0;
+	if ((slot_read(q, seq, 0, &hdr, sizeof(hdr)) != 0) || (hdr.magic != MQTT_QUEUE_MAGIC) || (hdr.seq != seq)) {
+		st->gen = 0;
+		st->state = STAGED_DONE;	/* lost slot: released without publication */
+		return MQSUCCESS;
+	}
+	if (slot_read(q, seq, sizeof(hdr), buf, hdr.topic_len + hdr.payload_len) != 0) {
+		return FAILURE;
+	}
+	buf[hdr.topic_len - 1] = '\0';
+
+	memset(&m, 0, sizeof(m));
+	m.qos = (enum QoS)hdr.qos;
+	m.retained = hdr.retained;
+	m.payload = buf + hdr.topic_len;
+	m.payloadlen = hdr.payload_len;
+	st->gen = hdr.gen;
+	st->state = STAGED_SENT;
+
+	rc = MQTTPublishAsync(c, (const char*)buf, &m, q);
+	if ((rc == MQSUCCESS) && (st->state == STAGED_SENT)) {
+		st->id = m.id;	/* QoS0 is already complete */
+	}
+	return rc;
+}
+
+
+int mqtt_queue_init(mqtt_queue_t* q, const mqtt_queue_backend_t* be, mqtt_queue_policy_t policy, unsigned char* stage)
+{
+	mqtt_queue_hdr_t hdr;
+	bool found = false;
+	uint32_t slot;
+
+	memset(q, 0, sizeof(mqtt_queue_t));
+	q->be = be;
+	q->policy = policy;
+	q->stage = stage;
+	if ((be->slots == 0) || (be->slot_size <= sizeof(mqtt_queue_hdr_t)) || (stage == NULL)) {
+		return FAILURE;
+	}
+
+	/* Rebuild the queue from the slot headers: the valid slots hold consecutive positions. */
+	for (slot = 0; slot < be->slots; slot++) {
+		if (be->read(be, slot, 0, &hdr, sizeof(hdr)) != 0) {
+			msg_error("mqtt_queue: slot %lu read failed\n", (unsigned long)slot);
+			return FAILURE;
+		}
+		if ((hdr.magic != MQTT_QUEUE_MAGIC) || ((hdr.seq % be->slots) != slot)) {
+			continue;
+		}
+		if (!found || ((int32_t)(hdr.seq - q->tail_seq) < 0)) {
+			q->tail_seq = hdr.seq;
+		}
+		if (!found || ((int32_t)(hdr.seq + 1 - q->head_seq) > 0)) {
+			q->head_seq = hdr.seq + 1;
+		}
+		found = true;
+	}
+	if (mqtt_queue_count(q) > be->slots) {
+		msg_error("mqtt_queue: inconsistent storage, %lu messages dropped\n",
+				(unsigned long)(mqtt_queue_count(q) - be->slots));
+		q->tail_seq = q->head_seq - be->slots;
+	}
+	q->next_seq = q->tail_seq;
+	if (found) {
+		msg_info("mqtt_queue: %lu messages recovered\n", (unsigned long)mqtt_queue_count(q));
+	}
+	return MQSUCCESS;
+}
+
+
+/* Warning: the queue takes the publication completion handler of the client.
+ * Do not mix with other MQTTPublishAsync() callers. */
+int mqtt_queue_attach(mqtt_queue_t* q, MQTTClient* c)
+{
+	(void)q;
+	return MQTTSetInflightWindow(c, c->inflight_window, mqtt_queue_complete);
+}
+
+
+int mqtt_queue_push(mqtt_queue_t* q, const char* topic, const MQTTMessage* msg)
+{
+	mqtt_queue_hdr_t hdr;
+	size_t topic_len = strlen(topic) + 1;
+	uint32_t magic = 0;
+
+	if ((topic_len > MQTT_QUEUE_TOPIC_MAX) || (sizeof(hdr) + topic_len + msg->payloadlen > q->be->slot_size)) {
+		msg_error("mqtt_queue: message too large for a slot (%lu bytes)\n", (unsigned long)msg->payloadlen);
+		return BUFFER_OVERFLOW;
+	}
+
+	if (mqtt_queue_count(q) >= q->be->slots) {
+		if ((q->policy == MQTT_QUEUE_COALESCE_TOPIC) && (coalesce(q, topic, topic_len, msg) == MQSUCCESS)) {
+			q->coalesced++;
+			return MQSUCCESS;
+		}
+		/* Drop the oldest: its slot is the one written below. */
+		if (slot_write(q, q->tail_seq, 0, &magic, sizeof(magic)) != 0) {
+			return FAILURE;
+		}
+		q->tail_seq++;
+		q->dropped++;
+	}
+
+	hdr.magic = MQTT_QUEUE_MAGIC;
+	hdr.seq = q->head_seq;
+	hdr.gen = 0;
+	hdr.qos = msg->qos;
+	hdr.retained = msg->retained;
+	hdr.topic_len = topic_len;
+	hdr.payload_len = msg->payloadlen;
+	/* The header goes last: the slot is valid once complete. */
+	if ((slot_write(q, q->head_seq, sizeof(hdr), topic, topic_len) != 0)
+			|| (slot_write(q, q->head_seq, sizeof(hdr) + topic_len, msg->payload, msg->payloadlen) != 0)
+			|| (slot_write(q, q->head_seq, 0, &hdr, sizeof(hdr)) != 0)) {
+		msg_error("mqtt_queue: slot write failed\n");
+		return FAILURE;
+	}
+	q->head_seq++;
+	return MQSUCCESS;
+}
+
+
+int mqtt_queue_drain(mqtt_queue_t* q, MQTTClient* c)
+{
+	int rc = MQSUCCESS;
+
+	/* 1. Release the completed publications, in order. */
+	while (q->staged_count > 0) {
+		mqtt_queue_staged_t* st = &q->staged[q->staged_first];
+		mqtt_queue_hdr_t hdr;
+
+		if (st->state == STAGED_SENT) {
+			break;
+		}
+		if (st->state == STAGED_FAILED) {
+			/* The session was lost with all its publications: send again from the oldest. */
+			q->staged_count = 0;
+			q->next_seq = q->tail_seq;
+			break;
+		}
+		if ((st->state == STAGED_DONE) && (st->seq == q->tail_seq)
+				&& (slot_read(q, st->seq, 0, &hdr, sizeof(hdr)) == 0) && (hdr.magic == MQTT_QUEUE_MAGIC)
+				&& (hdr.gen != st->gen)) {
+			st->state = STAGED_RESEND;	/* coalesced while in flight: publish the new value */
+		}
+		if (st->state == STAGED_RESEND) {
+			if (MQTTIsConnected(c)) {
+				rc = stage(q, c, q->staged_first, st->seq);
+				if (rc == WINDOW_FULL) {
+					st->state = STAGED_RESEND;
+					rc = MQSUCCESS;
+				} else if (rc != MQSUCCESS) {
+					st->state = STAGED_FAILED;
+				}
+			}
+			break;
+		}
+		if (st->seq == q->tail_seq) {
+			pop(q);
+		}
+		/* else: dropped on overflow while in flight. */
+		q->staged_first = (q->staged_first + 1) % MQTT_QUEUE_MAX_BATCH;
+		q->staged_count--;
+	}
+
+	if (!MQTTIsConnected(c)) {
+		return rc;
+	}
+
+	/* 2. Keep the batch full. */
+	if ((int32_t)(q->next_seq - q->tail_seq) < 0) {
+		q->next_seq = q->tail_seq;
+	}
+	while ((rc == MQSUCCESS) && (q->staged_count < MQTT_QUEUE_MAX_BATCH) && (q->next_seq != q->head_seq)) {
+		uint32_t idx = (q->staged_first + q->staged_count) % MQTT_QUEUE_MAX_BATCH;
+
+		rc = stage(q, c, idx, q->next_seq);
+		if (rc == MQSUCCESS) {
+			q->staged_count++;
+			q->next_seq++;
+		}
+	}
+	return (rc == WINDOW_FULL) ? MQSUCCESS : rc;
+}
+
+
+uint32_t mqtt_queue_count(const mqtt_queue_t* q)
+{
+	return q->head_seq - q->tail_seq;
+}
+
+
+static void mqtt_queue_complete(void* context, unsigned short id, int rc)
+{
+	mqtt_queue_t* q = (mqtt_queue_t*)context;
+	uint32_t i;
+
+	for (i = 0; i < q->staged_count; i++) {
+		mqtt_queue_staged_t* st = &q->staged[(q->staged_first + i) % MQTT_QUEUE_MAX_BATCH];
+		if ((st->state == STAGED_SENT) && (st->id == id)) {
+			st->state = (rc == MQSUCCESS) ? STAGED_DONE : STAGED_FAILED;
+			return;
+		}
+	}
+	/* QoS0 completes within MQTTPublishAsync(), before the entry is counted. */
+	if (id == 0) {
+		mqtt_queue_staged_t* st = &q->staged[(q->staged_first + q->staged_count) % MQTT_QUEUE_MAX_BATCH];
+		if (st->state == STAGED_SENT) {
+			st->state = (rc == MQSUCCESS) ? STAGED_DONE : STAGED_FAILED;
+		}
+	}
+}
+
+
+/* RAM backend ---------------------------------------------------------------*/
+static int ram_read(const mqtt_queue_backend_t* be, uint32_t slot, size_t offset, void* buf, size_t len)
+{
+	memcpy(buf, (unsigned char*)be->ctx + slot * be->slot_size + offset, len);
+	return 0;
+}
+
+
+static int ram_write(const mqtt_queue_backend_t* be, uint32_t slot, size_t offset, const void* buf, size_t len)
+{
+	memcpy((unsigned char*)be->ctx + slot * be->slot_size + offset, buf, len);
+	return 0;
+}
+
+
+void mqtt_queue_ram_init(mqtt_queue_backend_t* be, unsigned char* mem, uint32_t slots, size_t slot_size)
+{
+	memset(mem, 0, MQTT_QUEUE_RAM_SIZE(slots, slot_size));
+	be->read = ram_read;
+	be->write = ram_write;
+	be->ctx = mem;
+	be->slots = slots;
+	be->slot_size = slot_size;
+}
@@ -0,0 +1,109 @@
+/*
+ * mqtt_queue.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Daruin Solano
+ *
+ *  Store-and-forward outbound queue for the MQTT client.
+ *
+ *  Publications are pushed whatever the link state, and drained in order
+ *  through MQTTPublishAsync() once connected: up to MQTT_QUEUE_MAX_BATCH
+ *  messages are in flight at a time, and a message leaves the queue only
+ *  when its publication completed.
+ *
+ *  The messages are stored in fixed-size slots of a backend:
+ *  - RAM ring (mqtt_queue_ram_init), lost on reset;
+ *  - block device (mqtt_queue_backend_t callbacks), e.g. a file on Linux
+ *    (mqtt_queue_file_open). The queue is rebuilt from the slot headers
+ *    when it is initialized, so the pending messages survive a reset.
+ *
+ *  When the queue is full, the overflow policy applies:
+ *  - MQTT_QUEUE_DROP_OLDEST: the oldest message is dropped;
+ *  - MQTT_QUEUE_COALESCE_TOPIC: the newest message queued on the same topic
+ *    is replaced by the new one, e.g. to keep the last value of a sensor.
+ *    Falls back to dropping the oldest if the topic is not queued.
+ *
+ *  Not thread-safe: push and drain from the same task, or lock around them.
+ */
+
+#ifndef MQTT_MQTT_QUEUE_MQTT_QUEUE_H_
+#define MQTT_MQTT_QUEUE_MQTT_QUEUE_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "MQTTClient.h"
+
+#if !defined(MQTT_QUEUE_MAX_BATCH)
+#define MQTT_QUEUE_MAX_BATCH      4     /* redefinable - messages in flight while draining */
+#endif
+#if !defined(MQTT_QUEUE_TOPIC_MAX)
+#define MQTT_QUEUE_TOPIC_MAX      100   /* redefinable - longest topic name, \0 included */
+#endif
+
+typedef enum {
+  MQTT_QUEUE_DROP_OLDEST = 0,
+  MQTT_QUEUE_COALESCE_TOPIC
+} mqtt_queue_policy_t;
+
+typedef struct mqtt_queue_backend_s mqtt_queue_backend_t;
+
+/** Slot storage. Offsets are relative to the beginning of the slot.
+ *  Both callbacks return 0 on success. */
+struct mqtt_queue_backend_s {
+  int  (*read)(const mqtt_queue_backend_t* be, uint32_t slot, size_t offset, void* buf, size_t len);
+  int  (*write)(const mqtt_queue_backend_t* be, uint32_t slot, size_t offset, const void* buf, size_t len);
+  void* ctx;                /**< Backend specific: RAM area, file... */
+  uint32_t slots;           /**< Number of slots. */
+  size_t slot_size;         /**< Bytes per slot: header, topic and payload. */
+};
+
+/** Header written at the beginning of each used slot. */
+typedef struct {
+  uint32_t magic;
+  uint32_t seq;             /**< Position in the queue. */
+  uint16_t gen;             /**< Bumped when the payload is coalesced. */
+  uint8_t  qos;
+  uint8_t  retained;
+  uint16_t topic_len;       /**< Including the \0 terminator. */
+  uint16_t payload_len;
+} mqtt_queue_hdr_t;
+
+typedef struct {
+  uint32_t seq;
+  uint16_t gen;
+  unsigned short id;        /**< Packet id, 0 for QoS0. */
+  int8_t   state;
+} mqtt_queue_staged_t;
+
+typedef struct {
+  const mqtt_queue_backend_t* be;
+  mqtt_queue_policy_t policy;
+  uint32_t tail_seq;        /**< Oldest message. */
+  uint32_t head_seq;        /**< Next message. */
+  uint32_t next_seq;        /**< Next message to be sent. */
+  unsigned char* stage;     /**< MQTT_QUEUE_MAX_BATCH buffers of slot_size bytes, the payloads in flight. */
+  mqtt_queue_staged_t staged[MQTT_QUEUE_MAX_BATCH];
+  uint32_t staged_first;
+  uint32_t staged_count;
+  uint32_t dropped;         /**< Statistics: messages lost on overflow. */
+  uint32_t coalesced;       /**< Statistics: messages replaced on overflow. */
+} mqtt_queue_t;
+
+/* Memory to be provided by the caller for the RAM backend and the staging buffers. */
+#define MQTT_QUEUE_RAM_SIZE(slots, slot_size)   ((slots) * (slot_size))
+#define MQTT_QUEUE_STAGE_SIZE(slot_size)        (MQTT_QUEUE_MAX_BATCH * (slot_size))
+
+int  mqtt_queue_init(mqtt_queue_t* q, const mqtt_queue_backend_t* be, mqtt_queue_policy_t policy, unsigned char* stage);
+int  mqtt_queue_attach(mqtt_queue_t* q, MQTTClient* c);
+int  mqtt_queue_push(mqtt_queue_t* q, const char* topic, const MQTTMessage* msg);
+int  mqtt_queue_drain(mqtt_queue_t* q, MQTTClient* c);
+uint32_t mqtt_queue_count(const mqtt_queue_t* q);
+
+void mqtt_queue_ram_init(mqtt_queue_backend_t* be, unsigned char* mem, uint32_t slots, size_t slot_size);
+#if defined(__linux__)
+int  mqtt_queue_file_open(mqtt_queue_backend_t* be, const char* path, uint32_t slots, size_t slot_size);
+void mqtt_queue_file_close(mqtt_queue_backend_t* be);
+#endif
+
+#endif /* MQTT_MQTT_QUEUE_MQTT_QUEUE_H_ */
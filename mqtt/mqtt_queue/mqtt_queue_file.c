@@ -0,0 +1,90 @@
+/*
+ * mqtt_queue_file.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Daruin Solano
+ *
+ *  Block device backend of the MQTT outbound queue on a Linux file:
+ *  one fixed-size block per slot. Used to test the recovery of the queue
+ *  across restarts on a host.
+ */
+
+#if defined(__linux__)
+#include <stdio.h>
+#include <string.h>
+#include "mqtt_queue.h"
+#include "msg.h"
+
+
+static int file_read(const mqtt_queue_backend_t* be, uint32_t slot, size_t offset, void* buf, size_t len)
+{
+	FILE* f = (FILE*)be->ctx;
+
+	if (fseek(f, (long)(slot * be->slot_size + offset), SEEK_SET) != 0) {
+		return -1;
+	}
+	return (fread(buf, 1, len, f) == len) ? 0 : -1;
+}
+
+
+static int file_write(const mqtt_queue_backend_t* be, uint32_t slot, size_t offset, const void* buf, size_t len)
+{
+	FILE* f = (FILE*)be->ctx;
+
+	if (fseek(f, (long)(slot * be->slot_size + offset), SEEK_SET) != 0) {
+		return -1;
+	}
+	if (fwrite(buf, 1, len, f) != len) {
+		return -1;
+	}
+	return (fflush(f) == 0) ? 0 : -1;
+}
+
+
+int mqtt_queue_file_open(mqtt_queue_backend_t* be, const char* path, uint32_t slots, size_t slot_size)
+{
+	static const unsigned char zero[64];
+	FILE* f = fopen(path, "r+b");
+	long size;
+
+	if (f == NULL) {
+		f = fopen(path, "w+b");
+	}
+	if (f == NULL) {
+		msg_error("mqtt_queue: cannot open %s\n", path);
+		return FAILURE;
+	}
+	/* Extend the file to the whole device: the new blocks read as free slots. */
+	if ((fseek(f, 0, SEEK_END) != 0) || ((size = ftell(f)) < 0)) {
+		fclose(f);
+		return FAILURE;
+	}
+	while ((size_t)size < slots * slot_size) {
+		size_t len = slots * slot_size - size;
+		len = (len < sizeof(zero)) ? len : sizeof(zero);
+		if (fwrite(zero, 1, len, f) != len) {
+			fclose(f);
+			return FAILURE;
+		}
+		size += len;
+	}
+	fflush(f);
+
+	be->read = file_read;
+	be->write = file_write;
+	be->ctx = f;
+	be->slots = slots;
+	be->slot_size = slot_size;
+	return MQSUCCESS;
+}
+
+
+void mqtt_queue_file_close(mqtt_queue_backend_t* be)
+{
+	if (be->ctx != NULL) {
+		fclose((FILE*)be->ctx);
+		be->ctx = NULL;
+	}
+}
+
+#endif /* __linux__ */
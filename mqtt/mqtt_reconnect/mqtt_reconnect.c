@@ -0,0 +1,116 @@
+/*
+ * mqtt_reconnect.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Daruin Solano
+ */
+
+#include "mqtt_reconnect.h"
+#include "msg.h"
+
+#include <string.h>
+
+
+/* xorshift32: enough to spread the attempts, and no dependency on the HAL RNG */
+static uint32_t jitter_next(mqtt_reconnect_t* r)
+{
+	uint32_t x = r->seed;
+
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	r->seed = x;
+	return x;
+}
+
+
+/* Delay drawn in [backoff / 2, backoff], then the backoff doubles up to max_ms. */
+static uint32_t backoff_next(mqtt_reconnect_t* r)
+{
+	uint32_t half = r->backoff_ms / 2;
+	uint32_t delay = half + jitter_next(r) % (r->backoff_ms - half + 1);
+
+	r->backoff_ms = (r->backoff_ms < r->max_ms / 2) ? (r->backoff_ms * 2) : r->max_ms;
+	return delay;
+}
+
+
+void mqtt_reconnect_init(mqtt_reconnect_t* r, mqtt_reconnect_fn_t connect, void* ctx, uint32_t (*tick)(void), uint32_t seed)
+{
+	memset(r, 0, sizeof(*r));
+	r->connect = connect;
+	r->ctx = ctx;
+	r->tick = tick;
+	r->min_ms = MQTT_RECONNECT_MIN_MS;
+	r->max_ms = MQTT_RECONNECT_MAX_MS;
+	r->full_after = MQTT_RECONNECT_FULL_AFTER;
+	r->up = true;
+	r->backoff_ms = r->min_ms;
+	r->seed = (seed != 0) ? seed : 0x9E3779B9u;	/* xorshift is stuck on 0 */
+}
+
+
+void mqtt_reconnect_lost(mqtt_reconnect_t* r)
+{
+	if (!r->up) {
+		return;
+	}
+	r->up = false;
+	r->down_since = r->tick();
+	r->attempts = 0;
+	r->backoff_ms = r->min_ms;
+	r->next_attempt = r->down_since + jitter_next(r) % (r->min_ms + 1);
+}
+
+
+int mqtt_reconnect_poll(mqtt_reconnect_t* r, bool connected)
+{
+	bool full;
+	uint32_t now;
+	uint32_t delay;
+
+	if (!connected) {
+		mqtt_reconnect_lost(r);
+	}
+	if (r->up) {
+		return MQSUCCESS;
+	}
+	if ((int32_t)(r->tick() - r->next_attempt) < 0) {
+		return FAILURE;
+	}
+
+	full = (r->attempts >= r->full_after) && ((r->attempts - r->full_after) % (r->full_after + 1) == 0);
+	r->attempts++;
+	msg_debug("MQTT: reconnection attempt %lu (%s)\n", (unsigned long)r->attempts, full ? "full" : "fast");
+
+	if (r->connect(r->ctx, full) != MQSUCCESS) {
+		delay = backoff_next(r);
+		r->next_attempt = r->tick() + delay;
+		msg_error("MQTT: reconnection attempt %lu failed, next in %lu ms\n", (unsigned long)r->attempts,
+				(unsigned long)delay);
+		return FAILURE;
+	}
+
+	now = r->tick();
+	r->up = true;
+	r->reconnects++;
+	if (full) {
+		r->full_reconnects++;
+	}
+	r->last_ms = now - r->down_since;
+	r->total_ms += r->last_ms;
+	if (r->last_ms > r->max_reconnect_ms) {
+		r->max_reconnect_ms = r->last_ms;
+	}
+	msg_info("MQTT: reconnected in %lu ms, %lu attempts (%s path)\n", (unsigned long)r->last_ms,
+			(unsigned long)r->attempts, full ? "full" : "fast");
+	return MQSUCCESS;
+}
+
+
+uint32_t mqtt_reconnect_wait_ms(const mqtt_reconnect_t* r)
+{
+	int32_t left = (int32_t)(r->next_attempt - r->tick());
+
+	return (r->up || (left <= 0)) ? 0 : (uint32_t)left;
+}
@@ -0,0 +1,85 @@
+/*
+ * mqtt_reconnect.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Daruin Solano
+ *
+ *  Reconnect supervisor of the MQTT client.
+ *
+ *  Once the session is lost, the reconnection attempts are paced by a
+ *  jittered exponential backoff: each delay is drawn between half and all
+ *  of the current backoff, which doubles from min_ms up to max_ms. The
+ *  first attempt is only delayed by up to min_ms, so that the devices of a
+ *  fleet do not all come back at the same time after a broker restart.
+ *
+ *  An attempt is made through the connect callback of the application:
+ *  - fast path: new socket to the cached broker address, no NTP nor DNS,
+ *    and the MQTT session resumed (cleansession 0): the client sends its
+ *    unacknowledged QoS1/2 publications again;
+ *  - full path, after full_after consecutive failures of the fast one:
+ *    the broker address is resolved again, e.g. it moved.
+ *
+ *  Metrics: the reconnect time of an outage runs from the loss of the
+ *  session to the successful attempt, backoff delays included.
+ *
+ *  Not thread-safe: call from the task of the MQTT client.
+ */
+
+#ifndef MQTT_MQTT_RECONNECT_MQTT_RECONNECT_H_
+#define MQTT_MQTT_RECONNECT_MQTT_RECONNECT_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "MQTTClient.h"
+
+#if !defined(MQTT_RECONNECT_MIN_MS)
+#define MQTT_RECONNECT_MIN_MS       1000    /* redefinable - first backoff */
+#endif
+#if !defined(MQTT_RECONNECT_MAX_MS)
+#define MQTT_RECONNECT_MAX_MS       30000   /* redefinable - backoff ceiling */
+#endif
+#if !defined(MQTT_RECONNECT_FULL_AFTER)
+#define MQTT_RECONNECT_FULL_AFTER   3       /* redefinable - failed fast attempts before a full one */
+#endif
+
+/** Reconnection attempt. full: false for the fast path, true for the full one.
+ *  @return MQSUCCESS once the MQTT session is up again */
+typedef int (*mqtt_reconnect_fn_t)(void* ctx, bool full);
+
+typedef struct {
+  mqtt_reconnect_fn_t connect;
+  void* ctx;
+  uint32_t (*tick)(void);       /**< Time in ms, e.g. HAL_GetTick. */
+  uint32_t min_ms;
+  uint32_t max_ms;
+  uint32_t full_after;
+  bool up;                      /**< Session up, as far as the supervisor knows. */
+  uint32_t backoff_ms;          /**< Current backoff: the next delay is drawn in [backoff / 2, backoff]. */
+  uint32_t next_attempt;        /**< Time of the next attempt, ms. */
+  uint32_t down_since;          /**< Time of the loss, ms. */
+  uint32_t attempts;            /**< Attempts of the current outage. */
+  uint32_t seed;                /**< Jitter generator state. */
+  /* Metrics */
+  uint32_t reconnects;          /**< Outages recovered. */
+  uint32_t full_reconnects;     /**< ... of which through the full path. */
+  uint32_t last_ms;             /**< Reconnect time of the last outage. */
+  uint32_t max_reconnect_ms;    /**< Longest reconnect time. */
+  uint32_t total_ms;            /**< Sum of the reconnect times, for the average. */
+} mqtt_reconnect_t;
+
+/** seed: distinct per device, e.g. from its MAC address, for distinct jitters. The session is assumed up. */
+void mqtt_reconnect_init(mqtt_reconnect_t* r, mqtt_reconnect_fn_t connect, void* ctx, uint32_t (*tick)(void), uint32_t seed);
+
+/** The session was just lost, e.g. a read or a publication failed: schedule the first attempt.
+ *  Nothing done if the loss is known already. */
+void mqtt_reconnect_lost(mqtt_reconnect_t* r);
+
+/** Make the attempt if it is due. connected: the state of the client, MQTTIsConnected(); a loss not
+ *  told by mqtt_reconnect_lost() is found here. @return MQSUCCESS if the session is up, FAILURE while
+ *  it is down. */
+int  mqtt_reconnect_poll(mqtt_reconnect_t* r, bool connected);
+
+/** Time until the next attempt, ms: 0 if due or up. */
+uint32_t mqtt_reconnect_wait_ms(const mqtt_reconnect_t* r);
+
+#endif /* MQTT_MQTT_RECONNECT_MQTT_RECONNECT_H_ */
@@ -14,6 +14,7 @@
 #include "stm32l475e_iot01_hsensor.h"
 #endif
 #include "cJSON.h"
+#include "json_writer.h"
 #include "rtc.h"
 #include "utils_datetime.h"
 #include "net.h"
@@ -175,6 +176,7 @@ void check_MqttConnection_Task(void* argument) {
 void mqtt_client_publish_task(MQTTClient* client){
 //	MQTTClient* client = (MQTTClient*) argument;
 	MQTTMessage mqmsg;
+	json_writer_t w;
 
 	for(;;){
 		snprintf(mqtt_pubtopic, MQTT_TOPIC_BUFFER_SIZE, "/sensors/%s",	dev.MQClientId);
@@ -184,28 +186,24 @@ void mqtt_client_publish_task(MQTTClient* client){
 		pub_data.humidity = BSP_HSENSOR_ReadHumidity();
 #endif
 		rtc_gettime(&rtc);
-		pub_data.ts = rtc.unixtime;
-
-		/*create Json object to publish data*/
-		cJSON* publish_data =cJSON_CreateObject();
-		cJSON_AddBoolToObject(publish_data, "LedOn", status_data.LedOn);
-		cJSON_AddNumberToObject(publish_data, "Temperature", (pub_data.temperature * 9.0 / 5.0) + 32.0);
-		cJSON_AddNumberToObject(publish_data, "Humidity", pub_data.humidity);
-		cJSON_AddNumberToObject(publish_data, "TelemetryInterval", pub_data.ts);
-		cJSON_AddStringToObject(publish_data, "MacAddress", pub_data.mac);
-		// Convert JSON to String
-		char *msg = cJSON_Print(publish_data);
-		strcpy(mqtt_msg, msg);
-		cJSON_Delete(publish_data);
-		rc = strlen(mqtt_msg);
-
-
-		if ((rc < 0) || (rc >= MQTT_MSG_BUFFER_SIZE)) {
+		pub_data.unixtime = rtc.unixtime;
+
+		/* compact JSON, written straight into the message buffer: no heap, no tree */
+		json_writer_init(&w, mqtt_msg, MQTT_MSG_BUFFER_SIZE);
+		json_write_bool(&w, "LedOn", status_data.LedOn);
+		json_write_float(&w, "Temperature", (pub_data.temperature * 9.0 / 5.0) + 32.0, 2);
+		json_write_float(&w, "Humidity", pub_data.humidity, 2);
+		json_write_uint(&w, "TelemetryInterval", pub_data.unixtime);
+		json_write_string(&w, "MacAddress", pub_data.mac);
+		rc = json_writer_end(&w);
+
+
+		if (rc < 0) {
 			msg_error("Telemetry message formatting error.\n");
 		} else {
 			mqmsg.qos = QOS0;
 			mqmsg.payload = (char*) mqtt_msg;
-			mqmsg.payloadlen = strlen(mqtt_msg);
+			mqmsg.payloadlen = rc;
 
 			rc = MQTTPublish(client, mqtt_pubtopic, &mqmsg);
 			if (rc != MQSUCCESS) {
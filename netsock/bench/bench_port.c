@@ -0,0 +1,709 @@
+/*
+ * bench_port.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Daruin Solano
+ *
+ *  Host (Linux) port used by the netsock benchmarks. See bench_port.h.
+ */
+
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <poll.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+#include "net.conf.h"
+#include "wifi.h"
+#include "MQTTPacket.h"
+#include "timedate.h"
+#include "timingSystem.h"
+#include "bench_port.h"
+
+/* Private defines -----------------------------------------------------------*/
+#define HEAP_HDR_SIZE   16      /* Keeps the returned blocks 16-byte aligned. */
+#define WIFI_CMD_OPEN           7       /* AT commands of ES_WIFI_StartClientConnection() */
+#define WIFI_CMD_MQTT_OPEN      10      /* AT commands of ES_WIFI_StartMQTTClientConnection() */
+#define WIFI_MQTT_PACKET_SIZE   2048
+#define WIFI_MQTT_TOPIC_SIZE    128
+#define WIFI_MQTT_KEEPALIVE     60      /* s */
+#define WIFI_MQTT_TIMEOUT       5000    /* ms, CONNACK and SUBACK */
+
+/* Private typedef -----------------------------------------------------------*/
+typedef struct {
+  bool on;                                  /* MQTT client of the module on the socket */
+  char pub_topic[WIFI_MQTT_TOPIC_SIZE];
+} wifi_mqtt_t;
+
+/* Private variables ---------------------------------------------------------*/
+RNG_HandleTypeDef hrng = { 0x2545F491 };
+net_hnd_t hnet;
+
+static __thread uint32_t rng_state;
+static __thread size_t heap_cur;
+static __thread size_t heap_peak;
+static __thread uint32_t heap_allocs;
+
+static int wifi_fd[WIFI_MAX_CONNECTIONS] = { -1, -1, -1, -1 };
+static uint32_t wifi_latency_us;
+static bench_wifi_stats_t wifi_stats;
+static wifi_mqtt_t wifi_mqtt[WIFI_MAX_CONNECTIONS];
+static unsigned char wifi_mqtt_buf[WIFI_MQTT_PACKET_SIZE];
+static int wifi_mqtt_fd = -1;              /* Socket of MQTTPacket_read() */
+
+/* Private functions ---------------------------------------------------------*/
+static void wifi_charge(void)
+{
+  if (wifi_latency_us != 0)
+  {
+    usleep(wifi_latency_us);
+  }
+}
+
+static void wifi_command(uint32_t count)
+{
+  wifi_stats.cmd_calls += count;
+  if (wifi_latency_us != 0)
+  {
+    usleep(wifi_latency_us * count);
+  }
+}
+
+/* CPU time of the module: from the entry of a WIFI_* call to its return. */
+static uint64_t wifi_enter(void)
+{
+  return bench_thread_cpu_us();
+}
+
+static void wifi_leave(uint64_t cpu0)
+{
+  wifi_stats.module_cpu_us += bench_thread_cpu_us() - cpu0;
+}
+
+/* Time ----------------------------------------------------------------------*/
+uint64_t bench_now_us(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t) ts.tv_sec * 1000000u + (uint64_t) ts.tv_nsec / 1000u;
+}
+
+uint64_t bench_thread_cpu_us(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+  return (uint64_t) ts.tv_sec * 1000000u + (uint64_t) ts.tv_nsec / 1000u;
+}
+
+uint32_t HAL_GetTick(void)
+{
+  return (uint32_t) (bench_now_us() / 1000u);
+}
+
+void HAL_Delay(uint32_t Delay)
+{
+  usleep(Delay * 1000u);
+}
+
+void TimerInit(Timer *timer)
+{
+  timer->end_ms = 0;
+}
+
+void TimerCountdownMS(Timer *timer, unsigned int timeout_ms)
+{
+  timer->end_ms = bench_now_us() / 1000u + timeout_ms;
+}
+
+void TimerCountdown(Timer *timer, unsigned int timeout)
+{
+  TimerCountdownMS(timer, timeout * 1000u);
+}
+
+int TimerLeftMS(Timer *timer)
+{
+  uint64_t now = bench_now_us() / 1000u;
+  return (timer->end_ms > now) ? (int) (timer->end_ms - now) : 0;
+}
+
+char TimerIsExpired(Timer *timer)
+{
+  return (TimerLeftMS(timer) > 0) ? 0 : 1;
+}
+
+/* RTC -----------------------------------------------------------------------*/
+/* The host clock is right: nothing to set from the network. */
+int setRTCTimeDateFromNetwork(bool force_apply)
+{
+  (void) force_apply;
+  return TD_OK;
+}
+
+void RTC_CalendarShow(uint8_t *showtime, uint8_t *showdate)
+{
+  showtime[0] = '\0';
+  showdate[0] = '\0';
+}
+
+/* RNG -----------------------------------------------------------------------*/
+void bench_rng_seed(uint32_t seed)
+{
+  rng_state = (seed != 0) ? seed : 1;
+}
+
+HAL_StatusTypeDef HAL_RNG_GenerateRandomNumber(RNG_HandleTypeDef *rng, uint32_t *random32bit)
+{
+  if (rng_state == 0)
+  {
+    bench_rng_seed(rng->seed);
+  }
+  rng_state ^= rng_state << 13;
+  rng_state ^= rng_state >> 17;
+  rng_state ^= rng_state << 5;
+  *random32bit = rng_state;
+  return HAL_OK;
+}
+
+/* Heap ----------------------------------------------------------------------*/
+void * heap_alloc(size_t n, size_t size)
+{
+  size_t len = n * size;
+  uint8_t *p;
+
+  if ((size != 0) && (len / size != n))
+  {
+    return NULL;
+  }
+  p = calloc(1, len + HEAP_HDR_SIZE);
+  if (p == NULL)
+  {
+    return NULL;
+  }
+  memcpy(p, &len, sizeof(len));
+  heap_cur += len;
+  heap_allocs++;
+  if (heap_cur > heap_peak)
+  {
+    heap_peak = heap_cur;
+  }
+  return p + HEAP_HDR_SIZE;
+}
+
+void heap_free(void * p)
+{
+  size_t len;
+
+  if (p == NULL)
+  {
+    return;
+  }
+  p = (uint8_t *) p - HEAP_HDR_SIZE;
+  memcpy(&len, p, sizeof(len));
+  heap_cur -= len;
+  free(p);
+}
+
+void bench_heap_reset(void)
+{
+  heap_peak = heap_cur;
+  heap_allocs = 0;
+}
+
+size_t bench_heap_current(void)
+{
+  return heap_cur;
+}
+
+size_t bench_heap_peak(void)
+{
+  return heap_peak;
+}
+
+uint32_t bench_heap_allocs(void)
+{
+  return heap_allocs;
+}
+
+/* Network interface ---------------------------------------------------------*/
+int net_if_init(void * if_ctxt)
+{
+  (void) if_ctxt;
+  return 0;
+}
+
+int net_if_deinit(void * if_ctxt)
+{
+  (void) if_ctxt;
+  return 0;
+}
+
+int net_if_reinit(void * if_ctxt)
+{
+  (void) if_ctxt;
+  return 0;
+}
+
+/* Emulated WiFi module ------------------------------------------------------*/
+void bench_wifi_set_latency_us(uint32_t us)
+{
+  wifi_latency_us = us;
+}
+
+void bench_wifi_stats_reset(void)
+{
+  memset(&wifi_stats, 0, sizeof(wifi_stats));
+}
+
+void bench_wifi_stats_get(bench_wifi_stats_t *stats)
+{
+  *stats = wifi_stats;
+}
+
+bool WIFI_Is_Connected(void)
+{
+  return true;
+}
+
+WIFI_Status_t WIFI_GetIP_Address(uint8_t *ipaddr, uint8_t IpAddrLength)
+{
+  static const uint8_t lo[4] = { 127, 0, 0, 1 };
+
+  if (IpAddrLength < 4)
+  {
+    return WIFI_STATUS_ERROR;
+  }
+  memcpy(ipaddr, lo, sizeof(lo));
+  return WIFI_STATUS_OK;
+}
+
+WIFI_Status_t WIFI_GetMAC_Address(uint8_t *mac, uint8_t MacLength)
+{
+  static const uint8_t addr[6] = { 0x02, 0x00, 0x00, 0x00, 0x00, 0x01 };
+
+  if (MacLength < 6)
+  {
+    return WIFI_STATUS_ERROR;
+  }
+  memcpy(mac, addr, sizeof(addr));
+  return WIFI_STATUS_OK;
+}
+
+WIFI_Status_t WIFI_GetHostAddress(const char *location, uint8_t *ipaddr, uint8_t IpAddrLength)
+{
+  struct addrinfo hints, *res = NULL;
+  WIFI_Status_t ret = WIFI_STATUS_ERROR;
+
+  if (IpAddrLength < 4)
+  {
+    return WIFI_STATUS_ERROR;
+  }
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_INET;
+  hints.ai_socktype = SOCK_STREAM;
+  if ((getaddrinfo(location, NULL, &hints, &res) == 0) && (res != NULL))
+  {
+    memcpy(ipaddr, &((struct sockaddr_in *) res->ai_addr)->sin_addr, 4);
+    ret = WIFI_STATUS_OK;
+  }
+  if (res != NULL)
+  {
+    freeaddrinfo(res);
+  }
+  return ret;
+}
+
+static WIFI_Status_t wifi_connect(uint32_t sock_id, const uint8_t *ipaddr, uint16_t port)
+{
+  struct sockaddr_in sa;
+  int one = 1;
+  int fd;
+
+  if ((sock_id >= WIFI_MAX_CONNECTIONS) || (wifi_fd[sock_id] >= 0))
+  {
+    return WIFI_STATUS_NOT_SUPPORTED;
+  }
+  fd = socket(AF_INET, SOCK_STREAM, 0);
+  if (fd < 0)
+  {
+    return WIFI_STATUS_ERROR;
+  }
+  memset(&sa, 0, sizeof(sa));
+  sa.sin_family = AF_INET;
+  sa.sin_port = htons(port);
+  memcpy(&sa.sin_addr, ipaddr, 4);
+  if (connect(fd, (struct sockaddr *) &sa, sizeof(sa)) != 0)
+  {
+    close(fd);
+    return WIFI_STATUS_ERROR;
+  }
+  /* The module pushes every WIFI_SendData() out immediately. */
+  setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+  wifi_fd[sock_id] = fd;
+  return WIFI_STATUS_OK;
+}
+
+static int wifi_send_all(int fd, const uint8_t *buf, size_t len)
+{
+  while (len > 0)
+  {
+    ssize_t n = send(fd, buf, len, MSG_NOSIGNAL);
+    if (n <= 0)
+    {
+      return -1;
+    }
+    buf += n;
+    len -= (size_t) n;
+  }
+  return 0;
+}
+
+static int wifi_mqtt_getdata(unsigned char *buf, int count)
+{
+  ssize_t n = recv(wifi_mqtt_fd, buf, (size_t) count, MSG_WAITALL);
+  return (n == count) ? count : -1;
+}
+
+/* Next packet of the broker, in wifi_mqtt_buf: its type, 0 on timeout, -1 if the connection is lost. */
+static int wifi_mqtt_read(int fd, uint32_t timeout_ms)
+{
+  struct pollfd pfd;
+  int type;
+
+  pfd.fd = fd;
+  pfd.events = POLLIN;
+  pfd.revents = 0;
+  if (poll(&pfd, 1, (int) timeout_ms) <= 0)
+  {
+    return 0;
+  }
+  wifi_mqtt_fd = fd;
+  type = MQTTPacket_read(wifi_mqtt_buf, sizeof(wifi_mqtt_buf), wifi_mqtt_getdata);
+  return (type > 0) ? type : -1;
+}
+
+/* MQTT client of the module: connection, then subscription to the one topic it delivers. */
+static WIFI_Status_t wifi_mqtt_connect(uint32_t sock_id, const uint8_t *ipaddr, const WiFi_MQTT_Config_t *config)
+{
+  MQTTPacket_connectData options = MQTTPacket_connectData_initializer;
+  MQTTString topic = MQTTString_initializer;
+  unsigned char present = 0;
+  unsigned char connack_rc = 0;
+  unsigned short id = 0;
+  int count = 0;
+  int granted = 0;
+  int qos = 0;
+  int len;
+  int fd;
+
+  if ((config == NULL) || (config->client_id == NULL) || (config->pub_topic == NULL) || (config->sub_topic == NULL)
+      || (strlen(config->pub_topic) >= WIFI_MQTT_TOPIC_SIZE))
+  {
+    return WIFI_STATUS_ERROR;
+  }
+  wifi_command(WIFI_CMD_MQTT_OPEN);
+  if (wifi_connect(sock_id, ipaddr, config->port) != WIFI_STATUS_OK)
+  {
+    return WIFI_STATUS_ERROR;
+  }
+  fd = wifi_fd[sock_id];
+
+  options.clientID.cstring = config->client_id;
+  options.keepAliveInterval = WIFI_MQTT_KEEPALIVE;
+  options.cleansession = 1;
+  len = MQTTSerialize_connect(wifi_mqtt_buf, sizeof(wifi_mqtt_buf), &options);
+  if ((len <= 0) || (wifi_send_all(fd, wifi_mqtt_buf, len) != 0)
+      || (wifi_mqtt_read(fd, WIFI_MQTT_TIMEOUT) != CONNACK)
+      || (MQTTDeserialize_connack(&present, &connack_rc, wifi_mqtt_buf, sizeof(wifi_mqtt_buf)) != 1)
+      || (connack_rc != 0))
+  {
+    goto fail;
+  }
+  topic.cstring = config->sub_topic;
+  len = MQTTSerialize_subscribe(wifi_mqtt_buf, sizeof(wifi_mqtt_buf), 0, 1, 1, &topic, &qos);
+  if ((len <= 0) || (wifi_send_all(fd, wifi_mqtt_buf, len) != 0)
+      || (wifi_mqtt_read(fd, WIFI_MQTT_TIMEOUT) != SUBACK)
+      || (MQTTDeserialize_suback(&id, 1, &count, &granted, wifi_mqtt_buf, sizeof(wifi_mqtt_buf)) != 1)
+      || (granted == 0x80))
+  {
+    goto fail;
+  }
+  wifi_mqtt[sock_id].on = true;
+  strcpy(wifi_mqtt[sock_id].pub_topic, config->pub_topic);
+  return WIFI_STATUS_OK;
+
+fail:
+  close(fd);
+  wifi_fd[sock_id] = -1;
+  return WIFI_STATUS_ERROR;
+}
+
+static WIFI_Status_t wifi_mqtt_publish(uint32_t sock_id, const uint8_t *pdata, uint16_t Reqlen)
+{
+  MQTTString topic = MQTTString_initializer;
+  int len;
+
+  topic.cstring = wifi_mqtt[sock_id].pub_topic;
+  len = MQTTSerialize_publish(wifi_mqtt_buf, sizeof(wifi_mqtt_buf), 0, 0, 0, 0, topic, (unsigned char *) pdata, Reqlen);
+  if ((len <= 0) || (wifi_send_all(wifi_fd[sock_id], wifi_mqtt_buf, len) != 0))
+  {
+    return WIFI_STATUS_ERROR;
+  }
+  return WIFI_STATUS_OK;
+}
+
+/* Payload of the next PUBLISH: the other packets (PINGRESP) are consumed by the module. */
+static WIFI_Status_t wifi_mqtt_receive(uint32_t sock_id, uint8_t *pdata, uint16_t Reqlen, uint16_t *RcvDatalen,
+                                       uint32_t Timeout)
+{
+  uint64_t deadline = bench_now_us() + (uint64_t) Timeout * 1000u;
+
+  for (;;)
+  {
+    uint64_t now = bench_now_us();
+    MQTTString topic;
+    unsigned char *payload;
+    unsigned char dup;
+    unsigned char retained;
+    unsigned short id;
+    int qos;
+    int len;
+    int type = wifi_mqtt_read(wifi_fd[sock_id], (now < deadline) ? (uint32_t) ((deadline - now + 999u) / 1000u) : 0);
+
+    if (type <= 0)
+    {
+      return (type == 0) ? WIFI_STATUS_OK : WIFI_STATUS_ERROR;
+    }
+    if ((type == PUBLISH)
+        && (MQTTDeserialize_publish(&dup, &qos, &retained, &id, &topic, &payload, &len,
+                                    wifi_mqtt_buf, sizeof(wifi_mqtt_buf)) == 1))
+    {
+      *RcvDatalen = (uint16_t) ((len < Reqlen) ? len : Reqlen);
+      memcpy(pdata, payload, *RcvDatalen);
+      return WIFI_STATUS_OK;
+    }
+  }
+}
+
+static WIFI_Status_t wifi_send(uint32_t sock_id, const uint8_t *pdata, uint16_t Reqlen, uint16_t *SentDatalen)
+{
+  ssize_t n;
+
+  *SentDatalen = 0;
+  if ((sock_id >= WIFI_MAX_CONNECTIONS) || (wifi_fd[sock_id] < 0))
+  {
+    return WIFI_STATUS_ERROR;
+  }
+  wifi_charge();
+  if (wifi_mqtt[sock_id].on)
+  {
+    if (wifi_mqtt_publish(sock_id, pdata, Reqlen) != WIFI_STATUS_OK)
+    {
+      return WIFI_STATUS_ERROR;
+    }
+    n = Reqlen;
+  }
+  else
+  {
+    n = send(wifi_fd[sock_id], pdata, Reqlen, MSG_NOSIGNAL);
+    if (n < 0)
+    {
+      return WIFI_STATUS_ERROR;
+    }
+  }
+  *SentDatalen = (uint16_t) n;
+  wifi_stats.send_calls++;
+  wifi_stats.bytes_sent += (uint64_t) n;
+  return WIFI_STATUS_OK;
+}
+
+static WIFI_Status_t wifi_receive(uint32_t sock_id, uint8_t *pdata, uint16_t Reqlen, uint16_t *RcvDatalen,
+                                  uint32_t Timeout)
+{
+  struct pollfd pfd;
+  ssize_t n;
+
+  *RcvDatalen = 0;
+  if ((sock_id >= WIFI_MAX_CONNECTIONS) || (wifi_fd[sock_id] < 0))
+  {
+    return WIFI_STATUS_ERROR;
+  }
+  wifi_charge();
+  if (wifi_mqtt[sock_id].on)
+  {
+    if (wifi_mqtt_receive(sock_id, pdata, Reqlen, RcvDatalen, Timeout) != WIFI_STATUS_OK)
+    {
+      return WIFI_STATUS_ERROR;
+    }
+    n = *RcvDatalen;
+  }
+  else
+  {
+    pfd.fd = wifi_fd[sock_id];
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+    if (poll(&pfd, 1, (int) Timeout) <= 0)
+    {
+      return WIFI_STATUS_OK;  /* Timeout: no data, as the module reports it. */
+    }
+    n = recv(wifi_fd[sock_id], pdata, Reqlen, 0);
+    if (n <= 0)
+    {
+      return WIFI_STATUS_ERROR;  /* Closed by the peer. */
+    }
+    *RcvDatalen = (uint16_t) n;
+  }
+  if (n > 0)
+  {
+    wifi_stats.recv_calls++;
+    wifi_stats.bytes_recv += (uint64_t) n;
+  }
+  return WIFI_STATUS_OK;
+}
+
+/* TLS of the module: plain TCP, the module does the crypto. */
+WIFI_Status_t WIFI_OpenClientConnection(uint32_t sock_id, WIFI_Protocol_t type, ES_WIFI_TLS_SEC_MODE_t secmode,
+                                        const uint8_t *ipaddr, uint16_t port, uint16_t local_port)
+{
+  uint64_t cpu0 = wifi_enter();
+  WIFI_Status_t ret = WIFI_STATUS_NOT_SUPPORTED;
+
+  (void) secmode;
+  (void) local_port;
+  if ((type == WIFI_TCP_PROTOCOL) || (type == WIFI_TLS_PROTOCOL))
+  {
+    wifi_command(WIFI_CMD_OPEN);
+    ret = wifi_connect(sock_id, ipaddr, port);
+  }
+  wifi_leave(cpu0);
+  return ret;
+}
+
+WIFI_Status_t WIFI_SetCertificatesCredentials(WiFi_Tls_t *identity, WiFi_CredMode_t mode)
+{
+  (void) mode;
+  /* One store command per credential. */
+  wifi_command((identity->tls_ca_certs != NULL) + (identity->tls_dev_cert != NULL) + (identity->tls_dev_key != NULL));
+  return WIFI_STATUS_OK;
+}
+
+WIFI_Status_t WIFI_MQTTIoTConnect(uint32_t socket, const uint8_t *ip_addr, const WiFi_MQTT_Config_t *config)
+{
+  uint64_t cpu0 = wifi_enter();
+  WIFI_Status_t ret = WIFI_STATUS_NOT_SUPPORTED;
+
+  if ((socket < WIFI_MAX_CONNECTIONS) && (wifi_fd[socket] < 0))
+  {
+    ret = wifi_mqtt_connect(socket, ip_addr, config);
+  }
+  wifi_leave(cpu0);
+  return ret;
+}
+
+WIFI_Status_t WIFI_CloseClientConnection(uint32_t sock_id)
+{
+  uint64_t cpu0 = wifi_enter();
+
+  if ((sock_id >= WIFI_MAX_CONNECTIONS) || (wifi_fd[sock_id] < 0))
+  {
+    wifi_leave(cpu0);
+    return WIFI_STATUS_ERROR;
+  }
+  if (wifi_mqtt[sock_id].on)
+  {
+    int len = MQTTSerialize_disconnect(wifi_mqtt_buf, sizeof(wifi_mqtt_buf));
+    if (len > 0)
+    {
+      (void) wifi_send_all(wifi_fd[sock_id], wifi_mqtt_buf, len);
+    }
+    wifi_mqtt[sock_id].on = false;
+  }
+  close(wifi_fd[sock_id]);
+  wifi_fd[sock_id] = -1;
+  wifi_leave(cpu0);
+  return WIFI_STATUS_OK;
+}
+
+WIFI_Status_t WIFI_SendData(uint32_t sock_id, const uint8_t *pdata, uint16_t Reqlen, uint16_t *SentDatalen,
+                            uint32_t Timeout)
+{
+  uint64_t cpu0 = wifi_enter();
+  WIFI_Status_t ret;
+
+  (void) Timeout;
+  ret = wifi_send(sock_id, pdata, Reqlen, SentDatalen);
+  wifi_leave(cpu0);
+  return ret;
+}
+
+WIFI_Status_t WIFI_SendDataTo(uint32_t sock_id, const uint8_t *pdata, uint16_t Reqlen, uint16_t *SentDatalen,
+                              uint32_t Timeout, const uint8_t *ipaddr, uint16_t port)
+{
+  (void) ipaddr;
+  (void) port;
+  return WIFI_SendData(sock_id, pdata, Reqlen, SentDatalen, Timeout);
+}
+
+WIFI_Status_t WIFI_ReceiveData(uint32_t sock_id, uint8_t *pdata, uint16_t Reqlen, uint16_t *RcvDatalen,
+                               uint32_t Timeout)
+{
+  uint64_t cpu0 = wifi_enter();
+  WIFI_Status_t ret = wifi_receive(sock_id, pdata, Reqlen, RcvDatalen, Timeout);
+
+  wifi_leave(cpu0);
+  return ret;
+}
+
+WIFI_Status_t WIFI_ReceiveDataFrom(uint32_t sock_id, uint8_t *pdata, uint16_t Reqlen, uint16_t *RcvDatalen,
+                                   uint32_t Timeout, uint8_t *ipaddr, uint8_t IpAddrLength, uint16_t *port)
+{
+  (void) ipaddr;
+  (void) IpAddrLength;
+  *port = 0;
+  return WIFI_ReceiveData(sock_id, pdata, Reqlen, RcvDatalen, Timeout);
+}
+
+/* Loopback listener ---------------------------------------------------------*/
+int bench_listen(uint16_t *port)
+{
+  struct sockaddr_in sa;
+  socklen_t salen = sizeof(sa);
+  int one = 1;
+  int fd = socket(AF_INET, SOCK_STREAM, 0);
+
+  if (fd < 0)
+  {
+    return -1;
+  }
+  setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+  memset(&sa, 0, sizeof(sa));
+  sa.sin_family = AF_INET;
+  sa.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  sa.sin_port = htons(*port);   /* 0: ephemeral */
+  if ((bind(fd, (struct sockaddr *) &sa, sizeof(sa)) != 0) || (listen(fd, 4) != 0)
+      || (getsockname(fd, (struct sockaddr *) &sa, &salen) != 0))
+  {
+    close(fd);
+    return -1;
+  }
+  *port = ntohs(sa.sin_port);
+  return fd;
+}
+
+int bench_accept(int lfd)
+{
+  int one = 1;
+  int fd = accept(lfd, NULL, NULL);
+
+  if (fd >= 0)
+  {
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+  }
+  return fd;
+}
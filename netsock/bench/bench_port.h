@@ -0,0 +1,69 @@
+/*
+ * bench_port.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Daruin Solano
+ *
+ *  Host (Linux) port used by the netsock benchmarks.
+ *
+ *  - HAL_GetTick()/HAL_Delay() on the monotonic clock.
+ *  - HAL_RNG on a seeded xorshift generator so that every run draws the same
+ *    "random" bytes (entropy_hardware_poll.c is linked unchanged).
+ *  - heap_alloc()/heap_free() with per-thread current/peak counters.
+ *  - The WIFI_* socket primitives of the es-WiFi module emulated on POSIX
+ *    TCP sockets, so that net_tcp_wifi.c is linked unchanged too. Every
+ *    WIFI_SendData()/WIFI_ReceiveData() call is counted as one module
+ *    transaction and may be charged a fixed latency to mimic the SPI link;
+ *    the connection setups are charged one latency per AT command of the
+ *    es_wifi.c driver.
+ *  - The TLS of the module (WIFI_TLS_PROTOCOL) as plain TCP: its crypto is
+ *    not the MCU's, the peer must be a plain TCP one.
+ *  - The MQTT client of the module (WIFI_MQTTIoTConnect()), built on the
+ *    mqtt_packet codecs: CONNECT and SUBSCRIBE of the configured topic,
+ *    each WIFI_SendData() is a QoS0 PUBLISH of the configured topic, each
+ *    WIFI_ReceiveData() returns the payload of one PUBLISH received.
+ *  - Timer, RTC and NTP stubs of net_mqtt.c and the MQTT client.
+ *
+ *  The CPU time spent in the emulated module (its MQTT client, the socket
+ *  calls standing for the SPI transfers) is the module's, not the MCU's:
+ *  it is accounted apart, in bench_wifi_stats_t.module_cpu_us.
+ */
+
+#ifndef BENCH_PORT_H_
+#define BENCH_PORT_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+typedef struct {
+  uint32_t send_calls;    /**< WIFI_SendData() transactions. */
+  uint32_t recv_calls;    /**< WIFI_ReceiveData() transactions returning data. */
+  uint64_t bytes_sent;
+  uint64_t bytes_recv;
+  uint32_t cmd_calls;     /**< AT commands of the connection setups and credentials. */
+  uint64_t module_cpu_us; /**< CPU time of the calling threads inside the emulated module. */
+} bench_wifi_stats_t;
+
+/* Time */
+uint64_t bench_now_us(void);
+uint64_t bench_thread_cpu_us(void);
+
+/* RNG: seeds the calling thread's generator. */
+void bench_rng_seed(uint32_t seed);
+
+/* Heap accounting of the calling thread. */
+void bench_heap_reset(void);
+size_t bench_heap_current(void);
+size_t bench_heap_peak(void);
+uint32_t bench_heap_allocs(void);
+
+/* Emulated WiFi module */
+void bench_wifi_set_latency_us(uint32_t us);
+void bench_wifi_stats_reset(void);
+void bench_wifi_stats_get(bench_wifi_stats_t *stats);
+
+/* Loopback listener helpers for the in-process peers. */
+int bench_listen(uint16_t *port);
+int bench_accept(int lfd);
+
+#endif /* BENCH_PORT_H_ */
@@ -0,0 +1,19 @@
+/*
+ * ansi.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Daruin Solano
+ *
+ *  Host (Linux) stand-in: no colors in benchmark output.
+ */
+
+#ifndef BENCH_HOST_ANSI_H_
+#define BENCH_HOST_ANSI_H_
+
+#define ANSI_RESET   ""
+#define ANSI_RED     ""
+#define ANSI_GREEN   ""
+#define ANSI_YELLOW  ""
+#define ANSI_CYAN    ""
+
+#endif /* BENCH_HOST_ANSI_H_ */
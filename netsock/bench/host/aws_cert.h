@@ -0,0 +1,13 @@
+/*
+ * aws_cert.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Daruin Solano
+ *
+ *  Host (Linux) stand-in: the benchmarks use the mbedTLS test credentials.
+ */
+
+#ifndef BENCH_HOST_AWS_CERT_H_
+#define BENCH_HOST_AWS_CERT_H_
+
+#endif /* BENCH_HOST_AWS_CERT_H_ */
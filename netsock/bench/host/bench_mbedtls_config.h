@@ -0,0 +1,21 @@
+/*
+ * bench_mbedtls_config.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Daruin Solano
+ *
+ *  MBEDTLS_USER_CONFIG_FILE for the host benchmarks.
+ *  The device configuration (Http/inc/httpclient_mbedtls_config.h) is used
+ *  unchanged; only the server side needed by the in-process peer is added.
+ */
+
+#ifndef BENCH_MBEDTLS_CONFIG_H_
+#define BENCH_MBEDTLS_CONFIG_H_
+
+#define MBEDTLS_SSL_SRV_C
+
+/* The RSA test certificates shipped with mbed TLS 2.6.1 (certs.c) are
+ * SHA-1 signed; accept them so that the RSA cases can verify the peer. */
+#define MBEDTLS_TLS_DEFAULT_ALLOW_SHA1_IN_CERTIFICATES
+
+#endif /* BENCH_MBEDTLS_CONFIG_H_ */
@@ -0,0 +1,20 @@
+/*
+ * heap.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Daruin Solano
+ *
+ *  Host (Linux) stand-in for the target allocator overloading.
+ *  heap_alloc()/heap_free() are implemented in bench_port.c and keep
+ *  per-thread usage counters so that the benchmarks can report peak heap.
+ */
+
+#ifndef BENCH_HOST_HEAP_H_
+#define BENCH_HOST_HEAP_H_
+
+#include <stddef.h>
+
+void * heap_alloc(size_t n, size_t size);
+void heap_free(void * p);
+
+#endif /* BENCH_HOST_HEAP_H_ */
@@ -0,0 +1,15 @@
+/*
+ * main.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Daruin Solano
+ *
+ *  Host (Linux) stand-in for the board main.h.
+ */
+
+#ifndef BENCH_HOST_MAIN_H_
+#define BENCH_HOST_MAIN_H_
+
+#include "stm32l4xx_hal.h"
+
+#endif /* BENCH_HOST_MAIN_H_ */
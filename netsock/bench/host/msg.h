@@ -0,0 +1,28 @@
+/*
+ * msg.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Daruin Solano
+ *
+ *  Host (Linux) stand-in for common/msg.h.
+ *  Only errors are printed: the per-call debug traces of the TLS socket
+ *  would otherwise dominate the measurements.
+ */
+
+#ifndef __MSG_H__
+#define __MSG_H__
+
+#include <stdlib.h>
+#include <stdio.h>
+
+#define msg_debug(...)
+#define msg_info(...)
+#define msg_warning(...)
+#define msg_error(...)  \
+	{ \
+	fprintf(stderr, "[ERROR]: %s L#%d " , __func__, __LINE__); \
+	fprintf(stderr, __VA_ARGS__ ); \
+	fprintf(stderr, "\r\n");\
+	}
+
+#endif /* __MSG_H__ */
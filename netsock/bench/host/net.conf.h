@@ -0,0 +1,57 @@
+/*
+ * net.conf.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Daruin Solano
+ *
+ *  Host (Linux) replacement of netsock/inc/net.conf.h.
+ *  It is force-included (-include) before any netsock source and reuses the
+ *  same include guard, so the board configuration is never pulled in.
+ *
+ *  BENCH_WIFI_TLS builds the netsock of the boards without mbedTLS: TLS and
+ *  MQTT of the es-WiFi module (net_tls_wifi.c).
+ */
+
+#ifndef HTTP_INC_EXT_INCLUDES_H_
+#define HTTP_INC_EXT_INCLUDES_H_
+
+/* Includes ------------------------------------------------------------------*/
+#include "stm32l4xx_hal.h"
+
+#define USE_WIFI
+#ifndef BENCH_WIFI_TLS
+#define USE_MBED_TLS
+#endif
+
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+
+#include "net.h"
+#include "msg.h"
+
+#ifdef USE_MBED_TLS
+extern int mbedtls_hardware_poll( void *data, unsigned char *output, size_t len, size_t *olen );
+#endif /* USE_MBED_TLS */
+
+/* Exported constants --------------------------------------------------------*/
+#define NET_IF  NET_IF_WLAN
+
+/* Exported types ------------------------------------------------------------*/
+/* Timer of the MQTT client, on the monotonic clock of bench_port.c. */
+typedef struct Timer {
+  uint64_t end_ms;
+} Timer;
+
+/* Exported functions --------------------------------------------------------*/
+extern void TimerInit(Timer*);
+extern char TimerIsExpired(Timer*);
+extern void TimerCountdownMS(Timer*, unsigned int);
+extern void TimerCountdown(Timer*, unsigned int);
+extern int TimerLeftMS(Timer*);
+
+extern RNG_HandleTypeDef hrng;
+extern net_hnd_t hnet;
+
+#endif /* HTTP_INC_EXT_INCLUDES_H_ */
@@ -0,0 +1,14 @@
+/*
+ * rtc.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Daruin Solano
+ *
+ *  Host (Linux) stand-in for ntp/inc/rtc.h: nothing of it is used by the
+ *  netsock sources built for the benchmarks.
+ */
+
+#ifndef BENCH_HOST_RTC_H_
+#define BENCH_HOST_RTC_H_
+
+#endif /* BENCH_HOST_RTC_H_ */
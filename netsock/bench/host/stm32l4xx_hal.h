@@ -0,0 +1,34 @@
+/*
+ * stm32l4xx_hal.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Daruin Solano
+ *
+ *  Host (Linux) stand-in for the few HAL symbols the netsock layer touches.
+ *  Only used by the netsock/bench programs; never on the target include path.
+ */
+
+#ifndef BENCH_HOST_STM32L4XX_HAL_H_
+#define BENCH_HOST_STM32L4XX_HAL_H_
+
+#include <stdint.h>
+#include <string.h>
+#include <stdio.h>
+
+typedef enum
+{
+  HAL_OK       = 0x00U,
+  HAL_ERROR    = 0x01U,
+  HAL_BUSY     = 0x02U,
+  HAL_TIMEOUT  = 0x03U
+} HAL_StatusTypeDef;
+
+typedef struct { uint32_t seed; } RNG_HandleTypeDef;
+typedef struct { int unused; } SPI_HandleTypeDef;
+typedef struct { int unused; } RTC_HandleTypeDef;
+
+uint32_t HAL_GetTick(void);
+void HAL_Delay(uint32_t Delay);
+HAL_StatusTypeDef HAL_RNG_GenerateRandomNumber(RNG_HandleTypeDef *hrng, uint32_t *random32bit);
+
+#endif /* BENCH_HOST_STM32L4XX_HAL_H_ */
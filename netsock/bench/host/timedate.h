@@ -0,0 +1,21 @@
+/*
+ * timedate.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Daruin Solano
+ *
+ *  Host (Linux) stand-in for Time/inc/timedate.h: the NTP setting of the
+ *  RTC, a no-op in bench_port.c.
+ */
+
+#ifndef BENCH_HOST_TIMEDATE_H_
+#define BENCH_HOST_TIMEDATE_H_
+
+#include <stdbool.h>
+
+#define TD_OK             0
+#define TD_ERR_RTC       -3   /**< Could not set the RTC. */
+
+int setRTCTimeDateFromNetwork(bool force_apply);
+
+#endif /* BENCH_HOST_TIMEDATE_H_ */
@@ -0,0 +1,18 @@
+/*
+ * timingSystem.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Daruin Solano
+ *
+ *  Host (Linux) stand-in for Time/inc/timingSystem.h: the RTC calendar
+ *  display only, implemented in bench_port.c.
+ */
+
+#ifndef BENCH_HOST_TIMINGSYSTEM_H_
+#define BENCH_HOST_TIMINGSYSTEM_H_
+
+#include <stdint.h>
+
+extern void RTC_CalendarShow(uint8_t *showtime, uint8_t *showdate);
+
+#endif /* BENCH_HOST_TIMINGSYSTEM_H_ */
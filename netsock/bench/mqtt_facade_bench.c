@@ -0,0 +1,624 @@
+/*
+ * mqtt_facade_bench.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Daruin Solano
+ *
+ *  The backends of the MQTT facade (mqtt/mqtt_facade) compared on the
+ *  emulated es-WiFi module of bench_port.c, the same application calls for
+ *  all of them:
+ *  - default build (USE_MBED_TLS): "paho/mbedtls", the Paho client and
+ *    mbedTLS on the MCU, against an mbedTLS server in front of the broker;
+ *  - WIFI_TLS=1 build (no mbedTLS on the MCU): "paho/module-tls", the Paho
+ *    client over the TLS socket of the module, and "module", the MQTT client
+ *    of the module (NET_PROTO_MQTT socket). The emulated module talks plain
+ *    TCP to the broker: its TLS is not the MCU's work.
+ *  The broker is mqtt_broker (mqtt/mqtt_broker), in a thread of its own.
+ *
+ *  Per backend, over -n connections of -m publications each:
+ *  - connection: the first one (DNS, RTC, credentials) and the
+ *    reconnections (mqtt_facade_connect(), fast path), wall time p50/p90 and
+ *    MCU CPU time p50, with the AT commands of the module per connection;
+ *  - publication: the client publishes on the topic it is subscribed to.
+ *    Latency from mqtt_facade_publish() to the delivery of the message back
+ *    by mqtt_facade_poll(), p50/p99, MCU CPU time per publication (publish
+ *    and delivery) and module transactions per publication;
+ *  - RAM: peak heap of the client (mbedTLS allocations through heap_alloc())
+ *    and size of the backend state held in mqtt_facade_t (client, buffers).
+ *
+ *  MCU CPU time is the CPU time of the client thread minus the time spent in
+ *  the emulated module (bench_wifi_stats_t.module_cpu_us). The wall-clock
+ *  figures include the work of the broker and of the TLS server, which run
+ *  on the same machine, and the latency charged by -l to every module
+ *  transaction and AT command, standing for the SPI link.
+ *
+ *  Build and run: make -C netsock/bench mqtt-compare
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <errno.h>
+#include <unistd.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sys/socket.h>
+
+#include "net_internal.h"
+#include "mqtt_facade.h"
+#include "mqtt_broker.h"
+#include "bench_port.h"
+
+/* Private defines -----------------------------------------------------------*/
+#define BENCH_SERVER_NAME       "localhost"   /* CN of the mbedTLS test server certificates. */
+#define BENCH_CLIENT_ID         "IOT_STM32"
+#define BENCH_TOPIC             "/devices/IOT_STM32/telemetry"
+#define BENCH_DEFAULT_CONNECTS  20
+#define BENCH_DEFAULT_PUBLISHES 50
+#define BENCH_DEFAULT_PAYLOAD   96            /* The telemetry of mqtt_app.c, about. */
+#define BENCH_MAX_PAYLOAD       (MQTT_SEND_BUFFER_SIZE - 64)
+#define BENCH_ECHO_TIMEOUT_US   5000000u
+#define BENCH_POLL_MS           100
+
+#ifdef USE_MBED_TLS
+#define BENCH_VARIANT           "MCU TLS (mbedTLS)"
+#else
+#define BENCH_VARIANT           "module TLS (no mbedTLS)"
+#endif
+
+/* Private typedef -----------------------------------------------------------*/
+typedef struct {
+  const char * name;
+  mqtt_facade_backend_t backend;
+} bench_case_t;
+
+typedef struct {
+  int connects;
+  int publishes;
+  size_t payload;
+  enum QoS qos;
+  uint32_t seed;
+  uint32_t latency_us;
+} bench_opts_t;
+
+typedef struct {
+  int fd;                       /**< -1: free. */
+#ifdef USE_MBED_TLS
+  mbedtls_ssl_context ssl;
+#endif
+} bench_conn_t;
+
+typedef struct {
+  int lfd;
+  volatile int stop;
+  int rc;
+  uint32_t seed;
+  bench_conn_t conns[MQTT_BROKER_MAX_CLIENTS];
+  mqtt_broker_t broker;
+#ifdef USE_MBED_TLS
+  mbedtls_entropy_context entropy;
+  mbedtls_ctr_drbg_context ctr_drbg;
+  mbedtls_ssl_config conf;
+  mbedtls_x509_crt srvcert;
+  mbedtls_pk_context pkey;
+#endif
+} bench_server_t;
+
+typedef struct {
+  uint32_t expected;            /**< Sequence number of the publication in flight. */
+  uint64_t echo_us;             /**< Time of its delivery, 0 until then. */
+} bench_echo_t;
+
+/* Private variables ---------------------------------------------------------*/
+static const bench_case_t bench_cases[] =
+{
+#ifdef USE_MBED_TLS
+  { "paho/mbedtls",    MQTT_FACADE_PAHO },
+#else
+  { "paho/module-tls", MQTT_FACADE_PAHO },
+  { "module",          MQTT_FACADE_MODULE },
+#endif
+};
+
+#ifndef USE_MBED_TLS
+/* The emulated module takes any content: it stands for the certificate stored in the module. */
+static const char bench_module_ca[] = "-----BEGIN CERTIFICATE-----\n(module root CA)\n-----END CERTIFICATE-----\n";
+#endif
+
+static bench_server_t bench_server;
+static mqtt_facade_t bench_facade;
+
+/* Private functions ---------------------------------------------------------*/
+static int bench_cmp_double(const void * a, const void * b)
+{
+  double x = *(const double *) a;
+  double y = *(const double *) b;
+  return (x > y) - (x < y);
+}
+
+/* Nearest-rank percentile of a sorted array. */
+static double bench_percentile(const double * v, int n, int pct)
+{
+  int rank = (pct * n + 99) / 100;
+  return v[(rank > 0) ? rank - 1 : 0];
+}
+
+/* Broker side ---------------------------------------------------------------*/
+#ifdef USE_MBED_TLS
+static int bench_fd_send(void * ctx, const unsigned char * buf, size_t len)
+{
+  ssize_t n = send(*(int *) ctx, buf, len, MSG_NOSIGNAL);
+  return (n < 0) ? MBEDTLS_ERR_SSL_INTERNAL_ERROR : (int) n;
+}
+
+static int bench_fd_recv(void * ctx, unsigned char * buf, size_t len)
+{
+  ssize_t n = recv(*(int *) ctx, buf, len, 0);
+  return (n < 0) ? MBEDTLS_ERR_SSL_INTERNAL_ERROR : (int) n;
+}
+
+/* Once connected: the broker polls its sessions. */
+static int bench_fd_recv_nb(void * ctx, unsigned char * buf, size_t len)
+{
+  ssize_t n = recv(*(int *) ctx, buf, len, MSG_DONTWAIT);
+  if ((n < 0) && ((errno == EAGAIN) || (errno == EWOULDBLOCK)))
+  {
+    return MBEDTLS_ERR_SSL_WANT_READ;
+  }
+  return (n < 0) ? MBEDTLS_ERR_SSL_INTERNAL_ERROR : (int) n;
+}
+#endif /* USE_MBED_TLS */
+
+static int bench_conn_recv(void * conn, uint8_t * buf, size_t len)
+{
+  bench_conn_t * c = (bench_conn_t *) conn;
+#ifdef USE_MBED_TLS
+  int ret = mbedtls_ssl_read(&c->ssl, buf, len);
+
+  if ((ret == MBEDTLS_ERR_SSL_WANT_READ) || (ret == MBEDTLS_ERR_SSL_WANT_WRITE))
+  {
+    return 0;
+  }
+  return (ret > 0) ? ret : -1;
+#else
+  ssize_t n = recv(c->fd, buf, len, MSG_DONTWAIT);
+
+  if ((n < 0) && ((errno == EAGAIN) || (errno == EWOULDBLOCK)))
+  {
+    return 0;
+  }
+  return (n > 0) ? (int) n : -1;
+#endif
+}
+
+static int bench_conn_send(void * conn, const uint8_t * buf, size_t len)
+{
+  bench_conn_t * c = (bench_conn_t *) conn;
+
+  while (len > 0)
+  {
+#ifdef USE_MBED_TLS
+    int n = mbedtls_ssl_write(&c->ssl, buf, len);
+#else
+    int n = (int) send(c->fd, buf, len, MSG_NOSIGNAL);
+#endif
+    if (n <= 0)
+    {
+      return -1;
+    }
+    buf += n;
+    len -= (size_t) n;
+  }
+  return 0;
+}
+
+static void bench_conn_close(void * conn)
+{
+  bench_conn_t * c = (bench_conn_t *) conn;
+
+#ifdef USE_MBED_TLS
+  mbedtls_ssl_free(&c->ssl);
+#endif
+  close(c->fd);
+  c->fd = -1;
+}
+
+static const mqtt_broker_transport_t bench_transport = { bench_conn_recv, bench_conn_send, bench_conn_close };
+
+static void bench_server_accept(bench_server_t * srv)
+{
+  bench_conn_t * c = NULL;
+  int fd = bench_accept(srv->lfd);
+
+  if (fd < 0)
+  {
+    return;
+  }
+  for (int i = 0; (c == NULL) && (i < MQTT_BROKER_MAX_CLIENTS); i++)
+  {
+    c = (srv->conns[i].fd < 0) ? &srv->conns[i] : NULL;
+  }
+  if (c == NULL)
+  {
+    close(fd);
+    return;
+  }
+  c->fd = fd;
+#ifdef USE_MBED_TLS
+  mbedtls_ssl_init(&c->ssl);
+  mbedtls_ssl_set_bio(&c->ssl, &c->fd, bench_fd_send, bench_fd_recv, NULL);
+  if ((mbedtls_ssl_setup(&c->ssl, &srv->conf) != 0) || (mbedtls_ssl_handshake(&c->ssl) != 0))
+  {
+    bench_conn_close(c);
+    return;
+  }
+  mbedtls_ssl_set_bio(&c->ssl, &c->fd, bench_fd_send, bench_fd_recv_nb, NULL);
+#endif
+  if (mqtt_broker_attach(&srv->broker, c, &bench_transport, HAL_GetTick()) < 0)
+  {
+    bench_conn_close(c);
+  }
+}
+
+#ifdef USE_MBED_TLS
+static int bench_server_tls_init(bench_server_t * srv)
+{
+  mbedtls_entropy_init(&srv->entropy);
+  mbedtls_ctr_drbg_init(&srv->ctr_drbg);
+  mbedtls_ssl_config_init(&srv->conf);
+  mbedtls_x509_crt_init(&srv->srvcert);
+  mbedtls_pk_init(&srv->pkey);
+  if ((mbedtls_x509_crt_parse(&srv->srvcert, (const unsigned char *) mbedtls_test_srv_crt_ec, mbedtls_test_srv_crt_ec_len) != 0)
+      || (mbedtls_pk_parse_key(&srv->pkey, (const unsigned char *) mbedtls_test_srv_key_ec, mbedtls_test_srv_key_ec_len, NULL, 0) != 0)
+      || (mbedtls_ctr_drbg_seed(&srv->ctr_drbg, mbedtls_entropy_func, &srv->entropy, (const unsigned char *) "mqtt_bench_srv", 14) != 0)
+      || (mbedtls_ssl_config_defaults(&srv->conf, MBEDTLS_SSL_IS_SERVER, MBEDTLS_SSL_TRANSPORT_STREAM, MBEDTLS_SSL_PRESET_DEFAULT) != 0)
+      || (mbedtls_ssl_conf_own_cert(&srv->conf, &srv->srvcert, &srv->pkey) != 0))
+  {
+    return -1;
+  }
+  mbedtls_ssl_conf_rng(&srv->conf, mbedtls_ctr_drbg_random, &srv->ctr_drbg);
+  return 0;
+}
+
+static void bench_server_tls_free(bench_server_t * srv)
+{
+  mbedtls_ssl_config_free(&srv->conf);
+  mbedtls_x509_crt_free(&srv->srvcert);
+  mbedtls_pk_free(&srv->pkey);
+  mbedtls_ctr_drbg_free(&srv->ctr_drbg);
+  mbedtls_entropy_free(&srv->entropy);
+}
+#endif /* USE_MBED_TLS */
+
+/**
+ * @brief  In-process broker: accepts the connections (TLS handshake first in
+ *         the mbedTLS build) and serves them until stopped.
+ */
+static void * bench_server_thread(void * arg)
+{
+  bench_server_t * srv = (bench_server_t *) arg;
+
+  bench_rng_seed(srv->seed ^ 0x5A5A5A5A);
+#ifdef USE_MBED_TLS
+  if (bench_server_tls_init(srv) != 0)
+  {
+    fprintf(stderr, "server: setup failed\n");
+    shutdown(srv->lfd, SHUT_RDWR);  /* Refuse the client instead of leaving it waiting. */
+    bench_server_tls_free(srv);
+    srv->rc = -1;
+    return NULL;
+  }
+#endif
+
+  while (!srv->stop)
+  {
+    struct pollfd pfd[1 + MQTT_BROKER_MAX_CLIENTS];
+    int n = 0;
+
+    pfd[n].fd = srv->lfd;
+    pfd[n].events = POLLIN;
+    pfd[n++].revents = 0;
+    for (int i = 0; i < MQTT_BROKER_MAX_CLIENTS; i++)
+    {
+      if (srv->conns[i].fd >= 0)
+      {
+        pfd[n].fd = srv->conns[i].fd;
+        pfd[n].events = POLLIN;
+        pfd[n++].revents = 0;
+      }
+    }
+    (void) poll(pfd, n, 1);
+    if (pfd[0].revents & POLLIN)
+    {
+      bench_server_accept(srv);
+    }
+    while (mqtt_broker_poll(&srv->broker, HAL_GetTick()) > 0)
+    {
+    }
+  }
+
+  for (int i = 0; i < MQTT_BROKER_MAX_CLIENTS; i++)
+  {
+    if (srv->conns[i].fd >= 0)
+    {
+      bench_conn_close(&srv->conns[i]);
+    }
+  }
+#ifdef USE_MBED_TLS
+  bench_server_tls_free(srv);
+#endif
+  return NULL;
+}
+
+/* Client side ---------------------------------------------------------------*/
+static void bench_on_message(void * ctx, const char * topic, size_t topic_len, const void * payload, size_t len)
+{
+  bench_echo_t * echo = (bench_echo_t *) ctx;
+  uint32_t seq;
+
+  (void) topic;
+  (void) topic_len;
+  if (len >= sizeof(seq))
+  {
+    memcpy(&seq, payload, sizeof(seq));
+    if (seq == echo->expected)
+    {
+      echo->echo_us = bench_now_us();
+    }
+  }
+}
+
+static void bench_device_config(device_config_t * dev, uint16_t port)
+{
+  memset(dev, 0, sizeof(*dev));
+  dev->HostName = (char *) BENCH_SERVER_NAME;
+  dev->HostPort = port;
+  dev->ConnSecurity = CONN_SEC_SERVERAUTH;
+  dev->MQClientId = (char *) BENCH_CLIENT_ID;
+#ifdef USE_MBED_TLS
+  dev->tls_ca_certs = mbedtls_test_cas_pem;
+  dev->tls_ca_certs_len = mbedtls_test_cas_pem_len;
+#else
+  dev->tls_ca_certs = bench_module_ca;
+  dev->tls_ca_certs_len = sizeof(bench_module_ca);
+#endif
+}
+
+static int bench_case_run(const bench_case_t * bcase, const bench_opts_t * opts, uint16_t port)
+{
+  mqtt_facade_t * f = &bench_facade;
+  device_config_t dev;
+  bench_echo_t echo;
+  bench_wifi_stats_t st;
+  unsigned char * payload;
+  double * conn_ms;
+  double * conn_cpu_ms;
+  double * pub_ms;
+  double first_ms = 0.0;
+  double first_cpu_ms = 0.0;
+  uint64_t pub_cpu_us = 0;
+  uint64_t pub_xfers = 0;
+  uint64_t cmds = 0;
+  size_t peak_heap = 0;
+  size_t state = (bcase->backend == MQTT_FACADE_PAHO) ? sizeof(f->u.paho) : sizeof(f->u.module);
+  uint32_t seq = 0;
+  int reconnects = 0;
+  int published = 0;
+  int rc = MQSUCCESS;
+
+  conn_ms = calloc(opts->connects, sizeof(double));
+  conn_cpu_ms = calloc(opts->connects, sizeof(double));
+  pub_ms = calloc((size_t) opts->connects * opts->publishes, sizeof(double));
+  payload = malloc(opts->payload);
+  if ((conn_ms == NULL) || (conn_cpu_ms == NULL) || (pub_ms == NULL) || (payload == NULL))
+  {
+    free(conn_ms);
+    free(conn_cpu_ms);
+    free(pub_ms);
+    free(payload);
+    return FAILURE;
+  }
+  memset(payload, 'x', opts->payload);
+  memset(&echo, 0, sizeof(echo));
+
+  bench_device_config(&dev, port);
+  mqtt_facade_init(f, bcase->backend, &dev, BENCH_TOPIC, BENCH_TOPIC);
+  rc = mqtt_facade_subscribe(f, BENCH_TOPIC, QOS0, bench_on_message, &echo);
+
+  for (int i = 0; (rc == MQSUCCESS) && (i < opts->connects); i++)
+  {
+    uint64_t t0, c0, m0;
+    double ms, cpu_ms;
+
+    /* Connection: the first one resolves the broker, the next ones are reconnections. */
+    bench_heap_reset();
+    bench_wifi_stats_reset();
+    c0 = bench_thread_cpu_us();
+    t0 = bench_now_us();
+    rc = mqtt_facade_connect(f, i == 0);
+    ms = (double) (bench_now_us() - t0) / 1000.0;
+    bench_wifi_stats_get(&st);
+    cpu_ms = (double) (bench_thread_cpu_us() - c0 - st.module_cpu_us) / 1000.0;
+    if (rc != MQSUCCESS)
+    {
+      fprintf(stderr, "%s: connection %d failed\n", bcase->name, i);
+      break;
+    }
+    cmds += st.cmd_calls;
+    if (i == 0)
+    {
+      first_ms = ms;
+      first_cpu_ms = cpu_ms;
+    }
+    else
+    {
+      conn_ms[reconnects] = ms;
+      conn_cpu_ms[reconnects++] = cpu_ms;
+    }
+
+    /* Publications, each one waited for back on the subscription. */
+    bench_wifi_stats_reset();
+    m0 = bench_thread_cpu_us();
+    for (int j = 0; (rc == MQSUCCESS) && (j < opts->publishes); j++)
+    {
+      echo.expected = ++seq;
+      echo.echo_us = 0;
+      memcpy(payload, &seq, sizeof(seq));
+      t0 = bench_now_us();
+      rc = mqtt_facade_publish(f, BENCH_TOPIC, payload, opts->payload, opts->qos);
+      while ((rc == MQSUCCESS) && (echo.echo_us == 0) && (bench_now_us() - t0 < BENCH_ECHO_TIMEOUT_US))
+      {
+        rc = mqtt_facade_poll(f, BENCH_POLL_MS);
+      }
+      if ((rc != MQSUCCESS) || (echo.echo_us == 0))
+      {
+        fprintf(stderr, "%s: publication %u not delivered\n", bcase->name, (unsigned) seq);
+        rc = FAILURE;
+        break;
+      }
+      pub_ms[published++] = (double) (echo.echo_us - t0) / 1000.0;
+    }
+    bench_wifi_stats_get(&st);
+    pub_cpu_us += bench_thread_cpu_us() - m0 - st.module_cpu_us;
+    pub_xfers += st.send_calls + st.recv_calls;
+
+    mqtt_facade_disconnect(f);
+    if (bench_heap_peak() > peak_heap)
+    {
+      peak_heap = bench_heap_peak();
+    }
+  }
+
+  if ((rc != MQSUCCESS) || (published == 0))
+  {
+    printf("%-16s FAILED\n", bcase->name);
+    rc = FAILURE;
+  }
+  else
+  {
+    qsort(conn_ms, reconnects, sizeof(double), bench_cmp_double);
+    qsort(conn_cpu_ms, reconnects, sizeof(double), bench_cmp_double);
+    qsort(pub_ms, published, sizeof(double), bench_cmp_double);
+    printf("%-16s %8.2f %8.2f %8.2f %8.2f %8.2f %5.1f %8.3f %8.3f %8.1f %6.1f %9zu %7zu\n",
+           bcase->name, first_ms, first_cpu_ms,
+           (reconnects > 0) ? bench_percentile(conn_ms, reconnects, 50) : 0.0,
+           (reconnects > 0) ? bench_percentile(conn_ms, reconnects, 90) : 0.0,
+           (reconnects > 0) ? bench_percentile(conn_cpu_ms, reconnects, 50) : 0.0,
+           (double) cmds / opts->connects,
+           bench_percentile(pub_ms, published, 50), bench_percentile(pub_ms, published, 99),
+           (double) pub_cpu_us / published, (double) pub_xfers / published,
+           peak_heap, state);
+  }
+  free(conn_ms);
+  free(conn_cpu_ms);
+  free(pub_ms);
+  free(payload);
+  return rc;
+}
+
+static void bench_usage(const char * prog)
+{
+  printf("usage: %s [-n connections] [-m publications] [-b payload_bytes] [-q qos] [-l us_per_transaction] [-s seed]\n"
+         "  -n  connections per backend, the first one and the reconnections (default %d)\n"
+         "  -m  publications per connection, each one waited for back (default %d)\n"
+         "  -b  payload size (default %d, max %d)\n"
+         "  -q  QoS of the Paho publications, 0 or 1 (default 1); the module publishes with its own\n"
+         "  -l  latency charged to every emulated WiFi module transaction and AT command (default 0)\n"
+         "  -s  RNG seed (default 0x%08lx)\n",
+         prog, BENCH_DEFAULT_CONNECTS, BENCH_DEFAULT_PUBLISHES, BENCH_DEFAULT_PAYLOAD, BENCH_MAX_PAYLOAD,
+         (unsigned long) hrng.seed);
+}
+
+/* Functions Definition ------------------------------------------------------*/
+int main(int argc, char ** argv)
+{
+  bench_opts_t opts;
+  pthread_t tid;
+  uint16_t port = 0;
+  int qos = 1;
+  int opt;
+  int rc = 0;
+
+  opts.connects = BENCH_DEFAULT_CONNECTS;
+  opts.publishes = BENCH_DEFAULT_PUBLISHES;
+  opts.payload = BENCH_DEFAULT_PAYLOAD;
+  opts.seed = hrng.seed;
+  opts.latency_us = 0;
+
+  while ((opt = getopt(argc, argv, "n:m:b:q:l:s:h")) != -1)
+  {
+    switch (opt)
+    {
+      case 'n': opts.connects = atoi(optarg); break;
+      case 'm': opts.publishes = atoi(optarg); break;
+      case 'b': opts.payload = strtoul(optarg, NULL, 0); break;
+      case 'q': qos = atoi(optarg); break;
+      case 'l': opts.latency_us = strtoul(optarg, NULL, 0); break;
+      case 's': opts.seed = strtoul(optarg, NULL, 0); break;
+      default:
+        bench_usage(argv[0]);
+        return (opt == 'h') ? 0 : 2;
+    }
+  }
+  if ((opts.connects <= 0) || (opts.publishes <= 0) || (opts.payload < sizeof(uint32_t))
+      || (opts.payload > BENCH_MAX_PAYLOAD) || (qos < 0) || (qos > 1))
+  {
+    bench_usage(argv[0]);
+    return 2;
+  }
+  opts.qos = (qos == 0) ? QOS0 : QOS1;
+
+#ifdef USE_MBED_TLS
+  /* The server thread allocates before the first net_sock_open() installs
+   * the allocator: install it up front so every block goes through heap_free(). */
+  mbedtls_platform_set_calloc_free(heap_alloc, heap_free);
+#endif
+  bench_wifi_set_latency_us(opts.latency_us);
+  bench_rng_seed(opts.seed);
+  if (net_init(&hnet, NET_IF, net_if_init) != NET_OK)
+  {
+    fprintf(stderr, "net_init() failed\n");
+    return 1;
+  }
+
+  memset(&bench_server, 0, sizeof(bench_server));
+  for (int i = 0; i < MQTT_BROKER_MAX_CLIENTS; i++)
+  {
+    bench_server.conns[i].fd = -1;
+  }
+  mqtt_broker_init(&bench_server.broker);
+  bench_server.seed = opts.seed;
+  bench_server.lfd = bench_listen(&port);
+  if ((bench_server.lfd < 0) || (pthread_create(&tid, NULL, bench_server_thread, &bench_server) != 0))
+  {
+    fprintf(stderr, "broker setup failed\n");
+    return 1;
+  }
+
+  printf("mqtt_facade_bench: %s, seed 0x%08lx\n", BENCH_VARIANT, (unsigned long) opts.seed);
+  printf("                   %d connections x %d publications of %zu B, Paho QoS %d, %lu us/transaction\n\n",
+         opts.connects, opts.publishes, opts.payload, qos, (unsigned long) opts.latency_us);
+  printf("%-16s %8s %8s %8s %8s %8s %5s %8s %8s %8s %6s %9s %7s\n",
+         "backend", "1st ms", "1st cpu", "recon50", "recon90", "rec cpu", "AT", "pub50 ms", "pub99 ms",
+         "cpu/pub", "tx/pub", "peak heap", "state B");
+  printf("%-16s %8s %8s %8s %8s %8s %5s %8s %8s %8s %6s %9s %7s\n",
+         "", "", "ms", "ms", "ms", "ms", "/conn", "", "", "us", "", "B", "");
+
+  for (size_t i = 0; i < sizeof(bench_cases) / sizeof(bench_cases[0]); i++)
+  {
+    if (bench_case_run(&bench_cases[i], &opts, port) != MQSUCCESS)
+    {
+      rc = 1;
+    }
+  }
+
+  bench_server.stop = 1;
+  pthread_join(tid, NULL);
+  close(bench_server.lfd);
+  if (bench_server.rc != 0)
+  {
+    rc = 1;
+  }
+  net_deinit(hnet, net_if_deinit);
+  return rc;
+}
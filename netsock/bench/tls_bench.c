@@ -0,0 +1,622 @@
+/*
+ * tls_bench.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Daruin Solano
+ *
+ *  TLS handshake and record throughput benchmark for the netsock mbedTLS
+ *  socket (net_tls_mbedtls.c), built for Linux with the device mbedTLS
+ *  configuration (Http/inc/httpclient_mbedtls_config.h).
+ *
+ *  The client side is the unchanged netsock stack: net_sock_create() /
+ *  net_sock_setopt() / net_sock_open() over net_tcp_wifi.c, whose WIFI_*
+ *  primitives are emulated on loopback TCP by bench_port.c. The peer is an
+ *  in-process mbedTLS server thread which pins one ciphersuite and one curve
+ *  per case, so every case measures exactly one negotiated configuration.
+ *  The "server default" case pins nothing: it shows what the client profile
+ *  (-p, tls_profile socket option) negotiates against a stock server.
+ *  The PSK cases use the tls_psk / tls_psk_identity socket options: no
+ *  certificate is parsed nor exchanged.
+ *
+ *  Write coalescing: -w sets the tls_write_coalesce socket option of the
+ *  client, so that the -r sized uploads are combined into larger records.
+ *
+ *  Profile comparison: "make compare" runs the default and "fast" profiles
+ *  for every NET_TLS_ECP_TUNING variant of the device configuration.
+ *
+ *  Per case it reports:
+ *  - net_sock_open() latency (TCP connect + certificate parsing + handshake),
+ *    p50/p90/p99/max over the handshakes. The wall-clock figures include the
+ *    work of the peer, which runs on the same machine: the client CPU time
+ *    (p50) is what the device itself would spend;
+ *  - handshake bytes and emulated module transactions;
+ *  - upload/download throughput over records of a fixed size, and the
+ *    module send transactions of the upload;
+ *  - peak heap of the client (mbedTLS allocations through heap_alloc()).
+ *
+ *  Runs are reproducible: the RNG is seeded (-s), and the case list, counts
+ *  and sizes are fixed by the command line.
+ *
+ *  Build and run: make -C netsock/bench && netsock/bench/tls_bench -h
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <errno.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/socket.h>
+
+#include "net_internal.h"
+#include "mbedtls/certs.h"
+#include "bench_port.h"
+
+/* Private defines -----------------------------------------------------------*/
+#define BENCH_SERVER_NAME       "localhost"   /* CN of the mbedTLS test server certificates. */
+#define BENCH_DEFAULT_HS        50
+#define BENCH_DEFAULT_BULK      (64 * 1024)
+#define BENCH_DEFAULT_RECORD    1024
+#define BENCH_MAX_RECORD        4096          /* Below MBEDTLS_SSL_MAX_CONTENT_LEN of the device config. */
+#define BENCH_ACK               0xA5
+#define BENCH_PSK_IDENTITY      "tls_bench"
+
+/* Private typedef -----------------------------------------------------------*/
+typedef enum { CERT_EC = 0, CERT_RSA, CERT_NONE /* PSK */ } bench_cert_t;
+
+typedef struct {
+  const char * name;
+  const char * suite;           /**< Ciphersuite pinned on the server, NULL for the server defaults. */
+  mbedtls_ecp_group_id curve;   /**< Curve pinned on the server, MBEDTLS_ECP_DP_NONE if not applicable. */
+  bench_cert_t cert;
+} bench_case_t;
+
+typedef struct {
+  int iterations;
+  size_t bulk;
+  size_t record;
+  uint32_t seed;
+  uint32_t latency_us;
+  const char * filter;
+  const char * profile;         /**< tls_profile socket option, NULL to leave it unset. */
+  size_t coalesce;              /**< tls_write_coalesce socket option, 0 to leave it unset. */
+} bench_opts_t;
+
+typedef struct {
+  const bench_case_t * bcase;
+  const bench_opts_t * opts;
+  int lfd;
+  int suite_id;
+  mbedtls_ecp_group_id curves[2];
+  int rc;
+} bench_server_t;
+
+typedef struct {
+  const bench_case_t * bcase;
+  double * hs_ms;
+  double * cpu_ms;
+  int done;
+  uint64_t hs_bytes;
+  uint64_t hs_xfers;
+  uint64_t up_us;
+  uint64_t up_xfers;
+  uint64_t down_us;
+  size_t peak_heap;
+  const char * negotiated;
+} bench_result_t;
+
+/* Private variables ---------------------------------------------------------*/
+static const unsigned char bench_psk[16] =
+{
+  0x1d, 0x4e, 0x8b, 0x27, 0x93, 0xc6, 0x05, 0x7a, 0xe1, 0x38, 0x5f, 0xb2, 0x64, 0x0d, 0x99, 0xc4
+};
+
+static const bench_case_t bench_cases[] =
+{
+  { "server default (EC cert)",      NULL,                                      MBEDTLS_ECP_DP_NONE,       CERT_EC },
+  { "ECDHE-ECDSA-AES128-GCM/P-256",  "TLS-ECDHE-ECDSA-WITH-AES-128-GCM-SHA256", MBEDTLS_ECP_DP_SECP256R1,  CERT_EC },
+  { "ECDHE-ECDSA-AES128-CCM/P-256",  "TLS-ECDHE-ECDSA-WITH-AES-128-CCM",        MBEDTLS_ECP_DP_SECP256R1,  CERT_EC },
+  { "ECDHE-ECDSA-AES128-CBC/P-256",  "TLS-ECDHE-ECDSA-WITH-AES-128-CBC-SHA256", MBEDTLS_ECP_DP_SECP256R1,  CERT_EC },
+  { "ECDHE-ECDSA-AES256-GCM/P-384",  "TLS-ECDHE-ECDSA-WITH-AES-256-GCM-SHA384", MBEDTLS_ECP_DP_SECP384R1,  CERT_EC },
+  { "ECDHE-RSA-AES128-GCM/P-256",    "TLS-ECDHE-RSA-WITH-AES-128-GCM-SHA256",   MBEDTLS_ECP_DP_SECP256R1,  CERT_RSA },
+  { "RSA-AES128-GCM",                "TLS-RSA-WITH-AES-128-GCM-SHA256",         MBEDTLS_ECP_DP_NONE,       CERT_RSA },
+  { "ECDHE-PSK-AES128-CBC/P-256",    "TLS-ECDHE-PSK-WITH-AES-128-CBC-SHA256",   MBEDTLS_ECP_DP_SECP256R1,  CERT_NONE },
+  { "PSK-AES128-GCM",                "TLS-PSK-WITH-AES-128-GCM-SHA256",         MBEDTLS_ECP_DP_NONE,       CERT_NONE },
+  { "PSK-AES128-CCM",                "TLS-PSK-WITH-AES-128-CCM",                MBEDTLS_ECP_DP_NONE,       CERT_NONE },
+};
+
+/* Private functions ---------------------------------------------------------*/
+static int bench_cmp_double(const void * a, const void * b)
+{
+  double x = *(const double *) a;
+  double y = *(const double *) b;
+  return (x > y) - (x < y);
+}
+
+/* Nearest-rank percentile of a sorted array. */
+static double bench_percentile(const double * v, int n, int pct)
+{
+  int rank = (pct * n + 99) / 100;
+  return v[(rank > 0) ? rank - 1 : 0];
+}
+
+/* Whether the client profile can negotiate the case at all. */
+static bool bench_profile_offers(const char * profile, const bench_case_t * bcase)
+{
+  if ((profile == NULL) || (strcmp(profile, "fast") != 0))
+  {
+    return true;
+  }
+  /* PSK mode replaces the suites of the profile but keeps its curves. */
+  return ((bcase->cert == CERT_NONE)
+          || ((bcase->cert == CERT_EC)
+              && ((bcase->suite == NULL) || (strstr(bcase->suite, "ECDHE-ECDSA-WITH-AES-128-") != NULL))))
+      && ((bcase->curve == MBEDTLS_ECP_DP_NONE) || (bcase->curve == MBEDTLS_ECP_DP_SECP256R1));
+}
+
+static int bench_fd_send(void * ctx, const unsigned char * buf, size_t len)
+{
+  ssize_t n = send(*(int *) ctx, buf, len, MSG_NOSIGNAL);
+  return (n < 0) ? MBEDTLS_ERR_SSL_INTERNAL_ERROR : (int) n;
+}
+
+static int bench_fd_recv(void * ctx, unsigned char * buf, size_t len)
+{
+  ssize_t n = recv(*(int *) ctx, buf, len, 0);
+  return (n < 0) ? MBEDTLS_ERR_SSL_INTERNAL_ERROR : (int) n;
+}
+
+static int bench_ssl_read_all(mbedtls_ssl_context * ssl, unsigned char * buf, size_t len)
+{
+  size_t got = 0;
+  while (got < len)
+  {
+    int ret = mbedtls_ssl_read(ssl, buf + got, len - got);
+    if (ret <= 0)
+    {
+      return -1;
+    }
+    got += ret;
+  }
+  return 0;
+}
+
+static int bench_ssl_write_all(mbedtls_ssl_context * ssl, const unsigned char * buf, size_t len)
+{
+  size_t put = 0;
+  while (put < len)
+  {
+    int ret = mbedtls_ssl_write(ssl, buf + put, len - put);
+    if (ret <= 0)
+    {
+      return -1;
+    }
+    put += ret;
+  }
+  return 0;
+}
+
+/**
+ * @brief  In-process TLS peer: serves opts->iterations connections with the
+ *         ciphersuite and curve of the case pinned, then returns.
+ */
+static void * bench_server_thread(void * arg)
+{
+  bench_server_t * srv = (bench_server_t *) arg;
+  const bench_opts_t * opts = srv->opts;
+  mbedtls_entropy_context entropy;
+  mbedtls_ctr_drbg_context ctr_drbg;
+  mbedtls_ssl_config conf;
+  mbedtls_ssl_context ssl;
+  mbedtls_x509_crt srvcert;
+  mbedtls_pk_context pkey;
+  int suites[2] = { srv->suite_id, 0 };
+  unsigned char * buf = NULL;
+  int ret = -1;
+
+  bench_rng_seed(opts->seed ^ 0x5A5A5A5A);
+  mbedtls_entropy_init(&entropy);
+  mbedtls_ctr_drbg_init(&ctr_drbg);
+  mbedtls_ssl_config_init(&conf);
+  mbedtls_ssl_init(&ssl);
+  mbedtls_x509_crt_init(&srvcert);
+  mbedtls_pk_init(&pkey);
+
+  ret = 0;
+  if (srv->bcase->cert == CERT_EC)
+  {
+    ret = mbedtls_x509_crt_parse(&srvcert, (const unsigned char *) mbedtls_test_srv_crt_ec, mbedtls_test_srv_crt_ec_len);
+    ret |= mbedtls_pk_parse_key(&pkey, (const unsigned char *) mbedtls_test_srv_key_ec, mbedtls_test_srv_key_ec_len, NULL, 0);
+  }
+  else if (srv->bcase->cert == CERT_RSA)
+  {
+    ret = mbedtls_x509_crt_parse(&srvcert, (const unsigned char *) mbedtls_test_srv_crt_rsa, mbedtls_test_srv_crt_rsa_len);
+    ret |= mbedtls_pk_parse_key(&pkey, (const unsigned char *) mbedtls_test_srv_key_rsa, mbedtls_test_srv_key_rsa_len, NULL, 0);
+  }
+  if ((ret == 0)
+      && (mbedtls_ctr_drbg_seed(&ctr_drbg, mbedtls_entropy_func, &entropy, (const unsigned char *) "tls_bench_srv", 13) == 0)
+      && (mbedtls_ssl_config_defaults(&conf, MBEDTLS_SSL_IS_SERVER, MBEDTLS_SSL_TRANSPORT_STREAM, MBEDTLS_SSL_PRESET_DEFAULT) == 0))
+  {
+    ret = (srv->bcase->cert == CERT_NONE)
+        ? mbedtls_ssl_conf_psk(&conf, bench_psk, sizeof(bench_psk), (const unsigned char *) BENCH_PSK_IDENTITY, strlen(BENCH_PSK_IDENTITY))
+        : mbedtls_ssl_conf_own_cert(&conf, &srvcert, &pkey);
+  }
+  else
+  {
+    ret = -1;
+  }
+  if (ret != 0)
+  {
+    fprintf(stderr, "server: setup failed\n");
+    shutdown(srv->lfd, SHUT_RDWR);  /* Refuse the client instead of leaving it waiting. */
+    ret = -1;
+    goto exit;
+  }
+  mbedtls_ssl_conf_rng(&conf, mbedtls_ctr_drbg_random, &ctr_drbg);
+  if (srv->suite_id != 0)
+  {
+    mbedtls_ssl_conf_ciphersuites(&conf, suites);
+  }
+  if (srv->curves[0] != MBEDTLS_ECP_DP_NONE)
+  {
+    mbedtls_ssl_conf_curves(&conf, srv->curves);
+  }
+  if (mbedtls_ssl_setup(&ssl, &conf) != 0)
+  {
+    shutdown(srv->lfd, SHUT_RDWR);
+    ret = -1;
+    goto exit;
+  }
+
+  buf = malloc((opts->bulk > 0) ? opts->bulk : 1);
+  if (buf == NULL)
+  {
+    ret = -1;
+    goto exit;
+  }
+  memset(buf, 0x5C, (opts->bulk > 0) ? opts->bulk : 1);
+
+  for (int i = 0; i < opts->iterations; i++)
+  {
+    unsigned char ack = BENCH_ACK;
+    int fd = bench_accept(srv->lfd);
+
+    if (fd < 0)
+    {
+      ret = -1;
+      break;
+    }
+    mbedtls_ssl_session_reset(&ssl);
+    mbedtls_ssl_set_bio(&ssl, &fd, bench_fd_send, bench_fd_recv, NULL);
+    ret = mbedtls_ssl_handshake(&ssl);
+    if ((ret == 0) && (opts->bulk > 0))
+    {
+      /* Upload: receive the whole payload, then acknowledge it. */
+      ret = bench_ssl_read_all(&ssl, buf, opts->bulk);
+      if (ret == 0)
+      {
+        ret = bench_ssl_write_all(&ssl, &ack, 1);
+      }
+      /* Download: send the payload in records of the requested size. */
+      for (size_t off = 0; (ret == 0) && (off < opts->bulk); off += opts->record)
+      {
+        ret = bench_ssl_write_all(&ssl, buf + off, MIN(opts->record, opts->bulk - off));
+      }
+      /* Wait for the client acknowledgement before tearing down. */
+      if (ret == 0)
+      {
+        ret = bench_ssl_read_all(&ssl, &ack, 1);
+      }
+    }
+    if (ret == 0)
+    {
+      mbedtls_ssl_close_notify(&ssl);
+    }
+    close(fd);
+    if (ret != 0)
+    {
+      fprintf(stderr, "server: connection %d failed: -0x%x\n", i, -ret);
+      break;
+    }
+  }
+
+exit:
+  free(buf);
+  mbedtls_ssl_free(&ssl);
+  mbedtls_ssl_config_free(&conf);
+  mbedtls_x509_crt_free(&srvcert);
+  mbedtls_pk_free(&pkey);
+  mbedtls_ctr_drbg_free(&ctr_drbg);
+  mbedtls_entropy_free(&entropy);
+  srv->rc = ret;
+  return NULL;
+}
+
+/**
+ * @brief  One client connection through the netsock TLS socket.
+ */
+static int bench_client_run(const bench_opts_t * opts, uint16_t port, int iter, bench_result_t * res, unsigned char * buf)
+{
+  net_sockhnd_t sock = NULL;
+  bench_wifi_stats_t st;
+  unsigned char ack = 0;
+  uint64_t t0, t1, c0;
+  int rc;
+
+  bench_heap_reset();
+  bench_wifi_stats_reset();
+
+  rc = net_sock_create(hnet, &sock, NET_PROTO_TLS);
+  rc |= net_sock_setopt(sock, "tls_server_name", (uint8_t *) BENCH_SERVER_NAME, sizeof(BENCH_SERVER_NAME));
+  if (res->bcase->cert == CERT_NONE)
+  {
+    rc |= net_sock_setopt(sock, "tls_psk", bench_psk, sizeof(bench_psk));
+    rc |= net_sock_setopt(sock, "tls_psk_identity", (uint8_t *) BENCH_PSK_IDENTITY, sizeof(BENCH_PSK_IDENTITY));
+  }
+  else
+  {
+    rc |= net_sock_setopt(sock, "tls_ca_certs", (uint8_t *) mbedtls_test_cas_pem, mbedtls_test_cas_pem_len);
+  }
+  if (opts->profile != NULL)
+  {
+    rc |= net_sock_setopt(sock, "tls_profile", (uint8_t *) opts->profile, strlen(opts->profile) + 1);
+  }
+  if (opts->coalesce > 0)
+  {
+    char size[21];   /* the digits of a 64-bit size_t */
+    snprintf(size, sizeof(size), "%zu", opts->coalesce);
+    rc |= net_sock_setopt(sock, "tls_write_coalesce", (uint8_t *) size, strlen(size) + 1);
+  }
+  if (rc != NET_OK)
+  {
+    fprintf(stderr, "client: socket setup failed\n");
+    if (sock != NULL)
+    {
+      net_sock_destroy(sock);
+    }
+    return NET_ERR;
+  }
+
+  c0 = bench_thread_cpu_us();
+  t0 = bench_now_us();
+  rc = net_sock_open(sock, "127.0.0.1", NULL, port, 0);
+  t1 = bench_now_us();
+  res->cpu_ms[iter] = (double) (bench_thread_cpu_us() - c0) / 1000.0;
+  if (rc != NET_OK)
+  {
+    fprintf(stderr, "client: net_sock_open() failed: %d\n", rc);
+    net_sock_destroy(sock);
+    return rc;
+  }
+  res->hs_ms[iter] = (double) (t1 - t0) / 1000.0;
+  bench_wifi_stats_get(&st);
+  res->hs_bytes += st.bytes_sent + st.bytes_recv;
+  res->hs_xfers += st.send_calls + st.recv_calls;
+  res->negotiated = mbedtls_ssl_get_ciphersuite(&((net_sock_ctxt_t *) sock)->tlsData->ssl);
+
+  if (opts->bulk > 0)
+  {
+    /* Upload */
+    bench_wifi_stats_reset();
+    t0 = bench_now_us();
+    for (size_t off = 0; (rc == NET_OK) && (off < opts->bulk); off += opts->record)
+    {
+      size_t len = MIN(opts->record, opts->bulk - off);
+      rc = (net_sock_send(sock, buf + off, len) == (int) len) ? NET_OK : NET_ERR;
+    }
+    while ((rc == NET_OK) && (ack != BENCH_ACK))
+    {
+      int n = net_sock_recv(sock, &ack, 1);
+      rc = (n < 0) ? n : NET_OK;
+    }
+    t1 = bench_now_us();
+    res->up_us += t1 - t0;
+    bench_wifi_stats_get(&st);
+    res->up_xfers += st.send_calls;
+
+    /* Download */
+    t0 = t1;
+    for (size_t got = 0; (rc == NET_OK) && (got < opts->bulk); )
+    {
+      int n = net_sock_recv(sock, buf + got, opts->bulk - got);
+      if (n < 0)
+      {
+        rc = n;
+      }
+      else
+      {
+        got += n;
+      }
+    }
+    res->down_us += bench_now_us() - t0;
+    if (rc == NET_OK)
+    {
+      rc = (net_sock_send(sock, &ack, 1) == 1) ? NET_OK : NET_ERR;
+    }
+  }
+
+  net_sock_close(sock);
+  net_sock_destroy(sock);
+  if (bench_heap_peak() > res->peak_heap)
+  {
+    res->peak_heap = bench_heap_peak();
+  }
+  return rc;
+}
+
+static int bench_case_run(const bench_case_t * bcase, const bench_opts_t * opts)
+{
+  bench_server_t srv;
+  bench_result_t res;
+  pthread_t tid;
+  uint16_t port = 0;
+  unsigned char * buf;
+  int rc = NET_OK;
+
+  memset(&srv, 0, sizeof(srv));
+  memset(&res, 0, sizeof(res));
+  srv.bcase = bcase;
+  srv.opts = opts;
+  res.bcase = bcase;
+  srv.suite_id = (bcase->suite != NULL) ? mbedtls_ssl_get_ciphersuite_id(bcase->suite) : 0;
+  srv.curves[0] = bcase->curve;
+  srv.curves[1] = MBEDTLS_ECP_DP_NONE;
+  if (!bench_profile_offers(opts->profile, bcase))
+  {
+    printf("%-32s not offered by the fast profile\n", bcase->name);
+    return NET_OK;
+  }
+  if (((bcase->suite != NULL) && (srv.suite_id == 0)) || ((bcase->curve != MBEDTLS_ECP_DP_NONE) && (mbedtls_ecp_curve_info_from_grp_id(bcase->curve) == NULL)))
+  {
+    printf("%-32s not supported by this configuration\n", bcase->name);
+    return NET_OK;
+  }
+
+  res.hs_ms = calloc(opts->iterations, sizeof(double));
+  res.cpu_ms = calloc(opts->iterations, sizeof(double));
+  buf = malloc((opts->bulk > 0) ? opts->bulk : 1);
+  srv.lfd = bench_listen(&port);
+  if ((res.hs_ms == NULL) || (res.cpu_ms == NULL) || (buf == NULL) || (srv.lfd < 0)
+      || (pthread_create(&tid, NULL, bench_server_thread, &srv) != 0))
+  {
+    fprintf(stderr, "%s: setup failed\n", bcase->name);
+    free(res.hs_ms);
+    free(res.cpu_ms);
+    free(buf);
+    if (srv.lfd >= 0)
+    {
+      close(srv.lfd);
+    }
+    return NET_ERR;
+  }
+  memset(buf, 0xC5, (opts->bulk > 0) ? opts->bulk : 1);
+
+  bench_rng_seed(opts->seed);
+  for (res.done = 0; (rc == NET_OK) && (res.done < opts->iterations); res.done++)
+  {
+    rc = bench_client_run(opts, port, res.done, &res, buf);
+  }
+  if (rc != NET_OK)
+  {
+    /* Unblock the server if it is waiting for a connection. */
+    shutdown(srv.lfd, SHUT_RDWR);
+    res.done--;
+  }
+  pthread_join(tid, NULL);
+  close(srv.lfd);
+
+  if ((rc != NET_OK) || (srv.rc != 0) || (res.done == 0))
+  {
+    printf("%-32s FAILED (client %d, server -0x%x)\n", bcase->name, rc, -srv.rc);
+    rc = NET_ERR;
+  }
+  else
+  {
+    double up = (res.up_us > 0) ? (double) opts->bulk * res.done / 1024.0 / ((double) res.up_us / 1e6) : 0.0;
+    double down = (res.down_us > 0) ? (double) opts->bulk * res.done / 1024.0 / ((double) res.down_us / 1e6) : 0.0;
+
+    qsort(res.hs_ms, res.done, sizeof(double), bench_cmp_double);
+    qsort(res.cpu_ms, res.done, sizeof(double), bench_cmp_double);
+    printf("%-32s %-4s %8.2f %8.2f %8.2f %8.2f %8.2f %7llu %5llu %9.0f %6llu %9.0f %9zu\n",
+           bcase->name, (bcase->cert == CERT_EC) ? "EC" : (bcase->cert == CERT_RSA) ? "RSA" : "PSK",
+           bench_percentile(res.hs_ms, res.done, 50), bench_percentile(res.hs_ms, res.done, 90),
+           bench_percentile(res.hs_ms, res.done, 99), res.hs_ms[res.done - 1],
+           bench_percentile(res.cpu_ms, res.done, 50),
+           (unsigned long long) (res.hs_bytes / res.done), (unsigned long long) (res.hs_xfers / res.done),
+           up, (unsigned long long) (res.up_xfers / res.done), down, res.peak_heap);
+    if ((res.negotiated == NULL) || (bcase->suite == NULL) || (strcmp(res.negotiated, bcase->suite) != 0))
+    {
+      printf("%-32s negotiated %s\n", "", (res.negotiated != NULL) ? res.negotiated : "?");
+    }
+  }
+  free(res.hs_ms);
+  free(res.cpu_ms);
+  free(buf);
+  return rc;
+}
+
+static void bench_usage(const char * prog)
+{
+  printf("usage: %s [-n handshakes] [-b bulk_bytes] [-r record_bytes] [-l us_per_transaction] [-s seed] [-c case_filter] [-p profile] [-w coalesce_bytes]\n"
+         "  -n  handshakes per case (default %d)\n"
+         "  -b  bytes uploaded and downloaded per connection, 0 for handshakes only (default %d)\n"
+         "  -r  application write size (default %d, max %d)\n"
+         "  -l  latency charged to every emulated WiFi module transaction (default 0)\n"
+         "  -s  RNG seed (default 0x%08lx)\n"
+         "  -c  run only the cases whose name contains this string\n"
+         "  -p  tls_profile socket option of the client: default, fast (default: not set)\n"
+         "  -w  tls_write_coalesce socket option of the client, 0 to send every write as is (default 0)\n",
+         prog, BENCH_DEFAULT_HS, BENCH_DEFAULT_BULK, BENCH_DEFAULT_RECORD, BENCH_MAX_RECORD, (unsigned long) hrng.seed);
+}
+
+/* Functions Definition ------------------------------------------------------*/
+int main(int argc, char ** argv)
+{
+  bench_opts_t opts;
+  int opt;
+  int rc = 0;
+
+  opts.iterations = BENCH_DEFAULT_HS;
+  opts.bulk = BENCH_DEFAULT_BULK;
+  opts.record = BENCH_DEFAULT_RECORD;
+  opts.seed = hrng.seed;
+  opts.latency_us = 0;
+  opts.filter = NULL;
+  opts.profile = NULL;
+  opts.coalesce = 0;
+
+  while ((opt = getopt(argc, argv, "n:b:r:l:s:c:p:w:h")) != -1)
+  {
+    switch (opt)
+    {
+      case 'n': opts.iterations = atoi(optarg); break;
+      case 'b': opts.bulk = strtoul(optarg, NULL, 0); break;
+      case 'r': opts.record = strtoul(optarg, NULL, 0); break;
+      case 'l': opts.latency_us = strtoul(optarg, NULL, 0); break;
+      case 's': opts.seed = strtoul(optarg, NULL, 0); break;
+      case 'c': opts.filter = optarg; break;
+      case 'p': opts.profile = optarg; break;
+      case 'w': opts.coalesce = strtoul(optarg, NULL, 0); break;
+      default:
+        bench_usage(argv[0]);
+        return (opt == 'h') ? 0 : 2;
+    }
+  }
+  if ((opts.iterations <= 0) || (opts.record == 0) || (opts.record > BENCH_MAX_RECORD))
+  {
+    bench_usage(argv[0]);
+    return 2;
+  }
+
+  /* The server thread allocates before the first net_sock_open() installs
+   * the allocator: install it up front so every block goes through heap_free(). */
+  mbedtls_platform_set_calloc_free(heap_alloc, heap_free);
+  bench_wifi_set_latency_us(opts.latency_us);
+  if (net_init(&hnet, NET_IF, net_if_init) != NET_OK)
+  {
+    fprintf(stderr, "net_init() failed\n");
+    return 1;
+  }
+
+  printf("tls_bench: mbed TLS " MBEDTLS_VERSION_STRING ", ECP window %d, fixed-point %d, profile %s\n",
+         MBEDTLS_ECP_WINDOW_SIZE, MBEDTLS_ECP_FIXED_POINT_OPTIM, (opts.profile != NULL) ? opts.profile : "unset");
+  printf("           seed 0x%08lx, %d handshakes/case, %zu B bulk in %zu B writes, %zu B coalescing, %lu us/transaction\n\n",
+         (unsigned long) opts.seed, opts.iterations, opts.bulk, opts.record, opts.coalesce, (unsigned long) opts.latency_us);
+  printf("%-32s %-4s %8s %8s %8s %8s %8s %7s %5s %9s %6s %9s %9s\n",
+         "case", "cert", "p50 ms", "p90 ms", "p99 ms", "max ms", "cpu ms", "hs B", "xfers", "up KiB/s", "up tx", "dn KiB/s", "peak heap");
+
+  for (size_t i = 0; i < sizeof(bench_cases) / sizeof(bench_cases[0]); i++)
+  {
+    if ((opts.filter != NULL) && (strstr(bench_cases[i].name, opts.filter) == NULL))
+    {
+      continue;
+    }
+    if (bench_case_run(&bench_cases[i], &opts) != NET_OK)
+    {
+      rc = 1;
+    }
+  }
+
+  net_deinit(hnet, net_if_deinit);
+  return rc;
+}
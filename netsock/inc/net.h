@@ -67,16 +67,36 @@
  *            The caller is responsible for maintaining the passed memory area valid until the socket is destroyed.
  *
  *    Name                      Content                                                         Effect
- *    tls_ca_certs              List of the root CA cerficates. PEM format.                     TLS lib configuration.
+ *    tls_ca_certs              List of the root CA cerficates. PEM or DER format.              TLS lib configuration.
  *    tls_ca_crl                Certificate revocation list. PEM format.                        TLS lib configuration.
- *    tls_dev_cert              Client certificate. PEM format.                                 TLS lib configuration.
- *    tls_dev_key               Client private key. PEM format.                                 TLS lib configuration.
+ *    tls_dev_cert              Client certificate. PEM or DER format.                          TLS lib configuration.
+ *    tls_dev_key               Client private key. PEM or DER format.                          TLS lib configuration.
  *    tls_dev_pwd               Client private key password. Binary format.                     TLS lib configuration.
  *    tls_server_verification   NULL                                                            TLS lib configuration.
  *    tls_server_noverification NULL                                                            TLS lib configuration.
  *            Default option:   tls_server_verification
+ *            DER contents (see netsock/tools/pem2der.py) must be passed with their exact length.
+ *            Concatenated DER certificates are accepted as a chain.
  *  
  *    tls_server_name           Check pattern for the server certificate verification. String.  TLS lib configuration.
+ *    tls_profile               Connection profile name. String: "default" or "fast".           TLS lib configuration.
+ *            Default option:   "default" - every ciphersuite and curve enabled in the mbedTLS configuration.
+ *            "fast" offers only ECDHE-ECDSA AES-128 suites on P-256: the server must present an
+ *            ECDSA certificate. Build with NET_TLS_ECP_TUNING (httpclient_mbedtls_config.h) to trade
+ *            heap for a faster P-256.
+ *    tls_psk                   Pre-shared key. Binary format.                                  TLS lib configuration.
+ *    tls_psk_identity          Identity of the pre-shared key. String.                         TLS lib configuration.
+ *            Setting both selects the PSK mode: ECDHE-PSK and PSK ciphersuites only, the certificate
+ *            options are ignored and no certificate is parsed.
+ *    tls_write_coalesce        Coalescing buffer size in bytes. Ascii format.                  Write combining.
+ *    tls_write_coalesce_ms     Max age in ms of the coalesced data. Ascii format.              Write combining.
+ *            Default option:   "0" - every net_sock_send() call emits its own TLS record.
+ *            When enabled, small writes are held and sent as a single record once the buffer is full,
+ *            the oldest data is older than tls_write_coalesce_ms (checked on the next socket call),
+ *            or on net_sock_flush(), net_sock_recv() and net_sock_close(). Capped at MBEDTLS_SSL_MAX_CONTENT_LEN.
+ *            tls_write_coalesce is set before net_sock_open(): NET_PARAM on an open socket.
+ *            On a non-blocking socket, net_sock_send() returns 0 (would block) while the pending
+ *            data cannot be flushed to make room for the new write.
  *    sock_blocking             NULL.                                                           The recv calls are blocking until
  *                                                                                                  - at least one byte may be returned,
  *                                                                                                  - or the sock_read_timeout is reached.
@@ -84,19 +104,32 @@
  *                                                                                                The available payload is immediately returned, even if empty.
  *            Default option:   sock_blocking
  *  
+ *    mqtt_client_id            MQTT client identifier. String.                                 WiFi module MQTT configuration.
+ *    mqtt_pub_topic            Topic of the net_sock_send() payloads. String.                  WiFi module MQTT configuration.
+ *    mqtt_sub_topic            Topic of the net_sock_recv() payloads. String.                  WiFi module MQTT configuration.
+ *            NET_PROTO_MQTT sockets only (builds without USE_MBED_TLS): the es-WiFi module runs the MQTT
+ *            client and its TLS, the socket sends and receives the message payloads.
  *    sock_read_timeout       Timeout in ms. Ascii format.
  *    sock_write_timeout      Timeout in ms. Ascii format.                                    Applied to TCP sockets only.
  */
 
 typedef enum{
-	tls_ca_certs ,				//content List of the root CA cerficates. PEM format.
+	tls_ca_certs ,				//content List of the root CA cerficates. PEM or DER format.
 	tls_ca_crl,					//content Certificate revocation list. PEM format.
-	tls_dev_cert,				//content Client certificate. PEM format.
-	tls_dev_key,				//content Client private key. PEM format.
+	tls_dev_cert,				//content Client certificate. PEM or DER format.
+	tls_dev_key,				//content Client private key. PEM or DER format.
 	tls_dev_pwd,				//content Client private key password. Binary format.
 	tls_server_verification,	//content NULL
 	tls_server_noverification,	//content NULL
 	tls_server_name,			// content Check pattern for the server certificate verification. String.
+	tls_profile,				// content Connection profile name. String: "default" or "fast".
+	tls_psk,					// content Pre-shared key. Binary format.
+	tls_psk_identity,			// content Identity of the pre-shared key. String.
+	tls_write_coalesce,			// content Coalescing buffer size in bytes. Ascii format.
+	tls_write_coalesce_ms,		// content Max age in ms of the coalesced data. Ascii format.
+	mqtt_client_id,				// content MQTT client identifier. String.
+	mqtt_pub_topic,				// content Topic of the sent payloads. String.
+	mqtt_sub_topic,				// content Topic of the received payloads. String.
 	sock_blocking,
 	sock_noblocking,
 	sock_read_timeout,
@@ -251,6 +284,9 @@ int net_sock_create(net_hnd_t nethnd, net_sockhnd_t * sockhnd, net_proto_t proto
  * @brief   Open a socket and connect to the destination..
  * @param   In:   sockhnd   Socket.
  * @param   In:   hostname  Destination host. Hostname or IP address string.
+ * @param   In:   ipAddress Optional: address of the host, e.g. from net_get_hostaddress(). Saves the name lookup
+ *                          on every interface; hostname is still the name of the host, e.g. for the module
+ *                          MQTT/TLS endpoint. The TLS server name is still set with the "tls_server_name" option.
  * @param   In:   dstport   Destination port.
  * @retval  Status
  *            NET_OK        Success.
@@ -259,7 +295,7 @@ int net_sock_create(net_hnd_t nethnd, net_sockhnd_t * sockhnd, net_proto_t proto
  */
 // int net_sock_open(net_sockhnd_t sockhnd, const char * hostname, int dstport);
 // UDP variant: the remoteport must not be filled (will be overridden by sendto).
-int net_sock_open(net_sockhnd_t sockhnd, const char * hostname, net_ipaddr_t * ipAddress, int remoteport, int localport);
+int net_sock_open(net_sockhnd_t sockhnd, const char * hostname, const net_ipaddr_t * ipAddress, int remoteport, int localport);
 
 /**
  * @brief   Set a socket option.
@@ -318,6 +354,18 @@ int net_sock_send(net_sockhnd_t sockhnd, const uint8_t * buf, size_t len);
 // In: remoteport
 int net_sock_sendto(net_sockhnd_t sockhnd, const uint8_t * buf, size_t len, net_ipaddr_t * remoteaddress, int remoteport);
 
+/**
+ * @brief   Emit the data held by a socket in write coalescing mode (see "tls_write_coalesce").
+ *          Or do nothing if no data is pending, or the socket does not coalesce writes.
+ * @param   In:   sockhnd   Socket.
+ * @retval  Status
+ *            NET_OK        Success.
+ *            NET_TIMEOUT   In "sock_blocking" mode, the send timeout was reached.
+ *            NET_EOF       The connection was closed.
+ *            NET_ERR       Internal error.
+ */
+int net_sock_flush(net_sockhnd_t sockhnd);
+
 /**
  * @brief   Close a socket.
  *          Or do nothing if the socket was not open.  
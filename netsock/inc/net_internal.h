@@ -70,6 +70,7 @@
 #include "mbedtls/ctr_drbg.h"
 #include "mbedtls/certs.h"
 #include "mbedtls/x509.h"
+#include "mbedtls/version.h"
 #include "mbedtls/error.h"
 #include "mbedtls/debug.h"
 #include "mbedtls/timing.h"
@@ -102,11 +103,13 @@ typedef struct net_ctxt_s net_ctxt_t;
 typedef struct net_sock_ctxt_s net_sock_ctxt_t;
 
 typedef int net_sock_create_t(net_hnd_t nethnd, net_sockhnd_t * sockhnd, net_proto_t proto);
-typedef int net_sock_open_t(net_sockhnd_t sockhnd, const char * hostname, int remoteport, int localport);
+/* address: optional, the host already resolved; hostname stays its name, for the logs and the TLS/MQTT layers. */
+typedef int net_sock_open_t(net_sockhnd_t sockhnd, const char * hostname, const net_ipaddr_t * address, int remoteport, int localport);
 typedef int net_sock_recv_t(net_sockhnd_t sockhnd, uint8_t * const buf, size_t len);
 typedef int net_sock_recvfrom_t(net_sockhnd_t sockhnd, uint8_t * const buf, size_t len, net_ipaddr_t * remoteaddress, int * remoteport);
 typedef int net_sock_send_t(net_sockhnd_t sockhnd, const uint8_t * buf, size_t len);
 typedef int net_sock_sendto_t(net_sockhnd_t sockhnd, const uint8_t * buf, size_t len,  net_ipaddr_t * remoteaddress, int remoteport);
+typedef int net_sock_flush_t(net_sockhnd_t sockhnd);
 typedef int net_sock_close_t(net_sockhnd_t sockhnd);
 typedef int net_sock_destroy_t(net_sockhnd_t sockhnd);
 
@@ -116,20 +119,49 @@ typedef struct {
   net_sock_recvfrom_t * recvfrom;
   net_sock_send_t     * send;
   net_sock_sendto_t   * sendto;
+  net_sock_flush_t    * flush;    /**< Optional. NULL when the socket never holds outgoing data. */
   net_sock_close_t    * close;
   net_sock_destroy_t  * destroy;
 } net_sock_methods_t;
 
 #ifdef USE_MBED_TLS	/* For use with mbedTLS security stack*/
+/** TLS connection profiles, selected with the tls_profile socket option. */
+typedef enum {
+  NET_TLS_PROFILE_DEFAULT = 0,  /**< MBEDTLS_SSL_PRESET_DEFAULT: every suite and curve of the build. */
+  NET_TLS_PROFILE_FAST          /**< ECDHE-ECDSA on P-256 only. */
+} net_tls_profile_t;
+
+#if defined(MBEDTLS_KEY_EXCHANGE_ECDHE_ECDSA_ENABLED) && defined(MBEDTLS_ECP_DP_SECP256R1_ENABLED)
+#define NET_TLS_PROFILE_FAST_SUPPORTED
+#endif
+
+#if defined(MBEDTLS_KEY_EXCHANGE_PSK_ENABLED) || defined(MBEDTLS_KEY_EXCHANGE_ECDHE_PSK_ENABLED)
+#define NET_TLS_PSK_SUPPORTED
+#endif
+
 typedef struct {
-  unsigned char * tls_ca_certs; /**< Socket option. */
+  unsigned char * tls_ca_certs; /**< Socket option. PEM or DER. */
+  size_t tls_ca_certs_len;      /**< Socket option / meta. */
   unsigned char * tls_ca_crl;   /**< Socket option. */
-  unsigned char * tls_dev_cert; /**< Socket option. */
-  unsigned char * tls_dev_key;  /**< Socket option. */
+  unsigned char * tls_dev_cert; /**< Socket option. PEM or DER. */
+  size_t tls_dev_cert_len;      /**< Socket option / meta. */
+  unsigned char * tls_dev_key;  /**< Socket option. PEM or DER. */
+  size_t tls_dev_key_len;       /**< Socket option / meta. */
   uint8_t * tls_dev_pwd;        /**< Socket option. */
   size_t tls_dev_pwd_len;       /**< Socket option / meta. */
+  unsigned char * tls_psk;      /**< Socket option. Binary. Selects the PSK mode with tls_psk_identity. */
+  size_t tls_psk_len;           /**< Socket option / meta. */
+  unsigned char * tls_psk_identity; /**< Socket option. */
+  size_t tls_psk_identity_len;  /**< Socket option / meta. */
   bool tls_srv_verification;    /**< Socket option. */
   char * tls_srv_name;          /**< Socket option. */
+  net_tls_profile_t tls_profile; /**< Socket option. */
+  uint16_t tls_coalesce_size;   /**< Socket option. Write coalescing buffer size. 0: disabled. */
+  uint16_t tls_coalesce_delay;  /**< Socket option. Max age in ms of the coalesced data. 0: unbounded. */
+  uint8_t * tx_buf;             /**< Coalescing buffer. Allocated at open time. */
+  uint16_t tx_size;             /**< Size of tx_buf, tls_coalesce_size at its allocation. */
+  size_t tx_len;                /**< Coalesced length, pending the next record. */
+  uint32_t tx_start;            /**< Tick of the oldest coalesced write. */
   /* mbedTLS objects */
   mbedtls_entropy_context entropy;
 	mbedtls_ctr_drbg_context ctr_drbg;
@@ -181,6 +213,7 @@ struct net_ctxt_s {
 #define net_free(a)   free((a))
 
 int32_t net_timeout_left_ms(uint32_t init, uint32_t now, uint32_t timeout);
+bool net_ipaddr_to_ipv4(const net_ipaddr_t * address, uint8_t ip[4]);
 #ifdef USE_MBED_TLS
 extern int mbedtls_hardware_poll( void *data, unsigned char *output, size_t len, size_t *olen );
 #endif /* USE_MBED_TLS */
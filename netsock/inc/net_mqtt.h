@@ -26,6 +26,7 @@
 #endif /* LITMUS_LOOP */
 #define MQTT_READ_BUFFER_SIZE             600
 #define MQTT_CMD_TIMEOUT                  5000
+#define MQTT_TLS_WRITE_COALESCE           "1024" /**< tls_write_coalesce of the TLS connections: the publish header and payload are sent as one record. */
 #define MAX_SOCKET_ERRORS_BEFORE_NETIF_RESET  3
 
 #define MQTT_TOPIC_BUFFER_SIZE            100  /**< Maximum length of the application-defined topic names. */
@@ -37,7 +38,8 @@ typedef enum {
   CONN_SEC_NONE = 0,          /**< Clear connection */
   CONN_SEC_SERVERNOAUTH = 1,  /**< Encrypted TLS connection, with no authentication of the remote host: Shall NOT be used in a production environment. */
   CONN_SEC_SERVERAUTH = 2,    /**< Encrypted TLS connection, with authentication of the remote host. */
-  CONN_SEC_MUTUALAUTH = 3     /**< Encrypted TLS connection, with mutual authentication. */
+  CONN_SEC_MUTUALAUTH = 3,    /**< Encrypted TLS connection, with mutual authentication. */
+  CONN_SEC_PSK = 4            /**< Encrypted TLS connection, with mutual authentication by a pre-shared key. No certificate. */
 } conn_sec_t;
 
 typedef struct Network_s Network;
@@ -45,6 +47,7 @@ typedef struct Network_s Network;
 typedef int net_read_t(Network* n, unsigned char* buffer, int len, int timeout_ms);
 typedef int net_write_t(Network* n, unsigned char* buffer, int len, int timeout_ms);
 typedef int net_disconnect_t(Network* n);
+typedef int net_flush_t(Network* n);
 
 
 typedef uint32_t Mutex;
@@ -85,6 +88,9 @@ typedef struct {
   uint32_t		tls_dev_cert_len;
   const char* 	tls_dev_key;
   uint32_t		tls_dev_key_len;
+  const uint8_t* tls_psk;				/* CONN_SEC_PSK: binary key */
+  uint32_t		tls_psk_len;
+  const char* 	tls_psk_identity;		/* CONN_SEC_PSK: string */
 
 #ifdef LITMUS_LOOP
   char *LoopTopicId;
@@ -96,13 +102,19 @@ struct Network_s
 	net_read_t       *	mqttread;
 	net_write_t      *	mqttwrite;
 	net_disconnect_t *	mqttdisconnect;
+	net_flush_t      *	mqttflush;		/* Optional: emit the writes held by the transport. NULL if it sends them as they come. */
 	net_hnd_t 			netHandle;
 	net_sockhnd_t	 	sockHandle;
 	uint16_t			port;
 	net_ipaddr_t		hostip;
+	bool				hostip_valid;	/* hostip resolved: the reconnections do not look the broker up again */
+	int					read_timeout_ms;	/* sock_read_timeout of the socket, the timeout of network_read() rounded down to a step */
 };
 
+/* First connection: network interface, RTC time from NTP (once), broker address resolution and socket. */
 int  mqtt_network_init(Network *n, device_config_t* dev);
+/* Fast reconnection: new socket to the cached broker address, no NTP nor DNS. */
+int  mqtt_network_reconnect(Network *n, device_config_t* dev);
 void MutexLock(Mutex* mtx, int timeout);
 void MutexUnlock(Mutex* mtx);
 void MutexInit(Mutex* mtx);
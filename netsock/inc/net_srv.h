@@ -66,6 +66,7 @@ struct net_srv_conn_s{
 
 int net_srv_bind(net_hnd_t nethnd, net_sockhnd_t sockhnd, net_srv_conn_t* srv);
 int net_srv_listen(net_srv_conn_t* srv );
+int net_srv_accept(net_srv_conn_t* srv, uint32_t timeout);
 int net_srv_next_conn(net_srv_conn_t* srv);
 int net_srv_close(net_srv_conn_t* srv);
 
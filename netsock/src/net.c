@@ -446,9 +446,18 @@ int net_sock_create(net_hnd_t nethnd, net_sockhnd_t *sockhnd, net_proto_t proto)
 }
 
 int net_sock_open(net_sockhnd_t sockhnd, const char *hostname,
-		net_ipaddr_t *ipAddress, int remoteport, int localport) {
+		const net_ipaddr_t *ipAddress, int remoteport, int localport) {
 	net_sock_ctxt_t *sock = (net_sock_ctxt_t*) sockhnd;
-	return sock->methods.open(sockhnd, hostname, remoteport, localport);
+
+	return sock->methods.open(sockhnd, hostname, ipAddress, remoteport, localport);
+}
+
+bool net_ipaddr_to_ipv4(const net_ipaddr_t *address, uint8_t ip[4]) {
+	if ((address == NULL) || (address->ipv != NET_IP_V4)) {
+		return false;
+	}
+	memcpy(ip, &address->ip[12], 4);
+	return true;
 }
 
 int net_sock_setopt(net_sockhnd_t sockhnd, const char *optname,
@@ -466,6 +475,7 @@ int net_sock_setopt(net_sockhnd_t sockhnd, const char *optname,
       if (has_opt_data)
       {
         tlsData->tls_ca_certs = (unsigned char *) optbuf;
+        tlsData->tls_ca_certs_len = optlen;
         rc = NET_OK;
       }
     }
@@ -474,6 +484,7 @@ int net_sock_setopt(net_sockhnd_t sockhnd, const char *optname,
       if (has_opt_data)
       {
         tlsData->tls_dev_cert = (unsigned char *) optbuf;
+        tlsData->tls_dev_cert_len = optlen;
         rc = NET_OK;
       }
     }
@@ -482,6 +493,7 @@ int net_sock_setopt(net_sockhnd_t sockhnd, const char *optname,
       if (has_opt_data)
       {
         tlsData->tls_dev_key = (unsigned char *) optbuf;
+        tlsData->tls_dev_key_len = optlen;
         rc = NET_OK;
       }
     }
@@ -518,6 +530,69 @@ int net_sock_setopt(net_sockhnd_t sockhnd, const char *optname,
         rc = NET_OK;
       }
     }
+    if (strcmp(optname, "tls_profile") == 0)
+    {
+      if (has_opt_data)
+      {
+        if (strcmp((char const *) optbuf, "default") == 0)
+        {
+          tlsData->tls_profile = NET_TLS_PROFILE_DEFAULT;
+          rc = NET_OK;
+        }
+#ifdef NET_TLS_PROFILE_FAST_SUPPORTED
+        if (strcmp((char const *) optbuf, "fast") == 0)
+        {
+          tlsData->tls_profile = NET_TLS_PROFILE_FAST;
+          rc = NET_OK;
+        }
+#endif /* NET_TLS_PROFILE_FAST_SUPPORTED */
+      }
+    }
+#ifdef NET_TLS_PSK_SUPPORTED
+    if (strcmp(optname, "tls_psk") == 0)
+    {
+      if (has_opt_data)
+      {
+        tlsData->tls_psk = (unsigned char *) optbuf;
+        tlsData->tls_psk_len = optlen;
+        rc = NET_OK;
+      }
+    }
+    if (strcmp(optname, "tls_psk_identity") == 0)
+    {
+      if (has_opt_data)
+      {
+        tlsData->tls_psk_identity = (unsigned char *) optbuf;
+        /* The identity goes on the wire as is: drop a terminating null. */
+        tlsData->tls_psk_identity_len = (optbuf[optlen - 1] == '\0') ? optlen - 1 : optlen;
+        rc = (tlsData->tls_psk_identity_len > 0) ? NET_OK : NET_PARAM;
+      }
+    }
+#endif /* NET_TLS_PSK_SUPPORTED */
+    if (strcmp(optname, "tls_write_coalesce") == 0)
+    {
+      if (has_opt_data)
+      {
+        int size = atoi((char const *) optbuf);
+        if (tlsData->tx_buf == NULL)
+        {
+          tlsData->tls_coalesce_size = (size > 0) ? MIN(size, MBEDTLS_SSL_MAX_CONTENT_LEN) : 0;
+          rc = NET_OK;
+        }
+        else
+        {
+          rc = NET_PARAM;   /* The buffer is allocated at open time, with the size set before. */
+        }
+      }
+    }
+    if (strcmp(optname, "tls_write_coalesce_ms") == 0)
+    {
+      if (has_opt_data)
+      {
+        tlsData->tls_coalesce_delay = atoi((char const *) optbuf);
+        rc = NET_OK;
+      }
+    }
   }
 #else
   WiFi_Tls_t * tlsData = sock->wifi_tls;
@@ -579,6 +654,24 @@ int net_sock_setopt(net_sockhnd_t sockhnd, const char *optname,
       rc = NET_OK;
     }
   }
+  if ((sock->mqtt_ctx != NULL) && has_opt_data)
+  {
+    if (strcmp(optname, "mqtt_client_id") == 0)
+    {
+      sock->mqtt_ctx->client_id = (char *) optbuf;
+      rc = NET_OK;
+    }
+    if (strcmp(optname, "mqtt_pub_topic") == 0)
+    {
+      sock->mqtt_ctx->pub_topic = (char *) optbuf;
+      rc = NET_OK;
+    }
+    if (strcmp(optname, "mqtt_sub_topic") == 0)
+    {
+      sock->mqtt_ctx->sub_topic = (char *) optbuf;
+      rc = NET_OK;
+    }
+  }
 #endif /* USE_MBED_TLS or WIFI TLS Stack*/
 
 	if (strcmp(optname, "sock_blocking") == 0) {
@@ -637,6 +730,12 @@ int net_sock_sendto(net_sockhnd_t sockhnd, const uint8_t *buf, size_t len,
 			NET_PARAM;
 }
 
+int net_sock_flush(net_sockhnd_t sockhnd) {
+	net_sock_ctxt_t *sock = (net_sock_ctxt_t*) sockhnd;
+	return (sock->methods.flush != NULL) ?
+			sock->methods.flush(sockhnd) : NET_OK;
+}
+
 int net_sock_close(net_sockhnd_t sockhnd) {
 	net_sock_ctxt_t *sock = (net_sock_ctxt_t*) sockhnd;
 	return (sock->methods.close != NULL) ?
@@ -61,6 +61,15 @@
 #endif
 
 /* Private define ------------------------------------------------------------*/
+/* Step of the socket read timeout: a setopt only when the timeout of network_read() crosses a step */
+#ifdef MQTT_TASK_POLL_MS
+#define NET_MQTT_READ_STEP_MS	MQTT_TASK_POLL_MS
+#else
+#define NET_MQTT_READ_STEP_MS	20
+#endif
+
+/* Private variables ---------------------------------------------------------*/
+static bool rtc_synced = false;		/* RTC set from NTP once, kept across the reconnections */
 
 
 
@@ -77,6 +86,22 @@ int network_read(Network *n, unsigned char *buffer, int len, int timeout_ms) {
 
 	if (n->sockHandle == NULL) return NET_NOT_FOUND;
 
+	/* wait no longer than the caller: the MQTT_TASK network task polls with short reads between its writes,
+	 * MQTTWaitEvent() reads until the next client deadline, which may be now (1 ms: 0 is no timeout).
+	 * The deadlines of the client count down: rounded down to a step, the timeout of the socket changes
+	 * once per step instead of on every read, the client reads again for the rest. */
+	timeout_ms -= timeout_ms % NET_MQTT_READ_STEP_MS;
+	if (timeout_ms <= 0) {
+		timeout_ms = 1;
+	}
+	if (timeout_ms != n->read_timeout_ms) {
+		char stimeout[12];
+		snprintf(stimeout, sizeof(stimeout), "%d", timeout_ms);
+		if (net_sock_setopt(n->sockHandle, "sock_read_timeout", (const uint8_t*)stimeout, strlen(stimeout) + 1) == NET_OK) {
+			n->read_timeout_ms = timeout_ms;
+		}
+	}
+
 	bytes = net_sock_recv((net_sockhnd_t) n->sockHandle, buffer, len);
 	if (bytes < 0 && bytes != NET_TIMEOUT) {
 		msg_error("net_sock_recv failed - %d\n", bytes);
@@ -105,41 +130,36 @@ int network_write(Network *n, unsigned char *buffer, int len, int timeout_ms) {
 
 	return rc;
 }
+/** Function to emit the data held by the socket write coalescing
+ * @param - Address of Network Structure
+ * @return - 0 on SUCCESS
+ *         - -1 on FAILURE
+ **/
+int network_flush(Network *n) {
+	int rc;
+
+	if (n->sockHandle == NULL) return NET_NOT_FOUND;
+
+	rc = net_sock_flush((net_sockhnd_t) n->sockHandle);
+	if (rc < 0) {
+		msg_error("net_sock_flush failed - %d\n", rc);
+	}
+
+	return rc;
+}
+
 int network_disconnect(Network *n) {
 	net_sock_close(n->sockHandle);
 	net_sock_destroy(n->sockHandle);
+	n->sockHandle = NULL;
 	return 0;
 }
 
-int mqtt_network_init(Network *n, device_config_t* dev) {
+/* Create, configure and open the socket to the broker: at its cached address if it was resolved. */
+static int network_open(Network *n, device_config_t* dev) {
 	int rc = NET_ERR;
 
-	n->mqttdisconnect = network_disconnect;
-	n->mqttread = network_read;
-	n->mqttwrite = network_write;
-
-	if (hnet == NULL){ /* if network is not yet initialized*/
-		rc = net_init(&hnet, NET_IF, net_if_init);
-		if (rc != NET_OK) {
-			return NET_NOT_FOUND;	/* Must return as there is no network link*/
-		}else{
-			n->netHandle = hnet;
-			rc = NET_OK;
-		}
-	}
-
-	/* start the rtc timer*/
-	uint8_t date[12];
-	uint8_t time[12];
-	if (setRTCTimeDateFromNetwork(0) == TD_ERR_RTC){
-		msg_error("ntp get time from network failed...");
-		msg_error("program halted...!!!");
-		while(1);
-	}
-	RTC_CalendarShow(time, date);
-	msg_info("[RTC]** UTC-date: %s UTC-time: %s ** -5 to actual time **", date, time);
-	//rtc_initialize(&rtc);
-
+	n->mqttflush = NULL;
 	rc = net_sock_create(n->netHandle, &n->sockHandle, (dev->HostPort == 1883)?NET_PROTO_TCP:NET_PROTO_TLS);
 	if (rc != NET_OK) {
 		rc = NET_ERR;
@@ -175,34 +195,118 @@ int mqtt_network_init(Network *n, device_config_t* dev) {
 
 	if (dev->ConnSecurity == CONN_SEC_SERVERAUTH && rc == NET_OK){
 		(void)net_sock_setopt(n->sockHandle, "tls_ca_certs",
-				(const uint8_t*)dev->tls_ca_certs, strlen(dev->tls_ca_certs));
+				(const uint8_t*)dev->tls_ca_certs, dev->tls_ca_certs_len);
 		(void)net_sock_setopt(n->sockHandle, "tls_server_verification", NULL, 0);
 	}
 
+	if (dev->ConnSecurity == CONN_SEC_PSK && rc == NET_OK){
+		/* Pre-shared key only: the certificate fields of dev are ignored. */
+		if ((dev->tls_psk_identity == NULL)
+				|| (net_sock_setopt(n->sockHandle, "tls_psk", dev->tls_psk, dev->tls_psk_len) != NET_OK)
+				|| (net_sock_setopt(n->sockHandle, "tls_psk_identity",
+						(const uint8_t*)dev->tls_psk_identity, strlen(dev->tls_psk_identity)) != NET_OK)){
+			msg_error("TLS-PSK mode requires tls_psk and tls_psk_identity...\n");
+			net_sock_destroy(n->sockHandle);
+			n->sockHandle = NULL;
+			rc = NET_PARAM;
+		}
+	}
+
 	if (dev->ConnSecurity == CONN_SEC_NONE && rc == NET_OK){
 		(void)net_sock_setopt(n->sockHandle, "tls_server_noverification", NULL, 0);
 	}
+#else
+	/* TLS of the es-WiFi module: it is given the certificates at the opening, no PSK mode */
+	if ((dev->HostPort != 1883) && (rc == NET_OK)){
+		bool verify = (dev->ConnSecurity == CONN_SEC_SERVERAUTH) || (dev->ConnSecurity == CONN_SEC_MUTUALAUTH);
+
+		if (dev->tls_ca_certs && verify){
+			(void)net_sock_setopt(n->sockHandle, "tls_ca_certs",
+					(const uint8_t*)dev->tls_ca_certs, dev->tls_ca_certs_len);
+		}
+		if (dev->tls_dev_cert && dev->tls_dev_key && dev->ConnSecurity == CONN_SEC_MUTUALAUTH){
+			(void)net_sock_setopt(n->sockHandle, "tls_dev_cert",
+					(const uint8_t*)dev->tls_dev_cert, dev->tls_dev_cert_len);
+			(void)net_sock_setopt(n->sockHandle, "tls_dev_key",
+					(const uint8_t*)dev->tls_dev_key, dev->tls_dev_key_len);
+		}
+		(void)net_sock_setopt(n->sockHandle, (verify && dev->tls_ca_certs)
+				? "tls_server_verification" : "tls_server_noverification", NULL, 0);
+	}
+#endif
 
 	if (rc == NET_OK){
 		/* ASCII timeout strings (include the null terminator or pass strlen) */
 		net_sock_setopt(n->sockHandle, "sock_read_timeout",  (const uint8_t*)"5000", strlen("5000"));
+		n->read_timeout_ms = 5000;
 		net_sock_setopt(n->sockHandle, "sock_write_timeout", (const uint8_t*)"5000", strlen("5000"));
+#ifdef USE_MBED_TLS
 		(void)net_sock_setopt(n->sockHandle, "tls_server_name",
 							  (const uint8_t*)dev->HostName, strlen(dev->HostName));
-		rc = net_sock_open(n->sockHandle, dev->HostName, NULL, dev->HostPort, 0);
-	}
+		/* The client writes the publish header and payload separately: combine them into one record. */
+		if ((dev->HostPort != 1883)
+				&& (net_sock_setopt(n->sockHandle, "tls_write_coalesce",
+						(const uint8_t*)MQTT_TLS_WRITE_COALESCE, strlen(MQTT_TLS_WRITE_COALESCE)) == NET_OK)){
+			n->mqttflush = network_flush;
+		}
 #endif
+		rc = net_sock_open(n->sockHandle, dev->HostName, (n->hostip_valid) ? &n->hostip : NULL, dev->HostPort, 0);
+	}
 
 	if (rc != NET_OK) {
 		rc = NET_ERR;
 		msg_error("error creating/opening socket for mqtt client connection...\n");
 	}else{
 		n->port = dev->HostPort;
-		net_get_hostaddress(n->netHandle, &n->hostip, dev->HostName);
 	}
 	return rc;
 }
 
+int mqtt_network_init(Network *n, device_config_t* dev) {
+	int rc = NET_ERR;
+
+	n->mqttdisconnect = network_disconnect;
+	n->mqttread = network_read;
+	n->mqttwrite = network_write;
+	n->mqttflush = NULL;
+
+	if (hnet == NULL){ /* if network is not yet initialized*/
+		rc = net_init(&hnet, NET_IF, net_if_init);
+		if (rc != NET_OK) {
+			return NET_NOT_FOUND;	/* Must return as there is no network link*/
+		}
+	}
+	n->netHandle = hnet;
+
+	/* start the rtc timer: it keeps the time afterwards, the reconnections do not need NTP */
+	if (!rtc_synced) {
+		uint8_t date[12];
+		uint8_t time[12];
+		if (setRTCTimeDateFromNetwork(0) == TD_ERR_RTC){
+			msg_error("ntp get time from network failed...");
+			return NET_ERR;
+		}
+		RTC_CalendarShow(time, date);
+		msg_info("[RTC]** UTC-date: %s UTC-time: %s ** -5 to actual time **", date, time);
+		rtc_synced = true;
+	}
+
+	/* resolve the broker address, kept for mqtt_network_reconnect() */
+	n->hostip_valid = (net_get_hostaddress(n->netHandle, &n->hostip, dev->HostName) == NET_OK);
+	if (!n->hostip_valid) {
+		msg_error("%s could not be resolved, the socket will try again...\n", dev->HostName);
+	}
+
+	return network_open(n, dev);
+}
+
+int mqtt_network_reconnect(Network *n, device_config_t* dev) {
+	if (n->sockHandle != NULL) {
+		network_disconnect(n);
+	}
+	return network_open(n, dev);
+}
+
 #ifdef MQTT_TASK
 osMutexDef(mqtt);
 
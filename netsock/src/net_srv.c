@@ -92,18 +92,24 @@ int net_srv_bind(net_hnd_t nethnd, net_sockhnd_t sockhnd, net_srv_conn_t* srv)
 int net_srv_listen(net_srv_conn_t* srv )
 {
 	int rc = NET_ERR;
+	while( (rc = net_srv_accept(srv, 2000)) != NET_OK);
+	return rc;
+}
+
+/*wait at most timeout ms for a remote connection, NET_TIMEOUT if none*/
+int net_srv_accept(net_srv_conn_t* srv, uint32_t timeout)
+{
 	uint8_t ip[4] = {0};
 	uint16_t port;
 	net_sock_ctxt_t *sock = (net_sock_ctxt_t * ) srv->sock;
-	while( (rc = WIFI_WaitServerConnection((uint32_t)sock->underlying_sock_ctxt, 2000, ip, sizeof(ip), &port)) != WIFI_STATUS_OK);
-
-	if (rc == WIFI_STATUS_OK){
-		srv->remoteport = port;
-		for (int i=0;i<4;i++){
-			srv->remoteip.ip[12+i] = ip[i];
-		}
+	if (WIFI_WaitServerConnection((uint32_t)sock->underlying_sock_ctxt, timeout, ip, sizeof(ip), &port) != WIFI_STATUS_OK){
+		return NET_TIMEOUT;
 	}
-	return rc;
+	srv->remoteport = port;
+	for (int i=0;i<4;i++){
+		srv->remoteip.ip[12+i] = ip[i];
+	}
+	return NET_OK;
 }
 
 int net_srv_next_conn(net_srv_conn_t* srv)
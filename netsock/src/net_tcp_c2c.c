@@ -65,7 +65,7 @@ char OperatorsString[C2C_OPERATORS_LIST + 1];
 
 /* Private function prototypes -----------------------------------------------*/
 int net_sock_create_c2c(net_hnd_t nethnd, net_sockhnd_t * sockhnd, net_proto_t proto);
-int net_sock_open_c2c(net_sockhnd_t sockhnd, const char * hostname, int remoteport, int localport);
+int net_sock_open_c2c(net_sockhnd_t sockhnd, const char * hostname, const net_ipaddr_t * address, int remoteport, int localport);
 int net_sock_recv_tcp_c2c(net_sockhnd_t sockhnd, uint8_t * buf, size_t len);
 int net_sock_recvfrom_udp_c2c(net_sockhnd_t sockhnd, uint8_t * const buf, size_t len, net_ipaddr_t * remoteaddress, int * remoteport);
 int net_sock_send_tcp_c2c(net_sockhnd_t sockhnd, const uint8_t * buf, size_t len);
@@ -125,7 +125,7 @@ int net_sock_create_c2c(net_hnd_t nethnd, net_sockhnd_t * sockhnd, net_proto_t p
 }
 
 
-int net_sock_open_c2c(net_sockhnd_t sockhnd, const char * hostname, int remoteport, int localport)
+int net_sock_open_c2c(net_sockhnd_t sockhnd, const char * hostname, const net_ipaddr_t * address, int remoteport, int localport)
 {
   int rc = NET_ERR;
   net_sock_ctxt_t *sock = (net_sock_ctxt_t * ) sockhnd;
@@ -169,7 +169,7 @@ int net_sock_open_c2c(net_sockhnd_t sockhnd, const char * hostname, int remotepo
         }
         else
         {
-          if (C2C_GetHostAddress((char *)hostname, ip_addr) != C2C_RET_OK)
+          if (!net_ipaddr_to_ipv4(address, ip_addr) && (C2C_GetHostAddress((char *)hostname, ip_addr) != C2C_RET_OK))
           {
             /* NB: This blocking call may take several seconds before returning.
              *     An asynchronous interface should be added. */
@@ -55,7 +55,7 @@
 /* Private variables ---------------------------------------------------------*/
 /* Private function prototypes -----------------------------------------------*/
 int net_sock_create_lwip(net_hnd_t nethnd, net_sockhnd_t * sockhnd, net_proto_t proto);
-int net_sock_open_lwip(net_sockhnd_t sockhnd, const char * hostname, int remoteport, int localport);
+int net_sock_open_lwip(net_sockhnd_t sockhnd, const char * hostname, const net_ipaddr_t * address, int remoteport, int localport);
 int net_sock_recv_tcp_lwip(net_sockhnd_t sockhnd, uint8_t * buf, size_t len);
 int net_sock_recvfrom_udp_lwip(net_sockhnd_t sockhnd, uint8_t * const buf, size_t len, net_ipaddr_t * remoteaddress, int * remoteport);
 int net_sock_send_tcp_lwip( net_sockhnd_t sockhnd, const uint8_t * buf, size_t len);
@@ -114,11 +114,14 @@ int net_sock_create_lwip(net_hnd_t nethnd, net_sockhnd_t * sockhnd, net_proto_t
 }
 
 
-int net_sock_open_lwip(net_sockhnd_t sockhnd, const char * hostname, int dstport, int localport)
+int net_sock_open_lwip(net_sockhnd_t sockhnd, const char * hostname, const net_ipaddr_t * address, int dstport, int localport)
 {
   int rc = NET_OK;
   int ret = 0;
   net_sock_ctxt_t *sock = (net_sock_ctxt_t * ) sockhnd;
+  uint8_t ip[4];
+  char ipBuffer[16];
+  const char * node = hostname;
   
   char portBuffer[6];
   struct addrinfo hints;
@@ -164,7 +167,15 @@ int net_sock_open_lwip(net_sockhnd_t sockhnd, const char * hostname, int dstport
     return rc;
   }
   
-  if( ((ret = getaddrinfo(hostname, portBuffer, &hints, &list)) != 0) || (list == NULL) )
+  /* A resolved address is given to getaddrinfo() as a numeric host: no DNS query. */
+  if (net_ipaddr_to_ipv4(address, ip))
+  {
+    snprintf(ipBuffer, sizeof(ipBuffer), "%u.%u.%u.%u", ip[0], ip[1], ip[2], ip[3]);
+    node = ipBuffer;
+    hints.ai_flags |= AI_NUMERICHOST;
+  }
+
+  if( ((ret = getaddrinfo(node, portBuffer, &hints, &list)) != 0) || (list == NULL) )
   {
     msg_info("The address of %s could not be resolved. Error: %d.\n", hostname, ret);
     rc = NET_NOT_FOUND;
@@ -67,7 +67,7 @@
 /* Private variables ---------------------------------------------------------*/
 /* Private function prototypes -----------------------------------------------*/
 int net_sock_create_wifi(net_hnd_t nethnd, net_sockhnd_t * sockhnd, net_proto_t proto);
-int net_sock_open_wifi(net_sockhnd_t sockhnd, const char * hostname, int remoteport, int localport);
+int net_sock_open_wifi(net_sockhnd_t sockhnd, const char * hostname, const net_ipaddr_t * address, int remoteport, int localport);
 int net_sock_recv_tcp_wifi(net_sockhnd_t sockhnd, uint8_t * buf, size_t len);
 int net_sock_recvfrom_udp_wifi(net_sockhnd_t sockhnd, uint8_t * const buf, size_t len, net_ipaddr_t * remoteaddress, int * remoteport);
 int net_sock_send_tcp_wifi(net_sockhnd_t sockhnd, const uint8_t * buf, size_t len);
@@ -125,7 +125,31 @@ int net_sock_create_wifi(net_hnd_t nethnd, net_sockhnd_t * sockhnd, net_proto_t
 }
 
 
-int net_sock_open_wifi(net_sockhnd_t sockhnd, const char * hostname, int remoteport, int localport)
+/* Dotted IPv4 address string: the module does not need to resolve it. */
+static bool net_parse_ipv4(const char * s, uint8_t ip[4])
+{
+  for (int i = 0; i < 4; i++)
+  {
+    unsigned int v = 0;
+    int digits = 0;
+
+    while ((*s >= '0') && (*s <= '9') && (digits < 3))
+    {
+      v = v * 10 + (*s++ - '0');
+      digits++;
+    }
+    if ((digits == 0) || (v > 255) || (*s != ((i < 3) ? '.' : '\0')))
+    {
+      return false;
+    }
+    ip[i] = (uint8_t) v;
+    s++;
+  }
+  return true;
+}
+
+
+int net_sock_open_wifi(net_sockhnd_t sockhnd, const char * hostname, const net_ipaddr_t * address, int remoteport, int localport)
 {
   int rc = NET_ERR;
   net_sock_ctxt_t *sock = (net_sock_ctxt_t * ) sockhnd;
@@ -169,7 +193,8 @@ int net_sock_open_wifi(net_sockhnd_t sockhnd, const char * hostname, int remotep
         }
         else
         {
-          if (WIFI_GetHostAddress((char *)hostname, ip_addr, sizeof(ip_addr) ) != WIFI_STATUS_OK)
+          if (!net_ipaddr_to_ipv4(address, ip_addr) && !net_parse_ipv4(hostname, ip_addr)
+              && (WIFI_GetHostAddress((char *)hostname, ip_addr, sizeof(ip_addr) ) != WIFI_STATUS_OK))
           {
             // TODO: Defect report on WIFI_GetHostAddress() which return code is not informative.
             // NB: This blocking call may take several seconds before returning. An asynchronous interface should be added.
@@ -183,7 +208,8 @@ int net_sock_open_wifi(net_sockhnd_t sockhnd, const char * hostname, int remotep
         }
         break;
       case NET_PROTO_UDP:
-          if (WIFI_GetHostAddress((char *)hostname, ip_addr, sizeof(ip_addr)) != WIFI_STATUS_OK)
+          if (!net_ipaddr_to_ipv4(address, ip_addr) && !net_parse_ipv4(hostname, ip_addr)
+              && (WIFI_GetHostAddress((char *)hostname, ip_addr, sizeof(ip_addr)) != WIFI_STATUS_OK))
           {
             // TODO: Defect report on WIFI_GetHostAddress() which return code is not informative.
             // NB: This blocking call may take several seconds before returning. An asynchronous interface should be added.
@@ -51,16 +51,57 @@
 /* Private defines -----------------------------------------------------------*/
 /* Private typedef -----------------------------------------------------------*/
 /* Private variables ---------------------------------------------------------*/
+#ifdef NET_TLS_PROFILE_FAST_SUPPORTED
+/* "fast" profile: a short ClientHello, no negotiation towards larger curves
+ * or SHA-384, and a single curve for both ECDHE and the server signature. */
+static const int tls_fast_ciphersuites[] =
+{
+  MBEDTLS_TLS_ECDHE_ECDSA_WITH_AES_128_GCM_SHA256,
+  MBEDTLS_TLS_ECDHE_ECDSA_WITH_AES_128_CCM,
+  MBEDTLS_TLS_ECDHE_ECDSA_WITH_AES_128_CBC_SHA256,
+  0
+};
+static const mbedtls_ecp_group_id tls_fast_curves[] =
+{
+  MBEDTLS_ECP_DP_SECP256R1,
+  MBEDTLS_ECP_DP_NONE
+};
+static const int tls_fast_sig_hashes[] =
+{
+  MBEDTLS_MD_SHA256,
+  MBEDTLS_MD_NONE
+};
+#endif /* NET_TLS_PROFILE_FAST_SUPPORTED */
+
+#ifdef NET_TLS_PSK_SUPPORTED
+/* PSK mode: forward secrecy first, then plain PSK which costs no public-key
+ * operation at all. Suites left out of the build are skipped by mbedTLS. */
+static const int tls_psk_ciphersuites[] =
+{
+  MBEDTLS_TLS_ECDHE_PSK_WITH_AES_128_CBC_SHA256,
+  MBEDTLS_TLS_PSK_WITH_AES_128_GCM_SHA256,
+  MBEDTLS_TLS_PSK_WITH_AES_128_CCM,
+  MBEDTLS_TLS_PSK_WITH_AES_128_CBC_SHA256,
+  0
+};
+#endif /* NET_TLS_PSK_SUPPORTED */
+
 /* Private function prototypes -----------------------------------------------*/
 int net_sock_create_mbedtls(net_hnd_t nethnd, net_sockhnd_t * sockhnd, net_proto_t proto);
-int net_sock_open_mbedtls(net_sockhnd_t sockhnd, const char * hostname, int dstport, int localport);
+int net_sock_open_mbedtls(net_sockhnd_t sockhnd, const char * hostname, const net_ipaddr_t * address, int dstport, int localport);
 int net_sock_recv_mbedtls(net_sockhnd_t sockhnd, uint8_t * const buf, size_t len);
 int net_sock_send_mbedtls(net_sockhnd_t sockhnd, const uint8_t * buf, size_t len);
+int net_sock_flush_mbedtls(net_sockhnd_t sockhnd);
 int net_sock_close_mbedtls(net_sockhnd_t sockhnd);
 int net_sock_destroy_mbedtls(net_sockhnd_t sockhnd);
 
 static void my_debug( void *ctx, int level, const char *file, int line, const char *str );
 static void internal_close(net_sock_ctxt_t * sock);
+static bool tls_is_der(const unsigned char * buf, size_t len);
+static size_t tls_pem_len(const unsigned char * buf, size_t len);
+static int tls_crt_parse(mbedtls_x509_crt * chain, const unsigned char * buf, size_t len);
+static int tls_write(net_sock_ctxt_t * sock, const uint8_t * buf, size_t len);
+static bool tls_tx_expired(net_tls_data_t * tlsData);
 
 /* Functions Definition ------------------------------------------------------*/
 
@@ -97,6 +138,7 @@ int net_sock_create_mbedtls(net_hnd_t nethnd, net_sockhnd_t * sockhnd, net_proto
       sock->methods.open    = (net_sock_open_mbedtls);
       sock->methods.recv    = (net_sock_recv_mbedtls);
       sock->methods.send    = (net_sock_send_mbedtls);
+      sock->methods.flush   = (net_sock_flush_mbedtls);
       sock->methods.close   = (net_sock_close_mbedtls);
       sock->methods.destroy = (net_sock_destroy_mbedtls);
       sock->proto           = proto;
@@ -115,11 +157,13 @@ int net_sock_create_mbedtls(net_hnd_t nethnd, net_sockhnd_t * sockhnd, net_proto
 }
 
 
-int net_sock_open_mbedtls(net_sockhnd_t sockhnd, const char * hostname, int dstport, int localport)
+int net_sock_open_mbedtls(net_sockhnd_t sockhnd, const char * hostname, const net_ipaddr_t * address, int dstport, int localport)
 {
   int rc = NET_ERR;
   net_sock_ctxt_t *sock = (net_sock_ctxt_t * ) sockhnd;
   net_tls_data_t * tlsData = sock->tlsData;
+  /* PSK mode: no certificate is parsed nor configured. */
+  bool psk_mode = (tlsData->tls_psk != NULL) && (tlsData->tls_psk_identity != NULL);
 
   /* mbedTLS instance */
   int ret = 0;
@@ -162,10 +206,10 @@ int net_sock_open_mbedtls(net_sockhnd_t sockhnd, const char * hostname, int dstp
   }
 
 	/* Root CA */
-	if (tlsData->tls_ca_certs != NULL) {
-		if ((ret = mbedtls_x509_crt_parse(&tlsData->cacert,
+	if ((!psk_mode) && (tlsData->tls_ca_certs != NULL)) {
+		if ((ret = tls_crt_parse(&tlsData->cacert,
 				(unsigned char const*) tlsData->tls_ca_certs,
-				strlen((char const*) tlsData->tls_ca_certs) + 1)) != 0) {
+				tlsData->tls_ca_certs_len)) != 0) {
 			char errbuf[128];
 			mbedtls_strerror(ret, errbuf, sizeof(errbuf));
 			msg_debug("crt_parse rc = -0x%x (%s)\n", -ret, errbuf);
@@ -177,7 +221,7 @@ int net_sock_open_mbedtls(net_sockhnd_t sockhnd, const char * hostname, int dstp
 		}
 	}
   
-  if (tlsData->tls_ca_crl != NULL)
+  if ((!psk_mode) && (tlsData->tls_ca_crl != NULL))
   {
     if( (ret = mbedtls_x509_crl_parse(&tlsData->cacrl, (unsigned char const *)tlsData->tls_ca_crl, strlen((char const *) tlsData->tls_ca_crl) + 1)) != 0 )
     { 
@@ -188,9 +232,9 @@ int net_sock_open_mbedtls(net_sockhnd_t sockhnd, const char * hostname, int dstp
   }
 
   /* Client cert. and key */
-  if( (tlsData->tls_dev_cert != NULL) && (tlsData->tls_dev_key != NULL) )
+  if( (!psk_mode) && (tlsData->tls_dev_cert != NULL) && (tlsData->tls_dev_key != NULL) )
   {
-    if( (ret = mbedtls_x509_crt_parse(&tlsData->clicert, (unsigned char const *)tlsData->tls_dev_cert, strlen((char const *)tlsData->tls_dev_cert) + 1)) != 0 )
+    if( (ret = tls_crt_parse(&tlsData->clicert, (unsigned char const *)tlsData->tls_dev_cert, tlsData->tls_dev_cert_len)) != 0 )
     {
       msg_error(" failed\n  !  mbedtls_x509_crt_parse returned -0x%x while parsing device cert\n", -ret);
       internal_close(sock);
@@ -210,7 +254,9 @@ int net_sock_open_mbedtls(net_sockhnd_t sockhnd, const char * hostname, int dstp
     extern mbedtls_pk_info_t mbedtls_firewall_info;
     tlsData->pkey.pk_info = &mbedtls_firewall_info;
 #else /* FIREWALL_MBEDLIB */
-    if( (ret = mbedtls_pk_parse_key(&tlsData->pkey, (unsigned char const *)tlsData->tls_dev_key, strlen((char const *)tlsData->tls_dev_key) + 1,
+    /* A DER key skips the PEM armor search and the base64 pass. */
+    if( (ret = mbedtls_pk_parse_key(&tlsData->pkey, (unsigned char const *)tlsData->tls_dev_key,
+           tls_is_der(tlsData->tls_dev_key, tlsData->tls_dev_key_len) ? tlsData->tls_dev_key_len : tls_pem_len(tlsData->tls_dev_key, tlsData->tls_dev_key_len),
            (unsigned char const *)tlsData->tls_dev_pwd, tlsData->tls_dev_pwd_len)) != 0 )
     {
       msg_error(" failed\n  !  mbedtls_pk_parse_key returned -0x%x while parsing private key\n\n", -ret);
@@ -248,10 +294,30 @@ int net_sock_open_mbedtls(net_sockhnd_t sockhnd, const char * hostname, int dstp
     return NET_ERR;
   }
 
-#if 0
-  mbedtls_ssl_conf_cert_profile(&sock->conf, &mbedtls_x509_crt_XXX_suite);
-  // TODO: Allow the user to select a TLS profile?
-#endif
+#ifdef NET_TLS_PROFILE_FAST_SUPPORTED
+  if (tlsData->tls_profile == NET_TLS_PROFILE_FAST)
+  {
+    mbedtls_ssl_conf_ciphersuites(&tlsData->conf, tls_fast_ciphersuites);
+    mbedtls_ssl_conf_curves(&tlsData->conf, tls_fast_curves);
+    mbedtls_ssl_conf_sig_hashes(&tlsData->conf, tls_fast_sig_hashes);
+  }
+#endif /* NET_TLS_PROFILE_FAST_SUPPORTED */
+#ifdef NET_TLS_PSK_SUPPORTED
+  if (psk_mode)
+  {
+    /* The key authenticates both ends: the server sends no certificate. */
+    if( (ret = mbedtls_ssl_conf_psk(&tlsData->conf, tlsData->tls_psk, tlsData->tls_psk_len,
+           tlsData->tls_psk_identity, tlsData->tls_psk_identity_len)) != 0)
+    {
+      msg_error(" failed\n  ! mbedtls_ssl_conf_psk returned -0x%x\n\n", -ret);
+      internal_close(sock);
+      return NET_ERR;
+    }
+    mbedtls_ssl_conf_ciphersuites(&tlsData->conf, tls_psk_ciphersuites);
+    mbedtls_ssl_conf_authmode(&tlsData->conf, MBEDTLS_SSL_VERIFY_NONE);
+  }
+  else
+#endif /* NET_TLS_PSK_SUPPORTED */
   /* Only for debug
    * mbedtls_ssl_conf_verify(&(tlsDataParams->conf), _iot_tls_verify_cert, NULL); */
   if(tlsData->tls_srv_verification == true)
@@ -264,9 +330,12 @@ int net_sock_open_mbedtls(net_sockhnd_t sockhnd, const char * hostname, int dstp
   }
 
   mbedtls_ssl_conf_rng(&tlsData->conf, mbedtls_ctr_drbg_random, &tlsData->ctr_drbg);
-  mbedtls_ssl_conf_ca_chain(&tlsData->conf, &tlsData->cacert, (tlsData->tls_ca_crl != NULL) ? &tlsData->cacrl : NULL);
+  if (!psk_mode)
+  {
+    mbedtls_ssl_conf_ca_chain(&tlsData->conf, &tlsData->cacert, (tlsData->tls_ca_crl != NULL) ? &tlsData->cacrl : NULL);
+  }
 
-  if( (tlsData->tls_dev_cert != NULL) && (tlsData->tls_dev_key != NULL) )
+  if( (!psk_mode) && (tlsData->tls_dev_cert != NULL) && (tlsData->tls_dev_key != NULL) )
   {
     if( (ret = mbedtls_ssl_conf_own_cert(&tlsData->conf, &tlsData->clicert, &tlsData->pkey)) != 0)
     {
@@ -310,7 +379,7 @@ int net_sock_open_mbedtls(net_sockhnd_t sockhnd, const char * hostname, int dstp
   
   msg_debug("\n\nSSL state connect : %d ", sock->tlsData->ssl.state);
 
-  if( (ret = net_sock_open(sock->underlying_sock_ctxt, hostname, NULL, dstport, localport)) != NET_OK )
+  if( (ret = net_sock_open(sock->underlying_sock_ctxt, hostname, address, dstport, localport)) != NET_OK )
   {
     msg_error(" failed to connect to %s:%d  ! net_sock_open returned %d\n", hostname, dstport, ret);
     if (net_sock_destroy(sock->underlying_sock_ctxt) != NET_OK )
@@ -373,6 +442,17 @@ int net_sock_open_mbedtls(net_sockhnd_t sockhnd, const char * hostname, int dstp
 
   msg_debug("  . Verifying peer X.509 certificate...");
 
+  if (tlsData->tls_coalesce_size > 0)
+  {
+    tlsData->tx_len = 0;
+    tlsData->tx_buf = net_malloc(tlsData->tls_coalesce_size);
+    tlsData->tx_size = tlsData->tls_coalesce_size;
+    if (tlsData->tx_buf == NULL)
+    {
+      msg_error("Write coalescing buffer allocation failed. Sending without coalescing.\n");
+    }
+  }
+
 
 #if 0
 #ifdef msg_debug
@@ -399,6 +479,12 @@ int net_sock_recv_mbedtls(net_sockhnd_t sockhnd, uint8_t * buf, size_t len)
   int read = 0;
   int ret = 0;
   uint32_t start_time = HAL_GetTick();
+
+  /* A reader waits for an answer to what it sent: do not hold it back. */
+  if ((rc = net_sock_flush_mbedtls(sockhnd)) != NET_OK)
+  {
+    return rc;
+  }
   
   do
   {
@@ -449,45 +535,73 @@ int net_sock_send_mbedtls( net_sockhnd_t sockhnd, const uint8_t * buf, size_t le
   int rc = 0;
   net_sock_ctxt_t *sock = (net_sock_ctxt_t * ) sockhnd;
   net_tls_data_t * tlsData = sock->tlsData;
-  int sent = 0;
-  int ret = 0;
-  uint32_t start_time = HAL_GetTick();
-  
-  do
+
+  if (tlsData->tx_buf == NULL)
   {
-    if (sock->blocking == true)
+    return tls_write(sock, buf, len);
+  }
+
+  /* Write coalescing: the pending data goes first if the new write does not fit. */
+  if (tlsData->tx_len + len > tlsData->tx_size)
+  {
+    if ((rc = net_sock_flush_mbedtls(sockhnd)) != NET_OK)
     {
-      if (net_timeout_left_ms(start_time, HAL_GetTick(), sock->write_timeout) <= 0)
-      {
-        rc = NET_TIMEOUT;
-        break;
-      }
+      return rc;
     }
-    
-    ret = mbedtls_ssl_write(&tlsData->ssl, buf + sent, len - sent);
-    if (ret > 0)
+    if (tlsData->tx_len > 0)
     {
-      sent += ret;
+      return 0;   /* Non-blocking socket, the pending data is not all out: would block. */
     }
-    else
+  }
+  if (len >= tlsData->tx_size)
+  {
+    return tls_write(sock, buf, len);   /* Would fill the buffer alone: skip the copy. */
+  }
+
+  if (tlsData->tx_len == 0)
+  {
+    tlsData->tx_start = HAL_GetTick();
+  }
+  memcpy(tlsData->tx_buf + tlsData->tx_len, buf, len);
+  tlsData->tx_len += len;
+
+  if ( (tlsData->tx_len == tlsData->tx_size) || tls_tx_expired(tlsData) )
+  {
+    if ((rc = net_sock_flush_mbedtls(sockhnd)) != NET_OK)
     {
-      switch(ret)
-      {
-        case 0:
-          rc = NET_EOF;
-          break;
-        case MBEDTLS_ERR_SSL_WANT_READ:
-        case MBEDTLS_ERR_SSL_WANT_WRITE:
-          /* Nothing to do. The while() below handles the case. */
-          break;
-        default:
-          msg_error(" failed\n  ! mbedtls_ssl_write returned -0x%x\n\n", -ret);
-          rc = NET_ERR;
-      }
+      return rc;
     }
-  } while ( ((ret == MBEDTLS_ERR_SSL_WANT_READ) || (ret == MBEDTLS_ERR_SSL_WANT_WRITE)) && (sock->blocking == true) && (rc == 0));
-  
-  return (rc < 0) ? rc : sent;
+  }
+
+  return len;
+}
+
+
+int net_sock_flush_mbedtls(net_sockhnd_t sockhnd)
+{
+  net_sock_ctxt_t *sock = (net_sock_ctxt_t * ) sockhnd;
+  net_tls_data_t * tlsData = sock->tlsData;
+  int ret = 0;
+
+  if (tlsData->tx_len == 0)
+  {
+    return NET_OK;
+  }
+
+  ret = tls_write(sock, tlsData->tx_buf, tlsData->tx_len);
+  if (ret < 0)
+  {
+    tlsData->tx_len = 0;  /* The connection is lost: drop the pending data. */
+    return ret;
+  }
+  if ((size_t) ret < tlsData->tx_len)
+  {
+    /* Non-blocking socket: keep the remainder for the next call. */
+    memmove(tlsData->tx_buf, tlsData->tx_buf + ret, tlsData->tx_len - ret);
+  }
+  tlsData->tx_len -= ret;
+
+  return NET_OK;
 }
 
 
@@ -498,6 +612,11 @@ int net_sock_close_mbedtls(net_sockhnd_t sockhnd)
   int ret = 0;
   /* Closure notification is required by TLS if the session was not already closed by the remote host. */ 
   net_tls_data_t * tlsData = sock->tlsData;
+
+  if (net_sock_flush_mbedtls(sockhnd) != NET_OK)
+  {
+    msg_error("The coalesced data could not be sent before closing.\n");
+  }
   do
   {
     ret = mbedtls_ssl_close_notify(&tlsData->ssl);
@@ -573,12 +692,144 @@ static void my_debug( void *ctx, int level,
 }
 
 
+/**
+ * @brief   Tell a DER blob from a PEM string.
+ * @note    DER credentials (see netsock/tools/pem2der.py) always start with an ASN.1 SEQUENCE tag,
+ *          whereas PEM text starts with the "-----BEGIN" armor.
+ */
+static bool tls_is_der(const unsigned char * buf, size_t len)
+{
+  return (len > 1) && (buf[0] == (MBEDTLS_ASN1_CONSTRUCTED | MBEDTLS_ASN1_SEQUENCE));
+}
+
+
+/**
+ * @brief   Return the PEM buffer length expected by mbedTLS, i.e. including the \0 terminator.
+ * @note    net_sock_setopt() callers pass either strlen() or strlen() + 1: accept both
+ *          without walking the string again.
+ */
+static size_t tls_pem_len(const unsigned char * buf, size_t len)
+{
+  if (len == 0)
+  {
+    return strlen((char const *) buf) + 1;
+  }
+  return (buf[len - 1] == '\0') ? len : len + 1;
+}
+
+
+/**
+ * @brief   Parse a certificate chain option into an mbedTLS chain.
+ * @note    A DER option may hold several concatenated certificates. They are split along
+ *          their outer SEQUENCE header. When the mbedTLS version allows it, the chain
+ *          references the caller buffer (typically in flash) instead of copying it to the heap.
+ * @retval  0 on success, or an mbedTLS error code.
+ */
+static int tls_crt_parse(mbedtls_x509_crt * chain, const unsigned char * buf, size_t len)
+{
+  int ret = 0;
+  size_t offset = 0;
+
+  if (!tls_is_der(buf, len))
+  {
+    return mbedtls_x509_crt_parse(chain, buf, tls_pem_len(buf, len));
+  }
+
+  while ((offset < len) && (ret == 0))
+  {
+    unsigned char * p = (unsigned char *) buf + offset;
+    size_t seq_len = 0;
+
+    if ((ret = mbedtls_asn1_get_tag(&p, buf + len, &seq_len, MBEDTLS_ASN1_CONSTRUCTED | MBEDTLS_ASN1_SEQUENCE)) != 0)
+    {
+      break;
+    }
+    seq_len += (size_t) (p - (buf + offset));   /* Add the tag and length bytes. */
+#if (MBEDTLS_VERSION_NUMBER >= 0x02110000)
+    ret = mbedtls_x509_crt_parse_der_nocopy(chain, buf + offset, seq_len);
+#else
+    /* mbedTLS < 2.17 has no no-copy variant: the DER is still copied, but the PEM decoding is skipped. */
+    ret = mbedtls_x509_crt_parse_der(chain, buf + offset, seq_len);
+#endif
+    offset += seq_len;
+  }
+
+  return ret;
+}
+
+
+/**
+ * @brief   Write through mbedTLS. One record is emitted per MBEDTLS_SSL_MAX_CONTENT_LEN chunk.
+ */
+static int tls_write(net_sock_ctxt_t * sock, const uint8_t * buf, size_t len)
+{
+  int rc = 0;
+  net_tls_data_t * tlsData = sock->tlsData;
+  int sent = 0;
+  int ret = 0;
+  uint32_t start_time = HAL_GetTick();
+  
+  do
+  {
+    if (sock->blocking == true)
+    {
+      if (net_timeout_left_ms(start_time, HAL_GetTick(), sock->write_timeout) <= 0)
+      {
+        rc = NET_TIMEOUT;
+        break;
+      }
+    }
+    
+    ret = mbedtls_ssl_write(&tlsData->ssl, buf + sent, len - sent);
+    if (ret > 0)
+    {
+      sent += ret;
+    }
+    else
+    {
+      switch(ret)
+      {
+        case 0:
+          rc = NET_EOF;
+          break;
+        case MBEDTLS_ERR_SSL_WANT_READ:
+        case MBEDTLS_ERR_SSL_WANT_WRITE:
+          /* Nothing to do. The while() below handles the case. */
+          break;
+        default:
+          msg_error(" failed\n  ! mbedtls_ssl_write returned -0x%x\n\n", -ret);
+          rc = NET_ERR;
+      }
+    }
+  } while ( ((ret == MBEDTLS_ERR_SSL_WANT_READ) || (ret == MBEDTLS_ERR_SSL_WANT_WRITE)) && (sock->blocking == true) && (rc == 0));
+  
+  return (rc < 0) ? rc : sent;
+}
+
+
+/**
+ * @brief   Tell whether the oldest coalesced write reached the tls_write_coalesce_ms bound.
+ */
+static bool tls_tx_expired(net_tls_data_t * tlsData)
+{
+  return (tlsData->tls_coalesce_delay != 0)
+      && (net_timeout_left_ms(tlsData->tx_start, HAL_GetTick(), tlsData->tls_coalesce_delay) <= 0);
+}
+
+
 static void internal_close(net_sock_ctxt_t * sock)
 {
   net_tls_data_t * tlsData = sock->tlsData;
   
   sock->underlying_sock_ctxt = (net_sockhnd_t) -1;
  
+  if (tlsData->tx_buf != NULL)
+  {
+    net_free(tlsData->tx_buf);
+    tlsData->tx_buf = NULL;
+  }
+  tlsData->tx_size = 0;
+  tlsData->tx_len = 0;
   mbedtls_x509_crt_free(&tlsData->clicert);
   mbedtls_pk_free(&tlsData->pkey);
   mbedtls_x509_crt_free(&tlsData->cacert);
@@ -70,7 +70,8 @@
 #endif
 
 int net_sock_create_tls_wifi(net_hnd_t nethnd, net_sockhnd_t * sockhnd, net_proto_t proto);
-int net_sock_open_tls_wifi(net_sockhnd_t sockhnd, const char * hostname, int dstport, int localport);
+int net_sock_open_tls_wifi(net_sockhnd_t sockhnd, const char * hostname, const net_ipaddr_t * address, int dstport, int localport);
+int net_sock_destroy_tls_wifi(net_sockhnd_t sockhnd);
 extern int net_sock_recv_tcp_wifi(net_sockhnd_t sockhnd, uint8_t * buf, size_t len);
 extern int net_sock_send_tcp_wifi(net_sockhnd_t sockhnd, const uint8_t * buf, size_t len);
 extern int net_sock_close_tcp_wifi(net_sockhnd_t sockhnd);
@@ -136,7 +137,7 @@ int net_sock_create_tls_wifi(net_hnd_t nethnd, net_sockhnd_t * sockhnd, net_prot
         return NET_PARAM;
     }
     sock->methods.close     = (net_sock_close_tcp_wifi);
-    sock->methods.destroy   = (net_sock_destroy_tcp_wifi);
+    sock->methods.destroy   = (net_sock_destroy_tls_wifi);
     sock->proto             = proto;
     sock->blocking          = NET_DEFAULT_BLOCKING;
     sock->read_timeout      = NET_DEFAULT_BLOCKING_READ_TIMEOUT;
@@ -155,11 +156,12 @@ int net_sock_create_tls_wifi(net_hnd_t nethnd, net_sockhnd_t * sockhnd, net_prot
   * @brief  High-level wrapper to open an AWS MQTT connection using the Net Library context.
   * @param  sockhnd: The socket handle created by net_sock_create_wifi.
   * @param  hostname: AWS Endpoint (e.g., "xxx-ats.iot.us-east-1.amazonaws.com").
+  * @param  address: Optional: the endpoint already resolved, no DNS query by the module.
   * @param  remoteport: Usually 8883.
   * @param  config: AWS specific topics and Client ID.
   * @retval NET_OK if success, NET_ERR if failure.
   */
-int net_sock_open_tls_wifi(net_sockhnd_t sockhnd, const char * hostname, int dstport, int localport)
+int net_sock_open_tls_wifi(net_sockhnd_t sockhnd, const char * hostname, const net_ipaddr_t * address, int dstport, int localport)
 {
   net_sock_ctxt_t *sock = (net_sock_ctxt_t *)sockhnd;
   uint8_t ip_addr[4]  = {0};
@@ -174,12 +176,28 @@ int net_sock_open_tls_wifi(net_sockhnd_t sockhnd, const char * hostname, int dst
 
   if (sock->proto == NET_PROTO_MQTT){
 	  /* 1. Resolve Hostname (Reusing logic from your file) */
-	  if (WIFI_GetHostAddress((char *)hostname, ip_addr, sizeof(ip_addr)) != WIFI_STATUS_OK) {
+	  if (!net_ipaddr_to_ipv4(address, ip_addr)
+			  && (WIFI_GetHostAddress((char *)hostname, ip_addr, sizeof(ip_addr)) != WIFI_STATUS_OK)) {
 		  msg_error("Could not resolve mqtt server endpoint: %s\n", hostname);
 		  return NET_ERR;
 	  }
 
 
+	  /* The module picks the plain or the TLS MQTT connection from the port.
+	   * The endpoint name is kept for the life of the socket: hostname may not outlive this call. */
+	  net_free(sock->mqtt_ctx->endpoint_url);
+	  sock->mqtt_ctx->endpoint_url = net_malloc(strlen(hostname) + 1);
+	  if (sock->mqtt_ctx->endpoint_url == NULL) {
+		  msg_error("Could not allocate the mqtt endpoint name: %s\n", hostname);
+		  return NET_ERR;
+	  }
+	  strcpy(sock->mqtt_ctx->endpoint_url, hostname);
+	  sock->mqtt_ctx->port = (uint16_t)dstport;
+	  if ((sock->mqtt_ctx->client_id == NULL) || (sock->mqtt_ctx->pub_topic == NULL) || (sock->mqtt_ctx->sub_topic == NULL)) {
+		  msg_error("mqtt_client_id, mqtt_pub_topic and mqtt_sub_topic must be set: %s\n", hostname);
+		  return NET_PARAM;
+	  }
+
 	  /* 4. Call the low-level firmware interface */
 	  // We use the global EsWifiObj used by the B-L475E-IOT01A1
 	  if (WIFI_MQTTIoTConnect((uint32_t)sock->underlying_sock_ctxt, ip_addr, sock->mqtt_ctx) != WIFI_STATUS_OK) {
@@ -190,7 +208,8 @@ int net_sock_open_tls_wifi(net_sockhnd_t sockhnd, const char * hostname, int dst
   }
   if (sock->proto == NET_PROTO_TLS){
 	  /* 1. Resolve Hostname (Reusing logic from your file) */
-	  if (WIFI_GetHostAddress((char *)hostname, ip_addr, sizeof(ip_addr)) != WIFI_STATUS_OK) {
+	  if (!net_ipaddr_to_ipv4(address, ip_addr)
+			  && (WIFI_GetHostAddress((char *)hostname, ip_addr, sizeof(ip_addr)) != WIFI_STATUS_OK)) {
 		  msg_error("Could not resolve tls server endpoint: %s\n", hostname);
 		  return NET_ERR;
 	  }
@@ -223,5 +242,27 @@ int net_sock_open_tls_wifi(net_sockhnd_t sockhnd, const char * hostname, int dst
   return NET_OK;
 }
 
+/**
+  * @brief  Free the module TLS and MQTT configurations, then the socket.
+  */
+int net_sock_destroy_tls_wifi(net_sockhnd_t sockhnd)
+{
+  net_sock_ctxt_t *sock = (net_sock_ctxt_t *)sockhnd;
+  WiFi_Tls_t *wifitls = sock->wifi_tls;
+  WiFi_MQTT_Config_t *mqttData = sock->mqtt_ctx;
+  int rc = net_sock_destroy_tcp_wifi(sockhnd);
+
+  if (rc == NET_OK)
+  {
+    net_free(wifitls);
+    if (mqttData != NULL)
+    {
+      net_free(mqttData->endpoint_url);
+    }
+    net_free(mqttData);
+  }
+  return rc;
+}
+
 #endif
 
@@ -0,0 +1,110 @@
+#!/usr/bin/env python3
+"""
+pem2der.py
+
+ Created on: Oct 18, 2026
+     Author: Daruin Solano
+
+Build-time conversion of PEM certificates and keys into DER C arrays.
+
+The netsock mbedTLS socket accepts both formats through the tls_ca_certs,
+tls_dev_cert and tls_dev_key options. A DER option skips the PEM armor search
+and the base64 decoding on every net_sock_open(), and with mbedTLS >= 2.17 the
+certificates are referenced from flash instead of being copied to the heap.
+
+Usage:
+    pem2der.py -o aws_cert_der.h AWS_ROOT_CA1=AmazonRootCA1.pem \
+        AWS_CERTIFICATE=device.pem.crt AWS_PRIVATE_KEY=private.pem.key
+
+Each NAME=file.pem pair produces:
+    static const unsigned char NAME_DER[] = { ... };
+    #define NAME_DER_LEN  <length>
+
+A PEM file holding several certificates (a CA chain) is emitted as one array of
+concatenated DER certificates; the socket splits them at load time.
+A key file is emitted as its single PRIVATE KEY block (PKCS#8, RSA or EC): the
+EC PARAMETERS block that openssl ecparam -genkey writes ahead of it is skipped,
+the key names its curve.
+Any other block, or certificates and a key in the same file, is rejected: the
+socket tells DER from PEM by the SEQUENCE tag (0x30) the array starts with.
+Encrypted PEM keys (Proc-Type header) are rejected: convert them offline first.
+"""
+
+import argparse
+import base64
+import os
+import re
+import sys
+
+PEM_RE = re.compile(
+    r"-----BEGIN ([A-Z0-9 ]+)-----\s*(.*?)\s*-----END \1-----", re.DOTALL)
+
+
+def pem_to_der(text, path):
+    certs = []
+    keys = []
+    for label, body in PEM_RE.findall(text):
+        if "Proc-Type:" in body:
+            raise ValueError("%s: encrypted PEM block '%s' is not supported" % (path, label))
+        der = base64.b64decode("".join(body.split()))
+        if label == "CERTIFICATE":
+            certs.append(der)
+        elif label.endswith("PRIVATE KEY"):
+            keys.append(der)
+        elif label != "EC PARAMETERS":
+            raise ValueError("%s: unexpected PEM block '%s'" % (path, label))
+    if certs and keys:
+        raise ValueError("%s: certificates and a key in the same file" % path)
+    if len(keys) > 1:
+        raise ValueError("%s: %d keys, one expected" % (path, len(keys)))
+    if not certs and not keys:
+        raise ValueError("%s: no certificate nor key PEM block found" % path)
+    return b"".join(certs + keys)
+
+
+def c_array(name, der):
+    lines = ["static const unsigned char %s_DER[] = {" % name]
+    for i in range(0, len(der), 12):
+        chunk = der[i:i + 12]
+        lines.append("  " + ", ".join("0x%02X" % b for b in chunk) + ",")
+    lines.append("};")
+    lines.append("#define %s_DER_LEN  %d" % (name, len(der)))
+    return "\n".join(lines)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Convert PEM certificates/keys to DER C arrays.")
+    parser.add_argument("-o", "--output", required=True, help="generated header file")
+    parser.add_argument("items", nargs="+", metavar="NAME=file.pem")
+    args = parser.parse_args()
+
+    guard = re.sub(r"[^A-Za-z0-9]", "_", os.path.basename(args.output)).upper() + "_"
+    out = ["/* Generated by netsock/tools/pem2der.py. Do not edit. */",
+           "#ifndef %s" % guard,
+           "#define %s" % guard,
+           ""]
+
+    for item in args.items:
+        if "=" not in item:
+            parser.error("expected NAME=file.pem, got '%s'" % item)
+        name, path = item.split("=", 1)
+        if not re.match(r"^[A-Za-z_][A-Za-z0-9_]*$", name):
+            parser.error("'%s' is not a valid C identifier" % name)
+        with open(path, "r") as f:
+            try:
+                der = pem_to_der(f.read(), path)
+            except ValueError as e:
+                sys.stderr.write("pem2der: %s\n" % e)
+                return 1
+        out.append("/* %s */" % os.path.basename(path))
+        out.append(c_array(name, der))
+        out.append("")
+
+    out.append("#endif /* %s */" % guard)
+    with open(args.output, "w") as f:
+        f.write("\n".join(out) + "\n")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
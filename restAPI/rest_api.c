@@ -7,6 +7,7 @@
 
 
 #include "rest_api.h"
+#include "cJSON_CBOR.h"
 #include <string.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -66,6 +67,30 @@ static bool header_value_starts_with(const char *val, const char *prefix)
     return true;
 }
 
+/* Case-insensitive search of token in a header value, up to the end of its line. */
+static bool header_value_contains(const char *val, const char *token)
+{
+    if (!val || !token) return false;
+
+    size_t tlen = strlen(token);
+    const char *line_end = strstr(val, "\r\n");
+    if (!line_end) line_end = val + strlen(val);
+
+    for (const char *p = val; (size_t)(line_end - p) >= tlen; ++p) {
+        size_t i = 0;
+        while (i < tlen && tolower((unsigned char)p[i]) == tolower((unsigned char)token[i])) i++;
+        if (i == tlen) return true;
+    }
+    return false;
+}
+
+/* Content negotiation: CBOR responses for the clients that accept it. */
+static bool rest_accepts_cbor(const http_srv_request_t *req)
+{
+    const char *accept = find_header_value(req->headers, req->headers_len, "Accept");
+    return header_value_contains(accept, "application/cbor");
+}
+
 /* URL decode: converts '+' to space and %XX hex.
    Writes decoded string into dst (dst_len includes terminator).
    Returns decoded length, or -1 on error. */
@@ -142,6 +167,7 @@ static cJSON *parse_form_urlencoded(const char *body, uint32_t body_len)
 
 /* Decide how to parse body:
    - JSON -> parse
+   - CBOR -> decode into the same tree
    - form -> parse into object
    Returns cJSON* or NULL on failure. */
 static cJSON *rest_parse_body(const http_srv_request_t *req)
@@ -155,6 +181,10 @@ static cJSON *rest_parse_body(const http_srv_request_t *req)
         return cJSON_ParseWithLength(req->body, (size_t)req->body_len);
     }
 
+    if (ct && header_value_starts_with(ct, "application/cbor")) {
+        return cJSON_FromCBOR(req->body, (size_t)req->body_len);
+    }
+
     if (ct && header_value_starts_with(ct, "application/x-www-form-urlencoded")) {
         return parse_form_urlencoded(req->body, req->body_len);
     }
@@ -191,7 +221,8 @@ void rest_api_set_pretty(rest_api_t *api, bool pretty)
     api->pretty_json = pretty;
 }
 
-static int send_json_string(http_srv_t *hs, uint32_t status, const char *json_str)
+static int send_body(http_srv_t *hs, uint32_t status, const char *content_type,
+                     const uint8_t *body, uint32_t body_len)
 {
     const char *hdr_extra =
         "Cache-Control: no-store\r\n"
@@ -208,13 +239,19 @@ static int send_json_string(http_srv_t *hs, uint32_t status, const char *json_st
         (status == 404) ? "Not Found" :
         (status == 415) ? "Unsupported Media Type" :
         (status == 500) ? "Internal Server Error" : "OK",
-        "application/json",
-        (const uint8_t *)json_str,
-        (json_str ? strlen(json_str) : 0),
+        content_type,
+        body,
+        body_len,
         hdr_extra
     );
 }
 
+static int send_json_string(http_srv_t *hs, uint32_t status, const char *json_str)
+{
+    return send_body(hs, status, "application/json",
+                     (const uint8_t *)json_str, (json_str ? strlen(json_str) : 0));
+}
+
 int rest_send_json(http_srv_t *hs, uint32_t status, cJSON *obj, bool pretty)
 {
     if (!hs) return HTTP_ERR;
@@ -231,6 +268,31 @@ int rest_send_json(http_srv_t *hs, uint32_t status, cJSON *obj, bool pretty)
     return rc;
 }
 
+int rest_send_cbor(http_srv_t *hs, uint32_t status, cJSON *obj)
+{
+    static const uint8_t empty_map = 0xA0;
+
+    if (!hs) return HTTP_ERR;
+
+    if (!obj) {
+        return send_body(hs, status, "application/cbor", &empty_map, 1);
+    }
+
+    /* measured first: the exact size, as cJSON_Print allocates the JSON string */
+    int len = cJSON_ToCBOR(obj, NULL, 0);
+    if (len < 0) return HTTP_ERR;
+
+    uint8_t *cbor = (uint8_t *)malloc(len > 0 ? (size_t)len : 1);
+    if (!cbor) return HTTP_ERR;
+
+    int rc = HTTP_ERR;
+    if (cJSON_ToCBOR(obj, cbor, (size_t)len) == len) {
+        rc = send_body(hs, status, "application/cbor", cbor, (uint32_t)len);
+    }
+    free(cbor);
+    return rc;
+}
+
 int rest_send_error(http_srv_t *hs, uint32_t status, const char *code, const char *message)
 {
     cJSON *root = cJSON_CreateObject();
@@ -335,7 +397,8 @@ int rest_api_dispatch(rest_api_t *api, http_srv_t *hs, const http_srv_request_t
         return HTTP_OK;
     }
 
-    int src = rest_send_json(hs, status, json_out, api->pretty_json);
+    int src = rest_accepts_cbor(req) ? rest_send_cbor(hs, status, json_out)
+                                     : rest_send_json(hs, status, json_out, api->pretty_json);
     if (json_out) cJSON_Delete(json_out);
 
     http_srv_next_conn(hs);
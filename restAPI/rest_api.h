@@ -22,9 +22,11 @@ extern "C" {
 
 typedef struct rest_api_s rest_api_t;
 
+/* Bodies: JSON, CBOR (Content-Type: application/cbor) or form, parsed into the same cJSON tree.
+ * Responses: JSON, or CBOR when the Accept header of the request lists application/cbor. */
 typedef int (*rest_handler_fn)(http_srv_t *hs,
                                const http_srv_request_t *req,
-                               cJSON *body_in,          /* JSON object or form object */
+                               cJSON *body_in,          /* JSON, CBOR or form object */
                                cJSON **json_out,        /* response JSON object */
                                uint32_t *http_status);
 
@@ -51,6 +53,7 @@ void rest_api_set_pretty(rest_api_t *api, bool pretty);
 int  rest_api_dispatch(rest_api_t *api, http_srv_t *hs, const http_srv_request_t *req);
 
 int  rest_send_json(http_srv_t *hs, uint32_t status, cJSON *obj, bool pretty);
+int  rest_send_cbor(http_srv_t *hs, uint32_t status, cJSON *obj);
 int  rest_send_error(http_srv_t *hs, uint32_t status, const char *code, const char *message);
 
 const char *rest_query_get(const http_srv_request_t *req, const char *key,
@@ -0,0 +1,66 @@
+/*
+ * rest_sensors.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Daruin Solano
+ */
+
+
+#include "rest_sensors.h"
+
+static sensors_deadband_t *deadband_srv;
+
+static cJSON *rest_sensors_error(const char *code, const char *message)
+{
+    cJSON *root = cJSON_CreateObject();
+    if (!root) return NULL;
+
+    cJSON_AddStringToObject(root, "error", code);
+    cJSON_AddStringToObject(root, "message", message);
+    return root;
+}
+
+void rest_sensors_bind(sensors_deadband_t *deadband)
+{
+    deadband_srv = deadband;
+}
+
+int rest_sensors_deadband_get(http_srv_t *hs, const http_srv_request_t *req,
+                              cJSON *body_in, cJSON **json_out, uint32_t *http_status)
+{
+    (void)hs; (void)req; (void)body_in;
+
+    if (!deadband_srv) {
+        *http_status = 503;
+        *json_out = rest_sensors_error("unavailable", "No deadband filter");
+        return HTTP_OK;
+    }
+    *json_out = sensors_deadband_to_json(deadband_srv);
+    return *json_out ? HTTP_OK : HTTP_ERR;
+}
+
+int rest_sensors_deadband_put(http_srv_t *hs, const http_srv_request_t *req,
+                              cJSON *body_in, cJSON **json_out, uint32_t *http_status)
+{
+    int rc;
+
+    if (!deadband_srv) {
+        return rest_sensors_deadband_get(hs, req, body_in, json_out, http_status);
+    }
+    /* The filter belongs to the MQTT task: it applies the configuration at its next loop. */
+    rc = sensors_deadband_stage(deadband_srv, body_in);
+    if (rc == -1) {
+        *http_status = 400;
+        *json_out = rest_sensors_error("bad_request",
+                "Expected {\"<channel>\": {\"abs\", \"rel\", \"heartbeat_ms\", \"min_interval_ms\": numbers >= 0}}");
+        return HTTP_OK;
+    }
+    if (rc < 0) {
+        *http_status = 503;
+        *json_out = rest_sensors_error("busy", "A deadband configuration is being applied, try again");
+        return HTTP_OK;
+    }
+    *http_status = 202;
+    *json_out = cJSON_Duplicate(body_in, true);
+    return *json_out ? HTTP_OK : HTTP_ERR;
+}
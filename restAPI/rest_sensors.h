@@ -0,0 +1,50 @@
+/*
+ * rest_sensors.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Daruin Solano
+ *
+ *  REST endpoints of the sensors, for the route table of the application:
+ *
+ *    GET /api/sensors/deadband   configuration and metrics of the report by
+ *                                exception, per channel
+ *    PUT /api/sensors/deadband   change it: the channels and members given,
+ *                                see sensors_deadband_from_json(); 202, the
+ *                                task of the filter applies it, see
+ *                                sensors_deadband_stage()
+ *
+ *    static const rest_route_t routes[] = {
+ *        REST_SENSORS_ROUTES,
+ *        ...
+ *    };
+ *    rest_sensors_bind(&telemetry_deadband);
+ */
+
+#ifndef RESTAPI_REST_SENSORS_H_
+#define RESTAPI_REST_SENSORS_H_
+
+#pragma once
+#include "rest_api.h"
+#include "sensors_deadband.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define REST_SENSORS_ROUTES \
+    { "GET", "/api/sensors/deadband", rest_sensors_deadband_get, false }, \
+    { "PUT", "/api/sensors/deadband", rest_sensors_deadband_put, true }
+
+/* Deadband filter served by the endpoints; NULL: 503 */
+void rest_sensors_bind(sensors_deadband_t *deadband);
+
+int  rest_sensors_deadband_get(http_srv_t *hs, const http_srv_request_t *req,
+                               cJSON *body_in, cJSON **json_out, uint32_t *http_status);
+int  rest_sensors_deadband_put(http_srv_t *hs, const http_srv_request_t *req,
+                               cJSON *body_in, cJSON **json_out, uint32_t *http_status);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RESTAPI_REST_SENSORS_H_ */